@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * NOR flash simulator. Flash is kept in RAM or, on native_posix, in a file
+ * mapped to memory. Writes only move bits away from their erased value,
+ * erases work on whole sectors and optional delays model program and erase
+ * times. Usage and wear are counted in statistics groups.
+ */
+
+#ifdef CONFIG_ARCH_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cmdline.h"
+#include "posix_trace.h"
+#include "soc.h"
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#include <kernel.h>
+#include <device.h>
+#include <init.h>
+#include <flash.h>
+#include <stats.h>
+
+#define SECTOR_SIZE CONFIG_FLASH_SIMULATOR_SECTOR_SIZE
+#define SECTOR_COUNT CONFIG_FLASH_SIMULATOR_SECTOR_COUNT
+#define WRITE_BLOCK_SIZE CONFIG_FLASH_SIMULATOR_WRITE_BLOCK_SIZE
+#define ERASE_VALUE ((u8_t)CONFIG_FLASH_SIMULATOR_ERASE_VALUE)
+#define FLASH_SIZE (SECTOR_SIZE * SECTOR_COUNT)
+
+BUILD_ASSERT_MSG((SECTOR_SIZE % WRITE_BLOCK_SIZE) == 0,
+		 "Sector size must be a multiple of the write block size");
+
+#ifdef CONFIG_FLASH_SIMULATOR_STATS
+BUILD_ASSERT_MSG(SECTOR_COUNT <= UINT8_MAX,
+		 "Statistics group can hold at most 255 sectors");
+
+STATS_SECT_START(flash_sim)
+STATS_SECT_ENTRY64(bytes_read)
+STATS_SECT_ENTRY64(bytes_written)
+STATS_SECT_ENTRY64(writes)
+STATS_SECT_ENTRY64(double_writes)
+STATS_SECT_ENTRY64(erases)
+STATS_SECT_ENTRY64(sectors_erased)
+STATS_SECT_END;
+
+STATS_NAME_START(flash_sim)
+STATS_NAME(flash_sim, bytes_read)
+STATS_NAME(flash_sim, bytes_written)
+STATS_NAME(flash_sim, writes)
+STATS_NAME(flash_sim, double_writes)
+STATS_NAME(flash_sim, erases)
+STATS_NAME(flash_sim, sectors_erased)
+STATS_NAME_END(flash_sim);
+
+/* Erase cycles of every sector. The group has no name map, so the entries
+ * are reported as s<sector>.
+ */
+STATS_SECT_START(flash_sim_wear)
+STATS_SECT_ENTRY32(erase_cycles[SECTOR_COUNT])
+STATS_SECT_END;
+
+static STATS_SECT_DECL(flash_sim) flash_sim;
+static STATS_SECT_DECL(flash_sim_wear) flash_sim_wear;
+
+#define SIM_STATS_INC(name) STATS_INC(flash_sim, name)
+#define SIM_STATS_INCN(name, n) STATS_INCN(flash_sim, name, n)
+#define SECTOR_ERASED(sector) (flash_sim_wear.erase_cycles[(sector)]++)
+#else
+#define SIM_STATS_INC(name)
+#define SIM_STATS_INCN(name, n)
+#define SECTOR_ERASED(sector)
+#endif /* CONFIG_FLASH_SIMULATOR_STATS */
+
+static u8_t flash_ram[FLASH_SIZE];
+static u8_t *flash_mem = flash_ram;
+static bool write_protected = true;
+static struct k_sem flash_sim_lock;
+
+#ifdef CONFIG_ARCH_POSIX
+static char *flash_file_path;
+static int flash_file_fd = -1;
+#endif
+
+static bool flash_range_is_valid(off_t offset, size_t len)
+{
+	return (offset >= 0) && (len <= FLASH_SIZE) &&
+	       ((size_t)offset <= FLASH_SIZE - len);
+}
+
+static int flash_sim_read(struct device *dev, off_t offset, void *data,
+			  size_t len)
+{
+	ARG_UNUSED(dev);
+
+	if (!flash_range_is_valid(offset, len)) {
+		return -EINVAL;
+	}
+
+	memcpy(data, &flash_mem[offset], len);
+
+	SIM_STATS_INCN(bytes_read, len);
+
+	return 0;
+}
+
+/* Returns true if the write block was programmed since its last erase. */
+static bool write_block_is_programmed(const u8_t *block)
+{
+	for (int i = 0; i < WRITE_BLOCK_SIZE; i++) {
+		if (block[i] != ERASE_VALUE) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int flash_sim_write(struct device *dev, off_t offset,
+			   const void *data, size_t len)
+{
+	const u8_t *src = data;
+	u8_t *dst;
+
+	ARG_UNUSED(dev);
+
+	if (!flash_range_is_valid(offset, len) ||
+	    (offset % WRITE_BLOCK_SIZE) != 0 || (len % WRITE_BLOCK_SIZE) != 0) {
+		return -EINVAL;
+	}
+
+	if (write_protected) {
+		return -EACCES;
+	}
+
+	k_sem_take(&flash_sim_lock, K_FOREVER);
+
+	dst = &flash_mem[offset];
+
+	for (size_t blk = 0; blk < len; blk += WRITE_BLOCK_SIZE) {
+		if (write_block_is_programmed(&dst[blk])) {
+			if (!IS_ENABLED(CONFIG_FLASH_SIMULATOR_DOUBLE_WRITES)) {
+				k_sem_give(&flash_sim_lock);
+				return -EIO;
+			}
+
+			SIM_STATS_INC(double_writes);
+		}
+
+		/* Programmed bits stay programmed until erase. */
+		for (size_t i = blk; i < blk + WRITE_BLOCK_SIZE; i++) {
+			u8_t programmed = (dst[i] ^ ERASE_VALUE) |
+					  (src[i] ^ ERASE_VALUE);
+
+			dst[i] = programmed ^ ERASE_VALUE;
+		}
+
+		if (CONFIG_FLASH_SIMULATOR_WRITE_TIME_US) {
+			k_busy_wait(CONFIG_FLASH_SIMULATOR_WRITE_TIME_US);
+		}
+	}
+
+	SIM_STATS_INC(writes);
+	SIM_STATS_INCN(bytes_written, len);
+
+	k_sem_give(&flash_sim_lock);
+
+	return 0;
+}
+
+static int flash_sim_erase(struct device *dev, off_t offset, size_t size)
+{
+	ARG_UNUSED(dev);
+
+	if (!flash_range_is_valid(offset, size) ||
+	    (offset % SECTOR_SIZE) != 0 || (size % SECTOR_SIZE) != 0) {
+		return -EINVAL;
+	}
+
+	if (write_protected) {
+		return -EACCES;
+	}
+
+	k_sem_take(&flash_sim_lock, K_FOREVER);
+
+	for (size_t sector = offset / SECTOR_SIZE;
+	     sector < (offset + size) / SECTOR_SIZE; sector++) {
+		memset(&flash_mem[sector * SECTOR_SIZE], ERASE_VALUE,
+		       SECTOR_SIZE);
+		SECTOR_ERASED(sector);
+		SIM_STATS_INC(sectors_erased);
+
+		if (CONFIG_FLASH_SIMULATOR_ERASE_TIME_US) {
+			k_busy_wait(CONFIG_FLASH_SIMULATOR_ERASE_TIME_US);
+		}
+	}
+
+	SIM_STATS_INC(erases);
+
+	k_sem_give(&flash_sim_lock);
+
+	return 0;
+}
+
+static int flash_sim_write_protection(struct device *dev, bool enable)
+{
+	ARG_UNUSED(dev);
+
+	write_protected = enable;
+
+	return 0;
+}
+
+#if defined(CONFIG_FLASH_PAGE_LAYOUT)
+static const struct flash_pages_layout flash_sim_layout = {
+	.pages_count = SECTOR_COUNT,
+	.pages_size = SECTOR_SIZE,
+};
+
+static void flash_sim_page_layout(struct device *dev,
+				  const struct flash_pages_layout **layout,
+				  size_t *layout_size)
+{
+	ARG_UNUSED(dev);
+
+	*layout = &flash_sim_layout;
+	*layout_size = 1;
+}
+#endif /* CONFIG_FLASH_PAGE_LAYOUT */
+
+static const struct flash_driver_api flash_sim_api = {
+	.read = flash_sim_read,
+	.write = flash_sim_write,
+	.erase = flash_sim_erase,
+	.write_protection = flash_sim_write_protection,
+#if defined(CONFIG_FLASH_PAGE_LAYOUT)
+	.page_layout = flash_sim_page_layout,
+#endif
+	.write_block_size = WRITE_BLOCK_SIZE,
+};
+
+#ifdef CONFIG_ARCH_POSIX
+/* Map the backing file, an existing file keeps its content and space added
+ * to it reads as erased.
+ */
+static int flash_file_map(void)
+{
+	struct stat st;
+	void *mem;
+
+	flash_file_fd = open(flash_file_path, O_RDWR | O_CREAT, 0600);
+	if (flash_file_fd < 0) {
+		posix_print_warning("Failed to open flash file %s\n",
+				    flash_file_path);
+		return -EIO;
+	}
+
+	if (fstat(flash_file_fd, &st) < 0 ||
+	    ftruncate(flash_file_fd, FLASH_SIZE) < 0) {
+		posix_print_warning("Failed to resize flash file %s\n",
+				    flash_file_path);
+		goto err_close;
+	}
+
+	mem = mmap(NULL, FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+		   flash_file_fd, 0);
+	if (mem == MAP_FAILED) {
+		posix_print_warning("Failed to map flash file %s\n",
+				    flash_file_path);
+		goto err_close;
+	}
+
+	flash_mem = mem;
+
+	if (st.st_size < FLASH_SIZE) {
+		memset(&flash_mem[st.st_size], ERASE_VALUE,
+		       FLASH_SIZE - st.st_size);
+	}
+
+	return 0;
+
+err_close:
+	close(flash_file_fd);
+	flash_file_fd = -1;
+	return -EIO;
+}
+
+static void flash_sim_cleanup(void)
+{
+	if (flash_mem != flash_ram) {
+		munmap(flash_mem, FLASH_SIZE);
+	}
+
+	if (flash_file_fd >= 0) {
+		close(flash_file_fd);
+	}
+}
+
+static void flash_sim_options(void)
+{
+	static struct args_struct_t flash_options[] = {
+		/*
+		 * Fields:
+		 * manual, mandatory, switch,
+		 * option_name, var_name ,type,
+		 * destination, callback,
+		 * description
+		 */
+		{false, false, false,
+		"flash", "path", 's',
+		(void *)&flash_file_path, NULL,
+		"File backing the simulated flash, created if it does not "
+		"exist. By default flash is kept in RAM."},
+		ARG_TABLE_ENDMARKER
+	};
+
+	native_add_command_line_opts(flash_options);
+}
+
+NATIVE_TASK(flash_sim_options, PRE_BOOT_1, 12);
+NATIVE_TASK(flash_sim_cleanup, ON_EXIT, 1);
+#endif /* CONFIG_ARCH_POSIX */
+
+static int flash_sim_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	k_sem_init(&flash_sim_lock, 1, 1);
+
+#ifdef CONFIG_ARCH_POSIX
+	if (flash_file_path != NULL) {
+		if (flash_file_map() != 0) {
+			return -EIO;
+		}
+	} else
+#endif
+	{
+		memset(flash_ram, ERASE_VALUE, FLASH_SIZE);
+	}
+
+#ifdef CONFIG_FLASH_SIMULATOR_STATS
+	if (STATS_INIT_AND_REG(flash_sim, STATS_SIZE_64, "flash_sim") ||
+	    stats_init_and_reg(&flash_sim_wear.s_hdr, STATS_SIZE_32,
+			       SECTOR_COUNT, NULL, 0, "flash_sim_wear")) {
+		return -EIO;
+	}
+#endif
+
+	return 0;
+}
+
+DEVICE_AND_API_INIT(flash_simulator, CONFIG_FLASH_SIMULATOR_DEV_NAME,
+		    flash_sim_init, NULL, NULL, POST_KERNEL,
+		    CONFIG_KERNEL_INIT_PRIORITY_DEVICE, &flash_sim_api);
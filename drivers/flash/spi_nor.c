@@ -11,6 +11,8 @@
 #include <spi.h>
 #include <init.h>
 #include <string.h>
+#include <misc/byteorder.h>
+#include <generated_dts_board.h>
 #include "spi_nor.h"
 #include "flash_priv.h"
 
@@ -21,13 +23,25 @@
 #define SZ_32K  0x8000
 #define SZ_64K  0x10000
 
-#define MASK_256 0xFF
-#define MASK_4K  0xFFF
-#define MASK_32K 0x7FFF
-#define MASK_64K 0xFFFF
-
 #define SPI_NOR_MAX_ADDR_WIDTH 4
+#define SPI_NOR_MAX_DUMMY 1
+
+#if defined(DT_SPI_NOR_SIZE)
+#define SECTORS_COUNT (DT_SPI_NOR_SIZE / CONFIG_SPI_NOR_SECTOR_SIZE)
+#elif defined(CONFIG_FLASH_SIZE)
 #define SECTORS_COUNT (KB(CONFIG_FLASH_SIZE) / CONFIG_SPI_NOR_SECTOR_SIZE)
+#else
+/* size is only known from SFDP */
+#define SECTORS_COUNT 0
+#endif
+
+#if defined(CONFIG_SPI_NOR_READ_FAST)
+#define SPI_NOR_READ_CMD SPI_NOR_CMD_FAST_READ
+#define SPI_NOR_READ_DUMMY 1
+#else
+#define SPI_NOR_READ_CMD SPI_NOR_CMD_READ
+#define SPI_NOR_READ_DUMMY 0
+#endif
 
 #define JEDEC_ID(x)		    \
 	{			    \
@@ -42,6 +56,11 @@
  * @spi_cfg: The SPI configuration
  * @cs_ctrl: The GPIO pin used to emulate the SPI CS if required
  * @sem: The semaphore to access to the flash
+ * @size: The flash size in bytes
+ * @page_size: The largest amount of data a page program can write
+ * @addr_len: The number of address bytes sent with a command
+ * @erase_types: The erase instructions, largest erase size first
+ * @layout: The page layout, in units of the erase block size
  */
 struct spi_nor_data {
 	struct device *spi;
@@ -50,6 +69,13 @@ struct spi_nor_data {
 	struct spi_cs_control cs_ctrl;
 #endif /* CONFIG_SPI_NOR_GPIO_SPI_CS */
 	struct k_sem sem;
+	u32_t size;
+	u32_t page_size;
+	u8_t addr_len;
+	struct spi_nor_erase_type erase_types[SPI_NOR_ERASE_TYPES];
+#if defined(CONFIG_FLASH_PAGE_LAYOUT)
+	struct flash_pages_layout layout;
+#endif
 };
 
 #if defined(CONFIG_MULTITHREADING)
@@ -70,6 +96,7 @@ struct spi_nor_data {
  * @param opcode The command to send
  * @param is_addressed A flag to define if the command is addressed
  * @param addr The address to send
+ * @param dummy The number of dummy bytes to send after the address
  * @param data The buffer to store or read the value
  * @param length The size of the buffer
  * @param is_write A flag to define if it's a read or a write command
@@ -77,21 +104,28 @@ struct spi_nor_data {
  */
 static int spi_nor_access(const struct device *const dev,
 			  u8_t opcode, bool is_addressed, off_t addr,
-			  void *data, size_t length, bool is_write)
+			  size_t dummy, void *data, size_t length,
+			  bool is_write)
 {
 	struct spi_nor_data *const driver_data = dev->driver_data;
-
-	u8_t buf[4] = {
+	u8_t buf[1 + SPI_NOR_MAX_ADDR_WIDTH + SPI_NOR_MAX_DUMMY] = {
 		opcode,
-		(addr & 0xFF0000) >> 16,
-		(addr & 0xFF00) >> 8,
-		(addr & 0xFF),
 	};
+	size_t buf_len = 1;
+
+	if (is_addressed) {
+		/* address is sent MSB first, dummy bytes are zeros */
+		for (int i = driver_data->addr_len - 1; i >= 0; i--) {
+			buf[buf_len++] = (addr >> (8 * i)) & 0xFF;
+		}
+
+		buf_len += dummy;
+	}
 
 	struct spi_buf spi_buf[2] = {
 		{
 			.buf = buf,
-			.len = (is_addressed) ? 4 : 1,
+			.len = buf_len,
 		},
 		{
 			.buf = data,
@@ -118,13 +152,13 @@ static int spi_nor_access(const struct device *const dev,
 }
 
 #define spi_nor_cmd_read(dev, opcode, dest, length) \
-	spi_nor_access(dev, opcode, false, 0, dest, length, false)
-#define spi_nor_cmd_addr_read(dev, opcode, addr, dest, length) \
-	spi_nor_access(dev, opcode, true, addr, dest, length, false)
+	spi_nor_access(dev, opcode, false, 0, 0, dest, length, false)
+#define spi_nor_cmd_addr_read(dev, opcode, addr, dummy, dest, length) \
+	spi_nor_access(dev, opcode, true, addr, dummy, dest, length, false)
 #define spi_nor_cmd_write(dev, opcode) \
-	spi_nor_access(dev, opcode, false, 0, NULL, 0, true)
+	spi_nor_access(dev, opcode, false, 0, 0, NULL, 0, true)
 #define spi_nor_cmd_addr_write(dev, opcode, addr, src, length) \
-	spi_nor_access(dev, opcode, true, addr, src, length, true)
+	spi_nor_access(dev, opcode, true, addr, 0, src, length, true)
 
 /**
  * @brief Retrieve the Flash JEDEC ID and compare it with the one expected
@@ -168,145 +202,156 @@ static int spi_nor_wait_until_ready(struct device *dev)
 	return ret;
 }
 
+/* Whether the range is within the flash */
+static bool spi_nor_range_is_valid(const struct spi_nor_data *driver_data,
+				   off_t addr, size_t size)
+{
+	return (addr >= 0) && (size <= driver_data->size) &&
+	       ((size_t)addr <= driver_data->size - size);
+}
+
 static int spi_nor_read(struct device *dev, off_t addr, void *dest,
 			size_t size)
 {
 	struct spi_nor_data *const driver_data = dev->driver_data;
-	const struct spi_nor_config *params = dev->config->config_info;
 	int ret;
-	int to_read;
 
 	/* should be between 0 and flash size */
-	if ((addr < 0) || (addr + size) >  (params->sector_size
-					   * params->n_sectors)) {
+	if (!spi_nor_range_is_valid(driver_data, addr, size)) {
 		return -EINVAL;
 	}
 
 	SYNC_LOCK();
 
-	spi_nor_wait_until_ready(dev);
-
-	while (size) {
-		to_read = size;
-		if (size > params->page_size) {
-			to_read = params->page_size;
-		}
-
-		ret = spi_nor_cmd_addr_read(dev, SPI_NOR_CMD_READ, addr,
-					    dest, to_read);
-		if (ret != 0) {
-			SYNC_UNLOCK();
-			return ret;
-		}
-
-		size -= to_read;
-		addr += to_read;
-		dest = (u8_t *)dest + to_read;
+	/* the flash streams any length from a single read command */
+	ret = spi_nor_wait_until_ready(dev);
+	if (ret == 0) {
+		ret = spi_nor_cmd_addr_read(dev, SPI_NOR_READ_CMD, addr,
+					    SPI_NOR_READ_DUMMY, dest, size);
 	}
 
 	SYNC_UNLOCK();
-	return 0;
+	return ret;
 }
 
 static int spi_nor_write(struct device *dev, off_t addr, const void *src,
 			 size_t size)
 {
 	struct spi_nor_data *const driver_data = dev->driver_data;
-	const struct spi_nor_config *params = dev->config->config_info;
-	int ret;
+	int ret = 0;
 	size_t to_write;
 
 	/* should be between 0 and flash size */
-	if ((addr < 0) || ((size + addr) > (params->sector_size *
-						params->n_sectors))) {
+	if (!spi_nor_range_is_valid(driver_data, addr, size)) {
 		return -EINVAL;
 	}
 
 	SYNC_LOCK();
 
 	while (size) {
+		/* a page program wraps around at the end of the page */
+		to_write = driver_data->page_size -
+			   (addr % driver_data->page_size);
+		if (size < to_write) {
+			to_write = size;
+		}
+
 		/* write enable */
-		spi_nor_cmd_write(dev, SPI_NOR_CMD_WREN);
+		ret = spi_nor_cmd_write(dev, SPI_NOR_CMD_WREN);
+		if (ret == 0) {
+			ret = spi_nor_cmd_addr_write(dev, SPI_NOR_CMD_PP, addr,
+						     (void *)src, to_write);
+		}
 
-		to_write = size;
-		if (size >= params->page_size) {
-			to_write = params->page_size;
+		if (ret == 0) {
+			ret = spi_nor_wait_until_ready(dev);
 		}
 
-		ret = spi_nor_cmd_addr_write(dev, SPI_NOR_CMD_PP, addr,
-					     (void *)src, to_write);
 		if (ret != 0) {
-			SYNC_UNLOCK();
-			return ret;
+			break;
 		}
 
 		size -= to_write;
 		addr += to_write;
 		src = (u8_t *)src + to_write;
-
-		spi_nor_wait_until_ready(dev);
 	}
 
 	SYNC_UNLOCK();
-	return 0;
+	return ret;
+}
+
+/* Find the largest erase which starts at addr and does not exceed size */
+static const struct spi_nor_erase_type *
+spi_nor_erase_type_find(const struct spi_nor_data *driver_data, off_t addr,
+			size_t size)
+{
+	const struct spi_nor_erase_type *type;
+
+	for (int i = 0; i < ARRAY_SIZE(driver_data->erase_types); i++) {
+		type = &driver_data->erase_types[i];
+
+		if ((type->size != 0) && (size >= type->size) &&
+		    ((addr % type->size) == 0)) {
+			return type;
+		}
+	}
+
+	return NULL;
 }
 
 static int spi_nor_erase(struct device *dev, off_t addr, size_t size)
 {
 	struct spi_nor_data *const driver_data = dev->driver_data;
-	const struct spi_nor_config *params = dev->config->config_info;
+	const struct spi_nor_erase_type *type;
+	int ret = 0;
 
 	/* should be between 0 and flash size */
-	if ((addr < 0) || ((size + addr) >
-		(params->sector_size * params->n_sectors))) {
+	if (!spi_nor_range_is_valid(driver_data, addr, size)) {
 		return -ENODEV;
 	}
 
 	SYNC_LOCK();
 
 	while (size) {
-		/* write enable */
-		spi_nor_cmd_write(dev, SPI_NOR_CMD_WREN);
-
-		if (size == (params->sector_size * params->n_sectors)) {
+		if (size == driver_data->size) {
 			/* chip erase */
-			spi_nor_cmd_write(dev, SPI_NOR_CMD_CE);
-			size -= (params->sector_size * params->n_sectors);
-		} else if ((FLASH_ERASE_BLOCK_SIZE == SZ_64K)
-			  && (size >= SZ_64K)
-			  && ((addr & MASK_64K) == 0)) {
-			/* 64 KiB block erase */
-			spi_nor_cmd_addr_write(dev, SPI_NOR_CMD_BE, addr,
-			NULL, 0);
-			addr += SZ_64K;
-			size -= SZ_64K;
-		} else if ((FLASH_ERASE_BLOCK_SIZE == SZ_32K)
-			  && (size >= SZ_32K)
-			  && ((addr & MASK_32K) == 0)) {
-			/* 32 KiB block erase */
-			spi_nor_cmd_addr_write(dev, SPI_NOR_CMD_BE_32K, addr,
-					       NULL, 0);
-			addr += SZ_32K;
-			size -= SZ_32K;
-		} else if ((size >= params->sector_size) &&
-			  ((addr & (params->sector_size - 1)) == 0)) {
-			/* sector erase */
-			spi_nor_cmd_addr_write(dev, SPI_NOR_CMD_SE, addr,
-					       NULL, 0);
-			addr += params->sector_size;
-			size -= params->sector_size;
+			ret = spi_nor_cmd_write(dev, SPI_NOR_CMD_WREN);
+			if (ret == 0) {
+				ret = spi_nor_cmd_write(dev, SPI_NOR_CMD_CE);
+			}
+
+			size = 0;
 		} else {
-			/* minimal erase size is at least a sector size */
-			SYNC_UNLOCK();
-			return -EINVAL;
+			type = spi_nor_erase_type_find(driver_data, addr,
+						       size);
+			if (!type) {
+				/* minimal erase size is at least a sector */
+				ret = -EINVAL;
+				break;
+			}
+
+			ret = spi_nor_cmd_write(dev, SPI_NOR_CMD_WREN);
+			if (ret == 0) {
+				ret = spi_nor_cmd_addr_write(dev, type->cmd,
+							     addr, NULL, 0);
+			}
+
+			addr += type->size;
+			size -= type->size;
 		}
 
-		spi_nor_wait_until_ready(dev);
+		if (ret == 0) {
+			ret = spi_nor_wait_until_ready(dev);
+		}
+
+		if (ret != 0) {
+			break;
+		}
 	}
 
 	SYNC_UNLOCK();
 
-	return 0;
+	return ret;
 }
 
 static int spi_nor_write_protection_set(struct device *dev, bool write_protect)
@@ -326,6 +371,166 @@ static int spi_nor_write_protection_set(struct device *dev, bool write_protect)
 	return ret;
 }
 
+/**
+ * @brief Set the flash parameters given by the configuration
+ *
+ * @param dev The flash device structure
+ */
+static void spi_nor_set_static_params(struct device *dev)
+{
+	struct spi_nor_data *data = dev->driver_data;
+	const struct spi_nor_config *params = dev->config->config_info;
+
+	data->size = params->sector_size * params->n_sectors;
+	data->page_size = params->page_size;
+
+	(void)memset(data->erase_types, 0, sizeof(data->erase_types));
+	data->erase_types[0].size = SZ_64K;
+	data->erase_types[0].cmd = SPI_NOR_CMD_BE;
+	data->erase_types[1].size = SZ_32K;
+	data->erase_types[1].cmd = SPI_NOR_CMD_BE_32K;
+	data->erase_types[2].size = params->sector_size;
+	data->erase_types[2].cmd = SPI_NOR_CMD_SE;
+}
+
+#if defined(CONFIG_SPI_NOR_SFDP)
+/**
+ * @brief Read the flash parameters from the Basic Flash Parameter Table
+ *
+ * Parameters the table does not describe keep their configured value.
+ *
+ * @param dev The flash device structure
+ * @param en4b Set to the 4-byte address mode entry methods of the flash
+ * @return 0 on success, -ENOTSUP if the flash has no usable SFDP
+ *         parameters, other negative errno code on failure
+ */
+static int spi_nor_sfdp_discover(struct device *dev, u32_t *en4b)
+{
+	struct spi_nor_data *data = dev->driver_data;
+	u8_t hdr[SFDP_HEADER_SIZE + SFDP_PARAM_HEADER_SIZE];
+	u8_t raw[SFDP_BFPT_DWORDS * 4];
+	u32_t bfpt[SFDP_BFPT_DWORDS] = { 0 };
+	const u8_t *param = &hdr[SFDP_HEADER_SIZE];
+	u32_t dwords;
+	u32_t density;
+	u64_t bits;
+	int n = 0;
+
+	if (spi_nor_cmd_addr_read(dev, SPI_NOR_CMD_RDSFDP, 0, 1, hdr,
+				  sizeof(hdr)) != 0) {
+		return -EIO;
+	}
+
+	/* the first parameter header describes the basic table */
+	if ((sys_get_le32(hdr) != SFDP_SIGNATURE) ||
+	    (((param[7] << 8) | param[0]) != SFDP_BFPT_ID) ||
+	    (param[3] < 9)) {
+		return -ENOTSUP;
+	}
+
+	dwords = min(param[3], SFDP_BFPT_DWORDS);
+	if (spi_nor_cmd_addr_read(dev, SPI_NOR_CMD_RDSFDP,
+				  sys_get_le32(&param[4]) & 0xFFFFFF, 1, raw,
+				  dwords * 4) != 0) {
+		return -EIO;
+	}
+
+	for (int i = 0; i < dwords; i++) {
+		bfpt[i] = sys_get_le32(&raw[i * 4]);
+	}
+
+	/* density in bits, or its power of two for parts above 2 Gbit */
+	density = bfpt[1] & ~BIT(31);
+	if (bfpt[1] & BIT(31)) {
+		if (density > 34) {
+			return -ENOTSUP;
+		}
+
+		bits = (u64_t)1 << density;
+	} else {
+		bits = (u64_t)density + 1;
+	}
+
+	data->size = bits / 8;
+
+	/* erase types are kept ordered by size, largest first */
+	(void)memset(data->erase_types, 0, sizeof(data->erase_types));
+	for (int i = 0; i < SPI_NOR_ERASE_TYPES; i++) {
+		u32_t type = bfpt[7 + i / 2] >> (16 * (i % 2));
+		struct spi_nor_erase_type et = {
+			.size = BIT(type & 0xFF),
+			.cmd = (type >> 8) & 0xFF,
+		};
+		int j;
+
+		if ((type & 0xFF) == 0) {
+			continue;
+		}
+
+		for (j = n; j > 0 && data->erase_types[j - 1].size < et.size;
+		     j--) {
+			data->erase_types[j] = data->erase_types[j - 1];
+		}
+
+		data->erase_types[j] = et;
+		n++;
+	}
+
+	if (n == 0) {
+		return -ENOTSUP;
+	}
+
+	/* page size is given since JESD216A */
+	if (dwords >= 11) {
+		data->page_size = BIT((bfpt[10] >> 4) & 0xF);
+	}
+
+	if (SFDP_BFPT_ADDR_MODE(bfpt[0]) == SFDP_BFPT_ADDR_4B) {
+		data->addr_len = 4;
+	}
+
+	if (dwords >= 16) {
+		*en4b = bfpt[15];
+	}
+
+	return 0;
+}
+#endif /* CONFIG_SPI_NOR_SFDP */
+
+/**
+ * @brief Switch a flash above 16 MiB to 4-byte addresses
+ *
+ * @param dev The flash device structure
+ * @param en4b The 4-byte address mode entry methods of the flash
+ * @return 0 on success, negative errno code otherwise
+ */
+static int spi_nor_enter_4b(struct device *dev, u32_t en4b)
+{
+	struct spi_nor_data *data = dev->driver_data;
+
+	if ((data->size <= SPI_NOR_3B_ADDR_MAX) || (data->addr_len == 4)) {
+		return 0;
+	}
+
+	if (!(en4b & (SFDP_BFPT_4B_ENTRY_EN4B |
+		      SFDP_BFPT_4B_ENTRY_WREN_EN4B))) {
+		return -ENOTSUP;
+	}
+
+	if ((en4b & SFDP_BFPT_4B_ENTRY_WREN_EN4B) &&
+	    (spi_nor_cmd_write(dev, SPI_NOR_CMD_WREN) != 0)) {
+		return -EIO;
+	}
+
+	if (spi_nor_cmd_write(dev, SPI_NOR_CMD_EN4B) != 0) {
+		return -EIO;
+	}
+
+	data->addr_len = 4;
+
+	return 0;
+}
+
 /**
  * @brief Configure the flash
  *
@@ -337,6 +542,8 @@ static int spi_nor_configure(struct device *dev)
 {
 	struct spi_nor_data *data = dev->driver_data;
 	const struct spi_nor_config *params = dev->config->config_info;
+	u32_t en4b = SFDP_BFPT_4B_ENTRY_EN4B;
+	int ret;
 
 	data->spi = device_get_binding(DT_SPI_NOR_SPI_NAME);
 	if (!data->spi) {
@@ -365,6 +572,33 @@ static int spi_nor_configure(struct device *dev)
 		return -ENODEV;
 	}
 
+	data->addr_len = 3;
+	spi_nor_set_static_params(dev);
+
+#if defined(CONFIG_SPI_NOR_SFDP)
+	ret = spi_nor_sfdp_discover(dev, &en4b);
+	if (ret == -ENOTSUP) {
+		/* flash without SFDP keeps the configured parameters */
+		data->addr_len = 3;
+		spi_nor_set_static_params(dev);
+	} else if (ret != 0) {
+		return ret;
+	}
+#endif
+
+	if ((data->size == 0) || (data->page_size == 0)) {
+		return -EINVAL;
+	}
+
+	ret = spi_nor_enter_4b(dev, en4b);
+	if (ret != 0) {
+		return ret;
+	}
+
+#if defined(CONFIG_FLASH_PAGE_LAYOUT)
+	data->layout.pages_count = data->size / FLASH_ERASE_BLOCK_SIZE;
+	data->layout.pages_size = FLASH_ERASE_BLOCK_SIZE;
+#endif
 
 	return 0;
 }
@@ -383,16 +617,13 @@ static int spi_nor_init(struct device *dev)
 }
 
 #if defined(CONFIG_FLASH_PAGE_LAYOUT)
-static const struct flash_pages_layout dev_layout = {
-	.pages_count = KB(CONFIG_FLASH_SIZE) / FLASH_ERASE_BLOCK_SIZE,
-	.pages_size = FLASH_ERASE_BLOCK_SIZE,
-};
-
 static void spi_nor_pages_layout(struct device *dev,
 				const struct flash_pages_layout **layout,
 				size_t *layout_size)
 {
-	*layout = &dev_layout;
+	struct spi_nor_data *const driver_data = dev->driver_data;
+
+	*layout = &driver_data->layout;
 	*layout_size = 1;
 }
 #endif /* CONFIG_FLASH_PAGE_LAYOUT */
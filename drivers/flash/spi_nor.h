@@ -10,6 +10,7 @@
 #include <misc/util.h>
 
 #define SPI_NOR_MAX_ID_LEN	3
+#define SPI_NOR_ERASE_TYPES	4
 
 struct spi_nor_config {
 	u8_t id[SPI_NOR_MAX_ID_LEN];
@@ -18,6 +19,12 @@ struct spi_nor_config {
 	u32_t n_sectors;
 };
 
+/* An erase instruction and the size of the area it erases */
+struct spi_nor_erase_type {
+	u32_t size;
+	u8_t cmd;
+};
+
 /* Status register bits */
 #define SPI_NOR_WIP_BIT         BIT(0)  /* Write in progress */
 #define SPI_NOR_WEL_BIT         BIT(1)  /* Write enable latch */
@@ -26,6 +33,7 @@ struct spi_nor_config {
 #define SPI_NOR_CMD_WRSR        0x01    /* Write status register */
 #define SPI_NOR_CMD_RDSR        0x05    /* Read status register */
 #define SPI_NOR_CMD_READ        0x03    /* Read data */
+#define SPI_NOR_CMD_FAST_READ   0x0B    /* Read data at higher speed */
 #define SPI_NOR_CMD_WREN        0x06    /* Write enable */
 #define SPI_NOR_CMD_WRDI        0x04    /* Write disable */
 #define SPI_NOR_CMD_PP          0x02    /* Page program */
@@ -34,5 +42,23 @@ struct spi_nor_config {
 #define SPI_NOR_CMD_BE          0xD8    /* Block erase */
 #define SPI_NOR_CMD_CE          0xC7    /* Chip erase */
 #define SPI_NOR_CMD_RDID        0x9F    /* Read JEDEC ID */
+#define SPI_NOR_CMD_RDSFDP      0x5A    /* Read SFDP parameters */
+#define SPI_NOR_CMD_EN4B        0xB7    /* Enter 4-byte address mode */
+
+/* Serial Flash Discoverable Parameters, JESD216 */
+#define SFDP_SIGNATURE          0x50444653      /* "SFDP" */
+#define SFDP_HEADER_SIZE        8
+#define SFDP_PARAM_HEADER_SIZE  8
+#define SFDP_BFPT_ID            0xFF00  /* Basic Flash Parameter Table */
+/* Dwords of the Basic Flash Parameter Table used by the driver */
+#define SFDP_BFPT_DWORDS        16
+#define SFDP_BFPT_ADDR_MODE(dw1)        (((dw1) >> 17) & 0x3)
+#define SFDP_BFPT_ADDR_3B_4B    1       /* 3-byte, 4-byte on request */
+#define SFDP_BFPT_ADDR_4B       2       /* 4-byte only */
+#define SFDP_BFPT_4B_ENTRY_EN4B         BIT(24) /* EN4B enters 4B mode */
+#define SFDP_BFPT_4B_ENTRY_WREN_EN4B    BIT(25) /* WREN, then EN4B */
+
+/* Parts above 16 MiB need 4-byte addresses */
+#define SPI_NOR_3B_ADDR_MAX     0x1000000
 
 #endif /*__SPI_NOR_H__*/
@@ -14,6 +14,8 @@
 #include <sys/select.h>
 #include <unistd.h>
 
+#include <kernel.h>
+
 #include "uart.h"
 #include "cmdline.h" /* native_posix command line options header */
 #include "soc.h"
@@ -30,6 +32,12 @@
  *
  * When connected to its own pseudo terminal, it may also auto attach a terminal
  * emulator to it, if set so from command line.
+ *
+ * With CONFIG_UART_ASYNC_API the driver also implements the asynchronous API.
+ * There is no UART interrupt in this board, so transfers are carried out by
+ * work items on the system work queue: TX writes the whole buffer to the file
+ * descriptor and RX polls it every CONFIG_UART_NATIVE_POSIX_ASYNC_POLL_MS.
+ * Event callbacks are called from the system work queue thread.
  */
 
 static int np_uart_stdin_poll_in(struct device *dev, unsigned char *p_char);
@@ -41,14 +49,62 @@ static bool auto_attach;
 static const char default_cmd[] = CONFIG_NATIVE_UART_AUTOATTACH_DEFAULT_CMD;
 static char *auto_attach_cmd;
 
+#ifdef CONFIG_UART_ASYNC_API
+static int np_uart_callback_set(struct device *dev, uart_callback_t callback,
+				void *user_data);
+static int np_uart_tx(struct device *dev, const u8_t *buf, size_t len,
+		      u32_t timeout);
+static int np_uart_tx_abort(struct device *dev);
+static int np_uart_rx_enable(struct device *dev, u8_t *buf, size_t len,
+			     u32_t timeout);
+static int np_uart_rx_buf_rsp(struct device *dev, u8_t *buf, size_t len);
+static int np_uart_rx_disable(struct device *dev);
+static void np_uart_tx_work(struct k_work *work);
+static void np_uart_rx_work(struct k_work *work);
+#endif
+
 static struct uart_driver_api np_uart_driver_api = {
 	.poll_out = np_uart_poll_out,
 	.poll_in = np_uart_tty_poll_in,
+#ifdef CONFIG_UART_ASYNC_API
+	.callback_set = np_uart_callback_set,
+	.tx = np_uart_tx,
+	.tx_abort = np_uart_tx_abort,
+	.rx_enable = np_uart_rx_enable,
+	.rx_buf_rsp = np_uart_rx_buf_rsp,
+	.rx_disable = np_uart_rx_disable,
+#endif
+};
+
+#ifdef CONFIG_UART_ASYNC_API
+struct native_uart_async {
+	struct device *dev;
+	uart_callback_t callback;
+	void *user_data;
+
+	struct k_delayed_work tx_work;
+	const u8_t *tx_buf;
+	size_t tx_len;
+	size_t tx_cnt;
+
+	struct k_delayed_work rx_work;
+	u8_t *rx_buf;
+	size_t rx_len;
+	size_t rx_cnt; /* Bytes received to current buffer */
+	size_t rx_offset; /* Bytes already reported with UART_RX_RDY */
+	u8_t *rx_next_buf;
+	size_t rx_next_len;
+	u32_t rx_timeout;
+	s64_t rx_last; /* Uptime of the last received byte */
 };
+#endif
 
 struct native_uart_status {
 	int out_fd; /* File descriptor used for output */
 	int in_fd; /* File descriptor used for input */
+#ifdef CONFIG_UART_ASYNC_API
+	struct native_uart_async async;
+#endif
 };
 
 #define ERROR posix_print_error_and_exit
@@ -167,6 +223,12 @@ static int np_uart_init(struct device *dev)
 
 	d = (struct native_uart_status *)dev->driver_data;
 
+#ifdef CONFIG_UART_ASYNC_API
+	d->async.dev = dev;
+	k_delayed_work_init(&d->async.tx_work, np_uart_tx_work);
+	k_delayed_work_init(&d->async.rx_work, np_uart_rx_work);
+#endif
+
 	if (IS_ENABLED(CONFIG_NATIVE_UART_0_ON_OWN_PTY)) {
 		int tty_fn = open_tty();
 
@@ -281,6 +343,314 @@ static int np_uart_tty_poll_in(struct device *dev, unsigned char *p_char)
 	return 0;
 }
 
+#ifdef CONFIG_UART_ASYNC_API
+
+#define ASYNC_POLL_PERIOD K_MSEC(CONFIG_UART_NATIVE_POSIX_ASYNC_POLL_MS)
+
+static inline struct native_uart_async *get_async(struct device *dev)
+{
+	return &((struct native_uart_status *)dev->driver_data)->async;
+}
+
+static void async_evt(struct native_uart_async *a, struct uart_event *evt)
+{
+	if (a->callback) {
+		a->callback(evt, a->user_data);
+	}
+}
+
+static int np_uart_callback_set(struct device *dev, uart_callback_t callback,
+				void *user_data)
+{
+	struct native_uart_async *a = get_async(dev);
+
+	a->callback = callback;
+	a->user_data = user_data;
+
+	return 0;
+}
+
+/*
+ * Write as much of the pending TX buffer as the file descriptor accepts and
+ * reschedule if the pseudoterminal is full.
+ */
+static void np_uart_tx_work(struct k_work *work)
+{
+	struct native_uart_async *a =
+		CONTAINER_OF(work, struct native_uart_async, tx_work);
+	struct native_uart_status *d = a->dev->driver_data;
+	struct uart_event evt;
+	int ret;
+
+	if (!a->tx_buf) {
+		return;
+	}
+
+	while (a->tx_cnt < a->tx_len) {
+		ret = write(d->out_fd, a->tx_buf + a->tx_cnt,
+			    a->tx_len - a->tx_cnt);
+		if (ret <= 0) {
+			if (ret < 0 && errno != EAGAIN) {
+				WARN("%s: data could not be output\n",
+				     __func__);
+				break;
+			}
+
+			k_delayed_work_submit(&a->tx_work, ASYNC_POLL_PERIOD);
+			return;
+		}
+
+		a->tx_cnt += ret;
+	}
+
+	evt.type = (a->tx_cnt == a->tx_len) ? UART_TX_DONE : UART_TX_ABORTED;
+	evt.data.tx.buf = a->tx_buf;
+	evt.data.tx.len = a->tx_cnt;
+	a->tx_buf = NULL;
+
+	async_evt(a, &evt);
+}
+
+static int np_uart_tx(struct device *dev, const u8_t *buf, size_t len,
+		      u32_t timeout)
+{
+	struct native_uart_async *a = get_async(dev);
+	unsigned int key = irq_lock();
+
+	if (a->tx_buf) {
+		irq_unlock(key);
+		return -EBUSY;
+	}
+
+	a->tx_buf = buf;
+	a->tx_len = len;
+	a->tx_cnt = 0;
+	irq_unlock(key);
+
+	k_delayed_work_submit(&a->tx_work, K_NO_WAIT);
+
+	return 0;
+}
+
+static int np_uart_tx_abort(struct device *dev)
+{
+	struct native_uart_async *a = get_async(dev);
+	struct uart_event evt;
+	unsigned int key = irq_lock();
+
+	if (!a->tx_buf) {
+		irq_unlock(key);
+		return -EFAULT;
+	}
+
+	/* Work already queued finds no buffer and does nothing. */
+	k_delayed_work_cancel(&a->tx_work);
+
+	evt.type = UART_TX_ABORTED;
+	evt.data.tx.buf = a->tx_buf;
+	evt.data.tx.len = a->tx_cnt;
+	a->tx_buf = NULL;
+	irq_unlock(key);
+
+	async_evt(a, &evt);
+
+	return 0;
+}
+
+static int np_uart_read(struct device *dev, u8_t *buf, size_t len)
+{
+	struct native_uart_status *d = dev->driver_data;
+	int ret;
+
+	if (!IS_ENABLED(CONFIG_NATIVE_UART_0_ON_OWN_PTY)) {
+		static struct timeval timeout; /* just zero */
+		fd_set readfds;
+
+		if (feof(stdin)) {
+			return 0;
+		}
+
+		FD_ZERO(&readfds);
+		FD_SET(d->in_fd, &readfds);
+
+		if (select(d->in_fd + 1, &readfds, NULL, NULL, &timeout) <= 0) {
+			return 0;
+		}
+	}
+
+	ret = read(d->in_fd, buf, len);
+
+	return (ret < 0) ? 0 : ret;
+}
+
+static void rx_rdy(struct native_uart_async *a)
+{
+	struct uart_event evt;
+
+	if (a->rx_cnt == a->rx_offset) {
+		return;
+	}
+
+	evt.type = UART_RX_RDY;
+	evt.data.rx.buf = a->rx_buf;
+	evt.data.rx.offset = a->rx_offset;
+	evt.data.rx.len = a->rx_cnt - a->rx_offset;
+	a->rx_offset = a->rx_cnt;
+
+	async_evt(a, &evt);
+}
+
+static void rx_buf_release(struct native_uart_async *a, u8_t **buf)
+{
+	struct uart_event evt = {
+		.type = UART_RX_BUF_RELEASED,
+		.data.rx_buf.buf = *buf,
+	};
+
+	if (*buf) {
+		*buf = NULL;
+		async_evt(a, &evt);
+	}
+}
+
+static void rx_disabled(struct native_uart_async *a)
+{
+	struct uart_event evt = {
+		.type = UART_RX_DISABLED,
+	};
+
+	a->rx_buf = NULL;
+	async_evt(a, &evt);
+}
+
+static void rx_buf_request(struct native_uart_async *a)
+{
+	struct uart_event evt = {
+		.type = UART_RX_BUF_REQUEST,
+	};
+
+	async_evt(a, &evt);
+}
+
+static void np_uart_rx_work(struct k_work *work)
+{
+	struct native_uart_async *a =
+		CONTAINER_OF(work, struct native_uart_async, rx_work);
+	int ret;
+
+	while (a->rx_buf) {
+		ret = np_uart_read(a->dev, a->rx_buf + a->rx_cnt,
+				   a->rx_len - a->rx_cnt);
+		if (ret == 0) {
+			break;
+		}
+
+		a->rx_cnt += ret;
+		a->rx_last = k_uptime_get();
+
+		if (a->rx_cnt < a->rx_len) {
+			continue;
+		}
+
+		/* Buffer filled, switch to the next one. Reception may be
+		 * disabled from the callback.
+		 */
+		rx_rdy(a);
+		if (!a->rx_buf) {
+			return;
+		}
+
+		rx_buf_release(a, &a->rx_buf);
+
+		if (!a->rx_next_buf) {
+			rx_disabled(a);
+			return;
+		}
+
+		a->rx_buf = a->rx_next_buf;
+		a->rx_len = a->rx_next_len;
+		a->rx_next_buf = NULL;
+		a->rx_cnt = 0;
+		a->rx_offset = 0;
+		rx_buf_request(a);
+	}
+
+	if (!a->rx_buf) {
+		return;
+	}
+
+	if (a->rx_timeout != K_FOREVER &&
+	    k_uptime_get() - a->rx_last >= a->rx_timeout) {
+		rx_rdy(a);
+		if (!a->rx_buf) {
+			return;
+		}
+	}
+
+	k_delayed_work_submit(&a->rx_work, ASYNC_POLL_PERIOD);
+}
+
+static int np_uart_rx_enable(struct device *dev, u8_t *buf, size_t len,
+			     u32_t timeout)
+{
+	struct native_uart_async *a = get_async(dev);
+
+	if (a->rx_buf) {
+		return -EBUSY;
+	}
+
+	a->rx_buf = buf;
+	a->rx_len = len;
+	a->rx_cnt = 0;
+	a->rx_offset = 0;
+	a->rx_next_buf = NULL;
+	a->rx_timeout = timeout;
+	a->rx_last = k_uptime_get();
+
+	rx_buf_request(a);
+	k_delayed_work_submit(&a->rx_work, K_NO_WAIT);
+
+	return 0;
+}
+
+static int np_uart_rx_buf_rsp(struct device *dev, u8_t *buf, size_t len)
+{
+	struct native_uart_async *a = get_async(dev);
+
+	if (!a->rx_buf) {
+		return -EACCES;
+	}
+
+	if (a->rx_next_buf) {
+		return -EBUSY;
+	}
+
+	a->rx_next_buf = buf;
+	a->rx_next_len = len;
+
+	return 0;
+}
+
+static int np_uart_rx_disable(struct device *dev)
+{
+	struct native_uart_async *a = get_async(dev);
+
+	if (!a->rx_buf) {
+		return -EFAULT;
+	}
+
+	k_delayed_work_cancel(&a->rx_work);
+
+	rx_rdy(a);
+	rx_buf_release(a, &a->rx_buf);
+	rx_buf_release(a, &a->rx_next_buf);
+	rx_disabled(a);
+
+	return 0;
+}
+
+#endif /* CONFIG_UART_ASYNC_API */
+
 static struct native_uart_status native_uart_status_0;
 
 DEVICE_AND_API_INIT(uart_native_posix0,
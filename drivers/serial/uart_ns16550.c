@@ -190,6 +190,17 @@
 
 #define IIRC(dev) (DEV_DATA(dev)->iir_cache)
 
+#if defined(CONFIG_UART_INTERRUPT_DRIVEN) || defined(CONFIG_UART_ASYNC_API)
+#define UART_NS16550_IRQ_USED 1
+#endif
+
+/* Number of bytes which can be written to THR once it is empty. */
+#ifdef CONFIG_UART_NS16750
+#define TX_FIFO_SIZE 64
+#else
+#define TX_FIFO_SIZE 16
+#endif
+
 #ifdef UART_NS16550_ACCESS_IOPORT
 #define INBYTE(x) sys_in8(x)
 #define OUTBYTE(x, d) sys_out8(d, x)
@@ -208,11 +219,35 @@
 struct uart_ns16550_device_config {
 	u32_t sys_clk_freq;
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 	uart_irq_config_func_t	irq_config_func;
 #endif
 };
 
+#ifdef CONFIG_UART_ASYNC_API
+/** Asynchronous API state, buffers are serviced from the ISR. */
+struct uart_ns16550_async {
+	struct device *dev;
+	uart_callback_t cb;	/**< Event handler */
+	void *cb_data;		/**< Event handler argument */
+
+	const u8_t *tx_buf;	/**< Current TX buffer, NULL if idle */
+	size_t tx_len;
+	size_t tx_cnt;		/**< Bytes written to the FIFO */
+	u32_t tx_timeout;
+	struct k_delayed_work tx_timeout_work;
+
+	u8_t *rx_buf;		/**< Current RX buffer, NULL if disabled */
+	size_t rx_len;
+	size_t rx_cnt;		/**< Bytes received to current buffer */
+	size_t rx_offset;	/**< Bytes already reported */
+	u8_t *rx_next_buf;
+	size_t rx_next_len;
+	u32_t rx_timeout;
+	struct k_delayed_work rx_timeout_work;
+};
+#endif
+
 /** Device data structure */
 struct uart_ns16550_dev_data_t {
 	u32_t port;
@@ -229,6 +264,10 @@ struct uart_ns16550_dev_data_t {
 	void *cb_data;	/**< Callback function arg */
 #endif
 
+#ifdef CONFIG_UART_ASYNC_API
+	struct uart_ns16550_async async;
+#endif
+
 #ifdef CONFIG_UART_NS16550_DLF
 	u8_t dlf;		/**< DLF value */
 #endif
@@ -300,6 +339,10 @@ static inline int ns16550_pci_uart_scan(struct device *dev)
 
 #endif /* CONFIG_UART_NS16550_PCI */
 
+#ifdef CONFIG_UART_ASYNC_API
+static void async_init(struct device *dev);
+#endif
+
 /**
  * @brief Initialize individual UART port
  *
@@ -367,7 +410,11 @@ static int uart_ns16550_init(struct device *dev)
 
 	irq_unlock(old_level);
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef CONFIG_UART_ASYNC_API
+	async_init(dev);
+#endif
+
+#ifdef UART_NS16550_IRQ_USED
 	DEV_CFG(dev)->irq_config_func(dev);
 #endif
 
@@ -623,6 +670,364 @@ static void uart_ns16550_irq_callback_set(struct device *dev,
 	dev_data->cb_data = cb_data;
 }
 
+#endif /* CONFIG_UART_INTERRUPT_DRIVEN */
+
+#ifdef CONFIG_UART_ASYNC_API
+
+/*
+ * The asynchronous API is implemented on top of the FIFO interrupts: the ISR
+ * moves data between the FIFOs and the user buffers and reports events once a
+ * buffer is completed, so the caller does not handle individual characters.
+ */
+
+static void async_evt(struct uart_ns16550_async *async,
+		      struct uart_event *evt)
+{
+	if (async->cb) {
+		async->cb(evt, async->cb_data);
+	}
+}
+
+static void async_tx_done(struct device *dev, enum uart_event_type type)
+{
+	struct uart_ns16550_async *async = &DEV_DATA(dev)->async;
+	struct uart_event evt = {
+		.type = type,
+		.data.tx.buf = async->tx_buf,
+		.data.tx.len = async->tx_cnt,
+	};
+
+	OUTBYTE(IER(dev), INBYTE(IER(dev)) & (~IER_TBE));
+	async->tx_buf = NULL;
+
+	async_evt(async, &evt);
+}
+
+static void async_rx_rdy(struct uart_ns16550_async *async)
+{
+	struct uart_event evt;
+
+	if (async->rx_cnt == async->rx_offset) {
+		return;
+	}
+
+	evt.type = UART_RX_RDY;
+	evt.data.rx.buf = async->rx_buf;
+	evt.data.rx.offset = async->rx_offset;
+	evt.data.rx.len = async->rx_cnt - async->rx_offset;
+	async->rx_offset = async->rx_cnt;
+
+	async_evt(async, &evt);
+}
+
+static void async_rx_buf_release(struct uart_ns16550_async *async, u8_t **buf)
+{
+	struct uart_event evt = {
+		.type = UART_RX_BUF_RELEASED,
+		.data.rx_buf.buf = *buf,
+	};
+
+	if (*buf) {
+		*buf = NULL;
+		async_evt(async, &evt);
+	}
+}
+
+static void async_rx_buf_request(struct uart_ns16550_async *async)
+{
+	struct uart_event evt = {
+		.type = UART_RX_BUF_REQUEST,
+	};
+
+	async_evt(async, &evt);
+}
+
+/* Release all buffers and report that reception is disabled. */
+static void async_rx_disable(struct device *dev)
+{
+	struct uart_ns16550_async *async = &DEV_DATA(dev)->async;
+	struct uart_event evt = {
+		.type = UART_RX_DISABLED,
+	};
+
+	OUTBYTE(IER(dev), INBYTE(IER(dev)) & ~(IER_RXRDY | IER_LSR));
+	k_delayed_work_cancel(&async->rx_timeout_work);
+
+	async_rx_buf_release(async, &async->rx_buf);
+	async_rx_buf_release(async, &async->rx_next_buf);
+
+	async_evt(async, &evt);
+}
+
+static enum uart_rx_stop_reason lsr_to_reason(u8_t lsr)
+{
+	if (lsr & LSR_BI) {
+		return UART_BREAK;
+	} else if (lsr & LSR_OE) {
+		return UART_ERROR_OVERRUN;
+	} else if (lsr & LSR_PE) {
+		return UART_ERROR_PARITY;
+	}
+
+	return UART_ERROR_FRAMING;
+}
+
+static void async_rx_error(struct device *dev, u8_t lsr)
+{
+	struct uart_ns16550_async *async = &DEV_DATA(dev)->async;
+	struct uart_event evt = {
+		.type = UART_RX_STOPPED,
+		.data.rx_stop.reason = lsr_to_reason(lsr),
+		.data.rx_stop.data.buf = async->rx_buf,
+		.data.rx_stop.data.offset = async->rx_offset,
+		.data.rx_stop.data.len = async->rx_cnt - async->rx_offset,
+	};
+
+	async_evt(async, &evt);
+	async_rx_disable(dev);
+}
+
+static void async_rx_isr(struct device *dev)
+{
+	struct uart_ns16550_async *async = &DEV_DATA(dev)->async;
+	bool received = false;
+	u8_t lsr;
+
+	while (async->rx_buf && ((lsr = INBYTE(LSR(dev))) & LSR_RXRDY)) {
+		if (lsr & LSR_EOB_MASK) {
+			async_rx_error(dev, lsr);
+			return;
+		}
+
+		async->rx_buf[async->rx_cnt++] = INBYTE(RDR(dev));
+		received = true;
+
+		if (async->rx_cnt < async->rx_len) {
+			continue;
+		}
+
+		/* Buffer filled, continue with the next one if provided.
+		 * Reception may be disabled from the callback.
+		 */
+		async_rx_rdy(async);
+		if (!async->rx_buf) {
+			return;
+		}
+
+		async_rx_buf_release(async, &async->rx_buf);
+
+		if (!async->rx_next_buf) {
+			async_rx_disable(dev);
+			return;
+		}
+
+		async->rx_buf = async->rx_next_buf;
+		async->rx_len = async->rx_next_len;
+		async->rx_next_buf = NULL;
+		async->rx_cnt = 0U;
+		async->rx_offset = 0U;
+		async_rx_buf_request(async);
+	}
+
+	if (!received || !async->rx_buf) {
+		return;
+	}
+
+	if (async->rx_timeout == K_NO_WAIT) {
+		async_rx_rdy(async);
+	} else if (async->rx_timeout != K_FOREVER) {
+		/* Timeout is counted from the last received byte. */
+		k_delayed_work_submit(&async->rx_timeout_work,
+				      async->rx_timeout);
+	}
+}
+
+static void async_tx_isr(struct device *dev)
+{
+	struct uart_ns16550_async *async = &DEV_DATA(dev)->async;
+	size_t chunk;
+
+	if (!async->tx_buf || (INBYTE(LSR(dev)) & LSR_THRE) == 0) {
+		return;
+	}
+
+	if (async->tx_cnt == async->tx_len) {
+		k_delayed_work_cancel(&async->tx_timeout_work);
+		async_tx_done(dev, UART_TX_DONE);
+		return;
+	}
+
+	/* THR empty means that the whole TX FIFO can be filled. */
+	chunk = min(async->tx_len - async->tx_cnt, TX_FIFO_SIZE);
+	for (size_t i = 0; i < chunk; i++) {
+		OUTBYTE(THR(dev), async->tx_buf[async->tx_cnt++]);
+	}
+}
+
+static void uart_ns16550_async_isr(struct device *dev)
+{
+	/* Reading IIR acknowledges THRE interrupt. */
+	while ((INBYTE(IIR(dev)) & IIR_NIP) == 0) {
+		async_rx_isr(dev);
+		async_tx_isr(dev);
+	}
+}
+
+static void async_rx_timeout(struct k_work *work)
+{
+	struct uart_ns16550_async *async =
+		CONTAINER_OF(work, struct uart_ns16550_async, rx_timeout_work);
+	unsigned int key = irq_lock();
+
+	if (async->rx_buf) {
+		async_rx_rdy(async);
+	}
+
+	irq_unlock(key);
+}
+
+static void async_tx_timeout(struct k_work *work)
+{
+	struct uart_ns16550_async *async =
+		CONTAINER_OF(work, struct uart_ns16550_async, tx_timeout_work);
+
+	(void)uart_tx_abort(async->dev);
+}
+
+static void async_init(struct device *dev)
+{
+	struct uart_ns16550_async *async = &DEV_DATA(dev)->async;
+
+	async->dev = dev;
+	k_delayed_work_init(&async->rx_timeout_work, async_rx_timeout);
+	k_delayed_work_init(&async->tx_timeout_work, async_tx_timeout);
+}
+
+static int uart_ns16550_callback_set(struct device *dev,
+				     uart_callback_t callback,
+				     void *user_data)
+{
+	struct uart_ns16550_async *async = &DEV_DATA(dev)->async;
+
+	async->cb = callback;
+	async->cb_data = user_data;
+
+	return 0;
+}
+
+static int uart_ns16550_tx(struct device *dev, const u8_t *buf, size_t len,
+			   u32_t timeout)
+{
+	struct uart_ns16550_dev_data_t * const dev_data = DEV_DATA(dev);
+	struct uart_ns16550_async *async = &dev_data->async;
+	unsigned int key = irq_lock();
+
+	if (async->tx_buf) {
+		irq_unlock(key);
+		return -EBUSY;
+	}
+
+	async->tx_buf = buf;
+	async->tx_len = len;
+	async->tx_cnt = 0U;
+
+	/* Timeout is valid only with flow control. */
+	if ((dev_data->options & UART_OPTION_AFCE) &&
+	    timeout != K_FOREVER) {
+		k_delayed_work_submit(&async->tx_timeout_work, timeout);
+	}
+
+	/* Interrupt is raised immediately if THR is empty. */
+	OUTBYTE(IER(dev), INBYTE(IER(dev)) | IER_TBE);
+	irq_unlock(key);
+
+	return 0;
+}
+
+static int uart_ns16550_tx_abort(struct device *dev)
+{
+	struct uart_ns16550_async *async = &DEV_DATA(dev)->async;
+	unsigned int key = irq_lock();
+
+	if (!async->tx_buf) {
+		irq_unlock(key);
+		return -EFAULT;
+	}
+
+	k_delayed_work_cancel(&async->tx_timeout_work);
+	async_tx_done(dev, UART_TX_ABORTED);
+	irq_unlock(key);
+
+	return 0;
+}
+
+static int uart_ns16550_rx_enable(struct device *dev, u8_t *buf, size_t len,
+				  u32_t timeout)
+{
+	struct uart_ns16550_async *async = &DEV_DATA(dev)->async;
+	unsigned int key = irq_lock();
+
+	if (async->rx_buf) {
+		irq_unlock(key);
+		return -EBUSY;
+	}
+
+	async->rx_buf = buf;
+	async->rx_len = len;
+	async->rx_cnt = 0U;
+	async->rx_offset = 0U;
+	async->rx_next_buf = NULL;
+	async->rx_timeout = timeout;
+
+	async_rx_buf_request(async);
+
+	OUTBYTE(IER(dev), INBYTE(IER(dev)) | IER_RXRDY | IER_LSR);
+	irq_unlock(key);
+
+	return 0;
+}
+
+static int uart_ns16550_rx_buf_rsp(struct device *dev, u8_t *buf, size_t len)
+{
+	struct uart_ns16550_async *async = &DEV_DATA(dev)->async;
+	unsigned int key = irq_lock();
+	int err = 0;
+
+	if (!async->rx_buf) {
+		err = -EACCES;
+	} else if (async->rx_next_buf) {
+		err = -EBUSY;
+	} else {
+		async->rx_next_buf = buf;
+		async->rx_next_len = len;
+	}
+
+	irq_unlock(key);
+
+	return err;
+}
+
+static int uart_ns16550_rx_disable(struct device *dev)
+{
+	struct uart_ns16550_async *async = &DEV_DATA(dev)->async;
+	unsigned int key = irq_lock();
+
+	if (!async->rx_buf) {
+		irq_unlock(key);
+		return -EFAULT;
+	}
+
+	async_rx_rdy(async);
+	async_rx_disable(dev);
+	irq_unlock(key);
+
+	return 0;
+}
+
+#endif /* CONFIG_UART_ASYNC_API */
+
+#ifdef UART_NS16550_IRQ_USED
+
 /**
  * @brief Interrupt service routine.
  *
@@ -635,14 +1040,19 @@ static void uart_ns16550_irq_callback_set(struct device *dev,
 static void uart_ns16550_isr(void *arg)
 {
 	struct device *dev = arg;
+
+#ifdef CONFIG_UART_ASYNC_API
+	uart_ns16550_async_isr(dev);
+#else
 	struct uart_ns16550_dev_data_t * const dev_data = DEV_DATA(dev);
 
 	if (dev_data->cb) {
 		dev_data->cb(dev_data->cb_data);
 	}
+#endif
 }
 
-#endif /* CONFIG_UART_INTERRUPT_DRIVEN */
+#endif /* UART_NS16550_IRQ_USED */
 
 #ifdef CONFIG_UART_NS16550_LINE_CTRL
 
@@ -741,6 +1151,15 @@ static const struct uart_driver_api uart_ns16550_driver_api = {
 
 #endif
 
+#ifdef CONFIG_UART_ASYNC_API
+	.callback_set = uart_ns16550_callback_set,
+	.tx = uart_ns16550_tx,
+	.tx_abort = uart_ns16550_tx_abort,
+	.rx_enable = uart_ns16550_rx_enable,
+	.rx_buf_rsp = uart_ns16550_rx_buf_rsp,
+	.rx_disable = uart_ns16550_rx_disable,
+#endif
+
 #ifdef CONFIG_UART_NS16550_LINE_CTRL
 	.line_ctrl_set = uart_ns16550_line_ctrl_set,
 #endif
@@ -752,14 +1171,14 @@ static const struct uart_driver_api uart_ns16550_driver_api = {
 
 #ifdef CONFIG_UART_NS16550_PORT_0
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 static void irq_config_func_0(struct device *port);
 #endif
 
 static const struct uart_ns16550_device_config uart_ns16550_dev_cfg_0 = {
 	.sys_clk_freq = DT_UART_NS16550_PORT_0_CLK_FREQ,
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 	.irq_config_func = irq_config_func_0,
 #endif
 };
@@ -789,7 +1208,7 @@ DEVICE_AND_API_INIT(uart_ns16550_0, CONFIG_UART_NS16550_PORT_0_NAME, &uart_ns165
 		    PRE_KERNEL_1, CONFIG_KERNEL_INIT_PRIORITY_DEVICE,
 		    &uart_ns16550_driver_api);
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 static void irq_config_func_0(struct device *dev)
 {
 	ARG_UNUSED(dev);
@@ -806,14 +1225,14 @@ static void irq_config_func_0(struct device *dev)
 
 #ifdef CONFIG_UART_NS16550_PORT_1
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 static void irq_config_func_1(struct device *port);
 #endif
 
 static const struct uart_ns16550_device_config uart_ns16550_dev_cfg_1 = {
 	.sys_clk_freq = DT_UART_NS16550_PORT_1_CLK_FREQ,
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 	.irq_config_func = irq_config_func_1,
 #endif
 };
@@ -843,7 +1262,7 @@ DEVICE_AND_API_INIT(uart_ns16550_1, CONFIG_UART_NS16550_PORT_1_NAME, &uart_ns165
 		    PRE_KERNEL_1, CONFIG_KERNEL_INIT_PRIORITY_DEVICE,
 		    &uart_ns16550_driver_api);
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 static void irq_config_func_1(struct device *dev)
 {
 	ARG_UNUSED(dev);
@@ -860,14 +1279,14 @@ static void irq_config_func_1(struct device *dev)
 
 #ifdef CONFIG_UART_NS16550_PORT_2
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 static void irq_config_func_2(struct device *port);
 #endif
 
 static const struct uart_ns16550_device_config uart_ns16550_dev_cfg_2 = {
 	.sys_clk_freq = DT_UART_NS16550_PORT_2_CLK_FREQ,
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 	.irq_config_func = irq_config_func_2,
 #endif
 };
@@ -897,7 +1316,7 @@ DEVICE_AND_API_INIT(uart_ns16550_2, DT_UART_NS16550_PORT_2_NAME, &uart_ns16550_i
 		    PRE_KERNEL_1, CONFIG_KERNEL_INIT_PRIORITY_DEVICE,
 		    &uart_ns16550_driver_api);
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 static void irq_config_func_2(struct device *dev)
 {
 	ARG_UNUSED(dev);
@@ -914,14 +1333,14 @@ static void irq_config_func_2(struct device *dev)
 
 #ifdef CONFIG_UART_NS16550_PORT_3
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 static void irq_config_func_3(struct device *port);
 #endif
 
 static const struct uart_ns16550_device_config uart_ns16550_dev_cfg_3 = {
 	.sys_clk_freq = CONFIG_UART_NS16550_PORT_3_CLK_FREQ,
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 	.irq_config_func = irq_config_func_3,
 #endif
 };
@@ -951,7 +1370,7 @@ DEVICE_AND_API_INIT(uart_ns16550_3, CONFIG_UART_NS16550_PORT_3_NAME, &uart_ns165
 		    PRE_KERNEL_1, CONFIG_KERNEL_INIT_PRIORITY_DEVICE,
 		    &uart_ns16550_driver_api);
 
-#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+#ifdef UART_NS16550_IRQ_USED
 static void irq_config_func_3(struct device *dev)
 {
 	ARG_UNUSED(dev);
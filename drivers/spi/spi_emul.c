@@ -0,0 +1,451 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SPI bus emulator with a JEDEC SPI NOR flash on slave 0. Every byte clocked
+ * on the bus is fed to a model of the flash, which decodes the instruction,
+ * address and dummy bytes and returns data in the same byte slot. The flash
+ * is kept in RAM, programming only clears bits and program and erase
+ * instructions take effect when chip select is released, as on real parts.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <kernel.h>
+#include <device.h>
+#include <init.h>
+#include <spi.h>
+#include <stats.h>
+#include <misc/byteorder.h>
+
+#define NOR_SIZE CONFIG_SPI_EMUL_NOR_SIZE
+#define NOR_PAGE_SIZE 256
+#define NOR_SECTOR_SIZE 0x1000
+#define NOR_3B_ADDR_MAX 0x1000000
+
+#define NOR_SR_WEL BIT(1)
+
+#define NOR_CMD_WRSR 0x01
+#define NOR_CMD_PP 0x02
+#define NOR_CMD_READ 0x03
+#define NOR_CMD_WRDI 0x04
+#define NOR_CMD_RDSR 0x05
+#define NOR_CMD_WREN 0x06
+#define NOR_CMD_FAST_READ 0x0B
+#define NOR_CMD_SE 0x20
+#define NOR_CMD_BE_32K 0x52
+#define NOR_CMD_RDSFDP 0x5A
+#define NOR_CMD_RDID 0x9F
+#define NOR_CMD_EN4B 0xB7
+#define NOR_CMD_CE 0xC7
+#define NOR_CMD_BE 0xD8
+
+/* SFDP header, one parameter header and a JESD216B basic table */
+#define NOR_SFDP_BFPT_DWORDS 16
+#define NOR_SFDP_BFPT_PTP 16
+#define NOR_SFDP_SIZE (NOR_SFDP_BFPT_PTP + NOR_SFDP_BFPT_DWORDS * 4)
+
+BUILD_ASSERT_MSG((NOR_SIZE % 0x10000) == 0,
+		 "Flash size must be a multiple of 64 KiB");
+
+#ifdef CONFIG_SPI_EMUL_STATS
+STATS_SECT_START(spi_emul)
+STATS_SECT_ENTRY64(transactions)
+STATS_SECT_ENTRY64(bytes)
+STATS_SECT_ENTRY64(reads)
+STATS_SECT_ENTRY64(programs)
+STATS_SECT_ENTRY64(erases)
+STATS_SECT_END;
+
+STATS_NAME_START(spi_emul)
+STATS_NAME(spi_emul, transactions)
+STATS_NAME(spi_emul, bytes)
+STATS_NAME(spi_emul, reads)
+STATS_NAME(spi_emul, programs)
+STATS_NAME(spi_emul, erases)
+STATS_NAME_END(spi_emul);
+
+static STATS_SECT_DECL(spi_emul) spi_emul;
+
+#define EMUL_STATS_INC(name) STATS_INC(spi_emul, name)
+#define EMUL_STATS_INCN(name, n) STATS_INCN(spi_emul, name, n)
+#else
+#define EMUL_STATS_INC(name)
+#define EMUL_STATS_INCN(name, n)
+#endif /* CONFIG_SPI_EMUL_STATS */
+
+/* State of the flash within the current transaction */
+struct spi_emul_nor {
+	u8_t cmd;
+	u32_t addr;
+	size_t pos;
+	bool wel;
+	bool addr_4b;
+};
+
+/* Position in a buffer set */
+struct spi_emul_cursor {
+	const struct spi_buf *buf;
+	size_t count;
+	size_t off;
+};
+
+static u8_t nor_mem[NOR_SIZE];
+static u8_t nor_sfdp[NOR_SFDP_SIZE];
+static const u8_t nor_id[] = {
+	(CONFIG_SPI_EMUL_NOR_JEDEC_ID >> 16) & 0xFF,
+	(CONFIG_SPI_EMUL_NOR_JEDEC_ID >> 8) & 0xFF,
+	CONFIG_SPI_EMUL_NOR_JEDEC_ID & 0xFF,
+};
+
+static struct spi_emul_nor nor;
+static struct k_sem spi_emul_lock;
+/* Bus time not waited for yet, in nanoseconds */
+static u64_t bus_time_ns;
+
+static size_t nor_addr_len(u8_t cmd)
+{
+	switch (cmd) {
+	case NOR_CMD_READ:
+	case NOR_CMD_FAST_READ:
+	case NOR_CMD_PP:
+	case NOR_CMD_SE:
+	case NOR_CMD_BE_32K:
+	case NOR_CMD_BE:
+		return nor.addr_4b ? 4 : 3;
+	case NOR_CMD_RDSFDP:
+		return 3;
+	default:
+		return 0;
+	}
+}
+
+static size_t nor_dummy_len(u8_t cmd)
+{
+	return (cmd == NOR_CMD_FAST_READ || cmd == NOR_CMD_RDSFDP) ? 1 : 0;
+}
+
+/* Address of the flash, which wraps around at its end */
+static u8_t *nor_byte(u32_t addr)
+{
+	return &nor_mem[addr % NOR_SIZE];
+}
+
+/* Clock one byte, returns the byte the flash sends in the same slot. */
+static u8_t nor_xfer(u8_t tx)
+{
+	size_t pos = nor.pos++;
+	size_t addr_len = nor_addr_len(nor.cmd);
+	u32_t i;
+
+	if (pos == 0) {
+		nor.cmd = tx;
+		nor.addr = 0;
+		return 0xFF;
+	}
+
+	if (pos <= addr_len) {
+		nor.addr = (nor.addr << 8) | tx;
+		return 0xFF;
+	}
+
+	if (pos < 1 + addr_len + nor_dummy_len(nor.cmd)) {
+		return 0xFF;
+	}
+
+	i = pos - 1 - addr_len - nor_dummy_len(nor.cmd);
+
+	switch (nor.cmd) {
+	case NOR_CMD_RDID:
+		return (i < sizeof(nor_id)) ? nor_id[i] : 0xFF;
+	case NOR_CMD_RDSR:
+		/* instructions complete when chip select is released */
+		return nor.wel ? NOR_SR_WEL : 0;
+	case NOR_CMD_READ:
+	case NOR_CMD_FAST_READ:
+		return *nor_byte(nor.addr + i);
+	case NOR_CMD_RDSFDP:
+		if (!IS_ENABLED(CONFIG_SPI_EMUL_NOR_SFDP) ||
+		    nor.addr + i >= sizeof(nor_sfdp)) {
+			return 0xFF;
+		}
+
+		return nor_sfdp[nor.addr + i];
+	case NOR_CMD_PP:
+		/* the address wraps around within the page */
+		if (nor.wel) {
+			*nor_byte((nor.addr & ~(NOR_PAGE_SIZE - 1)) +
+				  ((nor.addr + i) % NOR_PAGE_SIZE)) &= tx;
+		}
+
+		return 0xFF;
+	default:
+		return 0xFF;
+	}
+}
+
+static void nor_erase(u32_t addr, size_t size)
+{
+	addr &= ~(size - 1);
+	memset(nor_byte(addr), 0xFF, size);
+
+	EMUL_STATS_INC(erases);
+
+	if (CONFIG_SPI_EMUL_NOR_ERASE_TIME_US) {
+		k_busy_wait(CONFIG_SPI_EMUL_NOR_ERASE_TIME_US *
+			    (size / NOR_SECTOR_SIZE));
+	}
+}
+
+/* Chip select is released, the instruction takes effect. */
+static void nor_release(void)
+{
+	bool addressed = nor.pos > nor_addr_len(nor.cmd);
+	bool wel = nor.wel;
+
+	if (nor.pos == 0) {
+		return;
+	}
+
+	nor.pos = 0;
+
+	switch (nor.cmd) {
+	case NOR_CMD_WREN:
+		nor.wel = true;
+		return;
+	case NOR_CMD_WRDI:
+		nor.wel = false;
+		return;
+	case NOR_CMD_EN4B:
+		nor.addr_4b = true;
+		return;
+	case NOR_CMD_READ:
+	case NOR_CMD_FAST_READ:
+		EMUL_STATS_INC(reads);
+		return;
+	case NOR_CMD_PP:
+	case NOR_CMD_WRSR:
+	case NOR_CMD_SE:
+	case NOR_CMD_BE_32K:
+	case NOR_CMD_BE:
+	case NOR_CMD_CE:
+		/* write enable latch is consumed by every write instruction */
+		nor.wel = false;
+		break;
+	default:
+		return;
+	}
+
+	if (!wel) {
+		return;
+	}
+
+	if (nor.cmd == NOR_CMD_PP) {
+		EMUL_STATS_INC(programs);
+
+		if (CONFIG_SPI_EMUL_NOR_PROGRAM_TIME_US) {
+			k_busy_wait(CONFIG_SPI_EMUL_NOR_PROGRAM_TIME_US);
+		}
+	} else if (nor.cmd == NOR_CMD_CE) {
+		nor_erase(0, NOR_SIZE);
+	} else if (addressed && nor.cmd == NOR_CMD_SE) {
+		nor_erase(nor.addr, NOR_SECTOR_SIZE);
+	} else if (addressed && nor.cmd == NOR_CMD_BE_32K) {
+		nor_erase(nor.addr, 0x8000);
+	} else if (addressed && nor.cmd == NOR_CMD_BE) {
+		nor_erase(nor.addr, 0x10000);
+	}
+}
+
+/* Returns the next byte of the buffer set, NULL for a dummy or skipped
+ * byte, and false once the set is exhausted.
+ */
+static bool spi_emul_cursor_next(struct spi_emul_cursor *cur, u8_t **byte)
+{
+	while (cur->count > 0 && cur->off >= cur->buf->len) {
+		cur->buf++;
+		cur->count--;
+		cur->off = 0;
+	}
+
+	if (cur->count == 0) {
+		return false;
+	}
+
+	*byte = cur->buf->buf ? (u8_t *)cur->buf->buf + cur->off : NULL;
+	cur->off++;
+
+	return true;
+}
+
+static void spi_emul_cursor_init(struct spi_emul_cursor *cur,
+				 const struct spi_buf_set *bufs)
+{
+	cur->buf = bufs ? bufs->buffers : NULL;
+	cur->count = (bufs && bufs->buffers) ? bufs->count : 0;
+	cur->off = 0;
+}
+
+/* Busy-wait for the time the bytes take on the bus. */
+static void spi_emul_bus_wait(const struct spi_config *config, size_t bytes)
+{
+	if (config->frequency == 0) {
+		return;
+	}
+
+	bus_time_ns += (u64_t)bytes * 8 * NSEC_PER_SEC / config->frequency;
+	if (bus_time_ns >= NSEC_PER_USEC) {
+		k_busy_wait(bus_time_ns / NSEC_PER_USEC);
+		bus_time_ns %= NSEC_PER_USEC;
+	}
+}
+
+static int spi_emul_transceive(struct device *dev,
+			       const struct spi_config *config,
+			       const struct spi_buf_set *tx_bufs,
+			       const struct spi_buf_set *rx_bufs)
+{
+	struct spi_emul_cursor tx;
+	struct spi_emul_cursor rx;
+	size_t bytes = 0;
+	bool has_tx;
+	bool has_rx;
+	u8_t *tx_byte;
+	u8_t *rx_byte;
+	u8_t out;
+
+	ARG_UNUSED(dev);
+
+	if (config->slave != 0 ||
+	    SPI_OP_MODE_GET(config->operation) != SPI_OP_MODE_MASTER ||
+	    SPI_WORD_SIZE_GET(config->operation) != 8 ||
+	    (config->operation & SPI_LINES_MASK) != SPI_LINES_SINGLE) {
+		return -ENOTSUP;
+	}
+
+	spi_emul_cursor_init(&tx, tx_bufs);
+	spi_emul_cursor_init(&rx, rx_bufs);
+
+	k_sem_take(&spi_emul_lock, K_FOREVER);
+
+	for (;;) {
+		has_tx = spi_emul_cursor_next(&tx, &tx_byte);
+		has_rx = spi_emul_cursor_next(&rx, &rx_byte);
+		if (!has_tx && !has_rx) {
+			break;
+		}
+
+		out = nor_xfer((has_tx && tx_byte) ? *tx_byte : 0);
+		if (has_rx && rx_byte) {
+			*rx_byte = out;
+		}
+
+		bytes++;
+	}
+
+	if (!(config->operation & SPI_HOLD_ON_CS)) {
+		nor_release();
+	}
+
+	EMUL_STATS_INC(transactions);
+	EMUL_STATS_INCN(bytes, bytes);
+
+	spi_emul_bus_wait(config, bytes);
+
+	k_sem_give(&spi_emul_lock);
+
+	return 0;
+}
+
+#ifdef CONFIG_SPI_ASYNC
+static int spi_emul_transceive_async(struct device *dev,
+				     const struct spi_config *config,
+				     const struct spi_buf_set *tx_bufs,
+				     const struct spi_buf_set *rx_bufs,
+				     struct k_poll_signal *async)
+{
+	return -ENOTSUP;
+}
+#endif /* CONFIG_SPI_ASYNC */
+
+static int spi_emul_release(struct device *dev,
+			    const struct spi_config *config)
+{
+	ARG_UNUSED(dev);
+	ARG_UNUSED(config);
+
+	k_sem_take(&spi_emul_lock, K_FOREVER);
+	nor_release();
+	k_sem_give(&spi_emul_lock);
+
+	return 0;
+}
+
+static const struct spi_driver_api spi_emul_api = {
+	.transceive = spi_emul_transceive,
+#ifdef CONFIG_SPI_ASYNC
+	.transceive_async = spi_emul_transceive_async,
+#endif
+	.release = spi_emul_release,
+};
+
+/* Describe the flash in a JESD216B Basic Flash Parameter Table */
+static void nor_sfdp_init(void)
+{
+	u32_t bfpt[NOR_SFDP_BFPT_DWORDS] = { 0 };
+	bool addr_4b = NOR_SIZE > NOR_3B_ADDR_MAX;
+
+	sys_put_le32(0x50444653, &nor_sfdp[0]);
+	nor_sfdp[4] = 6;
+	nor_sfdp[5] = 1;
+	nor_sfdp[6] = 0;
+	nor_sfdp[7] = 0xFF;
+
+	nor_sfdp[8] = 0x00;
+	nor_sfdp[9] = 6;
+	nor_sfdp[10] = 1;
+	nor_sfdp[11] = NOR_SFDP_BFPT_DWORDS;
+	sys_put_le32(NOR_SFDP_BFPT_PTP | (0xFFU << 24), &nor_sfdp[12]);
+
+	/* 4 KiB erase, 3-byte or 4-byte addressing */
+	bfpt[0] = 0x1 | (NOR_CMD_SE << 8) | (addr_4b ? BIT(17) : 0);
+	/* density in bits minus one */
+	bfpt[1] = NOR_SIZE * 8 - 1;
+	/* erase types as power of two of the size and instruction */
+	bfpt[7] = 12 | (NOR_CMD_SE << 8) | (15 << 16) | (NOR_CMD_BE_32K << 24);
+	bfpt[8] = 16 | (NOR_CMD_BE << 8);
+	/* page size as power of two */
+	bfpt[10] = 8 << 4;
+	/* 4-byte address mode is entered with EN4B */
+	bfpt[15] = addr_4b ? BIT(24) : 0;
+
+	for (int i = 0; i < NOR_SFDP_BFPT_DWORDS; i++) {
+		sys_put_le32(bfpt[i], &nor_sfdp[NOR_SFDP_BFPT_PTP + i * 4]);
+	}
+}
+
+static int spi_emul_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	k_sem_init(&spi_emul_lock, 1, 1);
+
+	memset(nor_mem, 0xFF, sizeof(nor_mem));
+	nor_sfdp_init();
+
+#ifdef CONFIG_SPI_EMUL_STATS
+	if (STATS_INIT_AND_REG(spi_emul, STATS_SIZE_64, "spi_emul")) {
+		return -EIO;
+	}
+#endif
+
+	return 0;
+}
+
+DEVICE_AND_API_INIT(spi_emul, CONFIG_SPI_EMUL_DRV_NAME, spi_emul_init,
+		    NULL, NULL, POST_KERNEL, CONFIG_SPI_INIT_PRIORITY,
+		    &spi_emul_api);
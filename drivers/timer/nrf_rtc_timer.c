@@ -13,6 +13,7 @@
 #include <sys_clock.h>
 #include <nrf_rtc.h>
 #include <spinlock.h>
+#include <debug/latency_stats.h>
 
 #define RTC NRF_RTC1
 
@@ -69,6 +70,13 @@ void rtc1_nrf_isr(void *arg)
 
 	u32_t key = irq_lock();
 	u32_t t = counter();
+
+#ifdef CONFIG_LATENCY_STATS
+	/* Counter runs at the cycle rate, compare is when the IRQ was raised */
+	sys_latency_record(SYS_LATENCY_ISR_ENTRY,
+			   counter_sub(t, nrf_rtc_cc_get(RTC, 0)),
+			   rtc1_nrf_isr);
+#endif
 	u32_t dticks = counter_sub(t, last_count) / CYC_PER_TICK;
 
 	last_count += dticks * CYC_PER_TICK;
@@ -43,7 +43,11 @@
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
+#if defined(CONFIG_FS_FATFS_FASTSEEK)
+#define	_USE_FASTSEEK	1
+#else
 #define	_USE_FASTSEEK	0
+#endif
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
@@ -202,7 +206,11 @@
 / System Configurations
 /---------------------------------------------------------------------------*/
 
+#if defined(CONFIG_FS_FATFS_FILE_BUFFER)
+#define	_FS_TINY	0
+#else
 #define	_FS_TINY	1
+#endif
 /* This option switches tiny buffer configuration. (0:Normal or 1:Tiny)
 /  At the tiny configuration, size of file object (FIL) is reduced _MAX_SS bytes.
 /  Instead of private sector buffer eliminated from the file object, common sector
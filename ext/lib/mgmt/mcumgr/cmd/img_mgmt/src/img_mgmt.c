@@ -74,6 +74,118 @@ static struct {
     uint8_t data_sha[IMG_MGMT_DATA_SHA_LEN];
 } img_mgmt_ctxt;
 
+#if IMG_MGMT_UL_REORDER_CHUNKS > 0
+/**
+ * Chunk received ahead of the expected offset, kept until the chunks before
+ * it arrive.  Unused entries have a length of 0.
+ */
+static struct {
+    size_t off;
+    size_t len;
+    uint8_t data[IMG_MGMT_UL_CHUNK_SIZE];
+} img_mgmt_ul_chunks[IMG_MGMT_UL_REORDER_CHUNKS];
+
+static void
+img_mgmt_ul_chunks_reset(void)
+{
+    int i;
+
+    for (i = 0; i < IMG_MGMT_UL_REORDER_CHUNKS; i++) {
+        img_mgmt_ul_chunks[i].len = 0;
+    }
+}
+
+/**
+ * Keeps an upload chunk which is ahead of the expected offset, if there is
+ * room for it.
+ */
+static void
+img_mgmt_ul_chunk_stash(size_t off, const uint8_t *data, size_t len)
+{
+    int free_idx;
+    int i;
+
+    if (len == 0 || off < img_mgmt_ctxt.off ||
+        off + len > img_mgmt_ctxt.len) {
+        return;
+    }
+
+    free_idx = -1;
+    for (i = 0; i < IMG_MGMT_UL_REORDER_CHUNKS; i++) {
+        if (img_mgmt_ul_chunks[i].len == 0) {
+            free_idx = i;
+        } else if (img_mgmt_ul_chunks[i].off == off) {
+            /* Retransmission of a chunk already kept. */
+            return;
+        }
+    }
+
+    if (free_idx >= 0) {
+        img_mgmt_ul_chunks[free_idx].off = off;
+        img_mgmt_ul_chunks[free_idx].len = len;
+        memcpy(img_mgmt_ul_chunks[free_idx].data, data, len);
+    }
+}
+
+/**
+ * Writes the kept chunks which continue the image at the expected offset.
+ */
+static int
+img_mgmt_ul_chunks_drain(void)
+{
+    bool last;
+    bool found;
+    size_t len;
+    int rc;
+    int i;
+
+    do {
+        found = false;
+        for (i = 0; i < IMG_MGMT_UL_REORDER_CHUNKS; i++) {
+            len = img_mgmt_ul_chunks[i].len;
+            if (len == 0 || img_mgmt_ul_chunks[i].off != img_mgmt_ctxt.off) {
+                continue;
+            }
+
+            last = img_mgmt_ctxt.off + len == img_mgmt_ctxt.len;
+            rc = img_mgmt_impl_write_image_data(img_mgmt_ctxt.off,
+                                                img_mgmt_ul_chunks[i].data,
+                                                len, last);
+            img_mgmt_ul_chunks[i].len = 0;
+            if (rc != 0) {
+                return rc;
+            }
+
+            img_mgmt_ctxt.off += len;
+            if (last) {
+                img_mgmt_ctxt.uploading = false;
+                return 0;
+            }
+
+            found = true;
+        }
+    } while (found);
+
+    return 0;
+}
+#else
+static void
+img_mgmt_ul_chunks_reset(void)
+{
+}
+
+static void
+img_mgmt_ul_chunk_stash(size_t off, const uint8_t *data, size_t len)
+{
+}
+
+static int
+img_mgmt_ul_chunks_drain(void)
+{
+    return 0;
+}
+#endif
+
 /**
  * Finds the TLVs in the specified image slot, if any.
  */
@@ -255,6 +367,7 @@ img_mgmt_erase(struct mgmt_ctxt *ctxt)
 
     /* reset uploading information on erase */
     img_mgmt_ctxt.uploading = false;
+    img_mgmt_ul_chunks_reset();
 
     return 0;
 }
@@ -313,14 +426,17 @@ img_mgmt_upload_first_chunk(struct mgmt_ctxt *ctxt, const uint8_t *req_data,
         return MGMT_ERR_ENOMEM;
     }
 
-    rc = img_mgmt_impl_erase_slot();
-    if (rc != 0) {
-        return rc;
+    if (!IMG_MGMT_UL_ERASE_PROGRESSIVELY) {
+        rc = img_mgmt_impl_erase_slot();
+        if (rc != 0) {
+            return rc;
+        }
     }
 
     img_mgmt_ctxt.uploading = true;
     img_mgmt_ctxt.off = 0;
     img_mgmt_ctxt.len = 0;
+    img_mgmt_ul_chunks_reset();
 
     /*
      * We accept SHA trimmed to any length by client since it's up to client
@@ -430,7 +546,10 @@ img_mgmt_upload(struct mgmt_ctxt *ctxt)
         }
 
         if (off != img_mgmt_ctxt.off) {
-            /* Invalid offset.  Drop the data and send the expected offset. */
+            /* Invalid offset.  Keep the data if it is ahead of the expected
+             * offset and send the expected offset.
+             */
+            img_mgmt_ul_chunk_stash(off, img_mgmt_data, data_len);
             return img_mgmt_encode_upload_rsp(ctxt, 0);
         }
     }
@@ -454,6 +573,12 @@ img_mgmt_upload(struct mgmt_ctxt *ctxt)
     if (last) {
         /* Upload complete. */
         img_mgmt_ctxt.uploading = false;
+    } else {
+        /* Chunks received out of order may continue the image now. */
+        rc = img_mgmt_ul_chunks_drain();
+        if (rc != 0) {
+            return rc;
+        }
     }
 
     return img_mgmt_encode_upload_rsp(ctxt, 0);
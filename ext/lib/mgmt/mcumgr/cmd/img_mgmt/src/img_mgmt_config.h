@@ -29,6 +29,10 @@
 #elif defined __ZEPHYR__
 
 #define IMG_MGMT_UL_CHUNK_SIZE  CONFIG_IMG_MGMT_UL_CHUNK_SIZE
+#define IMG_MGMT_UL_REORDER_CHUNKS  CONFIG_IMG_MGMT_UL_REORDER_CHUNKS
+#ifdef CONFIG_IMG_ERASE_PROGRESSIVELY
+#define IMG_MGMT_UL_ERASE_PROGRESSIVELY  1
+#endif
 
 #else
 
@@ -38,4 +42,16 @@
 
 #endif
 
+/* Upload chunks received out of order are dropped unless configured. */
+#ifndef IMG_MGMT_UL_REORDER_CHUNKS
+#define IMG_MGMT_UL_REORDER_CHUNKS  0
+#endif
+
+/* The slot is erased before an upload unless the image writer erases it as
+ * it goes.
+ */
+#ifndef IMG_MGMT_UL_ERASE_PROGRESSIVELY
+#define IMG_MGMT_UL_ERASE_PROGRESSIVELY  0
+#endif
+
 #endif
@@ -18,124 +18,92 @@
  */
 
 #include <misc/util.h>
-#include <logging/mdlog.h>
+#include <string.h>
+#include <logging/log_core.h>
+#include <logging/log_ctrl.h>
+#include <logging/log_backend_flash.h>
 #include <mgmt/mgmt.h>
 #include <log_mgmt/log_mgmt.h>
 #include <log_mgmt/log_mgmt_impl.h>
 #include "../../../src/log_mgmt_config.h"
 
+/* Entries are blocks of dictionary based records stored by the flash log
+ * backend.  Entry data has to be decoded on the host using the application
+ * ELF file, see scripts/logging/log_parser_dict.py.
+ */
+#define ZEPHYR_LOG_MGMT_NAME    "flash"
+
 struct zephyr_log_mgmt_walk_arg {
     log_mgmt_foreach_entry_fn *cb;
-    uint8_t body[LOG_MGMT_BODY_LEN];
     void *arg;
 };
 
+static const char * const zephyr_log_mgmt_levels[] = {
+    "none",
+    "err",
+    "wrn",
+    "inf",
+    "dbg",
+};
+
 int
 log_mgmt_impl_get_log(int idx, struct log_mgmt_log *out_log)
 {
-    struct mdlog *mdlog;
-    int i;
-
-    mdlog = NULL;
-    for (i = 0; i <= idx; i++) {
-        mdlog = mdlog_get_next(mdlog);
-        if (mdlog == NULL) {
-            return MGMT_ERR_ENOENT;
-        }
+    if (idx != 0) {
+        return MGMT_ERR_ENOENT;
     }
 
-    out_log->name = mdlog->l_name;
-    out_log->type = mdlog->l_handler->type;
+    out_log->name = ZEPHYR_LOG_MGMT_NAME;
+    out_log->type = LOG_MGMT_TYPE_STORAGE;
     return 0;
 }
 
 int
 log_mgmt_impl_get_module(int idx, const char **out_module_name)
 {
-    const char *name;
-
-    name = mdlog_module_name(idx);
-    if (name == NULL) {
+    if (idx < 0 || idx >= log_sources_count()) {
         return MGMT_ERR_ENOENT;
-    } else {
-        *out_module_name = name;
-        return 0;
     }
+
+    *out_module_name = log_source_name_get(CONFIG_LOG_DOMAIN_ID, idx);
+    return 0;
 }
 
 int
 log_mgmt_impl_get_level(int idx, const char **out_level_name)
 {
-    const char *name;
-
-    name = mdlog_level_name(idx);
-    if (name == NULL) {
+    if (idx < 0 || idx >= ARRAY_SIZE(zephyr_log_mgmt_levels)) {
         return MGMT_ERR_ENOENT;
-    } else {
-        *out_level_name = name;
-        return 0;
     }
+
+    *out_level_name = zephyr_log_mgmt_levels[idx];
+    return 0;
 }
 
 int
 log_mgmt_impl_get_next_idx(uint32_t *out_idx)
 {
-    *out_idx = mdlog_get_next_index();
+    *out_idx = log_backend_flash_next_seq_get();
     return 0;
 }
 
 static int
-zephyr_log_mgmt_walk_cb(struct mdlog *log, struct mdlog_offset *log_offset,
-                        const void *desciptor, uint16_t len)
+zephyr_log_mgmt_walk_cb(const struct log_backend_flash_block *block,
+                        void *arg)
 {
-    struct zephyr_log_mgmt_walk_arg *zephyr_log_mgmt_walk_arg;
+    struct zephyr_log_mgmt_walk_arg *walk_arg;
     struct log_mgmt_entry entry;
-    struct mdlog_entry_hdr ueh;
-    int read_len;
-    int rc;
 
-    zephyr_log_mgmt_walk_arg = log_offset->lo_arg;
+    walk_arg = arg;
 
-    rc = mdlog_read(log, desciptor, &ueh, 0, sizeof ueh);
-    if (rc != sizeof ueh) {
-        return MGMT_ERR_EUNKNOWN;
-    }
-
-    /* If specified timestamp is nonzero, it is the primary criterion, and the
-     * specified index is the secondary criterion.  If specified timetsamp is
-     * zero, specified index is the only criterion.
-     *
-     * If specified timestamp == 0: encode entries whose index >=
-     *     specified index.
-     * Else: encode entries whose timestamp >= specified timestamp and whose
-     *      index >= specified index
-     */
-
-    if (log_offset->lo_ts == 0) {
-        if (log_offset->lo_index > ueh.ue_index) {
-            return 0;
-        }
-    } else if (ueh.ue_ts < log_offset->lo_ts   ||
-               (ueh.ue_ts == log_offset->lo_ts &&
-                ueh.ue_index < log_offset->lo_index)) {
-        return 0;
-    }
+    entry.ts = LOG_BACKEND_FLASH_TIME(block->boot, block->timestamp);
+    entry.index = block->seq;
+    entry.module = 0;
+    entry.level = 0;
+    entry.len = block->len;
+    entry.data = block->data;
 
-    read_len = min(len - sizeof ueh, LOG_MGMT_BODY_LEN - sizeof ueh);
-    rc = mdlog_read(log, desciptor, zephyr_log_mgmt_walk_arg->body, sizeof ueh,
-                    read_len);
-    if (rc < 0) {
-        return MGMT_ERR_EUNKNOWN;
-    }
-
-    entry.ts = ueh.ue_ts;
-    entry.index = ueh.ue_index;
-    entry.module = ueh.ue_module;
-    entry.level = ueh.ue_level;
-    entry.len = rc;
-    entry.data = zephyr_log_mgmt_walk_arg->body;
-
-    return zephyr_log_mgmt_walk_arg->cb(&entry, zephyr_log_mgmt_walk_arg->arg);
+    return walk_arg->cb(&entry, walk_arg->arg);
 }
 
 int
@@ -144,44 +112,51 @@ log_mgmt_impl_foreach_entry(const char *log_name,
                             log_mgmt_foreach_entry_fn *cb, void *arg)
 {
     struct zephyr_log_mgmt_walk_arg walk_arg;
-    struct mdlog_offset offset;
-    struct mdlog *mdlog;
+    uint32_t min_index;
+    uint64_t min_time;
+    int rc;
+
+    if (strcmp(log_name, ZEPHYR_LOG_MGMT_NAME) != 0) {
+        return MGMT_ERR_ENOENT;
+    }
 
     walk_arg = (struct zephyr_log_mgmt_walk_arg) {
         .cb = cb,
         .arg = arg,
     };
 
-    mdlog = mdlog_find(log_name);
-    if (mdlog == NULL) {
-        return MGMT_ERR_ENOENT;
+    /* Make sure that the most recent messages are included. */
+    rc = log_backend_flash_flush();
+    if (rc != 0) {
+        return MGMT_ERR_EUNKNOWN;
     }
 
-    if (strcmp(mdlog->l_name, log_name) == 0) {
-        offset.lo_arg = &walk_arg;
-        offset.lo_ts = filter->min_timestamp;
-        offset.lo_index = filter->min_index;
-        offset.lo_data_len = 0;
+    min_index = filter->min_index;
+    if (filter->min_timestamp == -1) {
+        /* Only the last entry. */
+        min_time = 0;
+        min_index = max(min_index, log_backend_flash_next_seq_get() - 1);
+    } else {
+        min_time = filter->min_timestamp;
+    }
 
-        return mdlog_walk(mdlog, zephyr_log_mgmt_walk_cb, &offset);
+    rc = log_backend_flash_walk(min_time, min_index, zephyr_log_mgmt_walk_cb,
+                                &walk_arg);
+    if (rc < 0) {
+        return MGMT_ERR_EUNKNOWN;
     }
 
-    return MGMT_ERR_ENOENT;
+    return rc;
 }
 
 int
 log_mgmt_impl_clear(const char *log_name)
 {
-    struct mdlog *mdlog;
-    int rc;
-
-    mdlog = mdlog_find(log_name);
-    if (mdlog == NULL) {
+    if (strcmp(log_name, ZEPHYR_LOG_MGMT_NAME) != 0) {
         return MGMT_ERR_ENOENT;
     }
 
-    rc = mdlog_flush(mdlog);
-    if (rc != 0) {
+    if (log_backend_flash_clear() != 0) {
         return MGMT_ERR_EUNKNOWN;
     }
 
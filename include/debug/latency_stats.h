@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Latency histograms (CONFIG_LATENCY_STATS).
+ */
+
+#ifndef ZEPHYR_INCLUDE_DEBUG_LATENCY_STATS_H_
+#define ZEPHYR_INCLUDE_DEBUG_LATENCY_STATS_H_
+
+#include <zephyr/types.h>
+
+#ifdef CONFIG_LATENCY_STATS
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Latency histograms
+ * @defgroup latency_stats Latency histograms
+ * @ingroup debugging
+ * @{
+ */
+
+/** Number of histogram buckets. */
+#define SYS_LATENCY_BUCKETS 32
+
+/** Measured latencies. */
+enum sys_latency_type {
+	/** Time interrupts were kept locked by irq_lock() or k_spin_lock() */
+	SYS_LATENCY_IRQ_LOCKED,
+	/** Time from raising an interrupt to the start of its handler */
+	SYS_LATENCY_ISR_ENTRY,
+	/** Time from readying a thread in an ISR to the thread running */
+	SYS_LATENCY_THREAD_WAKEUP,
+	/** Time the scheduler was kept locked by a thread */
+	SYS_LATENCY_SCHED_LOCKED,
+
+	SYS_LATENCY_TYPES
+};
+
+/** Call site with the highest latencies of a histogram. */
+struct sys_latency_site {
+	/** Code address the latency is attributed to */
+	void *site;
+	/** Number of samples from the site */
+	u32_t count;
+	/** Longest sample from the site in cycles */
+	u32_t max;
+};
+
+/**
+ * @brief Latency histogram.
+ *
+ * Bucket 0 counts samples of 0 cycles, bucket n counts samples from
+ * 2^(n-1) to 2^n - 1 cycles. The last bucket counts all longer samples.
+ */
+struct sys_latency_hist {
+	/** Samples per bucket */
+	u32_t buckets[SYS_LATENCY_BUCKETS];
+	/** Number of samples */
+	u32_t count;
+	/** Longest sample in cycles */
+	u32_t max;
+	/** Sum of all samples in cycles */
+	u64_t total;
+	/** Call sites with the longest samples, unused have NULL site */
+	struct sys_latency_site sites[CONFIG_LATENCY_STATS_SITES];
+};
+
+/**
+ * @brief Record a latency sample.
+ *
+ * Can be called from any context. Drivers use it to report
+ * SYS_LATENCY_ISR_ENTRY samples for interrupts for which they know when
+ * the interrupt was raised; other latencies are recorded by the kernel.
+ *
+ * @param type Type of the latency.
+ * @param cycles Latency in hardware cycles.
+ * @param site Code address the sample is attributed to.
+ */
+void sys_latency_record(enum sys_latency_type type, u32_t cycles,
+			void *site);
+
+/**
+ * @brief Get a snapshot of a latency histogram.
+ *
+ * @param type Type of the latency.
+ * @param hist Histogram to fill.
+ */
+void sys_latency_get(enum sys_latency_type type,
+		     struct sys_latency_hist *hist);
+
+/**
+ * @brief Clear all latency histograms.
+ */
+void sys_latency_reset(void);
+
+/**
+ * @brief Get a percentile of a latency histogram.
+ *
+ * The result is the upper bound of the bucket which contains the percentile,
+ * limited to the longest sample.
+ *
+ * @param hist Histogram.
+ * @param permille Percentile in tenths of percent, e.g. 999 for p99.9.
+ *
+ * @return Percentile in cycles, 0 if the histogram is empty.
+ */
+u32_t sys_latency_percentile(const struct sys_latency_hist *hist,
+			     u32_t permille);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_LATENCY_STATS */
+
+#endif /* ZEPHYR_INCLUDE_DEBUG_LATENCY_STATS_H_ */
@@ -54,6 +54,20 @@ extern struct k_queue	 *_trace_list_k_queue;
  */
 #define SYS_TRACING_NEXT(type, name, obj) (((type *)obj)->__next)
 
+#ifdef CONFIG_OBJECT_STATS
+/**
+ * @def SYS_TRACING_STATS
+ *
+ * @brief Gets usage statistics of a traced object.
+ *
+ * @details Returns pointer to the struct k_obj_stats of a semaphore,
+ * mutex, queue, FIFO, LIFO, message queue or memory slab.
+ *
+ * @param obj Object to get statistics of.
+ */
+#define SYS_TRACING_STATS(obj) (&(obj)->__stats)
+#endif /* CONFIG_OBJECT_STATS */
+
 #endif /*CONFIG_OBJECT_TRACING*/
 
 #ifdef CONFIG_THREAD_MONITOR
@@ -8,15 +8,42 @@
 #ifndef ZEPHYR_INCLUDE_DFU_FLASH_IMG_H_
 #define ZEPHYR_INCLUDE_DFU_FLASH_IMG_H_
 
+#include <kernel.h>
+#ifdef CONFIG_IMG_ENABLE_IMAGE_CHECK
+#include <tinycrypt/sha256.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* The background writer programs one buffer while the other is filled */
+#define FLASH_IMG_BUF_CNT (IS_ENABLED(CONFIG_IMG_PIPELINED_WRITE) ? 2 : 1)
+
 struct flash_img_context {
-	u8_t buf[CONFIG_IMG_BLOCK_BUF_SIZE];
+	u8_t buf[FLASH_IMG_BUF_CNT][CONFIG_IMG_BLOCK_BUF_SIZE];
 	struct device *dev;
 	size_t bytes_written;
 	u16_t buf_bytes;
+	u8_t buf_idx;
+#ifdef CONFIG_IMG_ERASE_PROGRESSIVELY
+	/* Flash offset up to which the image slot is erased */
+	off_t erased_end;
+#endif
+#ifdef CONFIG_IMG_ENABLE_IMAGE_CHECK
+	struct tc_sha256_state_struct sha;
+	/* Bytes covered by the image hash, 0 until the header is written */
+	size_t hash_len;
+#endif
+#ifdef CONFIG_IMG_PIPELINED_WRITE
+	struct k_work work;
+	/* Available while no block is being written */
+	struct k_sem idle;
+	u8_t *wr_buf;
+	off_t wr_off;
+	/* First error of the background writer */
+	int wr_rc;
+#endif
 };
 
 /**
@@ -45,6 +72,14 @@ size_t flash_img_bytes_written(struct flash_img_context *ctx);
  * in blocks, the contents of flash from the last byte written up to the next
  * multiple of CONFIG_IMG_BLOCK_BUF_SIZE is padded with 0xff.
  *
+ * With CONFIG_IMG_PIPELINED_WRITE, blocks are written in the background and
+ * an error may be reported by a later call than the one which passed the
+ * data. The final call returns once all of the image is written.
+ *
+ * With CONFIG_IMG_ENABLE_IMAGE_CHECK, the final call fails with -EIO if the
+ * image read back from flash does not match the SHA-256 hash in its TLV area
+ * and with -EINVAL if the data written is not an MCUboot image.
+ *
  * @param ctx context
  * @param data data to write
  * @param len Number of bytes to write
@@ -47,6 +47,28 @@ struct fcb_entry_ctx {
 	const struct flash_area *fap;
 };
 
+#ifdef CONFIG_FCB_SUMMARY
+/*
+ * Summary of the elements of a sector. Elements are numbered in the order
+ * they were appended, including elements which failed CRC check. Sectors
+ * with elements without key have the full key range and a filter matching
+ * every key.
+ */
+struct fcb_summary {
+	u32_t fsum_first_seq;	/* Sequence number of the first element */
+	u32_t fsum_count;	/* Number of elements */
+	u32_t fsum_key_min;	/* Smallest key */
+	u32_t fsum_key_max;	/* Largest key */
+	u8_t fsum_bloom[CONFIG_FCB_SUMMARY_BLOOM_SIZE]; /* Filter of keys */
+};
+
+/*
+ * Gets the key of an element for sector summaries. Returns non-zero if the
+ * element has no key.
+ */
+typedef int (*fcb_key_cb)(struct fcb_entry_ctx *loc_ctx, u32_t *key);
+#endif
+
 struct fcb {
 	/* Caller of fcb_init fills this in */
 	u32_t f_magic;		/* As placed on the disk */
@@ -55,6 +77,11 @@ struct fcb {
 	u8_t f_scratch_cnt;	/* How many sectors should be kept empty */
 	struct flash_sector *f_sectors; /* Array of sectors, */
 					/* must be contiguous */
+#ifdef CONFIG_FCB_SUMMARY
+	bool f_summary;		/* Keep sector summaries, changes the */
+				/* layout in flash */
+	fcb_key_cb f_key_cb;	/* Key of elements, optional */
+#endif
 
 	/* Flash circular buffer internal state */
 	struct k_mutex f_mtx;	/* Locking for accessing the FCB data */
@@ -65,6 +92,11 @@ struct fcb {
 
 	const struct flash_area *fap; /* Flash area used by the fcb instance */
 				     /* This can be transfer to FCB user    */
+#ifdef CONFIG_FCB_SUMMARY
+	struct fcb_summary f_active_sum; /* Summary of the active sector */
+	u32_t f_active_pending;	/* Elements of the active sector which are */
+				/* not finished yet */
+#endif
 };
 
 /*
@@ -78,6 +110,7 @@ struct fcb {
 #define FCB_ERR_NOMEM	-5
 #define FCB_ERR_CRC	-6
 #define FCB_ERR_MAGIC   -7
+#define FCB_ERR_VERSION -8
 
 int fcb_init(int f_area_id, struct fcb *fcb);
 
@@ -134,6 +167,35 @@ int fcb_offset_last_n(struct fcb *fcb, u8_t entries,
  */
 int fcb_clear(struct fcb *fcb);
 
+#ifdef CONFIG_FCB_SUMMARY
+/*
+ * Get the summary of a sector. The summary of the active sector covers the
+ * elements appended so far.
+ */
+int fcb_sector_summary(struct fcb *fcb, struct flash_sector *sector,
+		       struct fcb_summary *sum);
+
+/*
+ * Sequence numbers of the oldest element and the next element to be
+ * appended.
+ */
+int fcb_seq_range(struct fcb *fcb, u32_t *first_seq, u32_t *next_seq);
+
+/*
+ * Locate the element with given sequence number. Returns FCB_ERR_NOVAR if
+ * there is no such element and FCB_ERR_CRC if the element is corrupted.
+ */
+int fcb_seek_seq(struct fcb *fcb, u32_t seq, struct fcb_entry *loc);
+
+/*
+ * Call 'cb' for every element with given key, as reported by f_key_cb.
+ * Sectors whose summary shows they have no such element are skipped. If the
+ * FCB has no f_key_cb, 'cb' gets called for all elements of the sectors
+ * which might contain the key.
+ */
+int fcb_walk_key(struct fcb *fcb, u32_t key, fcb_walk_cb cb, void *cb_arg);
+#endif
+
 int fcb_flash_read(const struct fcb *fcb, const struct flash_sector *sector,
 		   off_t off, void *dst, size_t len);
 int fcb_flash_write(const struct fcb *fcb, const struct flash_sector *sector,
@@ -185,6 +185,11 @@ irq_connect_dynamic(unsigned int irq, unsigned int priority,
  */
 #define ISR_DIRECT_DECLARE(name) _ARCH_ISR_DIRECT_DECLARE(name)
 
+#ifdef CONFIG_LATENCY_STATS
+/* Address of the code using the macro, latencies are attributed to it. */
+#define _LATENCY_SITE() ({ __label__ __here; __here: (void *)&&__here; })
+#endif
+
 /**
  * @brief Lock interrupts.
  *
@@ -219,6 +224,9 @@ irq_connect_dynamic(unsigned int irq, unsigned int priority,
 #ifdef CONFIG_SMP
 unsigned int _smp_global_lock(void);
 #define irq_lock() _smp_global_lock()
+#elif defined(CONFIG_LATENCY_STATS)
+unsigned int _latency_irq_lock(unsigned int key, void *site);
+#define irq_lock() _latency_irq_lock(_arch_irq_lock(), _LATENCY_SITE())
 #else
 #define irq_lock() _arch_irq_lock()
 #endif
@@ -240,6 +248,9 @@ unsigned int _smp_global_lock(void);
 #ifdef CONFIG_SMP
 void _smp_global_unlock(unsigned int key);
 #define irq_unlock(key) _smp_global_unlock(key)
+#elif defined(CONFIG_LATENCY_STATS)
+void _latency_irq_unlock(unsigned int key);
+#define irq_unlock(key) _latency_irq_unlock(key)
 #else
 #define irq_unlock(key) _arch_irq_unlock(key)
 #endif
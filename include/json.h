@@ -22,6 +22,7 @@
  */
 
 #include <misc/util.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <zephyr/types.h>
 #include <sys/types.h>
@@ -528,6 +529,10 @@ typedef int (*json_append_bytes_t)(const char *bytes, size_t len,
  * (2) no UTF-8 validation is performed; and
  * (3) only integer numbers are supported (no strtod() in the minimal libc).
  *
+ * Keys are looked up starting from the descriptor entry following the one
+ * matched last, so declaring the descriptor in the same order the fields
+ * appear in the documents being parsed makes each lookup a single compare.
+ *
  * @param json Pointer to JSON-encoded value to be parsed
  *
  * @param len Length of JSON-encoded value
@@ -535,7 +540,7 @@ typedef int (*json_append_bytes_t)(const char *bytes, size_t len,
  * @param descr Pointer to the descriptor array
  *
  * @param descr_len Number of elements in the descriptor array. Must be less
- * than 31 due to implementation detail reasons (if more fields are
+ * than 63 due to implementation detail reasons (if more fields are
  * necessary, use two descriptors)
  *
  * @param val Pointer to the struct to hold the decoded values
@@ -543,9 +548,133 @@ typedef int (*json_append_bytes_t)(const char *bytes, size_t len,
  * @return < 0 if error, bitmap of decoded fields on success (bit 0
  * is set if first field in the descriptor has been properly decoded, etc).
  */
-int json_obj_parse(char *json, size_t len,
-	const struct json_obj_descr *descr, size_t descr_len,
-	void *val);
+s64_t json_obj_parse(char *json, size_t len,
+		     const struct json_obj_descr *descr, size_t descr_len,
+		     void *val);
+
+/** @cond INTERNAL_HIDDEN */
+/* Make sure that json.h can be included even if the JSON library is not
+ * enabled.
+ */
+#ifndef CONFIG_JSON_STREAM_MAX_DEPTH
+#define CONFIG_JSON_STREAM_MAX_DEPTH 8
+#endif
+#ifndef CONFIG_JSON_STREAM_KEY_LEN
+#define CONFIG_JSON_STREAM_KEY_LEN 32
+#endif
+
+struct json_stream_frame {
+	/* Object: field descriptors; array: element descriptor; NULL when
+	 * the container is not described and is only being skipped.
+	 */
+	const struct json_obj_descr *descr;
+	/* Object: number of fields; array: maximum number of elements. */
+	size_t descr_len;
+	/* Object: struct being filled; array: slot for the next element. */
+	char *base;
+	/* Struct holding the element counter of an array. */
+	void *val;
+	union {
+		s64_t decoded;
+		ptrdiff_t elem_size;
+	};
+	/* Field index of this container in its parent object, or -1. */
+	s8_t parent_field;
+	/* Object: descriptor entry to try first for the next key. */
+	u8_t next_field;
+	u8_t type;
+};
+/** @endcond */
+
+/**
+ * @brief Incremental JSON parser state
+ *
+ * All members are private; use json_stream_parser_init() to set it up.
+ */
+struct json_stream_parser {
+	/** @cond INTERNAL_HIDDEN */
+	struct json_stream_frame stack[CONFIG_JSON_STREAM_MAX_DEPTH];
+	const struct json_obj_descr *target;
+	char *target_field;
+	char *str_buf;
+	size_t str_buf_size;
+	size_t str_used;
+	size_t str_start;
+	s64_t decoded;
+	s64_t num;
+	int error;
+	s8_t field;
+	u8_t depth;
+	u8_t state;
+	u8_t token;
+	u8_t token_pos;
+	u8_t key_len;
+	bool negative;
+	bool fraction;
+	char key[CONFIG_JSON_STREAM_KEY_LEN];
+	/** @endcond */
+};
+
+/**
+ * @brief Prepares an incremental parser for a new JSON object
+ *
+ * The incremental parser accepts the same documents and descriptors as
+ * json_obj_parse(), but the input can be fed in arbitrarily split chunks
+ * (e.g. as they come out of a socket or a net_buf chain), and the input
+ * buffers are never modified nor referenced after they have been parsed.
+ * Decoded strings are therefore copied, NUL-terminated and still escaped,
+ * to @a str_buf, and the char pointers in @a val point into it.
+ *
+ * Keys that do not match any descriptor are skipped along with their
+ * values, which may be arbitrarily nested objects or arrays as long as the
+ * total nesting stays within CONFIG_JSON_STREAM_MAX_DEPTH.
+ *
+ * @param parser Parser state to initialize
+ *
+ * @param descr Pointer to the descriptor array
+ *
+ * @param descr_len Number of elements in the descriptor array. Must be less
+ * than 63.
+ *
+ * @param val Pointer to the struct to hold the decoded values
+ *
+ * @param str_buf Buffer where decoded strings are stored, may be NULL if
+ * the descriptor does not contain strings
+ *
+ * @param str_buf_size Size of @a str_buf
+ */
+void json_stream_parser_init(struct json_stream_parser *parser,
+			     const struct json_obj_descr *descr,
+			     size_t descr_len, void *val,
+			     char *str_buf, size_t str_buf_size);
+
+/**
+ * @brief Feeds the next chunk of a JSON document to an incremental parser
+ *
+ * Anything following the closing brace of the top-level object is
+ * ignored.
+ *
+ * @param parser Parser state
+ *
+ * @param data Next chunk of the JSON-encoded value
+ *
+ * @param len Length of the chunk
+ *
+ * @return 0 if the chunk has been consumed, < 0 on error. Once an error is
+ * returned, all subsequent calls fail with the same error.
+ */
+int json_stream_parse(struct json_stream_parser *parser,
+		      const char *data, size_t len);
+
+/**
+ * @brief Finishes parsing with an incremental parser
+ *
+ * @param parser Parser state
+ *
+ * @return < 0 if error or if the document was incomplete, bitmap of
+ * decoded fields on success (same as json_obj_parse()).
+ */
+s64_t json_stream_parser_finish(struct json_stream_parser *parser);
 
 /**
  * @brief Escapes the string so it can be used to encode JSON objects
@@ -630,6 +759,38 @@ int json_obj_encode(const struct json_obj_descr *descr, size_t descr_len,
 		    const void *val, json_append_bytes_t append_bytes,
 		    void *data);
 
+/**
+ * @brief Encodes an object through a writer function, in chunks
+ *
+ * Same as json_obj_encode(), but output is coalesced in @a chunk and
+ * handed to @a append_bytes only once @a chunk_size bytes are available
+ * (plus a last partial chunk), instead of in many small pieces. This is
+ * useful when every call to the writer function is expensive, e.g. when
+ * it sends data over a socket.
+ *
+ * @param descr Pointer to the descriptor array
+ *
+ * @param descr_len Number of elements in the descriptor array
+ *
+ * @param val Struct holding the values
+ *
+ * @param chunk Scratch buffer used to coalesce the output
+ *
+ * @param chunk_size Size of @a chunk
+ *
+ * @param append_bytes Function to append bytes to the output
+ *
+ * @param data Data pointer to be passed to the append_bytes callback
+ * function.
+ *
+ * @return 0 if object has been successfully encoded. A negative value
+ * indicates an error.
+ */
+int json_obj_encode_chunked(const struct json_obj_descr *descr,
+			    size_t descr_len, const void *val,
+			    char *chunk, size_t chunk_size,
+			    json_append_bytes_t append_bytes, void *data);
+
 /**
  * @}
  */
@@ -103,6 +103,40 @@ typedef struct {
 #define _OBJECT_TRACING_NEXT_PTR(type)
 #endif
 
+#ifdef CONFIG_OBJECT_STATS
+/**
+ * @brief Usage statistics of a kernel object
+ *
+ * Take is a successful k_sem_take(), k_mutex_lock(), k_queue_get(),
+ * k_msgq_get() or k_mem_slab_alloc(), give is the opposite operation. Times
+ * are in hardware cycles (see k_cycle_get_32()).
+ */
+struct k_obj_stats {
+	/** Successful take operations */
+	u32_t takes;
+	/** Give operations */
+	u32_t gives;
+	/** Operations which had to wait */
+	u32_t blocked;
+	/** Operations which returned without success or timed out */
+	u32_t failed;
+	/** Longest wait */
+	u32_t wait_max;
+	/** Longest time a mutex was held, mutexes only */
+	u32_t hold_max;
+	/** Cumulative wait time */
+	u64_t wait_total;
+	/** Cumulative time a mutex was held, mutexes only */
+	u64_t hold_total;
+	/* cycle counter when the current owner locked a mutex */
+	u32_t hold_start;
+};
+
+#define _OBJECT_STATS struct k_obj_stats __stats;
+#else
+#define _OBJECT_STATS
+#endif
+
 #ifdef CONFIG_POLL
 #define _POLL_EVENT_OBJ_INIT(obj) \
 	.poll_events = SYS_DLIST_STATIC_INIT(&obj.poll_events),
@@ -461,6 +495,20 @@ struct _thread_base {
 	/* this thread's entry in a timeout queue */
 	struct _timeout timeout;
 #endif
+
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+	/* cycles the thread has been running for, updated on switch out */
+	u64_t usage;
+#endif
+
+#ifdef CONFIG_LATENCY_STATS
+	/* start and site of the scheduler lock held by the thread */
+	u32_t sched_lock_start;
+	void *sched_lock_site;
+	/* when and where the thread was readied by an ISR, NULL site if not */
+	u32_t wakeup_start;
+	void *wakeup_site;
+#endif
 };
 
 typedef struct _thread_base _thread_base_t;
@@ -1221,6 +1269,60 @@ __syscall void k_thread_name_set(k_tid_t thread_id, const char *value);
  */
 __syscall const char *k_thread_name_get(k_tid_t thread_id);
 
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+/** Execution time of a thread. */
+struct k_thread_runtime_stats {
+	/** Cycles the thread has been running for. */
+	u64_t execution_cycles;
+};
+
+/** Execution time accounted on a CPU. */
+struct k_cpu_runtime_stats {
+	/** Cycles accounted to all threads, including the idle thread. */
+	u64_t total_cycles;
+	/** Cycles accounted to the idle thread. */
+	u64_t idle_cycles;
+};
+
+/**
+ * @brief Get execution time of a thread
+ *
+ * Time is measured in hardware cycles (see k_cycle_get_32()) and updated
+ * when the thread is switched out. Time spent in interrupts is accounted to
+ * the interrupted thread. If the thread is currently running, the cycles
+ * since it was switched in are included.
+ *
+ * @param thread Thread ID.
+ * @param stats Statistics of the thread.
+ *
+ * @retval 0 on success.
+ * @retval -EINVAL if an argument is NULL.
+ */
+extern int k_thread_runtime_stats_get(k_tid_t thread,
+				      struct k_thread_runtime_stats *stats);
+
+/**
+ * @brief Get execution time accounted on a CPU
+ *
+ * CPU utilization is the ratio of the non-idle cycles to the total cycles
+ * between two calls.
+ *
+ * @param cpu CPU index, 0 on uniprocessor systems.
+ * @param stats Statistics of the CPU.
+ *
+ * @retval 0 on success.
+ * @retval -EINVAL if the CPU index is invalid or @a stats is NULL.
+ */
+extern int k_cpu_runtime_stats_get(int cpu, struct k_cpu_runtime_stats *stats);
+
+/**
+ * @brief Get execution time accounted on all CPUs
+ *
+ * @param stats Sum of the statistics of all CPUs.
+ */
+extern void k_cpu_runtime_stats_all_get(struct k_cpu_runtime_stats *stats);
+#endif /* CONFIG_THREAD_RUNTIME_STATS */
+
 /**
  * @}
  */
@@ -1673,6 +1775,7 @@ struct k_queue {
 	};
 
 	_OBJECT_TRACING_NEXT_PTR(k_queue)
+	_OBJECT_STATS
 };
 
 #define _K_QUEUE_INITIALIZER(obj) \
@@ -2832,6 +2935,7 @@ struct k_mutex {
 	int owner_orig_prio;
 
 	_OBJECT_TRACING_NEXT_PTR(k_mutex)
+	_OBJECT_STATS
 };
 
 /**
@@ -2934,6 +3038,7 @@ struct k_sem {
 	_POLL_EVENT;
 
 	_OBJECT_TRACING_NEXT_PTR(k_sem)
+	_OBJECT_STATS
 };
 
 #define _K_SEM_INITIALIZER(obj, initial_count, count_limit) \
@@ -3092,6 +3197,7 @@ struct k_msgq {
 	u32_t used_msgs;
 
 	_OBJECT_TRACING_NEXT_PTR(k_msgq)
+	_OBJECT_STATS
 	u8_t flags;
 };
 /**
@@ -3745,6 +3851,7 @@ struct k_mem_slab {
 	u32_t num_used;
 
 	_OBJECT_TRACING_NEXT_PTR(k_mem_slab)
+	_OBJECT_STATS
 };
 
 #define _K_MEM_SLAB_INITIALIZER(obj, slab_buffer, slab_block_size, \
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef ZEPHYR_INCLUDE_LOGGING_LOG_BACKEND_FLASH_H_
+#define ZEPHYR_INCLUDE_LOGGING_LOG_BACKEND_FLASH_H_
+
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Flash logger backend
+ * @defgroup log_backend_flash Flash logger backend
+ * @ingroup logger
+ * @{
+ */
+
+/** @brief Create time key from boot number and timestamp.
+ *
+ * Log timestamps start from zero after every reset, so stored blocks are
+ * ordered by the number of the boot in which they were written and then by
+ * timestamp. Timestamp is extended to 48 bits with the number of times it
+ * wrapped around during the boot.
+ */
+#define LOG_BACKEND_FLASH_TIME(boot, timestamp) \
+	(((u64_t)(boot) << 48) | ((u64_t)(timestamp) & 0xFFFFFFFFFFFFULL))
+
+/** @brief Block of log records read from flash. */
+struct log_backend_flash_block {
+	/** Sequence number, incremented for every stored block. */
+	u32_t seq;
+
+	/** Number of the boot in which block was written. */
+	u16_t boot;
+
+	/** Timestamp of the first record in the block, extended with the
+	 *  number of timestamp wraps in the boot.
+	 */
+	u64_t timestamp;
+
+	/** Dictionary based records, see @ref LOG_OUTPUT_FLAG_DICTIONARY. */
+	const u8_t *data;
+
+	/** Length of the records. */
+	u16_t len;
+};
+
+/** @brief Callback called for every block read from flash.
+ *
+ * @param block	Block. Data is valid only during the callback.
+ * @param ctx	User context.
+ *
+ * @return 0 to continue, other value stops the walk and is returned by
+ *	   @ref log_backend_flash_walk.
+ */
+typedef int (*log_backend_flash_walk_cb_t)(
+			const struct log_backend_flash_block *block, void *ctx);
+
+/** @brief Write pending records to flash.
+ *
+ * Records are collected in RAM and written once a block is full or when
+ * logger enters panic mode.
+ *
+ * @return 0 on success or negative error code.
+ */
+int log_backend_flash_flush(void);
+
+/** @brief Read stored blocks, from the oldest to the newest.
+ *
+ * Sector index is used to skip sectors which contain only older blocks, so
+ * seeking does not require reading the whole partition.
+ *
+ * @param min_time	Skip blocks whose first record is older than given
+ *			time key, see @ref LOG_BACKEND_FLASH_TIME. 0 to read
+ *			from the oldest.
+ * @param min_seq	Skip blocks with lower sequence number.
+ * @param cb		Callback called for every block.
+ * @param ctx		User context passed to the callback.
+ *
+ * @return 0 on success, value returned by the callback if it stopped the
+ *	   walk or negative error code.
+ */
+int log_backend_flash_walk(u64_t min_time, u32_t min_seq,
+			   log_backend_flash_walk_cb_t cb, void *ctx);
+
+/** @brief Get sequence number which will be assigned to the next block.
+ *
+ * @return Sequence number.
+ */
+u32_t log_backend_flash_next_seq_get(void);
+
+/** @brief Erase all stored blocks.
+ *
+ * Pending records are discarded as well. Sequence numbering continues.
+ *
+ * @return 0 on success or negative error code.
+ */
+int log_backend_flash_clear(void);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_INCLUDE_LOGGING_LOG_BACKEND_FLASH_H_ */
@@ -247,6 +247,17 @@ static inline bool log_msg_is_raw_string(struct log_msg *msg)
 	       (msg->hdr.params.hexdump.raw_string == 1);
 }
 
+/** @brief Get number of bytes stored in the hexdump message.
+ *
+ * @param msg Hexdump message.
+ *
+ * @return Data length.
+ */
+static inline u32_t log_msg_hexdump_length_get(struct log_msg *msg)
+{
+	return msg->hdr.params.hexdump.length;
+}
+
 
 /** @brief Check if message is of standard type.
  *
@@ -331,12 +342,17 @@ void log_msg_hexdump_data_get(struct log_msg *msg,
 
 union log_msg_chunk *log_msg_no_space_handle(void);
 
+/** @brief Allocate chunk from the message pool without blocking.
+ *
+ * @return Allocated chunk or NULL if pool is empty.
+ */
+union log_msg_chunk *log_msg_chunk_pool_alloc(void);
+
 static inline union log_msg_chunk *log_msg_chunk_alloc(void)
 {
-	union log_msg_chunk *msg = NULL;
-	int err = k_mem_slab_alloc(&log_msg_pool, (void **)&msg, K_NO_WAIT);
+	union log_msg_chunk *msg = log_msg_chunk_pool_alloc();
 
-	if (err != 0) {
+	if (msg == NULL) {
 		msg = log_msg_no_space_handle();
 	}
 
@@ -43,6 +43,15 @@ extern "C" {
  */
 #define LOG_OUTPUT_FLAG_FORMAT_SYSLOG		BIT(6)
 
+/** @brief Flag forcing dictionary based binary output.
+ *
+ * Message is not formatted, instead a binary record with format string
+ * address, raw timestamp, source ID and arguments is sent. Remaining flags
+ * are ignored. When set on the instance with log_output_flags_set(),
+ * dropped messages indication is sent as a binary record as well.
+ */
+#define LOG_OUTPUT_FLAG_DICTIONARY		BIT(7)
+
 /**
  * @brief Prototype of the function processing output data.
  *
@@ -59,6 +68,7 @@ struct log_output_control_block {
 	size_t offset;
 	void *ctx;
 	const char *hostname;
+	u32_t flags;
 };
 
 /** @brief Log_output instance structure. */
@@ -100,7 +110,8 @@ void log_output_msg_process(const struct log_output *log_output,
 
 /** @brief Process dropped messages indication.
  *
- * Function prints error message indicating lost log messages.
+ * Function prints error message indicating lost log messages. Binary record
+ * is sent instead if LOG_OUTPUT_FLAG_DICTIONARY is set on the instance.
  *
  * @param log_output Pointer to the log output instance.
  * @param cnt        Number of dropped messages.
@@ -135,6 +146,20 @@ static inline void log_output_hostname_set(const struct log_output *log_output,
 	log_output->control_block->hostname = hostname;
 }
 
+/** @brief Function for setting flags applied to every output of the instance.
+ *
+ * Flags are added to the ones passed to log_output_msg_process() and used
+ * for dropped messages indication.
+ *
+ * @param log_output	Pointer to the log output instance.
+ * @param flags		Flags, e.g. LOG_OUTPUT_FLAG_DICTIONARY.
+ */
+static inline void log_output_flags_set(const struct log_output *log_output,
+					u32_t flags)
+{
+	log_output->control_block->flags = flags;
+}
+
 /** @brief Set timestamp frequency.
  *
  * @param freq Frequency in Hz.
@@ -8,6 +8,7 @@
 #define ZEPHYR_INCLUDE_MGMT_BUF_H_
 
 #include <inttypes.h>
+#include <stdbool.h>
 #include "cbor_encoder_writer.h"
 #include "cbor_decoder_reader.h"
 struct net_buf;
@@ -15,11 +16,16 @@ struct net_buf;
 struct cbor_nb_reader {
 	struct cbor_decoder_reader r;
 	struct net_buf *nb;
+	/* Fragment of the last access and its offset in the chain. */
+	struct net_buf *frag;
+	int frag_off;
 };
 
 struct cbor_nb_writer {
 	struct cbor_encoder_writer enc;
 	struct net_buf *nb;
+	/* Whether fragments are added when the buffer is full. */
+	bool chain;
 };
 
 /**
@@ -46,9 +52,27 @@ void mcumgr_buf_free(struct net_buf *nb);
 void cbor_nb_writer_init(struct cbor_nb_writer *cnw,
 			 struct net_buf *nb);
 
+/**
+ * @brief Initializes a CBOR writer which extends the specified net_buf
+ * with fragments.
+ *
+ * When the last fragment is full, a fragment is allocated from the pool of
+ * nb and added to the chain.
+ *
+ * @param cnw                   The writer to initialize.
+ * @param nb                    The net_buf that the writer will write to.
+ */
+void cbor_nb_chain_writer_init(struct cbor_nb_writer *cnw,
+			       struct net_buf *nb);
+
 /**
  * @brief Initializes a CBOR reader with the specified net_buf.
  *
+ * The net_buf may be a fragment chain.  Byte and text strings are returned
+ * in place by cbor_value_get_byte_string_chunk() and
+ * cbor_value_get_text_string_chunk(), in pieces which do not cross
+ * fragment boundaries.
+ *
  * @param cnr                   The reader to initialize.
  * @param nb                    The net_buf that the reader will read from.
  */
@@ -198,6 +198,84 @@ int lwm2m_engine_get_bool(char *path, bool *value);
 int lwm2m_engine_get_float32(char *pathstr, float32_value_t *buf);
 int lwm2m_engine_get_float64(char *pathstr, float64_value_t *buf);
 
+struct lwm2m_engine_obj_inst;
+struct lwm2m_engine_obj_field;
+struct lwm2m_engine_res_inst;
+
+/**
+ * @brief Pre-resolved reference to an LwM2M resource
+ *
+ * @details Filled in once by lwm2m_engine_get_res_handle() so that
+ * frequent updates of the same resource skip path parsing and the
+ * object / instance / resource lookups.  A handle becomes stale when
+ * its object instance is deleted; accessors then return -ENOENT.
+ */
+struct lwm2m_res_handle {
+	struct lwm2m_engine_obj_inst *obj_inst;
+	struct lwm2m_engine_obj_field *obj_field;
+	struct lwm2m_engine_res_inst *res;
+	u16_t obj_id;
+	u16_t obj_inst_id;
+	u16_t res_id;
+};
+
+int lwm2m_engine_get_res_handle(char *pathstr,
+				struct lwm2m_res_handle *handle);
+
+int lwm2m_engine_handle_set_opaque(const struct lwm2m_res_handle *handle,
+				   char *data_ptr, u16_t data_len);
+int lwm2m_engine_handle_set_string(const struct lwm2m_res_handle *handle,
+				   char *data_ptr);
+int lwm2m_engine_handle_set_u8(const struct lwm2m_res_handle *handle,
+			       u8_t value);
+int lwm2m_engine_handle_set_u16(const struct lwm2m_res_handle *handle,
+				u16_t value);
+int lwm2m_engine_handle_set_u32(const struct lwm2m_res_handle *handle,
+				u32_t value);
+int lwm2m_engine_handle_set_u64(const struct lwm2m_res_handle *handle,
+				u64_t value);
+int lwm2m_engine_handle_set_s8(const struct lwm2m_res_handle *handle,
+			       s8_t value);
+int lwm2m_engine_handle_set_s16(const struct lwm2m_res_handle *handle,
+				s16_t value);
+int lwm2m_engine_handle_set_s32(const struct lwm2m_res_handle *handle,
+				s32_t value);
+int lwm2m_engine_handle_set_s64(const struct lwm2m_res_handle *handle,
+				s64_t value);
+int lwm2m_engine_handle_set_bool(const struct lwm2m_res_handle *handle,
+				 bool value);
+int lwm2m_engine_handle_set_float32(const struct lwm2m_res_handle *handle,
+				    float32_value_t *value);
+int lwm2m_engine_handle_set_float64(const struct lwm2m_res_handle *handle,
+				    float64_value_t *value);
+
+int lwm2m_engine_handle_get_opaque(const struct lwm2m_res_handle *handle,
+				   void *buf, u16_t buflen);
+int lwm2m_engine_handle_get_string(const struct lwm2m_res_handle *handle,
+				   void *str, u16_t strlen);
+int lwm2m_engine_handle_get_u8(const struct lwm2m_res_handle *handle,
+			       u8_t *value);
+int lwm2m_engine_handle_get_u16(const struct lwm2m_res_handle *handle,
+				u16_t *value);
+int lwm2m_engine_handle_get_u32(const struct lwm2m_res_handle *handle,
+				u32_t *value);
+int lwm2m_engine_handle_get_u64(const struct lwm2m_res_handle *handle,
+				u64_t *value);
+int lwm2m_engine_handle_get_s8(const struct lwm2m_res_handle *handle,
+			       s8_t *value);
+int lwm2m_engine_handle_get_s16(const struct lwm2m_res_handle *handle,
+				s16_t *value);
+int lwm2m_engine_handle_get_s32(const struct lwm2m_res_handle *handle,
+				s32_t *value);
+int lwm2m_engine_handle_get_s64(const struct lwm2m_res_handle *handle,
+				s64_t *value);
+int lwm2m_engine_handle_get_bool(const struct lwm2m_res_handle *handle,
+				 bool *value);
+int lwm2m_engine_handle_get_float32(const struct lwm2m_res_handle *handle,
+				    float32_value_t *buf);
+int lwm2m_engine_handle_get_float64(const struct lwm2m_res_handle *handle,
+				    float64_value_t *buf);
+
 int lwm2m_engine_register_read_callback(char *path,
 					lwm2m_engine_get_data_cb_t cb);
 int lwm2m_engine_register_pre_write_callback(char *path,
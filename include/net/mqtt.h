@@ -384,6 +384,42 @@ struct mqtt_transport {
 	};
 };
 
+#if defined(CONFIG_MQTT_LIB_SESSION)
+/** @brief Outgoing QoS 1/2 message tracked by the session layer. */
+struct mqtt_inflight {
+	/** Wall clock value (in milliseconds) of the last transmission. */
+	u32_t sent_at;
+
+	/** Length of the PUBLISH or PUBREL packet stored for the message,
+	 *  0 if the entry is free.
+	 */
+	u32_t len;
+
+	/** Message id of the in-flight message. */
+	u16_t message_id;
+
+	/** Packet is queued for transmission and has not been sent yet. */
+	bool queued;
+};
+
+/**
+ * @brief Session layer storage hook.
+ *
+ * Called whenever the packet kept for an in-flight message changes, so that
+ * the application can mirror it to persistent storage and feed it back with
+ * @ref mqtt_session_restore after a reboot.
+ *
+ * @param[in] client Client instance for which the hook is called.
+ * @param[in] message_id Message id of the in-flight message.
+ * @param[in] packet Packet to be retransmitted for the message, NULL if the
+ *                   message has been acknowledged and can be forgotten.
+ * @param[in] len Length of the packet, 0 if packet is NULL.
+ */
+typedef void (*mqtt_session_cb_t)(struct mqtt_client *client,
+				  u16_t message_id, const u8_t *packet,
+				  u32_t len);
+#endif /* CONFIG_MQTT_LIB_SESSION */
+
 /** @brief MQTT internal state. */
 struct mqtt_internal {
 	/** Internal. Mutex to protect access to the client instance. */
@@ -402,6 +438,17 @@ struct mqtt_internal {
 
 	/** Internal. Remaining payload length to read. */
 	u32_t remaining_payload;
+
+#if defined(CONFIG_MQTT_LIB_SESSION)
+	/** Internal. Number of bytes queued in tx_buf, not sent yet. */
+	u32_t tx_queued;
+
+	/** Internal. Outgoing QoS 1/2 messages awaiting acknowledgment. */
+	struct mqtt_inflight inflight[CONFIG_MQTT_LIB_SESSION_WINDOW];
+
+	/** Internal. Last message id assigned by the session layer. */
+	u16_t last_message_id;
+#endif
 };
 
 /**
@@ -469,6 +516,21 @@ struct mqtt_client {
 	 *  Default is 1.
 	 */
 	u8_t clean_session : 1;
+
+#if defined(CONFIG_MQTT_LIB_SESSION)
+	/** Storage for the packets of in-flight QoS 1/2 messages, split
+	 *  evenly between CONFIG_MQTT_LIB_SESSION_WINDOW messages. Messages
+	 *  published with @ref mqtt_session_publish shall fit in one share.
+	 */
+	u8_t *session_buf;
+
+	/** Size of session storage. */
+	u32_t session_buf_size;
+
+	/** Optional hook to mirror in-flight messages to persistent storage.
+	 */
+	mqtt_session_cb_t session_cb;
+#endif
 };
 
 /**
@@ -680,6 +742,65 @@ int mqtt_input(struct mqtt_client *client);
 int mqtt_read_publish_payload(struct mqtt_client *client, void *buffer,
 			      size_t length);
 
+#if defined(CONFIG_MQTT_LIB_SESSION)
+/**
+ * @brief API to publish a message through the session layer.
+ *
+ * Unlike @ref mqtt_publish, the library takes care of the message id, keeps
+ * a copy of QoS 1/2 messages until they are acknowledged, retransmits them
+ * with the DUP flag set when needed and handles the PUBREC/PUBREL exchange
+ * of QoS 2 on its own: only @ref MQTT_EVT_PUBACK and @ref MQTT_EVT_PUBCOMP
+ * are notified for such messages. Up to CONFIG_MQTT_LIB_SESSION_WINDOW
+ * messages can be in flight at the same time.
+ *
+ * The encoded message is queued in the transmit buffer together with other
+ * small messages and sent in a single transport write once the buffer is
+ * full, or when @ref mqtt_session_flush, @ref mqtt_input, @ref mqtt_live or
+ * any other API sending data is called.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ * @param[in] param Parameters to be used for the publish message, the
+ *                  message_id and dup_flag fields are ignored. Shall not be
+ *                  NULL. The message does not need to remain valid after
+ *                  the call.
+ *
+ * @return Message id assigned to a QoS 1/2 message, 0 for a QoS 0 message,
+ *         -EBUSY if the in-flight window is full, or another negative error
+ *         code (errno.h) indicating reason of failure.
+ */
+int mqtt_session_publish(struct mqtt_client *client,
+			 const struct mqtt_publish_param *param);
+
+/**
+ * @brief API to send the messages queued by @ref mqtt_session_publish.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ */
+int mqtt_session_flush(struct mqtt_client *client);
+
+/**
+ * @brief API to put back an in-flight message saved through the
+ *        @ref mqtt_session_cb_t hook, typically after a reboot.
+ *
+ * Shall be called before @ref mqtt_connect, in the order the messages were
+ * originally reported. Restored messages are retransmitted once a
+ * connection with clean_session set to 0 is accepted by the broker.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ * @param[in] packet Packet reported by the storage hook.
+ * @param[in] len Length of the packet.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ */
+int mqtt_session_restore(struct mqtt_client *client, const u8_t *packet,
+			 u32_t len);
+#endif /* CONFIG_MQTT_LIB_SESSION */
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,8 +40,16 @@ extern "C" {
  * @param write_block_size Alignment size
  * @param locked State of the filesystem, locked = true means the filesystem is
  * read only
+ * @param gc_ate_wra Allocation table entry write address after the last
+ * garbage collection
  * @param nvs_lock Mutex
  * @param flash_device Flash Device
+ * @param gc_work Background garbage collection work item
+ * @param gc_erase_lock Mutex held while background garbage collection erases
+ * a sector
+ * @param gc_erase_addr Address of the sector erased by background garbage
+ * collection
+ * @param gc_erasing The sector at gc_erase_addr is not erased yet
  */
 struct nvs_fs {
 	off_t offset;		/* filesystem offset in flash */
@@ -59,8 +67,15 @@ struct nvs_fs {
 		      * it can be unlocked by calling nvs_init again, this
 		      * will destroy all stored data
 		      */
+	u32_t gc_ate_wra;	/* ate_wra after the last garbage collection */
 	struct k_mutex nvs_lock;
 	struct device *flash_device;
+#ifdef CONFIG_NVS_BACKGROUND_GC
+	struct k_work gc_work;
+	struct k_mutex gc_erase_lock;
+	u32_t gc_erase_addr;
+	bool gc_erasing;
+#endif
 };
 
 /**
@@ -108,6 +123,24 @@ int nvs_reinit(struct nvs_fs *fs);
  */
 int nvs_clear(struct nvs_fs *fs);
 
+/**
+ * @brief nvs_compact
+ *
+ * Garbage collect the oldest sector ahead of time. If less than min_free
+ * bytes are free in the sector being written, the sector is closed and the
+ * valid entries of the oldest sector are moved to the next sector, as a
+ * write which does not fit would do. Calling this when the system is idle
+ * keeps the time of garbage collection out of later writes. Nothing is done
+ * if nothing was written since the last garbage collection.
+ *
+ * @param fs Pointer to file system
+ * @param min_free Free space in bytes below which garbage collection is done
+ * @retval 0 Success, garbage collection was not needed
+ * @retval 1 Success, garbage collection was done
+ * @retval -ERRNO errno code if error
+ */
+int nvs_compact(struct nvs_fs *fs, size_t min_free);
+
 /**
  * @brief nvs_write
  *
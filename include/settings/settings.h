@@ -45,7 +45,9 @@ struct settings_handler {
 	/**< Linked list node info for module internal usage. */
 
 	char *name;
-	/**< Name of subtree. */
+	/**< Name of subtree. It may span several levels, e.g. "bt/mesh",
+	 * items are passed to the handler with the longest matching name.
+	 */
 
 	int (*h_get)(int argc, char **argv, char *val, int val_len_max);
 	/**< Get values handler of settings items identified by keyword names.
@@ -118,6 +120,19 @@ int settings_register(struct settings_handler *cf);
  */
 int settings_load(void);
 
+/**
+ * Load serialized items of one subtree from registered persistence
+ * sources. Only items named @p subtree or placed below it are passed to
+ * the handlers, and only the handlers which may have got such items are
+ * committed.
+ *
+ * @param subtree Name of the subtree, e.g. "bt" or "bt/mesh". NULL loads
+ * all items, as @ref settings_load does.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int settings_load_subtree(const char *subtree);
+
 /**
  * Save currently running serialized items. All serialized items which are different
  * from currently persisted values will be saved.
@@ -7,6 +7,7 @@
 #define ZEPHYR_INCLUDE_SPINLOCK_H_
 
 #include <atomic.h>
+#include <irq.h>
 
 struct k_spinlock_key {
 	int key;
@@ -33,6 +34,10 @@ static inline k_spinlock_key_t k_spin_lock(struct k_spinlock *l)
 	 */
 	k.key = _arch_irq_lock();
 
+#ifdef CONFIG_LATENCY_STATS
+	(void)_latency_irq_lock(k.key, _LATENCY_SITE());
+#endif
+
 #ifdef CONFIG_SMP
 # ifdef CONFIG_DEBUG
 	l->saved_key = k.key;
@@ -63,7 +68,12 @@ static inline void k_spin_unlock(struct k_spinlock *l, k_spinlock_key_t key)
 	 */
 	atomic_clear(&l->locked);
 #endif
+
+#ifdef CONFIG_LATENCY_STATS
+	_latency_irq_unlock(key.key);
+#else
 	_arch_irq_unlock(key.key);
+#endif
 }
 
 #endif /* ZEPHYR_INCLUDE_SPINLOCK_H_ */
@@ -441,6 +441,7 @@ struct uart_driver_api {
  * @param callback  Event handler.
  * @param user_data Data to pass to event handler function.
  *
+ * @retval -ENOTSUP If not supported by the driver.
  * @retval 0	    If successful, negative errno code otherwise.
  */
 static inline int uart_callback_set(struct device *dev,
@@ -450,6 +451,10 @@ static inline int uart_callback_set(struct device *dev,
 	const struct uart_driver_api *api =
 			(const struct uart_driver_api *)dev->driver_api;
 
+	if (!api->callback_set) {
+		return -ENOTSUP;
+	}
+
 	return api->callback_set(dev, callback, user_data);
 }
 
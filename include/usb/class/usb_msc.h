@@ -101,6 +101,7 @@ struct CSW {
 #define READ10				0x28
 #define WRITE10				0x2A
 #define VERIFY10			0x2F
+#define SYNCHRONIZE_CACHE10		0x35
 #define READ12				0xA8
 #define WRITE12				0xAA
 #define MODE_SELECT10			0x55
@@ -151,7 +151,10 @@ void idle(void *unused1, void *unused2, void *unused3)
 	}
 #else
 	for (;;) {
-		(void)irq_lock();
+		/* Interrupts are enabled by k_cpu_idle(), not irq_unlock(),
+		 * so the lock is not visible to CONFIG_LATENCY_STATS.
+		 */
+		(void)_arch_irq_lock();
 		sys_power_save_idle();
 
 		IDLE_YIELD_IF_COOP();
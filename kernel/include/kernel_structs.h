@@ -107,6 +107,15 @@ struct _cpu {
 	/* True when _current is allowed to context switch */
 	u8_t swap_ok;
 #endif
+
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+	/* cycle counter value and tick count when _current was switched in */
+	u32_t usage0;
+	s64_t usage0_ticks;
+
+	/* cycles accounted to the threads run by this CPU */
+	u64_t usage_total;
+#endif
 };
 
 typedef struct _cpu _cpu_t;
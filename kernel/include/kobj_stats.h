@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_KERNEL_INCLUDE_KOBJ_STATS_H_
+#define ZEPHYR_KERNEL_INCLUDE_KOBJ_STATS_H_
+
+#include <kernel.h>
+#include <string.h>
+
+/*
+ * Usage statistics of kernel objects (CONFIG_OBJECT_STATS).
+ *
+ * Objects pass _OBJ_STATS(obj) to the helpers, which is NULL when statistics
+ * are disabled, so the calls compile to nothing. Unless noted otherwise,
+ * helpers are called with interrupts locked.
+ */
+
+#ifdef CONFIG_OBJECT_STATS
+
+#define _OBJ_STATS(obj) (&(obj)->__stats)
+
+static inline void _obj_stats_init(struct k_obj_stats *stats)
+{
+	(void)memset(stats, 0, sizeof(*stats));
+}
+
+static inline void _obj_stats_take(struct k_obj_stats *stats)
+{
+	stats->takes++;
+}
+
+static inline void _obj_stats_give(struct k_obj_stats *stats)
+{
+	stats->gives++;
+}
+
+static inline void _obj_stats_fail(struct k_obj_stats *stats)
+{
+	stats->failed++;
+}
+
+/* Called before the current thread is pended on the object, returns start
+ * of the wait for _obj_stats_wait_end().
+ */
+static inline u32_t _obj_stats_wait_start(struct k_obj_stats *stats)
+{
+	stats->blocked++;
+
+	return k_cycle_get_32();
+}
+
+/* Called without interrupts locked after the wait with its result. Take
+ * tells if the thread waited to take (or give) the object.
+ */
+static inline void _obj_stats_wait_end(struct k_obj_stats *stats,
+				       u32_t start, int result, bool take)
+{
+	u32_t wait = k_cycle_get_32() - start;
+	unsigned int key = irq_lock();
+
+	stats->wait_total += wait;
+	if (wait > stats->wait_max) {
+		stats->wait_max = wait;
+	}
+
+	if (result != 0) {
+		stats->failed++;
+	} else if (take) {
+		stats->takes++;
+	} else {
+		stats->gives++;
+	}
+
+	irq_unlock(key);
+}
+
+static inline void _obj_stats_hold_start(struct k_obj_stats *stats)
+{
+	stats->hold_start = k_cycle_get_32();
+}
+
+static inline void _obj_stats_hold_end(struct k_obj_stats *stats)
+{
+	u32_t hold = k_cycle_get_32() - stats->hold_start;
+
+	stats->hold_total += hold;
+	if (hold > stats->hold_max) {
+		stats->hold_max = hold;
+	}
+}
+
+#else
+
+struct k_obj_stats;
+
+#define _OBJ_STATS(obj) ((struct k_obj_stats *)NULL)
+
+static inline void _obj_stats_init(struct k_obj_stats *stats) { }
+static inline void _obj_stats_take(struct k_obj_stats *stats) { }
+static inline void _obj_stats_give(struct k_obj_stats *stats) { }
+static inline void _obj_stats_fail(struct k_obj_stats *stats) { }
+
+static inline u32_t _obj_stats_wait_start(struct k_obj_stats *stats)
+{
+	return 0;
+}
+
+static inline void _obj_stats_wait_end(struct k_obj_stats *stats,
+				       u32_t start, int result, bool take) { }
+static inline void _obj_stats_hold_start(struct k_obj_stats *stats) { }
+static inline void _obj_stats_hold_end(struct k_obj_stats *stats) { }
+
+#endif /* CONFIG_OBJECT_STATS */
+
+#endif /* ZEPHYR_KERNEL_INCLUDE_KOBJ_STATS_H_ */
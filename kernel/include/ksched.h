@@ -51,6 +51,19 @@ struct k_thread *_find_first_thread_to_unpend(_wait_q_t *wait_q,
 void idle(void *a, void *b, void *c);
 void z_time_slice(int ticks);
 
+/* Scheduler lock and wakeup latencies are attributed to the caller of the
+ * kernel API, the hooks are called from always inlined functions.
+ */
+#ifdef CONFIG_LATENCY_STATS
+void _latency_sched_lock(void *site);
+void _latency_sched_unlock(void);
+void _latency_thread_ready(struct k_thread *thread, void *site);
+#else
+#define _latency_sched_lock(site) /**/
+#define _latency_sched_unlock() /**/
+#define _latency_thread_ready(thread, site) /**/
+#endif
+
 /* find which one is the next thread to run */
 /* must be called with interrupts locked */
 #ifdef CONFIG_SMP
@@ -215,8 +228,10 @@ static inline bool _is_valid_prio(int prio, void *entry_point)
 	return true;
 }
 
-static inline void _ready_thread(struct k_thread *thread)
+static ALWAYS_INLINE void _ready_thread(struct k_thread *thread)
 {
+	_latency_thread_ready(thread, __builtin_return_address(0));
+
 	if (_is_thread_ready(thread)) {
 		_add_thread_to_ready_q(thread);
 	}
@@ -233,12 +248,13 @@ static inline void _ready_one_thread(_wait_q_t *wq)
 	}
 }
 
-static inline void _sched_lock(void)
+static ALWAYS_INLINE void _sched_lock(void)
 {
 #ifdef CONFIG_PREEMPT_ENABLED
 	__ASSERT(!_is_in_isr(), "");
 	__ASSERT(_current->base.sched_locked != 1, "");
 
+	_latency_sched_lock(__builtin_return_address(0));
 	--_current->base.sched_locked;
 
 	compiler_barrier();
@@ -257,6 +273,7 @@ static ALWAYS_INLINE void _sched_unlock_no_reschedule(void)
 	compiler_barrier();
 
 	++_current->base.sched_locked;
+	_latency_sched_unlock();
 #endif
 }
 
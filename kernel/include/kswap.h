@@ -15,6 +15,20 @@ extern void _check_stack_sentinel(void);
 #define _check_stack_sentinel() /**/
 #endif
 
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+extern void _thread_runtime_stats_switch(void);
+#else
+#define _thread_runtime_stats_switch() /**/
+#endif
+
+#ifdef CONFIG_LATENCY_STATS
+extern void _latency_swap_out(void);
+extern void _latency_swap_in(void);
+#else
+#define _latency_swap_out() /**/
+#define _latency_swap_in() /**/
+#endif
+
 
 /* In SMP, the irq_lock() is a spinlock which is implicitly released
  * and reacquired on context switch to preserve the existing
@@ -56,6 +70,8 @@ static inline int _Swap(unsigned int key)
 	if (new_thread != old_thread) {
 		old_thread->swap_retval = -EAGAIN;
 
+		_thread_runtime_stats_switch();
+
 #ifdef CONFIG_SMP
 		_current_cpu->swap_ok = 0;
 
@@ -64,9 +80,11 @@ static inline int _Swap(unsigned int key)
 		_smp_release_global_lock(new_thread);
 #endif
 
+		_latency_swap_out();
 		_current = new_thread;
 		_arch_switch(new_thread->switch_handle,
 			     &old_thread->switch_handle);
+		_latency_swap_in();
 	}
 
 #ifdef CONFIG_TRACING
@@ -91,8 +109,12 @@ static inline int _Swap(unsigned int key)
 #ifdef CONFIG_TRACING
 	sys_trace_thread_switched_out();
 #endif
+	/* ARM accounts the switch in PendSV, which also handles preemption */
+	_thread_runtime_stats_switch();
 #endif
+	_latency_swap_out();
 	ret = __swap(key);
+	_latency_swap_in();
 #ifndef CONFIG_ARM
 #ifdef CONFIG_TRACING
 	sys_trace_thread_switched_in();
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <kernel.h>
+#include <kernel_structs.h>
+#include <ksched.h>
+#include <kswap.h>
+#include <init.h>
+#include <string.h>
+#include <misc/__assert.h>
+#include <debug/latency_stats.h>
+
+/*
+ * Histograms are updated with the architecture lock so that recording does
+ * not recurse into the instrumented irq_lock().
+ */
+static struct sys_latency_hist hists[SYS_LATENCY_TYPES];
+
+/* Timestamps are meaningful only once the system timer runs. */
+static bool ready;
+
+/* Outermost interrupt locked section, the system is uniprocessor. Site is
+ * NULL while no section is measured.
+ */
+static u32_t irq_lock_depth;
+static u32_t irq_lock_start;
+static void *irq_lock_site;
+
+/* Timer drivers may lock interrupts to read the counter, which must not be
+ * accounted as a locked section.
+ */
+static u32_t cycles_now(void)
+{
+	unsigned int key = _arch_irq_lock();
+	u32_t now;
+
+	irq_lock_depth++;
+	now = k_cycle_get_32();
+	irq_lock_depth--;
+
+	_arch_irq_unlock(key);
+
+	return now;
+}
+
+static unsigned int bucket_get(u32_t cycles)
+{
+	unsigned int bucket;
+
+	if (cycles == 0U) {
+		return 0;
+	}
+
+	bucket = 32 - __builtin_clz(cycles);
+
+	return min(bucket, SYS_LATENCY_BUCKETS - 1);
+}
+
+/* Keep the sites with the longest samples. Sites are allocated in order and
+ * only released all at once, so the first unused one ends the search.
+ */
+static void site_record(struct sys_latency_hist *hist, u32_t cycles,
+			void *site)
+{
+	struct sys_latency_site *victim = NULL;
+
+	for (int i = 0; i < CONFIG_LATENCY_STATS_SITES; i++) {
+		struct sys_latency_site *s = &hist->sites[i];
+
+		if (s->site == site) {
+			s->count++;
+			s->max = max(s->max, cycles);
+			return;
+		}
+
+		if (s->site == NULL) {
+			victim = s;
+			break;
+		}
+
+		if (victim == NULL || s->max < victim->max) {
+			victim = s;
+		}
+	}
+
+	if (victim->site == NULL || cycles > victim->max) {
+		victim->site = site;
+		victim->count = 1U;
+		victim->max = cycles;
+	}
+}
+
+void sys_latency_record(enum sys_latency_type type, u32_t cycles,
+			void *site)
+{
+	struct sys_latency_hist *hist;
+	unsigned int key;
+
+	__ASSERT(type < SYS_LATENCY_TYPES, "invalid latency type %d", type);
+
+	hist = &hists[type];
+	key = _arch_irq_lock();
+
+	hist->buckets[bucket_get(cycles)]++;
+	hist->count++;
+	hist->total += cycles;
+	hist->max = max(hist->max, cycles);
+	site_record(hist, cycles, site);
+
+	_arch_irq_unlock(key);
+}
+
+void sys_latency_get(enum sys_latency_type type,
+		     struct sys_latency_hist *hist)
+{
+	unsigned int key;
+
+	__ASSERT(type < SYS_LATENCY_TYPES, "invalid latency type %d", type);
+
+	key = _arch_irq_lock();
+	(void)memcpy(hist, &hists[type], sizeof(*hist));
+	_arch_irq_unlock(key);
+}
+
+void sys_latency_reset(void)
+{
+	unsigned int key = _arch_irq_lock();
+
+	(void)memset(hists, 0, sizeof(hists));
+
+	_arch_irq_unlock(key);
+}
+
+u32_t sys_latency_percentile(const struct sys_latency_hist *hist,
+			     u32_t permille)
+{
+	u32_t target;
+	u32_t seen = 0U;
+
+	if (hist->count == 0U) {
+		return 0;
+	}
+
+	/* Number of samples at or below the percentile, at least one. */
+	target = ((u64_t)hist->count * min(permille, 1000U) + 999U) / 1000U;
+	target = max(target, 1U);
+
+	for (int i = 0; i < SYS_LATENCY_BUCKETS - 1; i++) {
+		seen += hist->buckets[i];
+		if (seen >= target) {
+			return min((u32_t)((1ULL << i) - 1), hist->max);
+		}
+	}
+
+	return hist->max;
+}
+
+unsigned int _latency_irq_lock(unsigned int key, void *site)
+{
+	/* Only the outermost lock starts a section. */
+	if (irq_lock_depth++ == 0U && ready) {
+		irq_lock_site = site;
+		irq_lock_start = cycles_now();
+	}
+
+	return key;
+}
+
+void _latency_irq_unlock(unsigned int key)
+{
+	/* Depth is zero for a lock released by a context switch. */
+	if (irq_lock_depth != 0U) {
+		if (irq_lock_depth == 1U && irq_lock_site != NULL) {
+			sys_latency_record(SYS_LATENCY_IRQ_LOCKED,
+					   cycles_now() - irq_lock_start,
+					   irq_lock_site);
+			irq_lock_site = NULL;
+		}
+
+		irq_lock_depth--;
+	}
+
+	_arch_irq_unlock(key);
+}
+
+void _latency_swap_out(void)
+{
+	/* The lock passed to _Swap() is released by the switch itself. */
+	if (irq_lock_site != NULL) {
+		sys_latency_record(SYS_LATENCY_IRQ_LOCKED,
+				   cycles_now() - irq_lock_start,
+				   irq_lock_site);
+		irq_lock_site = NULL;
+	}
+
+	irq_lock_depth = 0U;
+
+	/* A thread which switches out on its own was not woken up. */
+	_current->base.wakeup_site = NULL;
+}
+
+void _latency_swap_in(void)
+{
+	struct _thread_base *base = &_current->base;
+
+	if (base->wakeup_site != NULL) {
+		sys_latency_record(SYS_LATENCY_THREAD_WAKEUP,
+				   cycles_now() - base->wakeup_start,
+				   base->wakeup_site);
+		base->wakeup_site = NULL;
+	}
+}
+
+void _latency_thread_ready(struct k_thread *thread, void *site)
+{
+	if (_is_in_isr() && ready) {
+		thread->base.wakeup_start = cycles_now();
+		thread->base.wakeup_site = site;
+	} else {
+		thread->base.wakeup_site = NULL;
+	}
+}
+
+void _latency_sched_lock(void *site)
+{
+	struct _thread_base *base = &_current->base;
+
+	if (base->sched_locked == 0U && ready) {
+		base->sched_lock_start = cycles_now();
+		base->sched_lock_site = site;
+	}
+}
+
+void _latency_sched_unlock(void)
+{
+	struct _thread_base *base = &_current->base;
+
+	if (base->sched_locked == 0U && base->sched_lock_site != NULL) {
+		sys_latency_record(SYS_LATENCY_SCHED_LOCKED,
+				   cycles_now() - base->sched_lock_start,
+				   base->sched_lock_site);
+		base->sched_lock_site = NULL;
+	}
+}
+
+static int latency_stats_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	ready = true;
+
+	return 0;
+}
+
+SYS_INIT(latency_stats_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
@@ -13,6 +13,7 @@
 #include <misc/dlist.h>
 #include <ksched.h>
 #include <init.h>
+#include <kobj_stats.h>
 
 extern struct k_mem_slab _k_mem_slab_list_start[];
 extern struct k_mem_slab _k_mem_slab_list_end[];
@@ -80,6 +81,7 @@ void k_mem_slab_init(struct k_mem_slab *slab, void *buffer,
 	create_free_list(slab);
 	_waitq_init(&slab->wait_q);
 	SYS_TRACING_OBJ_INIT(k_mem_slab, slab);
+	_obj_stats_init(_OBJ_STATS(slab));
 
 	_k_object_init(slab);
 }
@@ -87,6 +89,7 @@ void k_mem_slab_init(struct k_mem_slab *slab, void *buffer,
 int k_mem_slab_alloc(struct k_mem_slab *slab, void **mem, s32_t timeout)
 {
 	unsigned int key = irq_lock();
+	u32_t wait_start;
 	int result;
 
 	if (slab->free_list != NULL) {
@@ -94,14 +97,18 @@ int k_mem_slab_alloc(struct k_mem_slab *slab, void **mem, s32_t timeout)
 		*mem = slab->free_list;
 		slab->free_list = *(char **)(slab->free_list);
 		slab->num_used++;
+		_obj_stats_take(_OBJ_STATS(slab));
 		result = 0;
 	} else if (timeout == K_NO_WAIT) {
 		/* don't wait for a free block to become available */
 		*mem = NULL;
+		_obj_stats_fail(_OBJ_STATS(slab));
 		result = -ENOMEM;
 	} else {
 		/* wait for a free block or timeout */
+		wait_start = _obj_stats_wait_start(_OBJ_STATS(slab));
 		result = _pend_current_thread(key, &slab->wait_q, timeout);
+		_obj_stats_wait_end(_OBJ_STATS(slab), wait_start, result, true);
 		if (result == 0) {
 			*mem = _current->base.swap_data;
 		}
@@ -118,6 +125,8 @@ void k_mem_slab_free(struct k_mem_slab *slab, void **mem)
 	int key = irq_lock();
 	struct k_thread *pending_thread = _unpend_first_thread(&slab->wait_q);
 
+	_obj_stats_give(_OBJ_STATS(slab));
+
 	if (pending_thread != NULL) {
 		_set_thread_return_value_with_data(pending_thread, 0, *mem);
 		_ready_thread(pending_thread);
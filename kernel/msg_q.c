@@ -21,6 +21,7 @@
 #include <init.h>
 #include <syscall_handler.h>
 #include <kernel_internal.h>
+#include <kobj_stats.h>
 
 extern struct k_msgq _k_msgq_list_start[];
 extern struct k_msgq _k_msgq_list_end[];
@@ -61,6 +62,7 @@ void k_msgq_init(struct k_msgq *q, char *buffer, size_t msg_size,
 	q->flags = 0;
 	_waitq_init(&q->wait_q);
 	SYS_TRACING_OBJ_INIT(k_msgq, q);
+	_obj_stats_init(_OBJ_STATS(q));
 
 	_k_object_init(q);
 }
@@ -115,10 +117,12 @@ int _impl_k_msgq_put(struct k_msgq *q, void *data, s32_t timeout)
 
 	unsigned int key = irq_lock();
 	struct k_thread *pending_thread;
+	u32_t wait_start;
 	int result;
 
 	if (q->used_msgs < q->max_msgs) {
 		/* message queue isn't full */
+		_obj_stats_give(_OBJ_STATS(q));
 		pending_thread = _unpend_first_thread(&q->wait_q);
 		if (pending_thread != NULL) {
 			/* give message to waiting thread */
@@ -141,11 +145,15 @@ int _impl_k_msgq_put(struct k_msgq *q, void *data, s32_t timeout)
 		result = 0;
 	} else if (timeout == K_NO_WAIT) {
 		/* don't wait for message space to become available */
+		_obj_stats_fail(_OBJ_STATS(q));
 		result = -ENOMSG;
 	} else {
 		/* wait for put message success, failure, or timeout */
 		_current->base.swap_data = data;
-		return _pend_current_thread(key, &q->wait_q, timeout);
+		wait_start = _obj_stats_wait_start(_OBJ_STATS(q));
+		result = _pend_current_thread(key, &q->wait_q, timeout);
+		_obj_stats_wait_end(_OBJ_STATS(q), wait_start, result, false);
+		return result;
 	}
 
 	irq_unlock(key);
@@ -190,10 +198,12 @@ int _impl_k_msgq_get(struct k_msgq *q, void *data, s32_t timeout)
 
 	unsigned int key = irq_lock();
 	struct k_thread *pending_thread;
+	u32_t wait_start;
 	int result;
 
 	if (q->used_msgs > 0) {
 		/* take first available message from queue */
+		_obj_stats_take(_OBJ_STATS(q));
 		(void)memcpy(data, q->read_ptr, q->msg_size);
 		q->read_ptr += q->msg_size;
 		if (q->read_ptr == q->buffer_end) {
@@ -222,11 +232,15 @@ int _impl_k_msgq_get(struct k_msgq *q, void *data, s32_t timeout)
 		result = 0;
 	} else if (timeout == K_NO_WAIT) {
 		/* don't wait for a message to become available */
+		_obj_stats_fail(_OBJ_STATS(q));
 		result = -ENOMSG;
 	} else {
 		/* wait for get message success or timeout */
 		_current->base.swap_data = data;
-		return _pend_current_thread(key, &q->wait_q, timeout);
+		wait_start = _obj_stats_wait_start(_OBJ_STATS(q));
+		result = _pend_current_thread(key, &q->wait_q, timeout);
+		_obj_stats_wait_end(_OBJ_STATS(q), wait_start, result, true);
+		return result;
 	}
 
 	irq_unlock(key);
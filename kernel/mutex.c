@@ -37,6 +37,7 @@
 #include <init.h>
 #include <syscall_handler.h>
 #include <tracing.h>
+#include <kobj_stats.h>
 
 #define RECORD_STATE_CHANGE(mutex) do { } while (false)
 #define RECORD_CONFLICT(mutex) do { } while (false)
@@ -78,6 +79,7 @@ void _impl_k_mutex_init(struct k_mutex *mutex)
 	_waitq_init(&mutex->wait_q);
 
 	SYS_TRACING_OBJ_INIT(k_mutex, mutex);
+	_obj_stats_init(_OBJ_STATS(mutex));
 	_k_object_init(mutex);
 	sys_trace_end_call(SYS_TRACE_ID_MUTEX_INIT);
 }
@@ -116,6 +118,7 @@ static void adjust_owner_prio(struct k_mutex *mutex, s32_t new_prio)
 
 int _impl_k_mutex_lock(struct k_mutex *mutex, s32_t timeout)
 {
+	u32_t wait_start;
 	int new_prio;
 	u32_t key;
 
@@ -130,6 +133,11 @@ int _impl_k_mutex_lock(struct k_mutex *mutex, s32_t timeout)
 					_current->base.prio :
 					mutex->owner_orig_prio;
 
+		if (mutex->lock_count == 0U) {
+			_obj_stats_hold_start(_OBJ_STATS(mutex));
+		}
+		_obj_stats_take(_OBJ_STATS(mutex));
+
 		mutex->lock_count++;
 		mutex->owner = _current;
 
@@ -146,6 +154,7 @@ int _impl_k_mutex_lock(struct k_mutex *mutex, s32_t timeout)
 	RECORD_CONFLICT();
 
 	if (unlikely(timeout == (s32_t)K_NO_WAIT)) {
+		_obj_stats_fail(_OBJ_STATS(mutex));
 		k_sched_unlock();
 		sys_trace_end_call(SYS_TRACE_ID_MUTEX_LOCK);
 		return -EBUSY;
@@ -162,8 +171,12 @@ int _impl_k_mutex_lock(struct k_mutex *mutex, s32_t timeout)
 		adjust_owner_prio(mutex, new_prio);
 	}
 
+	wait_start = _obj_stats_wait_start(_OBJ_STATS(mutex));
+
 	s32_t got_mutex = _pend_current_thread(key, &mutex->wait_q, timeout);
 
+	_obj_stats_wait_end(_OBJ_STATS(mutex), wait_start, got_mutex, true);
+
 	K_DEBUG("on mutex %p got_mutex value: %d\n", mutex, got_mutex);
 
 	K_DEBUG("%p got mutex %p (y/n): %c\n", _current, mutex,
@@ -222,6 +235,8 @@ void _impl_k_mutex_unlock(struct k_mutex *mutex)
 
 	K_DEBUG("mutex %p lock_count: %d\n", mutex, mutex->lock_count);
 
+	_obj_stats_give(_OBJ_STATS(mutex));
+
 	if (mutex->lock_count - 1U != 0U) {
 		mutex->lock_count--;
 		goto k_mutex_unlock_return;
@@ -229,6 +244,8 @@ void _impl_k_mutex_unlock(struct k_mutex *mutex)
 
 	key = irq_lock();
 
+	_obj_stats_hold_end(_OBJ_STATS(mutex));
+
 	adjust_owner_prio(mutex, mutex->owner_orig_prio);
 
 	new_owner = _unpend_first_thread(&mutex->wait_q);
@@ -239,6 +256,8 @@ void _impl_k_mutex_unlock(struct k_mutex *mutex)
 		mutex, new_owner, new_owner ? new_owner->base.prio : -1000);
 
 	if (new_owner != NULL) {
+		/* mutex is handed over, the new owner holds it from now */
+		_obj_stats_hold_start(_OBJ_STATS(mutex));
 		_ready_thread(new_owner);
 
 		irq_unlock(key);
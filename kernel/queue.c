@@ -22,6 +22,7 @@
 #include <init.h>
 #include <syscall_handler.h>
 #include <kernel_internal.h>
+#include <kobj_stats.h>
 
 extern struct k_queue _k_queue_list_start[];
 extern struct k_queue _k_queue_list_end[];
@@ -91,6 +92,7 @@ void _impl_k_queue_init(struct k_queue *queue)
 #endif
 
 	SYS_TRACING_OBJ_INIT(k_queue, queue);
+	_obj_stats_init(_OBJ_STATS(queue));
 	_k_object_init(queue);
 }
 
@@ -153,6 +155,7 @@ static s32_t queue_insert(struct k_queue *queue, void *prev, void *data,
 	first_pending_thread = _unpend_first_thread(&queue->wait_q);
 
 	if (first_pending_thread != NULL) {
+		_obj_stats_give(_OBJ_STATS(queue));
 		prepare_thread_to_run(first_pending_thread, data);
 		_reschedule(key);
 		return 0;
@@ -174,6 +177,7 @@ static s32_t queue_insert(struct k_queue *queue, void *prev, void *data,
 		sys_sfnode_init(data, 0x0);
 	}
 	sys_sflist_insert(&queue->data_q, prev, data);
+	_obj_stats_give(_OBJ_STATS(queue));
 
 #if defined(CONFIG_POLL)
 	handle_poll_events(queue, K_POLL_STATE_DATA_AVAILABLE);
@@ -235,6 +239,7 @@ void k_queue_append_list(struct k_queue *queue, void *head, void *tail)
 	__ASSERT(head && tail, "invalid head or tail");
 
 	unsigned int key = irq_lock();
+
 #if !defined(CONFIG_POLL)
 	struct k_thread *thread = NULL;
 
@@ -257,6 +262,9 @@ void k_queue_append_list(struct k_queue *queue, void *head, void *tail)
 	handle_poll_events(queue, K_POLL_STATE_DATA_AVAILABLE);
 #endif /* !CONFIG_POLL */
 
+	/* whole list is accounted as a single give */
+	_obj_stats_give(_OBJ_STATS(queue));
+
 	_reschedule(key);
 }
 
@@ -322,6 +330,7 @@ static void *k_queue_poll(struct k_queue *queue, s32_t timeout)
 void *_impl_k_queue_get(struct k_queue *queue, s32_t timeout)
 {
 	unsigned int key;
+	u32_t wait_start;
 	void *data;
 
 	key = irq_lock();
@@ -331,25 +340,33 @@ void *_impl_k_queue_get(struct k_queue *queue, s32_t timeout)
 
 		node = sys_sflist_get_not_empty(&queue->data_q);
 		data = z_queue_node_peek(node, true);
+		_obj_stats_take(_OBJ_STATS(queue));
 		irq_unlock(key);
 		return data;
 	}
 
 	if (timeout == K_NO_WAIT) {
+		_obj_stats_fail(_OBJ_STATS(queue));
 		irq_unlock(key);
 		return NULL;
 	}
 
+	wait_start = _obj_stats_wait_start(_OBJ_STATS(queue));
+
 #if defined(CONFIG_POLL)
 	irq_unlock(key);
 
-	return k_queue_poll(queue, timeout);
-
+	data = k_queue_poll(queue, timeout);
 #else
 	int ret = _pend_current_thread(key, &queue->wait_q, timeout);
 
-	return (ret != 0) ? NULL : _current->base.swap_data;
+	data = (ret != 0) ? NULL : _current->base.swap_data;
 #endif /* CONFIG_POLL */
+
+	_obj_stats_wait_end(_OBJ_STATS(queue), wait_start,
+			    (data != NULL) ? 0 : -EAGAIN, true);
+
+	return data;
 }
 
 #ifdef CONFIG_USERSPACE
@@ -507,6 +507,8 @@ void k_sched_unlock(void)
 		update_cache(1);
 	}
 
+	_latency_sched_unlock();
+
 	K_DEBUG("scheduler unlocked (%p:%d)\n",
 		_current, _current->base.sched_locked);
 
@@ -542,6 +544,7 @@ void *_get_next_switch_handle(void *interrupted)
 #ifdef CONFIG_TRACING
 			sys_trace_thread_switched_out();
 #endif
+			_thread_runtime_stats_switch();
 			_current = th;
 #ifdef CONFIG_TRACING
 			sys_trace_thread_switched_in();
@@ -553,6 +556,7 @@ void *_get_next_switch_handle(void *interrupted)
 #ifdef CONFIG_TRACING
 	sys_trace_thread_switched_out();
 #endif
+	_thread_runtime_stats_switch();
 	_current = _get_next_ready_thread();
 #ifdef CONFIG_TRACING
 	sys_trace_thread_switched_in();
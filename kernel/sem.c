@@ -28,6 +28,7 @@
 #include <init.h>
 #include <syscall_handler.h>
 #include <tracing.h>
+#include <kobj_stats.h>
 
 extern struct k_sem _k_sem_list_start[];
 extern struct k_sem _k_sem_list_end[];
@@ -70,6 +71,7 @@ void _impl_k_sem_init(struct k_sem *sem, unsigned int initial_count,
 #endif
 
 	SYS_TRACING_OBJ_INIT(k_sem, sem);
+	_obj_stats_init(_OBJ_STATS(sem));
 
 	_k_object_init(sem);
 	sys_trace_end_call(SYS_TRACE_ID_SEMA_INIT);
@@ -117,6 +119,7 @@ void _impl_k_sem_give(struct k_sem *sem)
 	u32_t key = irq_lock();
 
 	sys_trace_void(SYS_TRACE_ID_SEMA_GIVE);
+	_obj_stats_give(_OBJ_STATS(sem));
 	do_sem_give(sem);
 	sys_trace_end_call(SYS_TRACE_ID_SEMA_GIVE);
 	_reschedule(key);
@@ -133,14 +136,19 @@ int _impl_k_sem_take(struct k_sem *sem, s32_t timeout)
 	sys_trace_void(SYS_TRACE_ID_SEMA_TAKE);
 	u32_t key = irq_lock();
 
+	u32_t wait_start;
+	int ret;
+
 	if (likely(sem->count > 0U)) {
 		sem->count--;
+		_obj_stats_take(_OBJ_STATS(sem));
 		irq_unlock(key);
 		sys_trace_end_call(SYS_TRACE_ID_SEMA_TAKE);
 		return 0;
 	}
 
 	if (timeout == K_NO_WAIT) {
+		_obj_stats_fail(_OBJ_STATS(sem));
 		irq_unlock(key);
 		sys_trace_end_call(SYS_TRACE_ID_SEMA_TAKE);
 		return -EBUSY;
@@ -148,7 +156,11 @@ int _impl_k_sem_take(struct k_sem *sem, s32_t timeout)
 
 	sys_trace_end_call(SYS_TRACE_ID_SEMA_TAKE);
 
-	return _pend_current_thread(key, &sem->wait_q, timeout);
+	wait_start = _obj_stats_wait_start(_OBJ_STATS(sem));
+	ret = _pend_current_thread(key, &sem->wait_q, timeout);
+	_obj_stats_wait_end(_OBJ_STATS(sem), wait_start, ret, true);
+
+	return ret;
 }
 
 #ifdef CONFIG_USERSPACE
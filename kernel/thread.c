@@ -198,6 +198,112 @@ const char *_impl_k_thread_name_get(k_tid_t thread_id)
 }
 #endif /* CONFIG_THREAD_NAME */
 
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+/* Cycles since _current was switched in. The 32-bit cycle counter wraps
+ * within seconds on fast CPUs, so whole wraps are counted from the system
+ * ticks, which are precise enough to tell them apart.
+ */
+static u64_t runtime_stats_elapsed(struct _cpu *cpu, u32_t now, s64_t ticks)
+{
+	u32_t cycles = now - cpu->usage0;
+	u64_t approx;
+
+	approx = (u64_t)(ticks - cpu->usage0_ticks) *
+		 sys_clock_hw_cycles_per_tick();
+	if (approx <= cycles) {
+		return cycles;
+	}
+
+	/* Round to the number of wraps closest to the tick count */
+	return cycles + ((approx - cycles + (1ULL << 31)) & ~0xFFFFFFFFULL);
+}
+
+/* Called from the context switch path while _current is still the outgoing
+ * thread. Cycles since the previous switch belong to it.
+ */
+void _thread_runtime_stats_switch(void)
+{
+	struct _cpu *cpu = _current_cpu;
+	u32_t now = k_cycle_get_32();
+	s64_t ticks = z_tick_get();
+	u64_t cycles = runtime_stats_elapsed(cpu, now, ticks);
+
+	_current->base.usage += cycles;
+	cpu->usage_total += cycles;
+	cpu->usage0 = now;
+	cpu->usage0_ticks = ticks;
+}
+
+/* Cycles of the thread currently running on the CPU, not accounted yet. */
+static u64_t runtime_stats_pending(struct _cpu *cpu)
+{
+	return runtime_stats_elapsed(cpu, k_cycle_get_32(), z_tick_get());
+}
+
+int k_thread_runtime_stats_get(k_tid_t thread,
+			       struct k_thread_runtime_stats *stats)
+{
+	unsigned int key;
+
+	if (thread == NULL || stats == NULL) {
+		return -EINVAL;
+	}
+
+	key = irq_lock();
+
+	stats->execution_cycles = thread->base.usage;
+	for (int i = 0; i < CONFIG_MP_NUM_CPUS; i++) {
+		if (_kernel.cpus[i].current == thread) {
+			stats->execution_cycles +=
+				runtime_stats_pending(&_kernel.cpus[i]);
+		}
+	}
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+int k_cpu_runtime_stats_get(int cpu, struct k_cpu_runtime_stats *stats)
+{
+	struct _cpu *c;
+	unsigned int key;
+	u64_t pending;
+
+	if (cpu < 0 || cpu >= CONFIG_MP_NUM_CPUS || stats == NULL) {
+		return -EINVAL;
+	}
+
+	c = &_kernel.cpus[cpu];
+	key = irq_lock();
+
+	pending = runtime_stats_pending(c);
+	stats->total_cycles = c->usage_total + pending;
+	stats->idle_cycles = c->idle_thread->base.usage;
+	if (c->current == c->idle_thread) {
+		stats->idle_cycles += pending;
+	}
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+void k_cpu_runtime_stats_all_get(struct k_cpu_runtime_stats *stats)
+{
+	struct k_cpu_runtime_stats cpu_stats;
+
+	stats->total_cycles = 0;
+	stats->idle_cycles = 0;
+
+	for (int i = 0; i < CONFIG_MP_NUM_CPUS; i++) {
+		k_cpu_runtime_stats_get(i, &cpu_stats);
+		stats->total_cycles += cpu_stats.total_cycles;
+		stats->idle_cycles += cpu_stats.idle_cycles;
+	}
+}
+#endif /* CONFIG_THREAD_RUNTIME_STATS */
+
 #ifdef CONFIG_USERSPACE
 
 #if defined(CONFIG_THREAD_NAME)
@@ -678,6 +784,15 @@ void _init_thread_base(struct _thread_base *thread_base, int priority,
 
 	thread_base->sched_locked = 0;
 
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+	thread_base->usage = 0;
+#endif
+
+#ifdef CONFIG_LATENCY_STATS
+	thread_base->sched_lock_site = NULL;
+	thread_base->wakeup_site = NULL;
+#endif
+
 	/* swap_data does not need to be initialized */
 
 	_init_thread_timeout(thread_base);
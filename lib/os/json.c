@@ -112,7 +112,17 @@ static void *lexer_string(struct lexer *lexer)
 	ignore(lexer);
 
 	while (true) {
-		int chr = next(lexer);
+		int chr;
+
+		/* Skip the run of plain characters in one go: only quotes,
+		 * escapes and embedded NULs need the checks below.
+		 */
+		while (lexer->pos < lexer->end && *lexer->pos != '"' &&
+		       *lexer->pos != '\\' && *lexer->pos != '\0') {
+			lexer->pos++;
+		}
+
+		chr = next(lexer);
 
 		if (chr == '\0') {
 			emit(lexer, JSON_TOK_ERROR);
@@ -216,24 +226,28 @@ static void *lexer_null(struct lexer *lexer)
 
 static void *lexer_number(struct lexer *lexer)
 {
-	while (true) {
-		int chr = next(lexer);
-
-		if (isdigit(chr) || chr == '.') {
-			continue;
-		}
+	while (lexer->pos < lexer->end &&
+	       (isdigit((unsigned char)*lexer->pos) || *lexer->pos == '.')) {
+		lexer->pos++;
+	}
 
-		backup(lexer);
-		emit(lexer, JSON_TOK_NUMBER);
+	emit(lexer, JSON_TOK_NUMBER);
 
-		return lexer_json;
-	}
+	return lexer_json;
 }
 
 static void *lexer_json(struct lexer *lexer)
 {
 	while (true) {
-		int chr = next(lexer);
+		int chr;
+
+		while (lexer->pos < lexer->end &&
+		       isspace((unsigned char)*lexer->pos)) {
+			lexer->pos++;
+		}
+		ignore(lexer);
+
+		chr = next(lexer);
 
 		switch (chr) {
 		case '\0':
@@ -248,15 +262,15 @@ static void *lexer_json(struct lexer *lexer)
 			emit(lexer, (enum json_tokens)chr);
 			return lexer_json;
 		case '"':
-			return lexer_string;
+			return lexer_string(lexer);
 		case 'n':
-			return lexer_null;
+			return lexer_null(lexer);
 		case 't':
 		case 'f':
-			return lexer_boolean;
+			return lexer_boolean(lexer);
 		case '-':
 			if (isdigit(peek(lexer))) {
-				return lexer_number;
+				return lexer_number(lexer);
 			}
 
 			/* fallthrough */
@@ -267,7 +281,7 @@ static void *lexer_json(struct lexer *lexer)
 			}
 
 			if (isdigit(chr)) {
-				return lexer_number;
+				return lexer_number(lexer);
 			}
 
 			emit(lexer, JSON_TOK_ERROR);
@@ -424,9 +438,9 @@ static bool equivalent_types(enum json_tokens type1, enum json_tokens type2)
 	return type1 == type2;
 }
 
-static int obj_parse(struct json_obj *obj,
-		     const struct json_obj_descr *descr, size_t descr_len,
-		     void *val);
+static s64_t obj_parse(struct json_obj *obj,
+		       const struct json_obj_descr *descr, size_t descr_len,
+		       void *val);
 static int arr_parse(struct json_obj *obj,
 		     const struct json_obj_descr *elem_descr,
 		     size_t max_elements, void *field, void *val);
@@ -441,10 +455,12 @@ static int decode_value(struct json_obj *obj,
 	}
 
 	switch (descr->type) {
-	case JSON_TOK_OBJECT_START:
-		return obj_parse(obj, descr->object.sub_descr,
-				 descr->object.sub_descr_len,
-				 field);
+	case JSON_TOK_OBJECT_START: {
+		s64_t ret = obj_parse(obj, descr->object.sub_descr,
+				      descr->object.sub_descr_len, field);
+
+		return ret < 0 ? (int)ret : 0;
+	}
 	case JSON_TOK_LIST_START:
 		return arr_parse(obj, descr->array.element_descr,
 				 descr->array.n_elements, field, val);
@@ -536,60 +552,86 @@ static int arr_parse(struct json_obj *obj,
 	return -EINVAL;
 }
 
-static int obj_parse(struct json_obj *obj, const struct json_obj_descr *descr,
-		     size_t descr_len, void *val)
+static int find_field(const struct json_obj_descr *descr, size_t descr_len,
+		      s64_t decoded_fields, size_t next_field,
+		      const char *key, size_t key_len)
+{
+	size_t i, n;
+
+	/* Keys usually come in the same order as the descriptor, so
+	 * start looking right after the field matched last and wrap
+	 * around: for well-ordered documents every key is found with
+	 * a single comparison instead of a scan of the whole table.
+	 */
+	for (n = 0, i = next_field; n < descr_len; n++, i++) {
+		if (i >= descr_len) {
+			i = 0;
+		}
+
+		/* Field has been decoded already, skip */
+		if (decoded_fields & ((s64_t)1 << i)) {
+			continue;
+		}
+
+		/* Check if it's the i-th field */
+		if (key_len != descr[i].field_name_len) {
+			continue;
+		}
+
+		if (memcmp(key, descr[i].field_name,
+			   descr[i].field_name_len)) {
+			continue;
+		}
+
+		return i;
+	}
+
+	return -ENOENT;
+}
+
+static s64_t obj_parse(struct json_obj *obj,
+		       const struct json_obj_descr *descr, size_t descr_len,
+		       void *val)
 {
 	struct json_obj_key_value kv;
-	s32_t decoded_fields = 0;
-	size_t i;
+	s64_t decoded_fields = 0;
+	size_t next_field = 0;
 	int ret;
+	int i;
 
 	while (!obj_next(obj, &kv)) {
 		if (kv.value.type == JSON_TOK_OBJECT_END) {
 			return decoded_fields;
 		}
 
-		for (i = 0; i < descr_len; i++) {
-			void *decode_field = (char *)val + descr[i].offset;
-
-			/* Field has been decoded already, skip */
-			if (decoded_fields & (1 << i)) {
-				continue;
-			}
-
-			/* Check if it's the i-th field */
-			if (kv.key_len != descr[i].field_name_len) {
-				continue;
-			}
-
-			if (memcmp(kv.key, descr[i].field_name,
-				   descr[i].field_name_len)) {
-				continue;
-			}
-
-			/* Store the decoded value */
-			ret = decode_value(obj, &descr[i], &kv.value,
-					   decode_field, val);
-			if (ret < 0) {
-				return ret;
-			}
+		i = find_field(descr, descr_len, decoded_fields, next_field,
+			       kv.key, kv.key_len);
+		if (i < 0) {
+			continue;
+		}
 
-			decoded_fields |= 1<<i;
-			break;
+		/* Store the decoded value */
+		ret = decode_value(obj, &descr[i], &kv.value,
+				   (char *)val + descr[i].offset, val);
+		if (ret < 0) {
+			return ret;
 		}
+
+		decoded_fields |= (s64_t)1 << i;
+		next_field = i + 1;
 	}
 
 	return -EINVAL;
 }
 
-int json_obj_parse(char *payload, size_t len,
-		   const struct json_obj_descr *descr, size_t descr_len,
-		   void *val)
+s64_t json_obj_parse(char *payload, size_t len,
+		     const struct json_obj_descr *descr, size_t descr_len,
+		     void *val)
 {
 	struct json_obj obj;
 	int ret;
 
-	assert(descr_len < (sizeof(ret) * CHAR_BIT - 1));
+	assert(descr_len < (sizeof(s64_t) * CHAR_BIT - 1));
 
 	ret = obj_init(&obj, payload, len);
 	if (ret < 0) {
@@ -599,6 +641,625 @@ int json_obj_parse(char *payload, size_t len,
 	return obj_parse(&obj, descr, descr_len, val);
 }
 
+enum stream_state {
+	STREAM_START,
+	STREAM_KEY_OR_END,
+	STREAM_KEY,
+	STREAM_COLON,
+	STREAM_VALUE,
+	STREAM_VALUE_OR_END,
+	STREAM_COMMA_OR_END,
+	STREAM_DONE,
+};
+
+enum stream_token {
+	STREAM_TOK_NONE,
+	STREAM_TOK_KEY,
+	STREAM_TOK_STRING,
+	STREAM_TOK_NUMBER,
+	STREAM_TOK_TRUE,
+	STREAM_TOK_FALSE,
+	STREAM_TOK_NULL,
+};
+
+/* Escape states of a string token, kept in token_pos */
+#define STREAM_ESC_NONE		0
+#define STREAM_ESC_START	1
+#define STREAM_ESC_HEX		2
+#define STREAM_ESC_HEX_LAST	5
+
+static struct json_stream_frame *stream_top(struct json_stream_parser *parser)
+{
+	return &parser->stack[parser->depth - 1];
+}
+
+static int stream_push(struct json_stream_parser *parser, u8_t type,
+		       const struct json_obj_descr *descr, size_t descr_len,
+		       char *base, void *val)
+{
+	struct json_stream_frame *frame;
+
+	if (parser->depth == CONFIG_JSON_STREAM_MAX_DEPTH) {
+		return -ENOMEM;
+	}
+
+	frame = &parser->stack[parser->depth++];
+	frame->descr = descr;
+	frame->descr_len = descr_len;
+	frame->base = base;
+	frame->val = val;
+	frame->parent_field = parser->field;
+	frame->next_field = 0;
+	frame->type = type;
+
+	if (type == JSON_TOK_OBJECT_START) {
+		frame->decoded = 0;
+	} else if (descr) {
+		frame->elem_size = get_elem_size(descr);
+		assert(frame->elem_size > 0);
+
+		*(size_t *)((char *)val + descr->offset) = 0;
+	}
+
+	return 0;
+}
+
+static void stream_value_done(struct json_stream_parser *parser, int field)
+{
+	struct json_stream_frame *frame = stream_top(parser);
+
+	parser->state = STREAM_COMMA_OR_END;
+
+	if (!frame->descr) {
+		return;
+	}
+
+	if (frame->type == JSON_TOK_OBJECT_START) {
+		if (field >= 0) {
+			frame->decoded |= (s64_t)1 << field;
+		}
+
+		return;
+	}
+
+	(*(size_t *)((char *)frame->val + frame->descr->offset))++;
+	frame->base += frame->elem_size;
+}
+
+static int stream_close(struct json_stream_parser *parser, u8_t type)
+{
+	struct json_stream_frame *frame = stream_top(parser);
+
+	if (frame->type != type) {
+		return -EINVAL;
+	}
+
+	parser->depth--;
+
+	if (!parser->depth) {
+		parser->decoded = frame->decoded;
+		parser->state = STREAM_DONE;
+
+		return 0;
+	}
+
+	stream_value_done(parser, frame->descr ? frame->parent_field : -1);
+
+	return 0;
+}
+
+static void stream_select_key(struct json_stream_parser *parser)
+{
+	struct json_stream_frame *frame = stream_top(parser);
+	int i = -ENOENT;
+
+	if (frame->descr && parser->key_len <= sizeof(parser->key)) {
+		i = find_field(frame->descr, frame->descr_len, frame->decoded,
+			       frame->next_field, parser->key,
+			       parser->key_len);
+	}
+
+	if (i < 0) {
+		parser->target = NULL;
+		parser->field = -1;
+		return;
+	}
+
+	parser->target = &frame->descr[i];
+	parser->target_field = frame->base + frame->descr[i].offset;
+	parser->field = i;
+	frame->next_field = i + 1;
+}
+
+static int stream_select_element(struct json_stream_parser *parser)
+{
+	struct json_stream_frame *frame = stream_top(parser);
+	size_t *elements;
+
+	parser->field = -1;
+
+	if (!frame->descr) {
+		parser->target = NULL;
+		return 0;
+	}
+
+	elements = (size_t *)((char *)frame->val + frame->descr->offset);
+	if (*elements == frame->descr_len) {
+		return -ENOSPC;
+	}
+
+	parser->target = frame->descr;
+	parser->target_field = frame->base;
+
+	return 0;
+}
+
+static int stream_value(struct json_stream_parser *parser, char chr)
+{
+	const struct json_obj_descr *target = parser->target;
+	struct json_stream_frame *frame = stream_top(parser);
+	void *val = frame->type == JSON_TOK_OBJECT_START ?
+		    frame->base : frame->val;
+	int ret;
+
+	switch (chr) {
+	case '"':
+		if (target && target->type != JSON_TOK_STRING) {
+			return -EINVAL;
+		}
+
+		parser->token = STREAM_TOK_STRING;
+		parser->token_pos = STREAM_ESC_NONE;
+		parser->str_start = parser->str_used;
+
+		return 0;
+	case 't':
+	case 'f':
+		if (target && !equivalent_types(chr, target->type)) {
+			return -EINVAL;
+		}
+
+		parser->token = chr == 't' ? STREAM_TOK_TRUE : STREAM_TOK_FALSE;
+		parser->token_pos = 1;
+
+		return 0;
+	case 'n':
+		/* Same as json_obj_parse(): null is only fine when skipping */
+		if (target) {
+			return -EINVAL;
+		}
+
+		parser->token = STREAM_TOK_NULL;
+		parser->token_pos = 1;
+
+		return 0;
+	case '{':
+		if (!target) {
+			ret = stream_push(parser, JSON_TOK_OBJECT_START,
+					  NULL, 0, NULL, NULL);
+		} else if (target->type == JSON_TOK_OBJECT_START) {
+			ret = stream_push(parser, JSON_TOK_OBJECT_START,
+					  target->object.sub_descr,
+					  target->object.sub_descr_len,
+					  parser->target_field, NULL);
+		} else {
+			return -EINVAL;
+		}
+
+		parser->state = STREAM_KEY_OR_END;
+
+		return ret;
+	case '[':
+		if (!target) {
+			ret = stream_push(parser, JSON_TOK_LIST_START,
+					  NULL, 0, NULL, NULL);
+		} else if (target->type == JSON_TOK_LIST_START) {
+			ret = stream_push(parser, JSON_TOK_LIST_START,
+					  target->array.element_descr,
+					  target->array.n_elements,
+					  parser->target_field, val);
+		} else {
+			return -EINVAL;
+		}
+
+		parser->state = STREAM_VALUE_OR_END;
+
+		return ret;
+	case '-':
+		parser->negative = true;
+		break;
+	default:
+		if (!isdigit((unsigned char)chr)) {
+			return -EINVAL;
+		}
+
+		parser->negative = false;
+		break;
+	}
+
+	if (target && target->type != JSON_TOK_NUMBER) {
+		return -EINVAL;
+	}
+
+	parser->token = STREAM_TOK_NUMBER;
+	parser->token_pos = 0;
+	parser->fraction = false;
+	parser->num = 0;
+
+	/* Let the number token consume the first digit */
+	return chr == '-' ? 0 : 1;
+}
+
+static int stream_structural(struct json_stream_parser *parser, char chr)
+{
+	int ret;
+
+	if (isspace((unsigned char)chr)) {
+		return 0;
+	}
+
+	switch (parser->state) {
+	case STREAM_START:
+		if (chr != '{') {
+			return -EINVAL;
+		}
+
+		parser->state = STREAM_KEY_OR_END;
+		return 0;
+	case STREAM_KEY_OR_END:
+		if (chr == '}') {
+			return stream_close(parser, JSON_TOK_OBJECT_START);
+		}
+
+		/* fallthrough */
+	case STREAM_KEY:
+		if (chr != '"') {
+			return -EINVAL;
+		}
+
+		parser->token = STREAM_TOK_KEY;
+		parser->token_pos = STREAM_ESC_NONE;
+		parser->key_len = 0;
+		return 0;
+	case STREAM_COLON:
+		if (chr != ':') {
+			return -EINVAL;
+		}
+
+		stream_select_key(parser);
+		parser->state = STREAM_VALUE;
+		return 0;
+	case STREAM_VALUE_OR_END:
+		if (chr == ']') {
+			return stream_close(parser, JSON_TOK_LIST_START);
+		}
+
+		ret = stream_select_element(parser);
+		if (ret < 0) {
+			return ret;
+		}
+
+		/* fallthrough */
+	case STREAM_VALUE:
+		return stream_value(parser, chr);
+	case STREAM_COMMA_OR_END:
+		if (chr == '}') {
+			return stream_close(parser, JSON_TOK_OBJECT_START);
+		}
+
+		if (chr == ']') {
+			return stream_close(parser, JSON_TOK_LIST_START);
+		}
+
+		if (chr != ',') {
+			return -EINVAL;
+		}
+
+		if (stream_top(parser)->type == JSON_TOK_OBJECT_START) {
+			parser->state = STREAM_KEY;
+			return 0;
+		}
+
+		parser->state = STREAM_VALUE;
+		return stream_select_element(parser);
+	default:
+		return 0;
+	}
+}
+
+static int stream_store(struct json_stream_parser *parser, const char *chr,
+			size_t len)
+{
+	if (parser->token == STREAM_TOK_KEY) {
+		if (parser->key_len < sizeof(parser->key)) {
+			memcpy(parser->key + parser->key_len, chr,
+			       min(len, sizeof(parser->key) - parser->key_len));
+		}
+
+		/* Saturate just past the buffer so overlong keys never match */
+		parser->key_len = min(parser->key_len + len,
+				      sizeof(parser->key) + 1);
+
+		return 0;
+	}
+
+	if (!parser->target) {
+		return 0;
+	}
+
+	/* Always leave room for the terminating NUL */
+	if (len >= parser->str_buf_size - parser->str_used) {
+		return -ENOMEM;
+	}
+
+	memcpy(parser->str_buf + parser->str_used, chr, len);
+	parser->str_used += len;
+
+	return 0;
+}
+
+static int stream_string_end(struct json_stream_parser *parser)
+{
+	bool key = parser->token == STREAM_TOK_KEY;
+
+	parser->token = STREAM_TOK_NONE;
+
+	if (key) {
+		parser->state = STREAM_COLON;
+		return 0;
+	}
+
+	if (parser->target) {
+		if (parser->str_used >= parser->str_buf_size) {
+			return -ENOMEM;
+		}
+
+		parser->str_buf[parser->str_used++] = '\0';
+		*(char **)parser->target_field =
+			parser->str_buf + parser->str_start;
+	}
+
+	stream_value_done(parser, parser->field);
+
+	return 0;
+}
+
+static int stream_string(struct json_stream_parser *parser, char chr)
+{
+	switch (parser->token_pos) {
+	case STREAM_ESC_NONE:
+		if (chr == '"') {
+			return stream_string_end(parser);
+		}
+
+		if (chr == '\0') {
+			return -EINVAL;
+		}
+
+		if (chr == '\\') {
+			parser->token_pos = STREAM_ESC_START;
+		}
+
+		break;
+	case STREAM_ESC_START:
+		switch (chr) {
+		case '"':
+		case '\\':
+		case '/':
+		case 'b':
+		case 'f':
+		case 'n':
+		case 'r':
+		case 't':
+			parser->token_pos = STREAM_ESC_NONE;
+			break;
+		case 'u':
+			parser->token_pos = STREAM_ESC_HEX;
+			break;
+		default:
+			return -EINVAL;
+		}
+
+		break;
+	default:
+		if (!isxdigit((unsigned char)chr)) {
+			return -EINVAL;
+		}
+
+		if (parser->token_pos == STREAM_ESC_HEX_LAST) {
+			parser->token_pos = STREAM_ESC_NONE;
+		} else {
+			parser->token_pos++;
+		}
+
+		break;
+	}
+
+	return stream_store(parser, &chr, 1);
+}
+
+static int stream_number(struct json_stream_parser *parser, char chr)
+{
+	s64_t num;
+
+	if (isdigit((unsigned char)chr)) {
+		/* Stop accumulating once out of the s32_t range: this only
+		 * matters if the value is actually stored.
+		 */
+		if (!parser->fraction && parser->num <= (s64_t)INT32_MAX + 1) {
+			parser->num = parser->num * 10 + (chr - '0');
+		}
+
+		parser->token_pos = 1;
+		return 0;
+	}
+
+	if (chr == '.') {
+		parser->fraction = true;
+		return 0;
+	}
+
+	/* Anything else ends the number and has to be parsed again */
+	parser->token = STREAM_TOK_NONE;
+
+	if (!parser->token_pos) {
+		return -EINVAL;
+	}
+
+	if (parser->target) {
+		/* Only integers are supported, as in json_obj_parse() */
+		if (parser->fraction) {
+			return -EINVAL;
+		}
+
+		num = parser->negative ? -parser->num : parser->num;
+		if (num < INT32_MIN || num > INT32_MAX) {
+			return -ERANGE;
+		}
+
+		*(s32_t *)parser->target_field = num;
+	}
+
+	stream_value_done(parser, parser->field);
+
+	return 1;
+}
+
+static int stream_literal(struct json_stream_parser *parser, char chr)
+{
+	const char *literal;
+
+	switch (parser->token) {
+	case STREAM_TOK_TRUE:
+		literal = "true";
+		break;
+	case STREAM_TOK_FALSE:
+		literal = "false";
+		break;
+	default:
+		literal = "null";
+		break;
+	}
+
+	if (chr != literal[parser->token_pos]) {
+		return -EINVAL;
+	}
+
+	if (literal[++parser->token_pos]) {
+		return 0;
+	}
+
+	if (parser->target) {
+		*(bool *)parser->target_field =
+			parser->token == STREAM_TOK_TRUE;
+	}
+
+	parser->token = STREAM_TOK_NONE;
+	stream_value_done(parser, parser->field);
+
+	return 0;
+}
+
+static int stream_char(struct json_stream_parser *parser, char chr)
+{
+	switch (parser->token) {
+	case STREAM_TOK_KEY:
+	case STREAM_TOK_STRING:
+		return stream_string(parser, chr);
+	case STREAM_TOK_NUMBER:
+		return stream_number(parser, chr);
+	case STREAM_TOK_TRUE:
+	case STREAM_TOK_FALSE:
+	case STREAM_TOK_NULL:
+		return stream_literal(parser, chr);
+	default:
+		return stream_structural(parser, chr);
+	}
+}
+
+void json_stream_parser_init(struct json_stream_parser *parser,
+			     const struct json_obj_descr *descr,
+			     size_t descr_len, void *val,
+			     char *str_buf, size_t str_buf_size)
+{
+	assert(descr_len < (sizeof(s64_t) * CHAR_BIT - 1));
+
+	memset(parser, 0, sizeof(*parser));
+
+	parser->str_buf = str_buf;
+	parser->str_buf_size = str_buf_size;
+	parser->state = STREAM_START;
+	parser->token = STREAM_TOK_NONE;
+	parser->field = -1;
+
+	(void)stream_push(parser, JSON_TOK_OBJECT_START, descr, descr_len,
+			  val, NULL);
+}
+
+int json_stream_parse(struct json_stream_parser *parser,
+		      const char *data, size_t len)
+{
+	size_t i = 0;
+	size_t run;
+	int ret;
+
+	if (parser->error) {
+		return parser->error;
+	}
+
+	while (i < len && parser->state != STREAM_DONE) {
+		/* Copy runs of plain string characters in one go */
+		if ((parser->token == STREAM_TOK_KEY ||
+		     parser->token == STREAM_TOK_STRING) &&
+		    parser->token_pos == STREAM_ESC_NONE) {
+			for (run = 0; i + run < len; run++) {
+				char chr = data[i + run];
+
+				if (chr == '"' || chr == '\\' || chr == '\0') {
+					break;
+				}
+			}
+
+			if (run) {
+				ret = stream_store(parser, data + i, run);
+				if (ret < 0) {
+					parser->error = ret;
+					return ret;
+				}
+
+				i += run;
+				continue;
+			}
+		}
+
+		ret = stream_char(parser, data[i]);
+		if (ret < 0) {
+			parser->error = ret;
+			return ret;
+		}
+
+		/* A positive value means the character was not consumed */
+		if (!ret) {
+			i++;
+		}
+	}
+
+	return 0;
+}
+
+s64_t json_stream_parser_finish(struct json_stream_parser *parser)
+{
+	if (parser->error) {
+		return parser->error;
+	}
+
+	if (parser->state != STREAM_DONE) {
+		return -EINVAL;
+	}
+
+	return parser->decoded;
+}
+
 static char escape_as(char chr)
 {
 	switch (chr) {
@@ -919,3 +1580,66 @@ ssize_t json_calc_encoded_len(const struct json_obj_descr *descr,
 
 	return total;
 }
+
+struct chunk_appender {
+	char *chunk;
+	size_t used;
+	size_t size;
+	json_append_bytes_t append_bytes;
+	void *data;
+};
+
+static int append_bytes_to_chunk(const char *bytes, size_t len, void *data)
+{
+	struct chunk_appender *appender = data;
+	size_t n;
+	int ret;
+
+	while (len) {
+		n = min(len, appender->size - appender->used);
+
+		memcpy(appender->chunk + appender->used, bytes, n);
+		appender->used += n;
+		bytes += n;
+		len -= n;
+
+		if (appender->used == appender->size) {
+			ret = appender->append_bytes(appender->chunk,
+						     appender->used,
+						     appender->data);
+			if (ret < 0) {
+				return ret;
+			}
+
+			appender->used = 0;
+		}
+	}
+
+	return 0;
+}
+
+int json_obj_encode_chunked(const struct json_obj_descr *descr,
+			    size_t descr_len, const void *val,
+			    char *chunk, size_t chunk_size,
+			    json_append_bytes_t append_bytes, void *data)
+{
+	struct chunk_appender appender = {
+		.chunk = chunk,
+		.size = chunk_size,
+		.append_bytes = append_bytes,
+		.data = data,
+	};
+	int ret;
+
+	if (!chunk_size) {
+		return -EINVAL;
+	}
+
+	ret = json_obj_encode(descr, descr_len, val, append_bytes_to_chunk,
+			      &appender);
+	if (ret < 0 || !appender.used) {
+		return ret;
+	}
+
+	return append_bytes(chunk, appender.used, data);
+}
@@ -151,7 +151,7 @@ static int handle_server_info(struct nats *nats, char *payload, size_t len,
 	struct nats_info info = {};
 	char user[32], pass[64];
 	size_t user_len = sizeof(user), pass_len = sizeof(pass);
-	int ret;
+	s64_t ret;
 
 	ret = json_obj_parse(payload, len, descr, ARRAY_SIZE(descr), &info);
 	if (ret < 0) {
@@ -30,6 +30,9 @@
 #ifdef CONFIG_MCUMGR_CMD_STAT_MGMT
 #include "stat_mgmt/stat_mgmt.h"
 #endif
+#ifdef CONFIG_MCUMGR_CMD_LOG_MGMT
+#include "log_mgmt/log_mgmt.h"
+#endif
 
 /* Define an example stats group; approximates seconds since boot. */
 STATS_SECT_START(smp_svr_stats)
@@ -144,6 +147,9 @@ void main(void)
 #ifdef CONFIG_MCUMGR_CMD_STAT_MGMT
 	stat_mgmt_register_group();
 #endif
+#ifdef CONFIG_MCUMGR_CMD_LOG_MGMT
+	log_mgmt_register_group();
+#endif
 
 	/* Enable Bluetooth. */
 	rc = bt_enable(bt_ready);
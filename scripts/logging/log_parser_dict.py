@@ -0,0 +1,403 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2018 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""Decode dictionary based binary log output.
+
+When CONFIG_LOG_BACKEND_DICTIONARY is enabled, log backends send binary
+records instead of formatted strings. Format strings and source names are
+not sent, only their addresses, so the ELF file of the application is needed
+to turn the records back into text.
+
+Record layout (little endian):
+
+    u8  magic (0xA5)
+    u8  type | level << 4
+    u16 domain_id << 10 | source_id
+    u32 timestamp
+
+followed by type specific data:
+
+    standard:   u32 format string address, u8 nargs, nargs * u32 arguments,
+                u8 length and characters of each %s argument
+    hexdump:    u32 string address, u16 length, data
+    raw string: u16 length, data
+    dropped:    u32 number of dropped messages
+
+With --hex, input is the text printed by the 'log_flash dump' shell command:
+lines of hex encoded data are decoded and all other lines are skipped.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+from elftools.elf.sections import SymbolTableSection
+
+DICT_MAGIC = 0xA5
+DICT_HDR = struct.Struct('<BBHI')
+
+TYPE_STD = 1
+TYPE_HEXDUMP = 2
+TYPE_RAW_STRING = 3
+TYPE_DROPPED = 4
+
+HEXDUMP_BYTES_IN_LINE = 8
+
+HEX_LINE = re.compile(r'^(?:[0-9a-fA-F]{2})+$')
+
+SEVERITY = [None, 'err', 'wrn', 'inf', 'dbg']
+
+FMT_SPEC = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?'
+                      r'(?:hh|h|ll|l|j|z|t|L)?([a-zA-Z%])')
+
+
+class ElfStrings:
+    """Resolves strings and log source names from the ELF file."""
+
+    def __init__(self, elf_file):
+        self.segments = []
+        self.sources = []
+
+        with open(elf_file, 'rb') as f:
+            elf = ELFFile(f)
+            self.ptr_size = elf.elfclass // 8
+
+            for section in elf.iter_sections():
+                if section['sh_type'] != 'SHT_PROGBITS' or \
+                   section['sh_addr'] == 0:
+                    continue
+
+                self.segments.append((section['sh_addr'], section.data()))
+
+            self.sources = self._sources_get(elf)
+
+    def _symbols_get(self, elf):
+        symbols = {}
+        const_size = None
+
+        for section in elf.iter_sections():
+            if not isinstance(section, SymbolTableSection):
+                continue
+
+            for sym in section.iter_symbols():
+                symbols[sym.name] = sym['st_value']
+
+                if sym.name.startswith('log_const_') and \
+                   sym['st_size'] != 0:
+                    const_size = sym['st_size']
+
+        return symbols, const_size
+
+    def _sources_get(self, elf):
+        symbols, const_size = self._symbols_get(elf)
+        start = symbols.get('__log_const_start')
+        end = symbols.get('__log_const_end')
+
+        if start is None or end is None or const_size is None:
+            return []
+
+        ptr_fmt = '<I' if self.ptr_size == 4 else '<Q'
+        sources = []
+
+        for addr in range(start, end, const_size):
+            data = self.read(addr, self.ptr_size)
+            if data is None:
+                break
+
+            name_addr = struct.unpack(ptr_fmt, data)[0]
+            sources.append(self.string_get(name_addr))
+
+        return sources
+
+    def read(self, addr, length):
+        for base, data in self.segments:
+            if base <= addr and addr + length <= base + len(data):
+                return data[addr - base:addr - base + length]
+
+        return None
+
+    def string_get(self, addr):
+        for base, data in self.segments:
+            if base <= addr < base + len(data):
+                end = data.find(b'\0', addr - base)
+                if end < 0:
+                    end = len(data)
+
+                return data[addr - base:end].decode('utf-8', 'replace')
+
+        return '<unknown string 0x%08x>' % addr
+
+    def source_get(self, domain_id, source_id):
+        if domain_id == 0 and source_id < len(self.sources):
+            return self.sources[source_id]
+
+        return '<source %d.%d>' % (domain_id, source_id)
+
+
+def to_signed(value):
+    return value - (1 << 32) if value & (1 << 31) else value
+
+
+def str_args_get(fmt, nargs):
+    """Returns indexes of %s arguments sent along with the record."""
+    indexes = []
+    arg = 0
+
+    for match in FMT_SPEC.finditer(fmt):
+        flags, width, precision, conv = match.groups()
+
+        if conv == '%':
+            continue
+
+        arg += (width == '*') + (precision == '*')
+
+        if conv == 's' and arg < nargs:
+            indexes.append(arg)
+
+        arg += 1
+
+    return indexes
+
+
+def format_msg(fmt, args, str_args):
+    """Format message using python formatting on C format string."""
+    args = list(args)
+    str_args = list(str_args)
+
+    def arg_get():
+        return args.pop(0) if args else 0
+
+    def spec_format(match):
+        flags, width, precision, conv = match.groups()
+
+        if conv == '%':
+            return '%'
+
+        if width == '*':
+            width = str(to_signed(arg_get()))
+
+        if precision == '*':
+            precision = str(to_signed(arg_get()))
+
+        value = arg_get()
+        spec = '%' + flags + (width or '')
+        if precision is not None:
+            spec += '.' + precision
+
+        if conv == 's':
+            return (spec + 's') % (str_args.pop(0) if str_args else '')
+        elif conv == 'p':
+            return '0x%08x' % value
+        elif conv == 'c':
+            return (spec + 'c') % chr(value & 0xFF)
+        elif conv in 'di':
+            return (spec + 'd') % to_signed(value)
+        elif conv in 'ouxX':
+            return (spec + conv) % value
+
+        # Unsupported conversion, leave it as it is.
+        return match.group(0)
+
+    return FMT_SPEC.sub(spec_format, fmt)
+
+
+class Decoder:
+    def __init__(self, strings, out, timestamp_freq=0):
+        self.strings = strings
+        self.out = out
+        self.freq = timestamp_freq
+        self.buf = bytearray()
+
+    def timestamp_format(self, timestamp):
+        if not self.freq:
+            return '[%08d] ' % timestamp
+
+        seconds, remainder = divmod(timestamp, self.freq)
+        hours, seconds = divmod(seconds, 3600)
+        mins, seconds = divmod(seconds, 60)
+        us = remainder * 1000000 // self.freq
+
+        return '[%02d:%02d:%02d.%03d,%03d] ' % (hours, mins, seconds,
+                                                us // 1000, us % 1000)
+
+    def prefix_format(self, level, ids, timestamp):
+        source = self.strings.source_get(ids >> 10, ids & 0x3FF)
+        severity = SEVERITY[level] if level < len(SEVERITY) else '???'
+
+        return '%s<%s> %s: ' % (self.timestamp_format(timestamp),
+                                severity, source)
+
+    def hexdump_format(self, data, prefix_len):
+        lines = []
+
+        for offset in range(0, len(data), HEXDUMP_BYTES_IN_LINE):
+            chunk = data[offset:offset + HEXDUMP_BYTES_IN_LINE]
+            hex_str = ''.join('%02x ' % b for b in chunk)
+            char_str = ''.join(chr(b) if 32 <= b < 127 else '.'
+                               for b in chunk)
+
+            lines.append('\n' + ' ' * prefix_len +
+                         hex_str.ljust(3 * HEXDUMP_BYTES_IN_LINE) +
+                         '|' + char_str)
+
+        return ''.join(lines)
+
+    def record_parse(self, buf):
+        """Returns (length, text) of the record at the start of buf.
+
+        Length is None if more data is needed, 0 if record is invalid.
+        """
+        if len(buf) < DICT_HDR.size:
+            return None, None
+
+        magic, type_level, ids, timestamp = DICT_HDR.unpack_from(buf)
+        rec_type = type_level & 0x0F
+        level = type_level >> 4
+        pos = DICT_HDR.size
+
+        if magic != DICT_MAGIC:
+            return 0, None
+
+        if rec_type == TYPE_STD:
+            if len(buf) < pos + 5:
+                return None, None
+
+            fmt_addr, nargs = struct.unpack_from('<IB', buf, pos)
+            pos += 5
+
+            if len(buf) < pos + 4 * nargs:
+                return None, None
+
+            args = struct.unpack_from('<%dI' % nargs, buf, pos)
+            pos += 4 * nargs
+
+            fmt = self.strings.string_get(fmt_addr)
+            str_args = []
+
+            for _ in str_args_get(fmt, nargs):
+                if len(buf) < pos + 1 or len(buf) < pos + 1 + buf[pos]:
+                    return None, None
+
+                str_args.append(buf[pos + 1:pos + 1 + buf[pos]].decode(
+                    'utf-8', 'replace'))
+                pos += 1 + buf[pos]
+
+            text = self.prefix_format(level, ids, timestamp) + \
+                format_msg(fmt, args, str_args) + '\n'
+        elif rec_type in (TYPE_HEXDUMP, TYPE_RAW_STRING):
+            str_addr = None
+
+            if rec_type == TYPE_HEXDUMP:
+                if len(buf) < pos + 4:
+                    return None, None
+
+                str_addr = struct.unpack_from('<I', buf, pos)[0]
+                pos += 4
+
+            if len(buf) < pos + 2:
+                return None, None
+
+            length = struct.unpack_from('<H', buf, pos)[0]
+            pos += 2
+
+            if len(buf) < pos + length:
+                return None, None
+
+            data = bytes(buf[pos:pos + length])
+            pos += length
+
+            if str_addr is None:
+                text = data.decode('utf-8', 'replace')
+            else:
+                prefix = self.prefix_format(level, ids, timestamp)
+                text = prefix + self.strings.string_get(str_addr) + \
+                    self.hexdump_format(data, len(prefix)) + '\n'
+        elif rec_type == TYPE_DROPPED:
+            if len(buf) < pos + 4:
+                return None, None
+
+            cnt = struct.unpack_from('<I', buf, pos)[0]
+            pos += 4
+            text = '--- %d messages dropped ---\n' % cnt
+        else:
+            return 0, None
+
+        return pos, text
+
+    def feed(self, data):
+        self.buf += data
+
+        while self.buf:
+            length, text = self.record_parse(self.buf)
+            if length is None:
+                break
+
+            if length == 0:
+                # Lost synchronization, look for the next record.
+                next_magic = self.buf.find(bytes([DICT_MAGIC]), 1)
+                if next_magic < 0:
+                    self.buf = bytearray()
+                else:
+                    del self.buf[:next_magic]
+                continue
+
+            self.out.write(text)
+            del self.buf[:length]
+
+        self.out.flush()
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+
+    parser.add_argument('elf', help='ELF file of the application')
+    parser.add_argument('input', nargs='?', default='-',
+                        help='binary log data, stdin if not given')
+    parser.add_argument('--timestamp-freq', type=int, default=0,
+                        help='timestamp frequency in Hz, raw timestamps '
+                             'are printed if not given')
+    parser.add_argument('--hex', action='store_true',
+                        help='input is hex encoded text printed by the '
+                             'log_flash dump shell command')
+
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+    strings = ElfStrings(args.elf)
+    decoder = Decoder(strings, sys.stdout, args.timestamp_freq)
+
+    if args.hex:
+        with open(args.input) if args.input != '-' else sys.stdin as stream:
+            for line in stream:
+                line = line.strip()
+                if HEX_LINE.match(line):
+                    decoder.feed(bytes.fromhex(line))
+
+        return
+
+    if args.input == '-':
+        stream = sys.stdin.buffer
+    else:
+        stream = open(args.input, 'rb')
+
+    with stream:
+        while True:
+            data = stream.read1(1024) if hasattr(stream, 'read1') else \
+                stream.read(1024)
+            if not data:
+                break
+
+            decoder.feed(data)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2019 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""Turn a stream recorded with CONFIG_TRACING_CTF into a CTF trace.
+
+The target writes the binary event stream to a file (native_posix) or to a
+UART. This script copies the stream and the metadata describing it into a
+directory which can be opened with babeltrace or Trace Compass:
+
+    ctf_convert.py channel0_0 trace/
+    babeltrace trace/
+
+Clock frequency in the metadata is taken from the trace_start event which
+is the first event of the stream, so UART capture must start before the
+target is reset.
+
+With --print, events are also decoded and printed, which is enough to check
+a trace in CI without CTF tools.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+METADATA = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                        '..', '..', 'subsys', 'debug', 'tracing', 'ctf',
+                        'metadata')
+
+HEADER = struct.Struct('<IB')
+
+EVENT_TRACE_START = 0x01
+
+# ID: (name, field layout, field names). Must match ctf/metadata.
+THREAD = ('<Ib', ('thread', 'prio'))
+EVENTS = {
+    0x01: ('trace_start', '<I', ('freq',)),
+    0x02: ('lost_events', '<I', ('count',)),
+    0x10: ('thread_switched_out',) + THREAD,
+    0x11: ('thread_switched_in',) + THREAD,
+    0x12: ('thread_priority_set',) + THREAD,
+    0x13: ('thread_create',) + THREAD,
+    0x14: ('thread_abort',) + THREAD,
+    0x15: ('thread_suspend',) + THREAD,
+    0x16: ('thread_resume',) + THREAD,
+    0x17: ('thread_ready',) + THREAD,
+    0x18: ('thread_pend',) + THREAD,
+    0x19: ('thread_info', '<III', ('thread', 'stack_start', 'stack_size')),
+    0x20: ('isr_enter', '<', ()),
+    0x21: ('isr_exit', '<', ()),
+    0x22: ('isr_exit_to_scheduler', '<', ()),
+    0x30: ('idle', '<', ()),
+    0x40: ('call_start', '<I', ('id',)),
+    0x41: ('call_end', '<I', ('id',)),
+}
+
+
+def events(data):
+    """Yield (timestamp, name, fields) for every event in the stream."""
+    off = 0
+    while off + HEADER.size <= len(data):
+        timestamp, event_id = HEADER.unpack_from(data, off)
+        off += HEADER.size
+
+        if event_id not in EVENTS:
+            raise ValueError('unknown event 0x%02x at offset %d' %
+                             (event_id, off - HEADER.size))
+
+        name, layout, names = EVENTS[event_id]
+        size = struct.calcsize(layout)
+        if off + size > len(data):
+            break
+
+        values = struct.unpack_from(layout, data, off)
+        off += size
+
+        yield timestamp, event_id, name, dict(zip(names, values))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=
+                                     argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('stream', help='recorded stream')
+    parser.add_argument('output', help='trace directory to create')
+    parser.add_argument('--metadata', default=METADATA,
+                        help='metadata file (default: %(default)s)')
+    parser.add_argument('--print', action='store_true',
+                        help='print decoded events')
+    args = parser.parse_args()
+
+    with open(args.stream, 'rb') as f:
+        data = f.read()
+
+    if len(data) < HEADER.size or data[HEADER.size - 1] != EVENT_TRACE_START:
+        sys.exit('stream does not start with trace_start event')
+
+    _, _, _, fields = next(events(data))
+    freq = fields['freq']
+
+    with open(args.metadata) as f:
+        metadata = f.read()
+
+    metadata = re.sub(r'freq = \d+;', 'freq = %d;' % freq, metadata, count=1)
+
+    os.makedirs(args.output, exist_ok=True)
+    with open(os.path.join(args.output, 'metadata'), 'w') as f:
+        f.write(metadata)
+    with open(os.path.join(args.output, 'channel0_0'), 'wb') as f:
+        f.write(data)
+
+    if args.print:
+        for timestamp, _, name, fields in events(data):
+            print('%10u %-22s %s' % (timestamp, name, ' '.join(
+                '%s=0x%x' % (k, v) if k in ('thread', 'stack_start')
+                else '%s=%d' % (k, v) for k, v in fields.items())))
+
+
+if __name__ == '__main__':
+    main()
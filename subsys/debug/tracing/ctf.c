@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <tracing.h>
+#include <tracing_ctf.h>
+#include <atomic.h>
+#include <string.h>
+#include "ctf_backend.h"
+
+/*
+ * Events are stored in the format described by ctf/metadata: a packed
+ * header with 32-bit cycle timestamp and event ID followed by the event
+ * fields. The ring therefore contains a ready CTF stream which is passed to
+ * the backend as is.
+ *
+ * Ring is lock-free so that events can be recorded from any context,
+ * including nested interrupts. A writer reserves space by moving the head
+ * with compare-and-swap and copies the event. The last writer which leaves
+ * the ring publishes all reserved data to the reader. Events which do not fit
+ * are dropped and reported with lost_events event.
+ */
+
+#define RING_SIZE CONFIG_TRACING_CTF_BUFFER_SIZE
+#define RING_MASK (RING_SIZE - 1)
+
+BUILD_ASSERT((RING_SIZE & RING_MASK) == 0);
+
+enum ctf_event_id {
+	CTF_EVENT_TRACE_START = 0x01,
+	CTF_EVENT_LOST_EVENTS = 0x02,
+	CTF_EVENT_THREAD_SWITCHED_OUT = 0x10,
+	CTF_EVENT_THREAD_SWITCHED_IN = 0x11,
+	CTF_EVENT_THREAD_PRIORITY_SET = 0x12,
+	CTF_EVENT_THREAD_CREATE = 0x13,
+	CTF_EVENT_THREAD_ABORT = 0x14,
+	CTF_EVENT_THREAD_SUSPEND = 0x15,
+	CTF_EVENT_THREAD_RESUME = 0x16,
+	CTF_EVENT_THREAD_READY = 0x17,
+	CTF_EVENT_THREAD_PEND = 0x18,
+	CTF_EVENT_THREAD_INFO = 0x19,
+	CTF_EVENT_ISR_ENTER = 0x20,
+	CTF_EVENT_ISR_EXIT = 0x21,
+	CTF_EVENT_ISR_EXIT_TO_SCHEDULER = 0x22,
+	CTF_EVENT_IDLE = 0x30,
+	CTF_EVENT_CALL_START = 0x40,
+	CTF_EVENT_CALL_END = 0x41,
+};
+
+struct ctf_event_header {
+	u32_t timestamp;
+	u8_t id;
+} __packed;
+
+struct ctf_thread_fields {
+	u32_t thread;
+	s8_t prio;
+} __packed;
+
+struct ctf_thread_info_fields {
+	u32_t thread;
+	u32_t stack_start;
+	u32_t stack_size;
+} __packed;
+
+/* Largest event. */
+#define EVENT_MAX_LEN (sizeof(struct ctf_event_header) + \
+		       sizeof(struct ctf_thread_info_fields))
+
+static u8_t ring[RING_SIZE];
+
+/* Positions are free running, RING_SIZE being a power of two keeps them
+ * valid across wrap of the counters.
+ */
+static atomic_t ring_head;
+static atomic_t ring_committed;
+static atomic_t ring_tail;
+static atomic_t ring_writers;
+static atomic_t ring_dropped;
+static atomic_t draining;
+
+static void ring_publish(u32_t head)
+{
+	u32_t committed;
+
+	do {
+		committed = atomic_get(&ring_committed);
+		if ((s32_t)(head - committed) <= 0) {
+			/* Already published by a later writer. */
+			return;
+		}
+	} while (!atomic_cas(&ring_committed, committed, head));
+}
+
+/* The event timestamp is taken after the head is read and before the space
+ * is claimed. A writer preempted in between fails the claim and takes a new
+ * timestamp, so events are stored in time order.
+ */
+static bool ring_put(u8_t *event, u32_t len)
+{
+	struct ctf_event_header *hdr = (struct ctf_event_header *)event;
+	bool stored = false;
+	u32_t pos;
+	u32_t off;
+	u32_t chunk;
+	u32_t head;
+
+	atomic_inc(&ring_writers);
+
+	do {
+		pos = atomic_get(&ring_head);
+		if (pos + len - (u32_t)atomic_get(&ring_tail) > RING_SIZE) {
+			goto out;
+		}
+
+		hdr->timestamp = k_cycle_get_32();
+	} while (!atomic_cas(&ring_head, pos, pos + len));
+
+	off = pos & RING_MASK;
+	chunk = min(len, RING_SIZE - off);
+	memcpy(&ring[off], event, chunk);
+	memcpy(ring, &event[chunk], len - chunk);
+	stored = true;
+
+out:
+	/* All space reserved before this point belongs to writers which are
+	 * still counted, so it is complete once the counter drops to zero.
+	 */
+	head = atomic_get(&ring_head);
+	if (atomic_dec(&ring_writers) == 1) {
+		ring_publish(head);
+	}
+
+	return stored;
+}
+
+static bool event_store(u8_t id, const void *fields, u32_t len)
+{
+	u8_t event[EVENT_MAX_LEN];
+	struct ctf_event_header hdr = {
+		.id = id,
+	};
+
+	memcpy(event, &hdr, sizeof(hdr));
+	if (len) {
+		memcpy(&event[sizeof(hdr)], fields, len);
+	}
+
+	return ring_put(event, sizeof(hdr) + len);
+}
+
+static void event_put(u8_t id, const void *fields, u32_t len)
+{
+	if (!event_store(id, fields, len)) {
+		atomic_inc(&ring_dropped);
+	}
+}
+
+static void event_u32_put(u8_t id, u32_t value)
+{
+	event_put(id, &value, sizeof(value));
+}
+
+static void thread_event_put(u8_t id, struct k_thread *thread)
+{
+	struct ctf_thread_fields fields = {
+		.thread = (u32_t)(uintptr_t)thread,
+		.prio = thread->base.prio,
+	};
+
+	event_put(id, &fields, sizeof(fields));
+}
+
+void tracing_ctf_flush(void)
+{
+	u32_t tail;
+	u32_t committed;
+	u32_t off;
+	u32_t chunk;
+	u32_t dropped;
+
+	/* Only one reader at a time, concurrent flush is skipped. */
+	if (!atomic_cas(&draining, 0, 1)) {
+		return;
+	}
+
+	tail = atomic_get(&ring_tail);
+	committed = atomic_get(&ring_committed);
+
+	while (tail != committed) {
+		off = tail & RING_MASK;
+		chunk = min(committed - tail, RING_SIZE - off);
+
+		ctf_backend_output(&ring[off], chunk);
+
+		tail += chunk;
+		atomic_set(&ring_tail, tail);
+	}
+
+	/* Report drops once there is space, it is written with next flush. */
+	dropped = atomic_get(&ring_dropped);
+	if (dropped && event_store(CTF_EVENT_LOST_EVENTS, &dropped,
+				   sizeof(dropped))) {
+		atomic_sub(&ring_dropped, dropped);
+	}
+
+	atomic_clear(&draining);
+}
+
+void sys_trace_thread_switched_in(void)
+{
+	thread_event_put(CTF_EVENT_THREAD_SWITCHED_IN, k_current_get());
+}
+
+void sys_trace_thread_switched_out(void)
+{
+	thread_event_put(CTF_EVENT_THREAD_SWITCHED_OUT, k_current_get());
+}
+
+void sys_trace_thread_priority_set(struct k_thread *thread)
+{
+	thread_event_put(CTF_EVENT_THREAD_PRIORITY_SET, thread);
+}
+
+void sys_trace_thread_create(struct k_thread *thread)
+{
+	thread_event_put(CTF_EVENT_THREAD_CREATE, thread);
+	sys_trace_thread_info(thread);
+}
+
+void sys_trace_thread_abort(struct k_thread *thread)
+{
+	thread_event_put(CTF_EVENT_THREAD_ABORT, thread);
+}
+
+void sys_trace_thread_suspend(struct k_thread *thread)
+{
+	thread_event_put(CTF_EVENT_THREAD_SUSPEND, thread);
+}
+
+void sys_trace_thread_resume(struct k_thread *thread)
+{
+	thread_event_put(CTF_EVENT_THREAD_RESUME, thread);
+}
+
+void sys_trace_thread_ready(struct k_thread *thread)
+{
+	thread_event_put(CTF_EVENT_THREAD_READY, thread);
+}
+
+void sys_trace_thread_pend(struct k_thread *thread)
+{
+	thread_event_put(CTF_EVENT_THREAD_PEND, thread);
+}
+
+void sys_trace_thread_info(struct k_thread *thread)
+{
+	struct ctf_thread_info_fields fields = {
+		.thread = (u32_t)(uintptr_t)thread,
+#ifdef CONFIG_THREAD_STACK_INFO
+		.stack_start = (u32_t)thread->stack_info.start,
+		.stack_size = thread->stack_info.size,
+#endif
+	};
+
+	event_put(CTF_EVENT_THREAD_INFO, &fields, sizeof(fields));
+}
+
+void sys_trace_isr_enter(void)
+{
+	event_put(CTF_EVENT_ISR_ENTER, NULL, 0);
+}
+
+void sys_trace_isr_exit(void)
+{
+	event_put(CTF_EVENT_ISR_EXIT, NULL, 0);
+}
+
+void sys_trace_isr_exit_to_scheduler(void)
+{
+	event_put(CTF_EVENT_ISR_EXIT_TO_SCHEDULER, NULL, 0);
+}
+
+void sys_trace_idle(void)
+{
+	event_put(CTF_EVENT_IDLE, NULL, 0);
+}
+
+void sys_trace_void(unsigned int id)
+{
+	event_u32_put(CTF_EVENT_CALL_START, id);
+}
+
+void sys_trace_end_call(unsigned int id)
+{
+	event_u32_put(CTF_EVENT_CALL_END, id);
+}
+
+void z_sys_trace_idle(void)
+{
+	sys_trace_idle();
+}
+
+void z_sys_trace_isr_enter(void)
+{
+	sys_trace_isr_enter();
+}
+
+void z_sys_trace_isr_exit(void)
+{
+	sys_trace_isr_exit();
+}
+
+void z_sys_trace_isr_exit_to_scheduler(void)
+{
+	sys_trace_isr_exit_to_scheduler();
+}
+
+void z_sys_trace_thread_switched_in(void)
+{
+	sys_trace_thread_switched_in();
+}
+
+void z_sys_trace_thread_switched_out(void)
+{
+	sys_trace_thread_switched_out();
+}
+
+/* First event of the stream, host tools take the clock frequency from it. */
+static int ctf_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	event_u32_put(CTF_EVENT_TRACE_START,
+		      sys_clock_hw_cycles_per_sec());
+
+	return 0;
+}
+
+SYS_INIT(ctf_init, PRE_KERNEL_1, 0);
+
+static void ctf_thread(void)
+{
+	ctf_backend_init();
+
+	while (true) {
+		k_sleep(CONFIG_TRACING_CTF_FLUSH_INTERVAL);
+		tracing_ctf_flush();
+	}
+}
+
+K_THREAD_DEFINE(tracing_ctf, CONFIG_TRACING_CTF_THREAD_STACK_SIZE,
+		ctf_thread, NULL, NULL, NULL,
+		K_LOWEST_APPLICATION_THREAD_PRIO, 0, K_NO_WAIT);
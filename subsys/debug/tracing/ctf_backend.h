@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _TRACE_CTF_BACKEND_H
+#define _TRACE_CTF_BACKEND_H
+
+#include <zephyr/types.h>
+
+/* Interface implemented by the selected CTF output. Both functions are called
+ * from a single context at a time.
+ */
+int ctf_backend_init(void);
+void ctf_backend_output(const u8_t *data, u32_t len);
+
+#endif /* _TRACE_CTF_BACKEND_H */
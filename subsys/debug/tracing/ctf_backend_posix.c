@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zephyr/types.h>
+#include <tracing_ctf.h>
+#include "ctf_backend.h"
+#include "posix_trace.h"
+#include "soc.h"
+#include "cmdline.h" /* native_posix command line options header */
+
+/*
+ * Stream is written to a file in the host file system. Remaining events are
+ * written when the process exits, so a complete trace is available after
+ * the test finishes.
+ */
+
+static const char *file_name;
+static int fd = -1;
+
+int ctf_backend_init(void)
+{
+	if (fd >= 0) {
+		return 0;
+	}
+
+	if (file_name == NULL) {
+		file_name = CONFIG_TRACING_CTF_POSIX_FILE;
+	}
+
+	fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		posix_print_warning("Could not open CTF trace file %s\n",
+				    file_name);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+void ctf_backend_output(const u8_t *data, u32_t len)
+{
+	ssize_t ret;
+
+	if (ctf_backend_init() != 0) {
+		return;
+	}
+
+	while (len > 0) {
+		ret = write(fd, data, len);
+		if (ret <= 0) {
+			posix_print_warning("CTF trace could not be written\n");
+			return;
+		}
+
+		data += ret;
+		len -= ret;
+	}
+}
+
+static void ctf_add_options(void)
+{
+	static struct args_struct_t ctf_options[] = {
+		/*
+		 * Fields:
+		 * manual, mandatory, switch,
+		 * option_name, var_name ,type,
+		 * destination, callback,
+		 * description
+		 */
+		{false, false, false,
+		"trace_file", "file_name", 's',
+		(void *)&file_name, NULL,
+		"File to which the CTF stream is written, by default '"
+		CONFIG_TRACING_CTF_POSIX_FILE "'"},
+
+		ARG_TABLE_ENDMARKER
+	};
+
+	native_add_command_line_opts(ctf_options);
+}
+
+static void ctf_cleanup(void)
+{
+	tracing_ctf_flush();
+
+	if (fd >= 0) {
+		close(fd);
+		fd = -1;
+	}
+}
+
+NATIVE_TASK(ctf_add_options, PRE_BOOT_1, 20);
+NATIVE_TASK(ctf_cleanup, ON_EXIT, 10);
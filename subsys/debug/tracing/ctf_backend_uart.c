@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <device.h>
+#include <uart.h>
+#include "ctf_backend.h"
+
+static struct device *dev;
+
+int ctf_backend_init(void)
+{
+	dev = device_get_binding(CONFIG_TRACING_CTF_UART_DEV_NAME);
+
+	return dev ? 0 : -ENODEV;
+}
+
+void ctf_backend_output(const u8_t *data, u32_t len)
+{
+	if (!dev) {
+		return;
+	}
+
+	for (u32_t i = 0; i < len; i++) {
+		uart_poll_out(dev, data[i]);
+	}
+}
@@ -18,11 +18,57 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 #include <flash.h>
 #include <dfu/flash_img.h>
 #include <inttypes.h>
+#include <init.h>
 
 BUILD_ASSERT_MSG((CONFIG_IMG_BLOCK_BUF_SIZE % FLASH_WRITE_BLOCK_SIZE == 0),
 		 "CONFIG_IMG_BLOCK_BUF_SIZE is not a multiple of "
 		 "FLASH_WRITE_BLOCK_SIZE");
 
+#define SLOT_START FLASH_AREA_IMAGE_1_OFFSET
+#define SLOT_END   (FLASH_AREA_IMAGE_1_OFFSET + FLASH_AREA_IMAGE_1_SIZE)
+
+/* MCUboot trailer at the end of the slot: magic, followed by the image_ok,
+ * copy_done and swap_size fields aligned to the largest write block size
+ */
+#define BOOT_MAGIC_SZ     16
+#define BOOT_MAX_ALIGN    8
+#define BOOT_TRAILER_SIZE (BOOT_MAGIC_SZ + 3 * BOOT_MAX_ALIGN)
+
+#ifdef CONFIG_IMG_ENABLE_IMAGE_CHECK
+#define IMAGE_MAGIC          0x96f3b83d
+#define IMAGE_TLV_INFO_MAGIC 0x6907
+#define IMAGE_TLV_SHA256     0x10
+
+/* Fields of the MCUboot image header needed to locate the TLV area */
+struct image_header {
+	u32_t ih_magic;
+	u32_t ih_load_addr;
+	u16_t ih_hdr_size;
+	u16_t ih_pad1;
+	u32_t ih_img_size;
+} __packed;
+
+struct image_tlv_info {
+	u16_t it_magic;
+	u16_t it_tlv_tot;
+} __packed;
+
+struct image_tlv {
+	u8_t it_type;
+	u8_t it_pad;
+	u16_t it_len;
+} __packed;
+
+BUILD_ASSERT_MSG(CONFIG_IMG_BLOCK_BUF_SIZE >= sizeof(struct image_header),
+		 "CONFIG_IMG_BLOCK_BUF_SIZE is smaller than the image header");
+#endif
+
+#ifdef CONFIG_IMG_PIPELINED_WRITE
+static K_THREAD_STACK_DEFINE(img_work_q_stack, CONFIG_IMG_WORK_Q_STACK_SIZE);
+static struct k_work_q img_work_q;
+#endif
+
+#ifndef CONFIG_IMG_ENABLE_IMAGE_CHECK
 static bool flash_verify(struct device *dev, off_t offset,
 			 u8_t *data, size_t len)
 {
@@ -52,71 +98,270 @@ static bool flash_verify(struct device *dev, off_t offset,
 
 	return (len == 0) ? true : false;
 }
+#endif
 
-/* buffer data into block writes */
-static int flash_block_write(struct flash_img_context *ctx, off_t offset,
-			     u8_t *data, size_t len, bool finished)
+#ifdef CONFIG_IMG_ERASE_PROGRESSIVELY
+/* erase the pages of the slot up to the given offset */
+static int flash_erase_to(struct flash_img_context *ctx, off_t end)
 {
-	int processed = 0;
-	int rc = 0;
+	struct flash_pages_info page;
+	int rc;
 
-	while ((len - processed) >
-	       (CONFIG_IMG_BLOCK_BUF_SIZE - ctx->buf_bytes)) {
-		memcpy(ctx->buf + ctx->buf_bytes, data + processed,
-		       (CONFIG_IMG_BLOCK_BUF_SIZE - ctx->buf_bytes));
+	end = min(end, SLOT_END);
+
+	while (ctx->erased_end < end) {
+		rc = flash_get_page_info_by_offs(ctx->dev, ctx->erased_end,
+						 &page);
+		if (rc) {
+			return rc;
+		}
 
 		flash_write_protection_set(ctx->dev, false);
-		rc = flash_write(ctx->dev, offset + ctx->bytes_written,
-				 ctx->buf, CONFIG_IMG_BLOCK_BUF_SIZE);
+		rc = flash_erase(ctx->dev, page.start_offset, page.size);
 		flash_write_protection_set(ctx->dev, true);
 		if (rc) {
-			LOG_ERR("flash_write error %d offset=0x%08"PRIx32,
-				rc, (u32_t)(offset + ctx->bytes_written));
+			LOG_ERR("flash_erase error %d offset=0x%08"PRIx32,
+				rc, (u32_t)page.start_offset);
 			return rc;
 		}
 
-		if (!flash_verify(ctx->dev, offset + ctx->bytes_written,
-				  ctx->buf, CONFIG_IMG_BLOCK_BUF_SIZE)) {
-			return -EIO;
+		ctx->erased_end = page.start_offset + page.size;
+	}
+
+	return 0;
+}
+
+/* erase the pages holding the MCUboot trailer, which a stale trailer left
+ * in the slot would otherwise apply to the new image
+ */
+static int flash_erase_trailer(struct flash_img_context *ctx)
+{
+	struct flash_pages_info page;
+	int rc;
+
+	rc = flash_get_page_info_by_offs(ctx->dev,
+					 SLOT_END - BOOT_TRAILER_SIZE, &page);
+	if (rc) {
+		return rc;
+	}
+
+	ctx->erased_end = max(ctx->erased_end, page.start_offset);
+
+	return flash_erase_to(ctx, SLOT_END);
+}
+#else
+static inline int flash_erase_to(struct flash_img_context *ctx, off_t end)
+{
+	return 0;
+}
+
+static inline int flash_erase_trailer(struct flash_img_context *ctx)
+{
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_IMG_ENABLE_IMAGE_CHECK
+/* read the hashed part of a block back from flash into the hash */
+static int flash_hash_block(struct flash_img_context *ctx, off_t offset,
+			    u8_t *buf)
+{
+	const struct image_header *hdr = (const struct image_header *)buf;
+	size_t start = offset - SLOT_START;
+	size_t len;
+	int rc;
+
+	if (offset == SLOT_START) {
+		tc_sha256_init(&ctx->sha);
+		ctx->hash_len = 0;
+		if (hdr->ih_magic == IMAGE_MAGIC) {
+			ctx->hash_len = hdr->ih_hdr_size + hdr->ih_img_size;
 		}
+	}
 
-		ctx->bytes_written += CONFIG_IMG_BLOCK_BUF_SIZE;
-		processed += (CONFIG_IMG_BLOCK_BUF_SIZE - ctx->buf_bytes);
-		ctx->buf_bytes = 0;
+	if (start >= ctx->hash_len) {
+		return 0;
 	}
 
-	/* place rest of the data into ctx->buf */
-	if (processed < len) {
-		memcpy(ctx->buf + ctx->buf_bytes,
-		       data + processed, len - processed);
-		ctx->buf_bytes += len - processed;
+	len = min(ctx->hash_len - start, CONFIG_IMG_BLOCK_BUF_SIZE);
+
+	/* the written data is not needed anymore */
+	rc = flash_read(ctx->dev, offset, buf, len);
+	if (rc) {
+		LOG_ERR("flash_read error %d offset=0x%08"PRIx32,
+			rc, (u32_t)offset);
+		return rc;
 	}
 
-	if (finished && ctx->buf_bytes > 0) {
-		/* pad the rest of ctx->buf and write it out */
-		(void)memset(ctx->buf + ctx->buf_bytes, 0xFF,
-			     CONFIG_IMG_BLOCK_BUF_SIZE - ctx->buf_bytes);
+	tc_sha256_update(&ctx->sha, buf, len);
 
-		flash_write_protection_set(ctx->dev, false);
-		rc = flash_write(ctx->dev, offset + ctx->bytes_written,
-				 ctx->buf, CONFIG_IMG_BLOCK_BUF_SIZE);
-		flash_write_protection_set(ctx->dev, true);
+	return 0;
+}
+
+/* compare the hash of the image with the one in its TLV area */
+static int flash_img_verify_hash(struct flash_img_context *ctx)
+{
+	u8_t hash[TC_SHA256_DIGEST_SIZE];
+	u8_t tlv_hash[TC_SHA256_DIGEST_SIZE];
+	struct image_tlv_info info;
+	struct image_tlv tlv;
+	off_t offset;
+	off_t end;
+	int rc;
+
+	if (ctx->hash_len == 0 || ctx->hash_len > ctx->bytes_written) {
+		LOG_ERR("not an MCUboot image");
+		return -EINVAL;
+	}
+
+	tc_sha256_final(hash, &ctx->sha);
+
+	offset = SLOT_START + ctx->hash_len;
+	rc = flash_read(ctx->dev, offset, &info, sizeof(info));
+	if (rc) {
+		return rc;
+	}
+
+	if (info.it_magic != IMAGE_TLV_INFO_MAGIC) {
+		LOG_ERR("no TLV area");
+		return -EINVAL;
+	}
+
+	end = offset + info.it_tlv_tot;
+	offset += sizeof(info);
+
+	while (offset + sizeof(tlv) <= end) {
+		rc = flash_read(ctx->dev, offset, &tlv, sizeof(tlv));
 		if (rc) {
-			LOG_ERR("flash_write error %d offset=0x%08"PRIx32,
-				rc, (u32_t)(offset + ctx->bytes_written));
 			return rc;
 		}
+		offset += sizeof(tlv);
 
-		if (!flash_verify(ctx->dev, offset + ctx->bytes_written,
-				  ctx->buf, CONFIG_IMG_BLOCK_BUF_SIZE)) {
-			return -EIO;
+		if (tlv.it_type == IMAGE_TLV_SHA256 &&
+		    tlv.it_len == sizeof(tlv_hash)) {
+			rc = flash_read(ctx->dev, offset, tlv_hash,
+					sizeof(tlv_hash));
+			if (rc) {
+				return rc;
+			}
+
+			if (memcmp(hash, tlv_hash, sizeof(hash))) {
+				LOG_ERR("image hash mismatch");
+				return -EIO;
+			}
+
+			return 0;
 		}
 
-		ctx->bytes_written = ctx->bytes_written + ctx->buf_bytes;
-		ctx->buf_bytes = 0;
+		offset += tlv.it_len;
 	}
 
-	return rc;
+	LOG_ERR("no SHA-256 TLV");
+	return -EINVAL;
+}
+#endif
+
+/* program a full block buffer at the given offset and verify it */
+static int flash_block_flush(struct flash_img_context *ctx, off_t offset,
+			     u8_t *buf)
+{
+	int rc;
+
+	rc = flash_erase_to(ctx, offset + CONFIG_IMG_BLOCK_BUF_SIZE);
+	if (rc) {
+		return rc;
+	}
+
+	flash_write_protection_set(ctx->dev, false);
+	rc = flash_write(ctx->dev, offset, buf, CONFIG_IMG_BLOCK_BUF_SIZE);
+	flash_write_protection_set(ctx->dev, true);
+	if (rc) {
+		LOG_ERR("flash_write error %d offset=0x%08"PRIx32,
+			rc, (u32_t)offset);
+		return rc;
+	}
+
+#ifdef CONFIG_IMG_ENABLE_IMAGE_CHECK
+	rc = flash_hash_block(ctx, offset, buf);
+	if (rc) {
+		return rc;
+	}
+#else
+	if (!flash_verify(ctx->dev, offset, buf, CONFIG_IMG_BLOCK_BUF_SIZE)) {
+		return -EIO;
+	}
+#endif
+
+	/* get the next page ready while the next block is received */
+	return flash_erase_to(ctx, offset + 2 * CONFIG_IMG_BLOCK_BUF_SIZE);
+}
+
+#ifdef CONFIG_IMG_PIPELINED_WRITE
+static void flash_block_work(struct k_work *work)
+{
+	struct flash_img_context *ctx =
+		CONTAINER_OF(work, struct flash_img_context, work);
+
+	ctx->wr_rc = flash_block_flush(ctx, ctx->wr_off, ctx->wr_buf);
+	k_sem_give(&ctx->idle);
+}
+
+/* wait until the background writer is done with the last block */
+static int flash_block_wait(struct flash_img_context *ctx)
+{
+	k_sem_take(&ctx->idle, K_FOREVER);
+	k_sem_give(&ctx->idle);
+
+	return ctx->wr_rc;
+}
+
+static int img_work_q_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	k_work_q_start(&img_work_q, img_work_q_stack,
+		       K_THREAD_STACK_SIZEOF(img_work_q_stack),
+		       K_LOWEST_APPLICATION_THREAD_PRIO);
+
+	return 0;
+}
+
+SYS_INIT(img_work_q_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+#else
+static inline int flash_block_wait(struct flash_img_context *ctx)
+{
+	return 0;
+}
+#endif
+
+/* hand the current block buffer, holding len bytes of the image, over to
+ * be written
+ */
+static int flash_block_submit(struct flash_img_context *ctx, size_t len)
+{
+	u8_t *buf = ctx->buf[ctx->buf_idx];
+	off_t offset = SLOT_START + ctx->bytes_written;
+
+	ctx->bytes_written += len;
+	ctx->buf_bytes = 0;
+
+#ifdef CONFIG_IMG_PIPELINED_WRITE
+	k_sem_take(&ctx->idle, K_FOREVER);
+	if (ctx->wr_rc) {
+		k_sem_give(&ctx->idle);
+		return ctx->wr_rc;
+	}
+
+	ctx->wr_buf = buf;
+	ctx->wr_off = offset;
+	k_work_submit_to_queue(&img_work_q, &ctx->work);
+
+	ctx->buf_idx = (ctx->buf_idx + 1) % FLASH_IMG_BUF_CNT;
+
+	return 0;
+#else
+	return flash_block_flush(ctx, offset, buf);
+#endif
 }
 
 size_t flash_img_bytes_written(struct flash_img_context *ctx)
@@ -129,11 +374,69 @@ void flash_img_init(struct flash_img_context *ctx, struct device *dev)
 	ctx->dev = dev;
 	ctx->bytes_written = 0;
 	ctx->buf_bytes = 0;
+	ctx->buf_idx = 0;
+#ifdef CONFIG_IMG_ERASE_PROGRESSIVELY
+	ctx->erased_end = SLOT_START;
+#endif
+#ifdef CONFIG_IMG_ENABLE_IMAGE_CHECK
+	ctx->hash_len = 0;
+#endif
+#ifdef CONFIG_IMG_PIPELINED_WRITE
+	k_work_init(&ctx->work, flash_block_work);
+	k_sem_init(&ctx->idle, 1, 1);
+	ctx->wr_rc = 0;
+#endif
 }
 
 int flash_img_buffered_write(struct flash_img_context *ctx, u8_t *data,
 			     size_t len, bool flush)
 {
-	return flash_block_write(ctx, FLASH_AREA_IMAGE_1_OFFSET, data, len,
-				 flush);
+	size_t size;
+	int rc;
+
+	while (len) {
+		size = min(len, CONFIG_IMG_BLOCK_BUF_SIZE - ctx->buf_bytes);
+		memcpy(ctx->buf[ctx->buf_idx] + ctx->buf_bytes, data, size);
+		ctx->buf_bytes += size;
+		data += size;
+		len -= size;
+
+		if (ctx->buf_bytes == CONFIG_IMG_BLOCK_BUF_SIZE) {
+			rc = flash_block_submit(ctx, CONFIG_IMG_BLOCK_BUF_SIZE);
+			if (rc) {
+				return rc;
+			}
+		}
+	}
+
+	if (!flush) {
+		return 0;
+	}
+
+	if (ctx->buf_bytes > 0) {
+		/* pad the rest of the buffer and write it out */
+		(void)memset(ctx->buf[ctx->buf_idx] + ctx->buf_bytes, 0xFF,
+			     CONFIG_IMG_BLOCK_BUF_SIZE - ctx->buf_bytes);
+
+		rc = flash_block_submit(ctx, ctx->buf_bytes);
+		if (rc) {
+			return rc;
+		}
+	}
+
+	rc = flash_block_wait(ctx);
+	if (rc) {
+		return rc;
+	}
+
+	rc = flash_erase_trailer(ctx);
+	if (rc) {
+		return rc;
+	}
+
+#ifdef CONFIG_IMG_ENABLE_IMAGE_CHECK
+	rc = flash_img_verify_hash(ctx);
+#endif
+
+	return rc;
 }
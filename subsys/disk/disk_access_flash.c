@@ -18,9 +18,20 @@
 
 static struct device *flash_dev;
 
-/* flash read-copy-erase-write operation */
-static u8_t read_copy_buf[CONFIG_DISK_ERASE_BLOCK_SIZE];
-static u8_t *fs_buff = read_copy_buf;
+/*
+ * Writes are merged into cached copies of the erase blocks, so a block is
+ * erased and programmed once however many of its sectors are updated.
+ * Unused entries have an address of -1.
+ */
+struct block_cache {
+	off_t addr;
+	u32_t last_use;
+	bool dirty;
+	u8_t data[CONFIG_DISK_ERASE_BLOCK_SIZE];
+};
+
+static struct block_cache cache[CONFIG_DISK_FLASH_CACHE_BLOCKS];
+static u32_t cache_clock;
 
 /* calculate number of blocks required for a given size */
 #define GET_NUM_BLOCK(total_size, block_size) \
@@ -61,26 +72,20 @@ static int disk_flash_access_init(struct disk_info *disk)
 		return -ENODEV;
 	}
 
+	for (int i = 0; i < ARRAY_SIZE(cache); i++) {
+		cache[i].addr = -1;
+	}
+
 	return 0;
 }
 
-static int disk_flash_access_read(struct disk_info *disk, u8_t *buff,
-				u32_t start_sector, u32_t sector_count)
+static int flash_read_chunked(off_t fl_addr, u8_t *buff, u32_t size)
 {
-	off_t fl_addr;
-	u32_t remaining;
-	u32_t len;
-	u32_t num_read;
-
-	fl_addr = lba_to_address(start_sector);
-	remaining = (sector_count * SECTOR_SIZE);
-	len = CONFIG_DISK_FLASH_MAX_RW_SIZE;
+	u32_t len = CONFIG_DISK_FLASH_MAX_RW_SIZE;
 
-	num_read = GET_NUM_BLOCK(remaining, CONFIG_DISK_FLASH_MAX_RW_SIZE);
-
-	for (u32_t i = 0; i < num_read; i++) {
-		if (remaining < CONFIG_DISK_FLASH_MAX_RW_SIZE) {
-			len = remaining;
+	while (size) {
+		if (size < CONFIG_DISK_FLASH_MAX_RW_SIZE) {
+			len = size;
 		}
 
 		if (flash_read(flash_dev, fl_addr, buff, len) != 0) {
@@ -89,98 +94,140 @@ static int disk_flash_access_read(struct disk_info *disk, u8_t *buff,
 
 		fl_addr += len;
 		buff += len;
-		remaining -= len;
+		size -= len;
 	}
 
 	return 0;
 }
 
-/* This performs read-copy into an output buffer */
-static int read_copy_flash_block(off_t start_addr, u32_t size,
-				 const void *src_buff,
-				 u8_t *dest_buff)
+/* erase the block and program it with the cached data */
+static int cache_block_flush(struct block_cache *block)
 {
-	off_t fl_addr;
-	u32_t num_read;
-	u32_t offset = 0U;
+	off_t fl_addr = block->addr;
+	u8_t *src = block->data;
+	u32_t num_write;
 
-	/* adjust offset if starting address is not erase-aligned address */
-	if (start_addr & (CONFIG_DISK_FLASH_ERASE_ALIGNMENT - 1)) {
-		offset = start_addr & (CONFIG_DISK_FLASH_ERASE_ALIGNMENT - 1);
+	if (!block->dirty) {
+		return 0;
 	}
 
-	/* align starting address to an aligned address for flash erase-write */
-	fl_addr = ROUND_DOWN(start_addr, CONFIG_DISK_FLASH_ERASE_ALIGNMENT);
+	/* disable write-protection first before erase */
+	flash_write_protection_set(flash_dev, false);
+	if (flash_erase(flash_dev, fl_addr, CONFIG_DISK_ERASE_BLOCK_SIZE)
+			!= 0) {
+		return -EIO;
+	}
 
-	num_read = GET_NUM_BLOCK(CONFIG_DISK_ERASE_BLOCK_SIZE,
-				 CONFIG_DISK_FLASH_MAX_RW_SIZE);
+	/* write data to flash */
+	num_write = GET_NUM_BLOCK(CONFIG_DISK_ERASE_BLOCK_SIZE,
+				  CONFIG_DISK_FLASH_MAX_RW_SIZE);
 
-	/* read one block from flash */
-	for (u32_t i = 0; i < num_read; i++) {
-		int rc;
+	for (u32_t i = 0; i < num_write; i++) {
+		/* flash_write reenabled write-protection so disable it again */
+		flash_write_protection_set(flash_dev, false);
 
-		rc = flash_read(flash_dev,
-				fl_addr + (CONFIG_DISK_FLASH_MAX_RW_SIZE * i),
-				dest_buff + (CONFIG_DISK_FLASH_MAX_RW_SIZE * i),
-				CONFIG_DISK_FLASH_MAX_RW_SIZE);
-		if (rc != 0) {
+		if (flash_write(flash_dev, fl_addr, src,
+				CONFIG_DISK_FLASH_MAX_RW_SIZE) != 0) {
 			return -EIO;
 		}
+
+		fl_addr += CONFIG_DISK_FLASH_MAX_RW_SIZE;
+		src += CONFIG_DISK_FLASH_MAX_RW_SIZE;
 	}
 
-	/* overwrite with user data */
-	memcpy(dest_buff + offset, src_buff, size);
+	block->dirty = false;
 
 	return 0;
 }
 
-/* input size is either less or equal to a block size,
- * CONFIG_DISK_ERASE_BLOCK_SIZE.
+static int cache_flush(void)
+{
+	for (int i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache_block_flush(&cache[i]) != 0) {
+			return -EIO;
+		}
+	}
+
+	return 0;
+}
+
+static struct block_cache *cache_block_find(off_t block_addr)
+{
+	for (int i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i].addr == block_addr) {
+			cache[i].last_use = ++cache_clock;
+			return &cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Replace the least recently used block, which is written back first, with
+ * the given one. The block is read from flash only if the caller does not
+ * overwrite all of it.
  */
-static int update_flash_block(off_t start_addr, u32_t size, const void *buff)
+static struct block_cache *cache_block_alloc(off_t block_addr, bool fill)
 {
-	off_t fl_addr;
-	u8_t *src = (u8_t *)buff;
-	u32_t num_write;
+	struct block_cache *block;
 
-	/* if size is a partial block, perform read-copy with user data */
-	if (size < CONFIG_DISK_ERASE_BLOCK_SIZE) {
-		int rc;
+	block = &cache[0];
+	for (int i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i].addr == -1) {
+			block = &cache[i];
+			break;
+		}
 
-		rc = read_copy_flash_block(start_addr, size, buff, fs_buff);
-		if (rc != 0) {
-			return -EIO;
+		if (cache[i].last_use < block->last_use) {
+			block = &cache[i];
 		}
+	}
 
-		/* now use the local buffer as the source */
-		src = (u8_t *)fs_buff;
+	if (cache_block_flush(block) != 0) {
+		return NULL;
 	}
 
-	/* always align starting address for flash write operation */
-	fl_addr = ROUND_DOWN(start_addr, CONFIG_DISK_FLASH_ERASE_ALIGNMENT);
+	block->addr = -1;
 
-	/* disable write-protection first before erase */
-	flash_write_protection_set(flash_dev, false);
-	if (flash_erase(flash_dev, fl_addr, CONFIG_DISK_ERASE_BLOCK_SIZE)
-			!= 0) {
-		return -EIO;
+	if (fill && flash_read_chunked(block_addr, block->data,
+				       CONFIG_DISK_ERASE_BLOCK_SIZE) != 0) {
+		return NULL;
 	}
 
-	/* write data to flash */
-	num_write = GET_NUM_BLOCK(CONFIG_DISK_ERASE_BLOCK_SIZE,
-				  CONFIG_DISK_FLASH_MAX_RW_SIZE);
+	block->addr = block_addr;
+	block->last_use = ++cache_clock;
 
-	for (u32_t i = 0; i < num_write; i++) {
-		/* flash_write reenabled write-protection so disable it again */
-		flash_write_protection_set(flash_dev, false);
+	return block;
+}
 
-		if (flash_write(flash_dev, fl_addr, src,
-				CONFIG_DISK_FLASH_MAX_RW_SIZE) != 0) {
+static int disk_flash_access_read(struct disk_info *disk, u8_t *buff,
+				u32_t start_sector, u32_t sector_count)
+{
+	off_t fl_addr;
+	u32_t remaining;
+
+	fl_addr = lba_to_address(start_sector);
+	remaining = (sector_count * SECTOR_SIZE);
+
+	while (remaining) {
+		off_t block_addr = ROUND_DOWN(fl_addr,
+					      CONFIG_DISK_ERASE_BLOCK_SIZE);
+		struct block_cache *block = cache_block_find(block_addr);
+		u32_t size;
+
+		size = min(GET_SIZE_TO_BOUNDARY(fl_addr,
+						CONFIG_DISK_ERASE_BLOCK_SIZE),
+			   remaining);
+
+		if (block) {
+			memcpy(buff, &block->data[fl_addr - block_addr], size);
+		} else if (flash_read_chunked(fl_addr, buff, size) != 0) {
 			return -EIO;
 		}
 
-		fl_addr += CONFIG_DISK_FLASH_MAX_RW_SIZE;
-		src += CONFIG_DISK_FLASH_MAX_RW_SIZE;
+		fl_addr += size;
+		buff += size;
+		remaining -= size;
 	}
 
 	return 0;
@@ -191,65 +238,46 @@ static int disk_flash_access_write(struct disk_info *disk, const u8_t *buff,
 {
 	off_t fl_addr;
 	u32_t remaining;
-	u32_t size;
 
 	fl_addr = lba_to_address(start_sector);
 	remaining = (sector_count * SECTOR_SIZE);
 
-	/* check if start address is erased-aligned address  */
-	if (fl_addr & (CONFIG_DISK_FLASH_ERASE_ALIGNMENT - 1)) {
-		off_t block_bnd;
-
-		/* not aligned */
-		/* check if the size goes over flash block boundary */
-		block_bnd = fl_addr + CONFIG_DISK_ERASE_BLOCK_SIZE;
-		block_bnd = block_bnd & ~(CONFIG_DISK_ERASE_BLOCK_SIZE - 1);
-		if ((fl_addr + remaining) < block_bnd) {
-			/* not over block boundary (a partial block also) */
-			if (update_flash_block(fl_addr, remaining, buff) != 0) {
+	while (remaining) {
+		off_t block_addr = ROUND_DOWN(fl_addr,
+					      CONFIG_DISK_ERASE_BLOCK_SIZE);
+		struct block_cache *block = cache_block_find(block_addr);
+		bool stale = false;
+		u8_t *dst;
+		u32_t size;
+
+		size = min(GET_SIZE_TO_BOUNDARY(fl_addr,
+						CONFIG_DISK_ERASE_BLOCK_SIZE),
+			   remaining);
+
+		if (!block) {
+			/* a block which is entirely overwritten is not read */
+			stale = (size == CONFIG_DISK_ERASE_BLOCK_SIZE);
+			block = cache_block_alloc(block_addr, !stale);
+			if (!block) {
 				return -EIO;
 			}
-			return 0;
 		}
 
-		/* write goes over block boundary */
-		size = GET_SIZE_TO_BOUNDARY(fl_addr,
-						CONFIG_DISK_ERASE_BLOCK_SIZE);
+		/* rewriting unchanged data costs no erase */
+		dst = &block->data[fl_addr - block_addr];
+		if (stale || memcmp(dst, buff, size) != 0) {
+			memcpy(dst, buff, size);
+			block->dirty = true;
+		}
 
-		/* write first partial block */
-		if (update_flash_block(fl_addr, size, buff) != 0) {
+		if (!IS_ENABLED(CONFIG_DISK_FLASH_WRITE_BACK) &&
+		    cache_block_flush(block) != 0) {
 			return -EIO;
 		}
 
 		fl_addr += size;
-		remaining -= size;
 		buff += size;
-	}
-
-	/* start is an erase-aligned address */
-	while (remaining) {
-		int rc;
-
-		if (remaining < CONFIG_DISK_ERASE_BLOCK_SIZE) {
-			break;
-		}
-
-		rc = update_flash_block(fl_addr, CONFIG_DISK_ERASE_BLOCK_SIZE,
-					 buff);
-		if (rc != 0) {
-			return -EIO;
-		}
-
-		fl_addr += CONFIG_DISK_ERASE_BLOCK_SIZE;
-		remaining -= CONFIG_DISK_ERASE_BLOCK_SIZE;
-		buff += CONFIG_DISK_ERASE_BLOCK_SIZE;
-	}
-
-	/* remaining partial block */
-	if (remaining) {
-		if (update_flash_block(fl_addr, remaining, buff) != 0) {
-			return -EIO;
-		}
+		remaining -= size;
 	}
 
 	return 0;
@@ -259,7 +287,7 @@ static int disk_flash_access_ioctl(struct disk_info *disk, u8_t cmd, void *buff)
 {
 	switch (cmd) {
 	case DISK_IOCTL_CTRL_SYNC:
-		return 0;
+		return cache_flush();
 	case DISK_IOCTL_GET_SECTOR_COUNT:
 		*(u32_t *)buff = CONFIG_DISK_VOLUME_SIZE / SECTOR_SIZE;
 		return 0;
@@ -20,8 +20,19 @@
 K_MEM_SLAB_DEFINE(fatfs_dirp_pool, sizeof(DIR),
 			CONFIG_FS_FATFS_NUM_DIRS, 4);
 
+/* FatFs file object, the file pointer of the glue points to fil */
+struct fatfs_file {
+	FIL fil;
+#if defined(CONFIG_FS_FATFS_FASTSEEK)
+	/* Cluster link map, fil.cltbl points to it while it is valid */
+	DWORD link_map[CONFIG_FS_FATFS_FASTSEEK_MAP_SIZE];
+	/* The file changed since the map was created */
+	bool link_map_stale;
+#endif
+};
+
 /* Memory pool for FatFs file objects */
-K_MEM_SLAB_DEFINE(fatfs_filep_pool, sizeof(FIL),
+K_MEM_SLAB_DEFINE(fatfs_filep_pool, sizeof(struct fatfs_file),
 			CONFIG_FS_FATFS_NUM_FILES, 4);
 
 static int translate_error(int error)
@@ -63,6 +74,42 @@ static int translate_error(int error)
 	return -EIO;
 }
 
+#if defined(CONFIG_FS_FATFS_FASTSEEK)
+/* Map the cluster chain so that seeks do not follow it in the FAT. A file
+ * too fragmented for the map is seeked the normal way.
+ */
+static void link_map_create(struct fatfs_file *file)
+{
+	file->link_map[0] = ARRAY_SIZE(file->link_map);
+	file->link_map_stale = false;
+	file->fil.cltbl = file->link_map;
+
+	if (f_lseek(&file->fil, CREATE_LINKMAP) != FR_OK) {
+		file->fil.cltbl = NULL;
+	}
+}
+
+/* A mapped file cannot grow, so the map is dropped before modifications
+ * and created again on the next seek.
+ */
+static void link_map_invalidate(struct fatfs_file *file)
+{
+	file->link_map_stale = true;
+	file->fil.cltbl = NULL;
+}
+
+static void link_map_update(struct fatfs_file *file)
+{
+	if (file->link_map_stale) {
+		link_map_create(file);
+	}
+}
+#else
+static inline void link_map_create(struct fatfs_file *file) { }
+static inline void link_map_invalidate(struct fatfs_file *file) { }
+static inline void link_map_update(struct fatfs_file *file) { }
+#endif /* CONFIG_FS_FATFS_FASTSEEK */
+
 static int fatfs_open(struct fs_file_t *zfp, const char *file_name)
 {
 	FRESULT res;
@@ -70,7 +117,7 @@ static int fatfs_open(struct fs_file_t *zfp, const char *file_name)
 	void *ptr;
 
 	if (k_mem_slab_alloc(&fatfs_filep_pool, &ptr, K_NO_WAIT) == 0) {
-		(void)memset(ptr, 0, sizeof(FIL));
+		(void)memset(ptr, 0, sizeof(struct fatfs_file));
 		zfp->filep = ptr;
 	} else {
 		return -ENOMEM;
@@ -79,6 +126,9 @@ static int fatfs_open(struct fs_file_t *zfp, const char *file_name)
 	fs_mode = FA_READ | FA_WRITE | FA_OPEN_ALWAYS;
 
 	res = f_open(zfp->filep, &file_name[1], fs_mode);
+	if (res == FR_OK) {
+		link_map_create(zfp->filep);
+	}
 
 	return translate_error(res);
 }
@@ -140,6 +190,8 @@ static ssize_t fatfs_write(struct fs_file_t *zfp, const void *ptr, size_t size)
 	FRESULT res;
 	unsigned int bw;
 
+	link_map_invalidate(zfp->filep);
+
 	res = f_write(zfp->filep, ptr, size, &bw);
 	if (res != FR_OK) {
 		return translate_error(res);
@@ -171,6 +223,8 @@ static int fatfs_seek(struct fs_file_t *zfp, off_t offset, int whence)
 		return -EINVAL;
 	}
 
+	link_map_update(zfp->filep);
+
 	res = f_lseek(zfp->filep, pos);
 
 	return translate_error(res);
@@ -186,6 +240,8 @@ static int fatfs_truncate(struct fs_file_t *zfp, off_t length)
 	FRESULT res = FR_OK;
 	off_t cur_length = f_size((FIL *)zfp->filep);
 
+	link_map_invalidate(zfp->filep);
+
 	/* f_lseek expands file if new position is larger than file size */
 	res = f_lseek(zfp->filep, length);
 	if (res != FR_OK) {
@@ -163,6 +163,9 @@ fcb_init(int f_area_id, struct fcb *fcb)
 			break;
 		}
 	}
+	if (rc == FCB_OK) {
+		rc = fcb_summary_init(fcb);
+	}
 	k_mutex_init(&fcb->f_mtx);
 	return rc;
 }
@@ -273,6 +276,9 @@ int fcb_sector_hdr_read(struct fcb *fcb, struct flash_sector *sector,
 	if (fdap->fd_magic != fcb->f_magic) {
 		return FCB_ERR_MAGIC;
 	}
+	if (fdap->fd_ver != fcb->f_version) {
+		return FCB_ERR_VERSION;
+	}
 	return 1;
 }
 
@@ -295,6 +301,10 @@ fcb_offset_last_n(struct fcb *fcb, u8_t entries,
 		entries = 1U;
 	}
 
+	if (fcb_summary_enabled(fcb)) {
+		return fcb_summary_last_n(fcb, entries, last_n_entry);
+	}
+
 	i = 0;
 	(void)memset(&loc, 0, sizeof(loc));
 	while (!fcb_getnext(fcb, &loc)) {
@@ -46,6 +46,10 @@ fcb_append_to_scratch(struct fcb *fcb)
 	if (!sector) {
 		return FCB_ERR_NOSPACE;
 	}
+	rc = fcb_summary_close(fcb);
+	if (rc) {
+		return rc;
+	}
 	rc = fcb_sector_hdr_init(fcb, sector, fcb->f_active_id + 1);
 	if (rc) {
 		return rc;
@@ -53,6 +57,7 @@ fcb_append_to_scratch(struct fcb *fcb)
 	fcb->f_active.fe_sector = sector;
 	fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
 	fcb->f_active_id++;
+	fcb_summary_open(fcb);
 	return FCB_OK;
 }
 
@@ -77,13 +82,18 @@ fcb_append(struct fcb *fcb, u16_t len, struct fcb_entry *append_loc)
 		return FCB_ERR_ARGS;
 	}
 	active = &fcb->f_active;
-	if (active->fe_elem_off + len + cnt > active->fe_sector->fs_size) {
+	if (active->fe_elem_off + len + cnt >
+	    fcb_sector_data_end(fcb, active->fe_sector)) {
 		sector = fcb_new_sector(fcb, fcb->f_scratch_cnt);
-		if (!sector || (sector->fs_size <
+		if (!sector || (fcb_sector_data_end(fcb, sector) <
 			sizeof(struct fcb_disk_area) + len + cnt)) {
 			rc = FCB_ERR_NOSPACE;
 			goto err;
 		}
+		rc = fcb_summary_close(fcb);
+		if (rc) {
+			goto err;
+		}
 		rc = fcb_sector_hdr_init(fcb, sector, fcb->f_active_id + 1);
 		if (rc) {
 			goto err;
@@ -91,6 +101,7 @@ fcb_append(struct fcb *fcb, u16_t len, struct fcb_entry *append_loc)
 		fcb->f_active.fe_sector = sector;
 		fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
 		fcb->f_active_id++;
+		fcb_summary_open(fcb);
 	}
 
 	rc = fcb_flash_write(fcb, active->fe_sector, active->fe_elem_off, tmp_str, cnt);
@@ -103,6 +114,7 @@ fcb_append(struct fcb *fcb, u16_t len, struct fcb_entry *append_loc)
 	append_loc->fe_data_off = active->fe_elem_off + cnt;
 
 	active->fe_elem_off = append_loc->fe_data_off + len;
+	fcb_summary_append(fcb);
 
 	k_mutex_unlock(&fcb->f_mtx);
 
@@ -131,5 +143,6 @@ fcb_append_finish(struct fcb *fcb, struct fcb_entry *loc)
 	if (rc) {
 		return FCB_ERR_FLASH;
 	}
+	fcb_summary_finish(fcb, loc);
 	return 0;
 }
@@ -26,7 +26,8 @@ fcb_elem_crc8(struct fcb *fcb, struct fcb_entry *loc, u8_t *c8p)
 	u32_t end;
 	int rc;
 
-	if (loc->fe_elem_off + 2 > loc->fe_sector->fs_size) {
+	if (loc->fe_elem_off + 2 >
+	    fcb_sector_data_end(fcb, loc->fe_sector)) {
 		return FCB_ERR_NOVAR;
 	}
 	rc = fcb_flash_read(fcb, loc->fe_sector, loc->fe_elem_off, tmp_str, 2);
@@ -24,6 +24,37 @@ struct fcb_disk_area {
 	u16_t fd_id;
 };
 
+#ifdef CONFIG_FCB_SUMMARY
+/*
+ * Sector summary, written at the end of the sector when the sector is
+ * closed.
+ */
+struct fcb_disk_summary {
+	u32_t fds_magic;
+	u32_t fds_first_seq;
+	u32_t fds_count;
+	u32_t fds_key_min;
+	u32_t fds_key_max;
+	u8_t fds_bloom[CONFIG_FCB_SUMMARY_BLOOM_SIZE];
+	u16_t fds_id;		/* id of the summarized sector */
+	u8_t _pad;
+	u8_t fds_crc8;
+};
+
+/*
+ * Sequence number of the first element of a sector, written when the sector
+ * is opened. Elements of the oldest sector are numbered from it after a
+ * restart, even if there is no summary of a preceding sector to follow.
+ */
+struct fcb_disk_seq {
+	u32_t fdq_magic;
+	u32_t fdq_first_seq;
+	u16_t fdq_id;		/* id of the sector */
+	u8_t _pad;
+	u8_t fdq_crc8;
+};
+#endif
+
 int fcb_put_len(u8_t *buf, u16_t len);
 int fcb_get_len(u8_t *buf, u16_t *len);
 
@@ -35,6 +66,64 @@ static inline int fcb_len_in_flash(struct fcb *fcb, u16_t len)
 	return (len + (fcb->f_align - 1)) & ~(fcb->f_align - 1);
 }
 
+#ifdef CONFIG_FCB_SUMMARY
+/*
+ * Offsets of the summary and of the first sequence number, both stored at
+ * the end of the sector.
+ */
+static inline u32_t fcb_sector_summary_off(struct fcb *fcb,
+					   struct flash_sector *sector)
+{
+	return sector->fs_size -
+	       fcb_len_in_flash(fcb, sizeof(struct fcb_disk_summary));
+}
+
+static inline u32_t fcb_sector_seq_off(struct fcb *fcb,
+				       struct flash_sector *sector)
+{
+	return fcb_sector_summary_off(fcb, sector) -
+	       fcb_len_in_flash(fcb, sizeof(struct fcb_disk_seq));
+}
+#endif
+
+/*
+ * End of the element area of a sector, summaries are stored after it.
+ */
+static inline u32_t fcb_sector_data_end(struct fcb *fcb,
+					struct flash_sector *sector)
+{
+#ifdef CONFIG_FCB_SUMMARY
+	if (fcb->f_summary) {
+		return fcb_sector_seq_off(fcb, sector);
+	}
+#endif
+	return sector->fs_size;
+}
+
+#ifdef CONFIG_FCB_SUMMARY
+int fcb_summary_init(struct fcb *fcb);
+void fcb_summary_append(struct fcb *fcb);
+void fcb_summary_finish(struct fcb *fcb, struct fcb_entry *loc);
+int fcb_summary_close(struct fcb *fcb);
+void fcb_summary_open(struct fcb *fcb);
+int fcb_summary_last_n(struct fcb *fcb, u8_t entries, struct fcb_entry *loc);
+
+static inline bool fcb_summary_enabled(struct fcb *fcb)
+{
+	return fcb->f_summary;
+}
+#else
+static inline int fcb_summary_init(struct fcb *fcb) { return 0; }
+static inline void fcb_summary_append(struct fcb *fcb) { }
+static inline void fcb_summary_finish(struct fcb *fcb,
+				      struct fcb_entry *loc) { }
+static inline int fcb_summary_close(struct fcb *fcb) { return 0; }
+static inline void fcb_summary_open(struct fcb *fcb) { }
+static inline int fcb_summary_last_n(struct fcb *fcb, u8_t entries,
+				     struct fcb_entry *loc) { return -ENOENT; }
+static inline bool fcb_summary_enabled(struct fcb *fcb) { return false; }
+#endif
+
 const struct flash_area *fcb_open_flash(const struct fcb *fcb);
 u8_t fcb_get_align(const struct fcb *fcb);
 int fcb_erase_sector(const struct fcb *fcb, const struct flash_sector *sector);
@@ -37,6 +37,7 @@ fcb_rotate(struct fcb *fcb)
 		fcb->f_active.fe_sector = sector;
 		fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
 		fcb->f_active_id++;
+		fcb_summary_open(fcb);
 	}
 	fcb->f_oldest = fcb_getnext_sector(fcb, fcb->f_oldest);
 out:
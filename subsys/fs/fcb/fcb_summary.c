@@ -0,0 +1,649 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <crc.h>
+
+#include "fcb.h"
+#include "fcb_priv.h"
+
+/*
+ * Sector summaries. The summary of the active sector is kept in RAM and
+ * written to the end of the sector when the sector is closed. Sectors closed
+ * without a summary, e.g. due to a reset, get it in fcb_init(). Sectors whose
+ * summary area holds something else are scanned whenever their summary is
+ * needed. The sequence number of the first element is also written when a
+ * sector is opened, so numbering does not depend on the summary of a sector
+ * which has been erased since.
+ */
+
+#define BLOOM_BITS	(CONFIG_FCB_SUMMARY_BLOOM_SIZE * 8)
+#define BLOOM_HASHES	3
+
+BUILD_ASSERT_MSG((CONFIG_FCB_SUMMARY_BLOOM_SIZE % 4) == 0,
+		 "Bloom filter size must be a multiple of 4");
+
+static u32_t key_hash(u32_t key)
+{
+	key ^= key >> 16;
+	key *= 0x7feb352dU;
+	key ^= key >> 15;
+	key *= 0x846ca68bU;
+	key ^= key >> 16;
+
+	return key;
+}
+
+static void summary_reset(struct fcb_summary *sum, u32_t first_seq)
+{
+	(void)memset(sum, 0, sizeof(*sum));
+	sum->fsum_first_seq = first_seq;
+	sum->fsum_key_min = UINT32_MAX;
+}
+
+static void summary_add_key(struct fcb_summary *sum, u32_t key)
+{
+	u32_t hash = key_hash(key);
+
+	sum->fsum_key_min = min(sum->fsum_key_min, key);
+	sum->fsum_key_max = max(sum->fsum_key_max, key);
+
+	for (int i = 0; i < BLOOM_HASHES; i++) {
+		u32_t bit = (hash >> (10 * i)) % BLOOM_BITS;
+
+		sum->fsum_bloom[bit / 8] |= BIT(bit % 8);
+	}
+}
+
+static void summary_add_keyless(struct fcb_summary *sum)
+{
+	sum->fsum_key_min = 0U;
+	sum->fsum_key_max = UINT32_MAX;
+	(void)memset(sum->fsum_bloom, 0xff, sizeof(sum->fsum_bloom));
+}
+
+static bool summary_has_key(const struct fcb_summary *sum, u32_t key)
+{
+	u32_t hash = key_hash(key);
+
+	if (key < sum->fsum_key_min || key > sum->fsum_key_max) {
+		return false;
+	}
+
+	for (int i = 0; i < BLOOM_HASHES; i++) {
+		u32_t bit = (hash >> (10 * i)) % BLOOM_BITS;
+
+		if (!(sum->fsum_bloom[bit / 8] & BIT(bit % 8))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void summary_add_elem(struct fcb *fcb, struct fcb_summary *sum,
+			     struct fcb_entry *loc)
+{
+	struct fcb_entry_ctx entry_ctx = {
+		.loc = *loc,
+		.fap = fcb->fap,
+	};
+	u32_t key;
+
+	if (fcb->f_key_cb && fcb->f_key_cb(&entry_ctx, &key) == 0) {
+		summary_add_key(sum, key);
+	} else {
+		summary_add_keyless(sum);
+	}
+}
+
+static u8_t disk_summary_crc8(const struct fcb_disk_summary *fds)
+{
+	return crc8_ccitt(CRC8_CCITT_INITIAL_VALUE, fds,
+			  offsetof(struct fcb_disk_summary, fds_crc8));
+}
+
+/*
+ * Returns 1 if the sector has a summary, 0 if its summary area is erased
+ * and FCB_ERR_CRC if the area holds something else.
+ */
+static int summary_read(struct fcb *fcb, struct flash_sector *sector,
+			u16_t id, struct fcb_summary *sum)
+{
+	struct fcb_disk_summary fds;
+	const u8_t *raw = (const u8_t *)&fds;
+	bool erased = true;
+	int rc;
+
+	rc = fcb_flash_read(fcb, sector, fcb_sector_summary_off(fcb, sector),
+			    &fds, sizeof(fds));
+	if (rc) {
+		return FCB_ERR_FLASH;
+	}
+
+	if (fds.fds_magic != ~fcb->f_magic || fds.fds_id != id ||
+	    fds.fds_crc8 != disk_summary_crc8(&fds)) {
+		for (int i = 0; i < sizeof(fds); i++) {
+			erased = erased && (raw[i] == 0xff);
+		}
+
+		return erased ? 0 : FCB_ERR_CRC;
+	}
+
+	sum->fsum_first_seq = fds.fds_first_seq;
+	sum->fsum_count = fds.fds_count;
+	sum->fsum_key_min = fds.fds_key_min;
+	sum->fsum_key_max = fds.fds_key_max;
+	memcpy(sum->fsum_bloom, fds.fds_bloom, sizeof(sum->fsum_bloom));
+
+	return 1;
+}
+
+static int summary_write(struct fcb *fcb, struct flash_sector *sector,
+			 u16_t id, const struct fcb_summary *sum)
+{
+	u8_t buf[fcb_len_in_flash(fcb, sizeof(struct fcb_disk_summary))];
+	struct fcb_disk_summary fds;
+
+	fds.fds_magic = ~fcb->f_magic;
+	fds.fds_first_seq = sum->fsum_first_seq;
+	fds.fds_count = sum->fsum_count;
+	fds.fds_key_min = sum->fsum_key_min;
+	fds.fds_key_max = sum->fsum_key_max;
+	memcpy(fds.fds_bloom, sum->fsum_bloom, sizeof(fds.fds_bloom));
+	fds.fds_id = id;
+	fds._pad = 0xff;
+	fds.fds_crc8 = disk_summary_crc8(&fds);
+
+	(void)memset(buf, 0xff, sizeof(buf));
+	memcpy(buf, &fds, sizeof(fds));
+
+	return fcb_flash_write(fcb, sector, fcb_sector_summary_off(fcb, sector),
+			       buf, sizeof(buf));
+}
+
+static u8_t disk_seq_crc8(const struct fcb_disk_seq *fdq)
+{
+	return crc8_ccitt(CRC8_CCITT_INITIAL_VALUE, fdq,
+			  offsetof(struct fcb_disk_seq, fdq_crc8));
+}
+
+/*
+ * Returns 1 if the first sequence number of the sector was found, 0
+ * otherwise.
+ */
+static int seq_read(struct fcb *fcb, struct flash_sector *sector, u16_t id,
+		    u32_t *first_seq)
+{
+	struct fcb_disk_seq fdq;
+	int rc;
+
+	rc = fcb_flash_read(fcb, sector, fcb_sector_seq_off(fcb, sector),
+			    &fdq, sizeof(fdq));
+	if (rc) {
+		return FCB_ERR_FLASH;
+	}
+
+	if (fdq.fdq_magic != ~fcb->f_magic || fdq.fdq_id != id ||
+	    fdq.fdq_crc8 != disk_seq_crc8(&fdq)) {
+		return 0;
+	}
+
+	*first_seq = fdq.fdq_first_seq;
+
+	return 1;
+}
+
+static int seq_write(struct fcb *fcb, struct flash_sector *sector, u16_t id,
+		     u32_t first_seq)
+{
+	u8_t buf[fcb_len_in_flash(fcb, sizeof(struct fcb_disk_seq))];
+	struct fcb_disk_seq fdq;
+
+	fdq.fdq_magic = ~fcb->f_magic;
+	fdq.fdq_first_seq = first_seq;
+	fdq.fdq_id = id;
+	fdq._pad = 0xff;
+	fdq.fdq_crc8 = disk_seq_crc8(&fdq);
+
+	(void)memset(buf, 0xff, sizeof(buf));
+	memcpy(buf, &fdq, sizeof(fdq));
+
+	return fcb_flash_write(fcb, sector, fcb_sector_seq_off(fcb, sector),
+			       buf, sizeof(buf));
+}
+
+/*
+ * Build the summary of a sector from its elements. First_seq is used if the
+ * sector holds no sequence number of its own.
+ */
+static int summary_scan(struct fcb *fcb, struct flash_sector *sector,
+			u16_t id, u32_t first_seq, struct fcb_summary *sum)
+{
+	struct fcb_entry loc;
+	int rc;
+
+	rc = seq_read(fcb, sector, id, &first_seq);
+	if (rc < 0) {
+		return rc;
+	}
+
+	summary_reset(sum, first_seq);
+
+	loc.fe_sector = sector;
+	loc.fe_elem_off = sizeof(struct fcb_disk_area);
+
+	while (1) {
+		rc = fcb_elem_info(fcb, &loc);
+		if (rc == FCB_ERR_NOVAR) {
+			return 0;
+		}
+		if (rc != 0 && rc != FCB_ERR_CRC) {
+			return rc;
+		}
+
+		sum->fsum_count++;
+		if (rc == 0) {
+			summary_add_elem(fcb, sum, &loc);
+		}
+
+		loc.fe_elem_off = loc.fe_data_off +
+				  fcb_len_in_flash(fcb, loc.fe_data_len) +
+				  fcb_len_in_flash(fcb, FCB_CRC_SZ);
+	}
+}
+
+/*
+ * Get the summary of a sector in use. First_seq is the sequence number its
+ * first element has if the summary has to be built. The summary is written
+ * to a sector closed without one if repair is set.
+ */
+static int sector_summary(struct fcb *fcb, struct flash_sector *sector,
+			  u32_t first_seq, struct fcb_summary *sum,
+			  bool repair)
+{
+	struct fcb_disk_area fda;
+	int rc;
+
+	if (sector == fcb->f_active.fe_sector) {
+		*sum = fcb->f_active_sum;
+		return 0;
+	}
+
+	rc = fcb_sector_hdr_read(fcb, sector, &fda);
+	if (rc <= 0) {
+		return rc ? rc : FCB_ERR_ARGS;
+	}
+
+	rc = summary_read(fcb, sector, fda.fd_id, sum);
+	if (rc == 1) {
+		return 0;
+	}
+	if (rc != 0 && rc != FCB_ERR_CRC) {
+		return rc;
+	}
+
+	repair = repair && (rc == 0);
+
+	rc = summary_scan(fcb, sector, fda.fd_id, first_seq, sum);
+	if (rc == 0 && repair) {
+		rc = summary_write(fcb, sector, fda.fd_id, sum);
+	}
+
+	return rc;
+}
+
+int fcb_summary_init(struct fcb *fcb)
+{
+	struct flash_sector *sector;
+	struct fcb_summary sum;
+	u32_t seq = 0U;
+	int rc;
+
+	if (!fcb->f_summary) {
+		return 0;
+	}
+
+	for (sector = fcb->f_oldest; sector != fcb->f_active.fe_sector;
+	     sector = fcb_getnext_sector(fcb, sector)) {
+		rc = sector_summary(fcb, sector, seq, &sum, true);
+		if (rc) {
+			return rc;
+		}
+
+		seq = sum.fsum_first_seq + sum.fsum_count;
+	}
+
+	/* Elements left unfinished by the reset are never finished */
+	fcb->f_active_pending = 0U;
+
+	return summary_scan(fcb, sector, fcb->f_active_id, seq,
+			    &fcb->f_active_sum);
+}
+
+void fcb_summary_append(struct fcb *fcb)
+{
+	if (fcb->f_summary) {
+		fcb->f_active_sum.fsum_count++;
+		fcb->f_active_pending++;
+	}
+}
+
+void fcb_summary_finish(struct fcb *fcb, struct fcb_entry *loc)
+{
+	if (!fcb->f_summary) {
+		return;
+	}
+
+	k_mutex_lock(&fcb->f_mtx, K_FOREVER);
+
+	/* Sectors closed with unfinished elements are summarized as keyless,
+	 * so elements finished later are still found.
+	 */
+	if (loc->fe_sector == fcb->f_active.fe_sector) {
+		summary_add_elem(fcb, &fcb->f_active_sum, loc);
+		fcb->f_active_pending--;
+	}
+
+	k_mutex_unlock(&fcb->f_mtx);
+}
+
+int fcb_summary_close(struct fcb *fcb)
+{
+	struct fcb_summary sum;
+	int rc;
+
+	if (!fcb->f_summary) {
+		return 0;
+	}
+
+	/* Closing is retried if opening the next sector failed. A summary
+	 * area which is not erased any more is left alone, the sector is
+	 * scanned when its summary is needed.
+	 */
+	rc = summary_read(fcb, fcb->f_active.fe_sector, fcb->f_active_id, &sum);
+	if (rc == 1 || rc == FCB_ERR_CRC) {
+		return 0;
+	}
+	if (rc) {
+		return rc;
+	}
+
+	if (fcb->f_active_pending) {
+		summary_add_keyless(&fcb->f_active_sum);
+	}
+
+	return summary_write(fcb, fcb->f_active.fe_sector, fcb->f_active_id,
+			     &fcb->f_active_sum);
+}
+
+void fcb_summary_open(struct fcb *fcb)
+{
+	struct fcb_summary *sum = &fcb->f_active_sum;
+
+	if (!fcb->f_summary) {
+		return;
+	}
+
+	summary_reset(sum, sum->fsum_first_seq + sum->fsum_count);
+	fcb->f_active_pending = 0U;
+
+	/* Without it the sector is numbered after the one preceding it */
+	(void)seq_write(fcb, fcb->f_active.fe_sector, fcb->f_active_id,
+			sum->fsum_first_seq);
+}
+
+int fcb_sector_summary(struct fcb *fcb, struct flash_sector *sector,
+		       struct fcb_summary *sum)
+{
+	struct flash_sector *cur;
+	u32_t seq = 0U;
+	int rc;
+
+	if (!fcb->f_summary) {
+		return FCB_ERR_ARGS;
+	}
+
+	rc = k_mutex_lock(&fcb->f_mtx, K_FOREVER);
+	if (rc) {
+		return FCB_ERR_ARGS;
+	}
+
+	/* Sequence numbers of sectors without a summary follow the ones
+	 * before them.
+	 */
+	cur = fcb->f_oldest;
+	while (1) {
+		rc = sector_summary(fcb, cur, seq, sum, false);
+		if (rc || cur == sector) {
+			break;
+		}
+
+		if (cur == fcb->f_active.fe_sector) {
+			rc = FCB_ERR_ARGS;
+			break;
+		}
+
+		seq = sum->fsum_first_seq + sum->fsum_count;
+		cur = fcb_getnext_sector(fcb, cur);
+	}
+
+	k_mutex_unlock(&fcb->f_mtx);
+
+	return rc;
+}
+
+int fcb_seq_range(struct fcb *fcb, u32_t *first_seq, u32_t *next_seq)
+{
+	struct fcb_summary sum;
+	int rc;
+
+	if (!fcb->f_summary) {
+		return FCB_ERR_ARGS;
+	}
+
+	rc = k_mutex_lock(&fcb->f_mtx, K_FOREVER);
+	if (rc) {
+		return FCB_ERR_ARGS;
+	}
+
+	rc = sector_summary(fcb, fcb->f_oldest, 0U, &sum, false);
+	if (rc == 0) {
+		*first_seq = sum.fsum_first_seq;
+		*next_seq = fcb->f_active_sum.fsum_first_seq +
+			    fcb->f_active_sum.fsum_count;
+	}
+
+	k_mutex_unlock(&fcb->f_mtx);
+
+	return rc;
+}
+
+/* Step over an element, whether it passes CRC check or not. */
+static int elem_skip(struct fcb *fcb, struct fcb_entry *loc)
+{
+	u8_t buf[2];
+	u16_t len;
+	int cnt;
+	int rc;
+
+	if (loc->fe_elem_off + sizeof(buf) >
+	    fcb_sector_data_end(fcb, loc->fe_sector)) {
+		return FCB_ERR_NOVAR;
+	}
+
+	rc = fcb_flash_read(fcb, loc->fe_sector, loc->fe_elem_off, buf,
+			    sizeof(buf));
+	if (rc) {
+		return FCB_ERR_FLASH;
+	}
+
+	cnt = fcb_get_len(buf, &len);
+	if (cnt < 0) {
+		return cnt;
+	}
+
+	loc->fe_elem_off += fcb_len_in_flash(fcb, cnt) +
+			    fcb_len_in_flash(fcb, len) +
+			    fcb_len_in_flash(fcb, FCB_CRC_SZ);
+
+	return 0;
+}
+
+int fcb_seek_seq(struct fcb *fcb, u32_t seq, struct fcb_entry *loc)
+{
+	struct flash_sector *sector;
+	struct fcb_summary sum;
+	u32_t idx;
+	int rc;
+
+	if (!fcb->f_summary) {
+		return FCB_ERR_ARGS;
+	}
+
+	rc = k_mutex_lock(&fcb->f_mtx, K_FOREVER);
+	if (rc) {
+		return FCB_ERR_ARGS;
+	}
+
+	/* Only the summaries are read until the sector is found */
+	sector = fcb->f_oldest;
+	sum.fsum_first_seq = 0U;
+	sum.fsum_count = 0U;
+	while (1) {
+		rc = sector_summary(fcb, sector,
+				    sum.fsum_first_seq + sum.fsum_count,
+				    &sum, false);
+		if (rc) {
+			goto out;
+		}
+
+		idx = seq - sum.fsum_first_seq;
+		if (idx < sum.fsum_count) {
+			break;
+		}
+
+		if (sector == fcb->f_active.fe_sector) {
+			rc = FCB_ERR_NOVAR;
+			goto out;
+		}
+
+		sector = fcb_getnext_sector(fcb, sector);
+	}
+
+	loc->fe_sector = sector;
+	loc->fe_elem_off = sizeof(struct fcb_disk_area);
+	while (idx--) {
+		rc = elem_skip(fcb, loc);
+		if (rc) {
+			goto out;
+		}
+	}
+
+	rc = fcb_elem_info(fcb, loc);
+out:
+	k_mutex_unlock(&fcb->f_mtx);
+
+	return rc;
+}
+
+int fcb_summary_last_n(struct fcb *fcb, u8_t entries, struct fcb_entry *loc)
+{
+	u32_t first_seq;
+	u32_t next_seq;
+	u32_t seq;
+	int rc;
+
+	rc = fcb_seq_range(fcb, &first_seq, &next_seq);
+	if (rc || first_seq == next_seq) {
+		return -ENOENT;
+	}
+
+	if (next_seq - first_seq > entries) {
+		seq = next_seq - entries;
+	} else {
+		seq = first_seq;
+	}
+
+	rc = fcb_seek_seq(fcb, seq, loc);
+	if (rc == FCB_ERR_CRC) {
+		/* Corrupted elements are not served */
+		rc = fcb_getnext(fcb, loc);
+	}
+
+	return rc ? -ENOENT : 0;
+}
+
+struct walk_key_arg {
+	struct fcb *fcb;
+	u32_t key;
+	fcb_walk_cb cb;
+	void *cb_arg;
+};
+
+static int walk_key_cb(struct fcb_entry_ctx *loc_ctx, void *arg)
+{
+	struct walk_key_arg *wk = arg;
+	u32_t key;
+
+	if (wk->fcb->f_key_cb &&
+	    (wk->fcb->f_key_cb(loc_ctx, &key) != 0 || key != wk->key)) {
+		return 0;
+	}
+
+	return wk->cb(loc_ctx, wk->cb_arg);
+}
+
+int fcb_walk_key(struct fcb *fcb, u32_t key, fcb_walk_cb cb, void *cb_arg)
+{
+	struct walk_key_arg wk = {
+		.fcb = fcb,
+		.key = key,
+		.cb = cb,
+		.cb_arg = cb_arg,
+	};
+	struct flash_sector *sector;
+	struct fcb_summary sum;
+	bool active;
+	int rc;
+
+	if (!fcb->f_summary) {
+		return FCB_ERR_ARGS;
+	}
+
+	sector = fcb->f_oldest;
+	sum.fsum_first_seq = 0U;
+	sum.fsum_count = 0U;
+	do {
+		rc = k_mutex_lock(&fcb->f_mtx, K_FOREVER);
+		if (rc) {
+			return FCB_ERR_ARGS;
+		}
+
+		rc = sector_summary(fcb, sector,
+				    sum.fsum_first_seq + sum.fsum_count,
+				    &sum, false);
+		active = (sector == fcb->f_active.fe_sector);
+
+		k_mutex_unlock(&fcb->f_mtx);
+
+		if (rc) {
+			return rc;
+		}
+
+		if (sum.fsum_count && summary_has_key(&sum, key)) {
+			rc = fcb_walk(fcb, sector, walk_key_cb, &wk);
+			if (rc) {
+				return rc;
+			}
+		}
+
+		sector = fcb_getnext_sector(fcb, sector);
+	} while (!active);
+
+	return 0;
+}
@@ -11,6 +11,7 @@
 #include <inttypes.h>
 #include <nvs/nvs.h>
 #include <crc.h>
+#include <init.h>
 #include "nvs_priv.h"
 
 #define LOG_LEVEL CONFIG_NVS_LOG_LEVEL
@@ -351,6 +352,15 @@ static int _nvs_prev_ate(struct nvs_fs *fs, u32_t *addr, struct nvs_ate *ate)
 		*addr -= (1 << ADDR_SECT_SHIFT);
 	}
 
+#ifdef CONFIG_NVS_BACKGROUND_GC
+	/* the sector erased by background gc holds no valid entries */
+	if (fs->gc_erasing &&
+	    ((*addr & ADDR_SECT_MASK) == fs->gc_erase_addr)) {
+		*addr = fs->ate_wra;
+		return 0;
+	}
+#endif
+
 	rc = _nvs_flash_ate_rd(fs, *addr, &close_ate);
 	if (rc) {
 		return rc;
@@ -403,8 +413,83 @@ static void _nvs_sector_advance(struct nvs_fs *fs, u32_t *addr)
 	}
 }
 
+/* _nvs_sector_gap returns the space left between data and allocation
+ * entries of a closed sector. It is not available for writes until the
+ * sector is garbage collected. A sector that is not closed, or is closed
+ * with an invalid close ate, has no gap.
+ */
+static int _nvs_sector_gap(struct nvs_fs *fs, u32_t addr, u32_t *gap)
+{
+	int rc;
+	struct nvs_ate close_ate, last_ate;
+	u32_t data_end;
+	size_t ate_size;
+
+	ate_size = _nvs_al_size(fs, sizeof(struct nvs_ate));
+	*gap = 0;
+
+	addr &= ADDR_SECT_MASK;
+	rc = _nvs_flash_ate_rd(fs, addr + fs->sector_size - ate_size,
+			       &close_ate);
+	if (rc) {
+		return rc;
+	}
+
+	if (!_nvs_ate_cmp_const(&close_ate, 0xff) ||
+	    _nvs_ate_crc8_check(&close_ate)) {
+		return 0;
+	}
+
+	/* the close ate points to itself when no ate was written */
+	if (close_ate.offset == fs->sector_size - ate_size) {
+		*gap = close_ate.offset;
+		return 0;
+	}
+
+	rc = _nvs_flash_ate_rd(fs, addr + close_ate.offset, &last_ate);
+	if (rc) {
+		return rc;
+	}
+
+	if (_nvs_ate_crc8_check(&last_ate)) {
+		return 0;
+	}
+
+	/* data is written in order, the last ate has the last data */
+	data_end = last_ate.offset + _nvs_al_size(fs, last_ate.len);
+	if (close_ate.offset > data_end) {
+		*gap = close_ate.offset - data_end;
+	}
+	return 0;
+}
+
+/* _nvs_gc_erase_wait waits until background gc has erased the sector after
+ * the write sector, it has to be erased before it is written. A failed
+ * erase is retried.
+ */
+static int _nvs_gc_erase_wait(struct nvs_fs *fs)
+{
+#ifdef CONFIG_NVS_BACKGROUND_GC
+	int rc = 0;
+
+	k_mutex_lock(&fs->gc_erase_lock, K_FOREVER);
+	if (fs->gc_erasing) {
+		rc = _nvs_flash_erase_sector(fs, fs->gc_erase_addr);
+		if (!rc) {
+			fs->gc_erasing = false;
+		}
+	}
+	k_mutex_unlock(&fs->gc_erase_lock);
+
+	return rc;
+#else
+	return 0;
+#endif
+}
+
 /* allocation entry close (this closes the current sector) by writing offset
- * of last ate to the sector end.
+ * of last ate to the sector end. The space left in the sector is taken from
+ * the free space until the sector is garbage collected.
  */
 static int _nvs_sector_close(struct nvs_fs *fs)
 {
@@ -414,6 +499,13 @@ static int _nvs_sector_close(struct nvs_fs *fs)
 
 	ate_size = _nvs_al_size(fs, sizeof(struct nvs_ate));
 
+	rc = _nvs_gc_erase_wait(fs);
+	if (rc) {
+		return rc;
+	}
+
+	fs->free_space -= fs->ate_wra + ate_size - fs->data_wra;
+
 	close_ate.id = 0xFFFF;
 	close_ate.len = 0;
 	close_ate.offset = (u16_t)((fs->ate_wra + ate_size) & ADDR_OFFS_MASK);
@@ -435,21 +527,22 @@ static int _nvs_sector_close(struct nvs_fs *fs)
 
 /* garbage collection: the address ate_wra has been updated to the new sector
  * that has just been started. The data to gc is in the sector after this new
- * sector.
+ * sector. _nvs_gc_move copies the valid entries of the gc sector, returned in
+ * sec_addr, to the new sector. The gc sector is erased afterwards.
  */
-static int _nvs_gc(struct nvs_fs *fs)
+static int _nvs_gc_move(struct nvs_fs *fs, u32_t *sec_addr)
 {
 	int rc;
 	struct nvs_ate close_ate, gc_ate, wlk_ate;
-	u32_t sec_addr, gc_addr, gc_prev_addr, wlk_addr, wlk_prev_addr,
-	      data_addr, stop_addr;
+	u32_t gc_addr, gc_prev_addr, wlk_addr, wlk_prev_addr,
+	      data_addr, stop_addr, gap;
 	size_t ate_size;
 
 	ate_size = _nvs_al_size(fs, sizeof(struct nvs_ate));
 
-	sec_addr = (fs->ate_wra & ADDR_SECT_MASK);
-	_nvs_sector_advance(fs, &sec_addr);
-	gc_addr = sec_addr + fs->sector_size - ate_size;
+	*sec_addr = (fs->ate_wra & ADDR_SECT_MASK);
+	_nvs_sector_advance(fs, sec_addr);
+	gc_addr = *sec_addr + fs->sector_size - ate_size;
 
 	/* if the sector is not closed don't do gc */
 	rc = _nvs_flash_ate_rd(fs, gc_addr, &close_ate);
@@ -460,13 +553,14 @@ static int _nvs_gc(struct nvs_fs *fs)
 
 	rc = _nvs_ate_cmp_const(&close_ate, 0xff);
 	if (!rc) {
-		rc = _nvs_flash_erase_sector(fs, sec_addr);
-		if (rc) {
-			return rc;
-		}
 		return 0;
 	}
 
+	rc = _nvs_sector_gap(fs, *sec_addr, &gap);
+	if (rc) {
+		return rc;
+	}
+
 	stop_addr = gc_addr - ate_size;
 
 	gc_addr &= ADDR_SECT_MASK;
@@ -525,19 +619,70 @@ static int _nvs_gc(struct nvs_fs *fs)
 		}
 	}
 
+	/* the space left in the gc sector is available again */
+	fs->free_space += gap;
+	return 0;
+}
+
+static int _nvs_gc(struct nvs_fs *fs)
+{
+	int rc;
+	u32_t sec_addr;
+
+	rc = _nvs_gc_move(fs, &sec_addr);
+	if (rc) {
+		return rc;
+	}
+
 	rc = _nvs_flash_erase_sector(fs, sec_addr);
 	if (rc) {
 		return rc;
 	}
+	fs->gc_ate_wra = fs->ate_wra;
 	return 0;
 }
 
+/* gc ahead of time is needed when less than min_free bytes are left in the
+ * write sector. It is not when no entry was written since the last gc, as
+ * gc would only move the same entries again.
+ */
+static bool _nvs_compact_needed(struct nvs_fs *fs, size_t min_free)
+{
+	return (fs->ate_wra != fs->gc_ate_wra) &&
+	       (fs->ate_wra - fs->data_wra < min_free);
+}
+
+/* _nvs_compact closes the write sector and garbage collects the oldest
+ * sector when needed. Returns 1 when gc was done, 0 when it was not needed
+ * and an errcode on error.
+ */
+static int _nvs_compact(struct nvs_fs *fs, size_t min_free)
+{
+	int rc;
+
+	if (!_nvs_compact_needed(fs, min_free)) {
+		return 0;
+	}
+
+	rc = _nvs_sector_close(fs);
+	if (rc) {
+		return rc;
+	}
+
+	rc = _nvs_gc(fs);
+	if (rc) {
+		return rc;
+	}
+	return 1;
+}
+
 static int _nvs_update_free_space(struct nvs_fs *fs)
 {
 
 	int rc;
 	struct nvs_ate step_ate, wlk_ate;
 	u32_t step_addr, wlk_addr;
+	u32_t gap;
 	size_t ate_size;
 
 	ate_size = _nvs_al_size(fs, sizeof(struct nvs_ate));
@@ -547,6 +692,15 @@ static int _nvs_update_free_space(struct nvs_fs *fs)
 		fs->free_space += (fs->sector_size - ate_size);
 	}
 
+	/* space left in closed sectors is only reused after gc */
+	for (u16_t i = 0; i < fs->sector_count; i++) {
+		rc = _nvs_sector_gap(fs, i << ADDR_SECT_SHIFT, &gap);
+		if (rc) {
+			return rc;
+		}
+		fs->free_space -= gap;
+	}
+
 	step_addr = fs->ate_wra;
 
 	while (1) {
@@ -588,6 +742,11 @@ int nvs_clear(struct nvs_fs *fs)
 	int rc;
 	off_t addr;
 
+	rc = _nvs_gc_erase_wait(fs);
+	if (rc) {
+		return rc;
+	}
+
 	for (u16_t i = 0; i < fs->sector_count; i++) {
 		addr = i << ADDR_SECT_SHIFT;
 		rc = _nvs_flash_erase_sector(fs, addr);
@@ -598,6 +757,73 @@ int nvs_clear(struct nvs_fs *fs)
 	return 0;
 }
 
+#ifdef CONFIG_NVS_BACKGROUND_GC
+#define NVS_GC_THRESHOLD(fs) \
+	((fs)->sector_size * CONFIG_NVS_BACKGROUND_GC_THRESHOLD / 100)
+
+static K_THREAD_STACK_DEFINE(nvs_gc_work_q_stack,
+			     CONFIG_NVS_BACKGROUND_GC_STACK_SIZE);
+static struct k_work_q nvs_gc_work_q;
+
+/* Background gc moves the valid entries of the oldest sector with the file
+ * system locked, but erases the sector without the lock. Reads and writes
+ * which fit in the write sector go on during the erase, a write which has to
+ * close the write sector waits for it in _nvs_sector_close.
+ */
+static void _nvs_gc_work(struct k_work *work)
+{
+	struct nvs_fs *fs = CONTAINER_OF(work, struct nvs_fs, gc_work);
+	u32_t sec_addr;
+	int rc;
+
+	k_mutex_lock(&fs->nvs_lock, K_FOREVER);
+
+	if (fs->locked || !_nvs_compact_needed(fs, NVS_GC_THRESHOLD(fs))) {
+		k_mutex_unlock(&fs->nvs_lock);
+		return;
+	}
+
+	rc = _nvs_sector_close(fs);
+	if (!rc) {
+		rc = _nvs_gc_move(fs, &sec_addr);
+	}
+	if (rc) {
+		k_mutex_unlock(&fs->nvs_lock);
+		LOG_ERR("Background gc failed (%d)", rc);
+		return;
+	}
+	fs->gc_ate_wra = fs->ate_wra;
+
+	k_mutex_lock(&fs->gc_erase_lock, K_FOREVER);
+	fs->gc_erase_addr = sec_addr;
+	fs->gc_erasing = true;
+	k_mutex_unlock(&fs->nvs_lock);
+
+	rc = _nvs_flash_erase_sector(fs, sec_addr);
+	if (rc) {
+		/* retried by the next write to the sector */
+		LOG_ERR("Background gc erase failed (%d)", rc);
+	} else {
+		fs->gc_erasing = false;
+	}
+	k_mutex_unlock(&fs->gc_erase_lock);
+}
+
+static int _nvs_gc_work_q_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	k_work_q_start(&nvs_gc_work_q, nvs_gc_work_q_stack,
+		       K_THREAD_STACK_SIZEOF(nvs_gc_work_q_stack),
+		       K_LOWEST_APPLICATION_THREAD_PRIO);
+
+	return 0;
+}
+
+SYS_INIT(_nvs_gc_work_q_init, POST_KERNEL,
+	 CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+#endif
+
 int nvs_reinit(struct nvs_fs *fs)
 {
 	int rc;
@@ -612,6 +838,11 @@ int nvs_reinit(struct nvs_fs *fs)
 
 	k_mutex_lock(&fs->nvs_lock, K_FOREVER);
 
+	rc = _nvs_gc_erase_wait(fs);
+	if (rc) {
+		goto end;
+	}
+
 	ate_size = _nvs_al_size(fs, sizeof(struct nvs_ate));
 	/* step through the sectors to find the last sector */
 	for (u16_t i = 0; i < fs->sector_count; i++) {
@@ -705,6 +936,9 @@ int nvs_reinit(struct nvs_fs *fs)
 		}
 	}
 
+	/* only an entry written after init makes gc worthwhile */
+	fs->gc_ate_wra = fs->ate_wra;
+
 	rc = _nvs_update_free_space(fs);
 end:
 	k_mutex_unlock(&fs->nvs_lock);
@@ -717,6 +951,11 @@ int nvs_init(struct nvs_fs *fs, const char *dev_name)
 	int rc;
 
 	k_mutex_init(&fs->nvs_lock);
+#ifdef CONFIG_NVS_BACKGROUND_GC
+	k_mutex_init(&fs->gc_erase_lock);
+	fs->gc_erasing = false;
+	k_work_init(&fs->gc_work, _nvs_gc_work);
+#endif
 
 	fs->flash_device = device_get_binding(dev_name);
 	if (!fs->flash_device) {
@@ -763,6 +1002,9 @@ ssize_t nvs_write(struct nvs_fs *fs, u16_t id, const void *data, size_t len)
 	struct nvs_ate wlk_ate;
 	u32_t wlk_addr, rd_addr, freed_space;
 	u16_t sector_freespace;
+#ifdef CONFIG_NVS_BACKGROUND_GC
+	u16_t start_freespace;
+#endif
 
 	ate_size = _nvs_al_size(fs, sizeof(struct nvs_ate));
 	data_size = _nvs_al_size(fs, len);
@@ -777,6 +1019,9 @@ ssize_t nvs_write(struct nvs_fs *fs, u16_t id, const void *data, size_t len)
 		return -EROFS;
 	}
 
+	/* hold the lock while walking, gc may run from another thread */
+	k_mutex_lock(&fs->nvs_lock, K_FOREVER);
+
 	/* find latest entry with same id */
 	wlk_addr = fs->ate_wra;
 	rd_addr = wlk_addr;
@@ -786,7 +1031,7 @@ ssize_t nvs_write(struct nvs_fs *fs, u16_t id, const void *data, size_t len)
 		rd_addr = wlk_addr;
 		rc = _nvs_prev_ate(fs, &wlk_addr, &wlk_ate);
 		if (rc) {
-			return rc;
+			goto end;
 		}
 		if ((wlk_ate.id == id) && (!_nvs_ate_crc8_check(&wlk_ate))) {
 			break;
@@ -804,13 +1049,14 @@ ssize_t nvs_write(struct nvs_fs *fs, u16_t id, const void *data, size_t len)
 		if (len == 0) {
 			/* do not try to compare with empty data */
 			if (wlk_ate.len == 0) {
-				return 0;
+				rc = 0;
+				goto end;
 			}
 		} else {
 			/* compare the data and if equal return 0 */
 			rc = _nvs_flash_block_cmp(fs, rd_addr, data, len);
 			if (rc <= 0) {
-				return rc;
+				goto end;
 			}
 		}
 		/* data different, calculate freed space */
@@ -818,14 +1064,15 @@ ssize_t nvs_write(struct nvs_fs *fs, u16_t id, const void *data, size_t len)
 		freed_space += ate_size;
 	}
 
-	k_mutex_lock(&fs->nvs_lock, K_FOREVER);
-
 	fs->free_space += freed_space;
 	if (fs->free_space < (data_size + ate_size)) {
 		rc = -ENOSPC;
 		goto end;
 	}
 
+#ifdef CONFIG_NVS_BACKGROUND_GC
+	start_freespace = fs->ate_wra - fs->data_wra;
+#endif
 	gc_count = 0;
 	while (1) {
 		if (gc_count == fs->sector_count) {
@@ -852,15 +1099,44 @@ ssize_t nvs_write(struct nvs_fs *fs, u16_t id, const void *data, size_t len)
 		}
 		gc_count++;
 	}
+
+#ifdef CONFIG_NVS_BACKGROUND_GC
+	/* Start background gc when this write brought the free space of the
+	 * write sector below the threshold. A write that did gc itself does
+	 * not, the new sector may be filled with moved entries only.
+	 */
+	sector_freespace = fs->ate_wra - fs->data_wra;
+	if ((gc_count == 0) &&
+	    (start_freespace >= NVS_GC_THRESHOLD(fs)) &&
+	    (sector_freespace < NVS_GC_THRESHOLD(fs))) {
+		k_work_submit_to_queue(&nvs_gc_work_q, &fs->gc_work);
+	}
+#endif
+
 	rc = len;
 end:
-	k_mutex_unlock(&fs->nvs_lock);
 	if (rc < 0) {
 		fs->free_space -= freed_space;
 	}
 	if (rc == -EROFS) {
 		fs->locked = true;
 	}
+	k_mutex_unlock(&fs->nvs_lock);
+	return rc;
+}
+
+int nvs_compact(struct nvs_fs *fs, size_t min_free)
+{
+	int rc;
+
+	if (fs->locked) {
+		return -EROFS;
+	}
+
+	k_mutex_lock(&fs->nvs_lock, K_FOREVER);
+	rc = _nvs_compact(fs, min_free);
+	k_mutex_unlock(&fs->nvs_lock);
+
 	return rc;
 }
 
@@ -886,6 +1162,9 @@ ssize_t nvs_read_hist(struct nvs_fs *fs, u16_t id, void *data, size_t len,
 
 	cnt_his = 0U;
 
+	/* gc may erase the entry while it is read */
+	k_mutex_lock(&fs->nvs_lock, K_FOREVER);
+
 	wlk_addr = fs->ate_wra;
 	rd_addr = wlk_addr;
 
@@ -905,7 +1184,8 @@ ssize_t nvs_read_hist(struct nvs_fs *fs, u16_t id, void *data, size_t len,
 
 	if (((wlk_addr == fs->ate_wra) && (wlk_ate.id != id)) ||
 	    (wlk_ate.len == 0) || (cnt_his < cnt)) {
-		return -ENOENT;
+		rc = -ENOENT;
+		goto err;
 	}
 
 	rd_addr &= ADDR_SECT_MASK;
@@ -914,10 +1194,10 @@ ssize_t nvs_read_hist(struct nvs_fs *fs, u16_t id, void *data, size_t len,
 	if (rc) {
 		goto err;
 	}
-
-	return wlk_ate.len;
+	rc = wlk_ate.len;
 
 err:
+	k_mutex_unlock(&fs->nvs_lock);
 	return rc;
 }
 
@@ -0,0 +1,573 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log_backend.h>
+#include <logging/log_backend_flash.h>
+#include <logging/log_core.h>
+#include <logging/log_msg.h>
+#include <logging/log_output.h>
+#include <flash_map.h>
+#include <fcb.h>
+#include <kernel.h>
+#include <misc/byteorder.h>
+#include <misc/util.h>
+#include <errno.h>
+#include <string.h>
+
+/* Every FCB entry holds one block: header followed by dictionary records.
+ *
+ * Header layout (little endian):
+ *	u32 sequence number
+ *	u32 timestamp of the first record
+ *	u16 boot number
+ *	u16 length of records
+ *	u16 number of timestamp wraps in the boot
+ *	u16 reserved, 0xFFFF
+ *
+ * Records never cross block boundary, so every block can be decoded on its
+ * own. Remaining space up to the flash write alignment is filled with 0xFF.
+ */
+#define BLOCK_HDR_LEN 16
+#define BLOCK_DATA_MAX (CONFIG_LOG_BACKEND_FLASH_BLOCK_SIZE - BLOCK_HDR_LEN)
+
+#define FCB_VERSION 2
+
+/* First block of the sector, used to find where reading should start. */
+struct sector_index {
+	u32_t seq;
+	u64_t timestamp;
+	u16_t boot;
+	bool valid;
+};
+
+static struct flash_sector sectors[CONFIG_LOG_BACKEND_FLASH_SECTORS];
+static struct sector_index sector_idx[CONFIG_LOG_BACKEND_FLASH_SECTORS];
+
+static struct fcb fcb = {
+	.f_magic = CONFIG_LOG_BACKEND_FLASH_MAGIC,
+	.f_version = FCB_VERSION,
+	.f_sectors = sectors,
+};
+
+static u8_t block[CONFIG_LOG_BACKEND_FLASH_BLOCK_SIZE];
+static u32_t block_len;
+static u64_t block_timestamp;
+
+static u8_t read_buf[CONFIG_LOG_BACKEND_FLASH_BLOCK_SIZE];
+
+static u8_t rec[BLOCK_DATA_MAX];
+static u32_t rec_len;
+static bool rec_overflow;
+
+static u32_t next_seq;
+static u32_t last_timestamp;
+static u16_t wraps;
+static u16_t boot;
+static u32_t lost;
+static bool initialized;
+static bool panic_mode;
+
+/* Protects block, sector index and FCB state. */
+static K_MUTEX_DEFINE(lock);
+
+/* Protects read buffer. */
+static K_MUTEX_DEFINE(read_lock);
+
+static int rec_out(u8_t *data, size_t length, void *ctx)
+{
+	size_t len = length;
+
+	ARG_UNUSED(ctx);
+
+	if (len > sizeof(rec) - rec_len) {
+		len = sizeof(rec) - rec_len;
+		rec_overflow = true;
+	}
+
+	memcpy(&rec[rec_len], data, len);
+	rec_len += len;
+
+	return length;
+}
+
+static u8_t output_buf[16];
+
+LOG_OUTPUT_DEFINE(log_output, rec_out, output_buf, sizeof(output_buf));
+
+/* In panic mode only the panic context is running and it may not block. */
+static void storage_lock(void)
+{
+	if (!panic_mode) {
+		k_mutex_lock(&lock, K_FOREVER);
+	}
+}
+
+static void storage_unlock(void)
+{
+	if (!panic_mode) {
+		k_mutex_unlock(&lock);
+	}
+}
+
+static inline u64_t index_time_get(const struct sector_index *idx)
+{
+	return LOG_BACKEND_FLASH_TIME(idx->boot, idx->timestamp);
+}
+
+static int block_hdr_parse(const u8_t *data, u32_t len,
+			   struct log_backend_flash_block *blk)
+{
+	if (len < BLOCK_HDR_LEN) {
+		return -EINVAL;
+	}
+
+	blk->seq = sys_get_le32(&data[0]);
+	blk->timestamp = ((u64_t)sys_get_le16(&data[12]) << 32) |
+			 sys_get_le32(&data[4]);
+	blk->boot = sys_get_le16(&data[8]);
+	blk->len = sys_get_le16(&data[10]);
+	blk->data = &data[BLOCK_HDR_LEN];
+
+	if (blk->len > len - BLOCK_HDR_LEN) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int block_hdr_read(struct fcb_entry *loc,
+			  struct log_backend_flash_block *blk)
+{
+	u8_t hdr[BLOCK_HDR_LEN];
+
+	if (loc->fe_data_len < BLOCK_HDR_LEN ||
+	    flash_area_read(fcb.fap, FCB_ENTRY_FA_DATA_OFF((*loc)), hdr,
+			    sizeof(hdr))) {
+		return -EIO;
+	}
+
+	blk->seq = sys_get_le32(&hdr[0]);
+	blk->timestamp = ((u64_t)sys_get_le16(&hdr[12]) << 32) |
+			 sys_get_le32(&hdr[4]);
+	blk->boot = sys_get_le16(&hdr[8]);
+
+	return 0;
+}
+
+static int sector_index_cb(struct fcb_entry_ctx *entry_ctx, void *arg)
+{
+	struct log_backend_flash_block *blk = arg;
+
+	if (block_hdr_read(&entry_ctx->loc, blk) == 0) {
+		/* Stop at the first valid block. */
+		return 1;
+	}
+
+	return 0;
+}
+
+static int sector_last_cb(struct fcb_entry_ctx *entry_ctx, void *arg)
+{
+	struct log_backend_flash_block *blk = arg;
+
+	(void)block_hdr_read(&entry_ctx->loc, blk);
+
+	return 0;
+}
+
+static void index_build(void)
+{
+	struct log_backend_flash_block blk;
+	struct flash_sector *sector = fcb.f_oldest;
+	struct flash_sector *last = NULL;
+
+	memset(sector_idx, 0, sizeof(sector_idx));
+
+	/* Only the first block of every sector is read. */
+	while (true) {
+		struct sector_index *idx = &sector_idx[sector - sectors];
+
+		if (fcb_walk(&fcb, sector, sector_index_cb, &blk) == 1) {
+			idx->seq = blk.seq;
+			idx->timestamp = blk.timestamp;
+			idx->boot = blk.boot;
+			idx->valid = true;
+			last = sector;
+		}
+
+		if (sector == fcb.f_active.fe_sector) {
+			break;
+		}
+
+		sector = (sector + 1 == &sectors[fcb.f_sector_cnt]) ?
+			 sectors : sector + 1;
+	}
+
+	if (last == NULL) {
+		return;
+	}
+
+	/* Continue numbering after the newest stored block. */
+	blk.seq = sector_idx[last - sectors].seq;
+	blk.boot = sector_idx[last - sectors].boot;
+	(void)fcb_walk(&fcb, last, sector_last_cb, &blk);
+
+	next_seq = blk.seq + 1;
+	boot = blk.boot + 1;
+}
+
+static int storage_init(void)
+{
+	u32_t cnt = ARRAY_SIZE(sectors);
+	int rc;
+
+	if (initialized) {
+		return 0;
+	}
+
+	rc = flash_area_get_sectors(CONFIG_LOG_BACKEND_FLASH_AREA, &cnt,
+				    sectors);
+	if (rc != 0 && rc != -ENOMEM) {
+		return -ENODEV;
+	}
+
+	fcb.f_sector_cnt = cnt;
+
+	rc = fcb_init(CONFIG_LOG_BACKEND_FLASH_AREA, &fcb);
+	if (rc == FCB_ERR_MAGIC || rc == FCB_ERR_VERSION) {
+		/* Partition holds something else or a log in an older
+		 * format, start over. Other errors may be transient, stored
+		 * log is kept and initialization is retried on next use.
+		 */
+		rc = flash_area_erase(fcb.fap, 0, fcb.fap->fa_size);
+		if (rc == 0) {
+			rc = fcb_init(CONFIG_LOG_BACKEND_FLASH_AREA, &fcb);
+		}
+	}
+
+	if (rc != 0) {
+		return -EIO;
+	}
+
+	index_build();
+	initialized = true;
+
+	return 0;
+}
+
+/* Panic context may interrupt a thread which is initializing storage, so
+ * in panic mode storage is used only if it is already initialized.
+ */
+static int storage_ready(void)
+{
+	if (panic_mode) {
+		return initialized ? 0 : -EIO;
+	}
+
+	return storage_init();
+}
+
+static int block_write(void)
+{
+	struct sector_index *idx;
+	struct fcb_entry loc;
+	u32_t len;
+	int rc;
+
+	if (block_len == 0) {
+		return 0;
+	}
+
+	sys_put_le32(next_seq, &block[0]);
+	sys_put_le32((u32_t)block_timestamp, &block[4]);
+	sys_put_le16(boot, &block[8]);
+	sys_put_le16(block_len, &block[10]);
+	sys_put_le16((u16_t)(block_timestamp >> 32), &block[12]);
+	sys_put_le16(0xFFFF, &block[14]);
+
+	len = ROUND_UP(BLOCK_HDR_LEN + block_len, fcb.f_align);
+	memset(&block[BLOCK_HDR_LEN + block_len], 0xFF,
+	       len - BLOCK_HDR_LEN - block_len);
+	block_len = 0;
+
+	rc = fcb_append(&fcb, len, &loc);
+	if (rc == FCB_ERR_NOSPACE) {
+		/* Partition is full, oldest sector is reused. FCB writes
+		 * sectors in turn so they wear evenly.
+		 */
+		sector_idx[fcb.f_oldest - sectors].valid = false;
+		rc = fcb_rotate(&fcb);
+		if (rc == 0) {
+			rc = fcb_append(&fcb, len, &loc);
+		}
+	}
+
+	if (rc == 0) {
+		rc = fcb_flash_write(&fcb, loc.fe_sector, loc.fe_data_off,
+				     block, len);
+	}
+
+	if (rc == 0) {
+		rc = fcb_append_finish(&fcb, &loc);
+	}
+
+	if (rc != 0) {
+		return -EIO;
+	}
+
+	idx = &sector_idx[loc.fe_sector - sectors];
+	if (!idx->valid) {
+		idx->seq = next_seq;
+		idx->timestamp = block_timestamp;
+		idx->boot = boot;
+		idx->valid = true;
+	}
+
+	next_seq++;
+
+	return 0;
+}
+
+/* Move record prepared by log_output to the block. */
+static void rec_store(u32_t timestamp)
+{
+	if (rec_overflow) {
+		lost++;
+	} else if (rec_len != 0) {
+		if (block_len + rec_len > BLOCK_DATA_MAX) {
+			(void)block_write();
+		}
+
+		if (block_len == 0) {
+			block_timestamp = ((u64_t)wraps << 32) | timestamp;
+		}
+
+		memcpy(&block[BLOCK_HDR_LEN + block_len], rec, rec_len);
+		block_len += rec_len;
+	}
+
+	rec_len = 0;
+	rec_overflow = false;
+}
+
+static void timestamp_update(u32_t timestamp)
+{
+	/* Keep time keys growing when timestamp wraps around. Boot number
+	 * stays, so blocks are still attributed to the right boot.
+	 */
+	if (timestamp < last_timestamp) {
+		wraps++;
+	}
+
+	last_timestamp = timestamp;
+}
+
+static void lost_store(void)
+{
+	if (lost != 0) {
+		log_output_dropped_process(&log_output, lost);
+		lost = 0;
+		rec_store(last_timestamp);
+	}
+}
+
+static void put(const struct log_backend *const backend,
+		struct log_msg *msg)
+{
+	u32_t timestamp = log_msg_timestamp_get(msg);
+
+	ARG_UNUSED(backend);
+
+	log_msg_get(msg);
+
+	storage_lock();
+
+	if (storage_ready() == 0) {
+		timestamp_update(timestamp);
+		lost_store();
+		log_output_msg_process(&log_output, msg,
+				       LOG_OUTPUT_FLAG_DICTIONARY);
+		rec_store(timestamp);
+
+		if (panic_mode) {
+			(void)block_write();
+		}
+	}
+
+	storage_unlock();
+
+	log_msg_put(msg);
+}
+
+static void dropped(const struct log_backend *const backend, u32_t cnt)
+{
+	ARG_UNUSED(backend);
+
+	storage_lock();
+	lost += cnt;
+	storage_unlock();
+}
+
+static void panic(struct log_backend const *const backend)
+{
+	ARG_UNUSED(backend);
+
+	panic_mode = true;
+
+	/* From now on every message is written to flash as soon as it is
+	 * processed.
+	 */
+	if (storage_ready() == 0) {
+		(void)block_write();
+	}
+}
+
+static void log_backend_flash_init(void)
+{
+	log_output_flags_set(&log_output, LOG_OUTPUT_FLAG_DICTIONARY);
+
+	/* Logger may be initialized before flash driver, in that case
+	 * initialization is retried on the first use.
+	 */
+	storage_lock();
+	(void)storage_ready();
+	storage_unlock();
+}
+
+int log_backend_flash_flush(void)
+{
+	int rc;
+
+	storage_lock();
+
+	rc = storage_ready();
+	if (rc == 0) {
+		lost_store();
+		rc = block_write();
+	}
+
+	storage_unlock();
+
+	return rc;
+}
+
+/* Find sector from which reading should start. Sectors preceding sector
+ * whose first block is already too old cannot contain requested blocks.
+ */
+static struct flash_sector *start_sector_get(u64_t min_time, u32_t min_seq)
+{
+	struct flash_sector *start = NULL;
+	struct flash_sector *sector;
+
+	storage_lock();
+
+	sector = fcb.f_oldest;
+	while (true) {
+		struct sector_index *idx = &sector_idx[sector - sectors];
+
+		if (idx->valid && (idx->seq <= min_seq ||
+				   index_time_get(idx) < min_time)) {
+			start = sector;
+		}
+
+		if (sector == fcb.f_active.fe_sector) {
+			break;
+		}
+
+		sector = (sector + 1 == &sectors[fcb.f_sector_cnt]) ?
+			 sectors : sector + 1;
+	}
+
+	storage_unlock();
+
+	return start;
+}
+
+int log_backend_flash_walk(u64_t min_time, u32_t min_seq,
+			   log_backend_flash_walk_cb_t cb, void *ctx)
+{
+	struct log_backend_flash_block blk;
+	struct fcb_entry loc;
+	u64_t time;
+	u32_t len;
+	int rc;
+
+	storage_lock();
+	rc = storage_ready();
+	storage_unlock();
+
+	if (rc != 0) {
+		return rc;
+	}
+
+	k_mutex_lock(&read_lock, K_FOREVER);
+
+	loc.fe_sector = start_sector_get(min_time, min_seq);
+	loc.fe_elem_off = 0;
+
+	while (fcb_getnext(&fcb, &loc) == 0) {
+		len = min(loc.fe_data_len, sizeof(read_buf));
+
+		if (flash_area_read(fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc),
+				    read_buf, len) ||
+		    block_hdr_parse(read_buf, len, &blk)) {
+			continue;
+		}
+
+		time = LOG_BACKEND_FLASH_TIME(blk.boot, blk.timestamp);
+		if (blk.seq < min_seq || time < min_time) {
+			continue;
+		}
+
+		rc = cb(&blk, ctx);
+		if (rc != 0) {
+			break;
+		}
+	}
+
+	k_mutex_unlock(&read_lock);
+
+	return rc;
+}
+
+u32_t log_backend_flash_next_seq_get(void)
+{
+	u32_t seq;
+
+	storage_lock();
+	seq = (storage_ready() == 0) ? next_seq : 0;
+	storage_unlock();
+
+	return seq;
+}
+
+int log_backend_flash_clear(void)
+{
+	int rc;
+
+	storage_lock();
+
+	rc = storage_ready();
+	if (rc == 0) {
+		block_len = 0;
+		lost = 0;
+		rc = fcb_clear(&fcb) ? -EIO : 0;
+		memset(sector_idx, 0, sizeof(sector_idx));
+	}
+
+	storage_unlock();
+
+	return rc;
+}
+
+const struct log_backend_api log_backend_flash_api = {
+	.put = put,
+	.dropped = dropped,
+	.panic = panic,
+	.init = log_backend_flash_init,
+};
+
+LOG_BACKEND_DEFINE(log_backend_flash, log_backend_flash_api, true);
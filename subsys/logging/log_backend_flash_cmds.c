@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <shell/shell.h>
+#include <logging/log_backend_flash.h>
+#include <stdlib.h>
+
+#define HEX_BYTES_IN_LINE 32
+
+static char hex_char(u8_t nibble)
+{
+	return (nibble < 10) ? '0' + nibble : 'a' + nibble - 10;
+}
+
+/* Blocks are printed as a header line followed by lines of hex data which
+ * can be passed to scripts/logging/log_parser_dict.py --hex.
+ */
+static int block_print(const struct log_backend_flash_block *block,
+		       void *ctx)
+{
+	const struct shell *shell = ctx;
+	char line[2 * HEX_BYTES_IN_LINE + 1];
+
+	shell_print(shell, "block %u boot %u wraps %u timestamp %u len %u",
+		    block->seq, block->boot, (u32_t)(block->timestamp >> 32),
+		    (u32_t)block->timestamp, block->len);
+
+	for (u32_t off = 0; off < block->len; off += HEX_BYTES_IN_LINE) {
+		u32_t chunk = min(block->len - off, HEX_BYTES_IN_LINE);
+
+		for (u32_t i = 0; i < chunk; i++) {
+			line[2 * i] = hex_char(block->data[off + i] >> 4);
+			line[2 * i + 1] = hex_char(block->data[off + i] & 0xF);
+		}
+
+		line[2 * chunk] = '\0';
+		shell_print(shell, "%s", line);
+	}
+
+	return 0;
+}
+
+static int dump(const struct shell *shell, u64_t min_time, u32_t min_seq)
+{
+	int rc;
+
+	rc = log_backend_flash_flush();
+	if (rc == 0) {
+		rc = log_backend_flash_walk(min_time, min_seq, block_print,
+					    (void *)shell);
+	}
+
+	if (rc != 0) {
+		shell_error(shell, "Failed to read log (err %d).", rc);
+	}
+
+	return 0;
+}
+
+static int cmd_log_flash_dump(const struct shell *shell,
+			      size_t argc, char **argv)
+{
+	u32_t min_seq = (argc > 1) ? strtoul(argv[1], NULL, 0) : 0;
+
+	return dump(shell, 0, min_seq);
+}
+
+static int cmd_log_flash_seek(const struct shell *shell,
+			      size_t argc, char **argv)
+{
+	u32_t boot = strtoul(argv[1], NULL, 0);
+	u64_t timestamp = strtoul(argv[2], NULL, 0);
+
+	if (argc > 3) {
+		timestamp |= (u64_t)strtoul(argv[3], NULL, 0) << 32;
+	}
+
+	return dump(shell, LOG_BACKEND_FLASH_TIME(boot, timestamp), 0);
+}
+
+static int cmd_log_flash_flush(const struct shell *shell,
+			       size_t argc, char **argv)
+{
+	int rc = log_backend_flash_flush();
+
+	if (rc != 0) {
+		shell_error(shell, "Failed to flush log (err %d).", rc);
+	}
+
+	return 0;
+}
+
+static int cmd_log_flash_clear(const struct shell *shell,
+			       size_t argc, char **argv)
+{
+	int rc = log_backend_flash_clear();
+
+	if (rc != 0) {
+		shell_error(shell, "Failed to clear log (err %d).", rc);
+	}
+
+	return 0;
+}
+
+static int cmd_log_flash_status(const struct shell *shell,
+				size_t argc, char **argv)
+{
+	shell_print(shell, "Next block: %u", log_backend_flash_next_seq_get());
+
+	return 0;
+}
+
+SHELL_CREATE_STATIC_SUBCMD_SET(sub_log_flash)
+{
+	SHELL_CMD(clear, NULL, "Erase stored logs.", cmd_log_flash_clear),
+	SHELL_CMD_ARG(dump, NULL,
+		      "'log_flash dump [<block>]' prints stored blocks "
+		      "starting from given block number.",
+		      cmd_log_flash_dump, 1, 1),
+	SHELL_CMD(flush, NULL, "Write pending records to flash.",
+		  cmd_log_flash_flush),
+	SHELL_CMD_ARG(seek, NULL,
+		      "'log_flash seek <boot> <timestamp> [<wraps>]' prints "
+		      "stored blocks starting from given time.",
+		      cmd_log_flash_seek, 3, 1),
+	SHELL_CMD(status, NULL, "Flash log status.", cmd_log_flash_status),
+	SHELL_SUBCMD_SET_END
+};
+
+SHELL_CMD_REGISTER(log_flash, &sub_log_flash, "Flash log backend commands",
+		   NULL);
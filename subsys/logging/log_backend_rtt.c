@@ -228,6 +228,10 @@ static void log_backend_rtt_init(void)
 	host_present = true;
 	panic_mode = 0;
 	line_pos = line_buf;
+
+	if (IS_ENABLED(CONFIG_LOG_BACKEND_DICTIONARY)) {
+		log_output_flags_set(&log_output, LOG_OUTPUT_FLAG_DICTIONARY);
+	}
 }
 
 static void panic(struct log_backend const *const backend)
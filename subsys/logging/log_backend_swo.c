@@ -104,6 +104,10 @@ static void log_backend_swo_init(void)
 	ITM->TCR  = 0x0001000D;
 	/* Enable stimulus port used by the logger */
 	ITM->TER  = 1 << ITM_PORT_LOGGER;
+
+	if (IS_ENABLED(CONFIG_LOG_BACKEND_DICTIONARY)) {
+		log_output_flags_set(&log_output, LOG_OUTPUT_FLAG_DICTIONARY);
+	}
 }
 
 static void log_backend_swo_panic(struct log_backend const *const backend)
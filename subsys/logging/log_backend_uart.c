@@ -11,11 +11,83 @@
 #include <device.h>
 #include <uart.h>
 #include <assert.h>
+#include <string.h>
+
+/* In panic mode interrupts may be locked so transfer completion is polled
+ * for at most that long before the transfer is aborted.
+ */
+#define TX_PANIC_WAIT_US 100000
+
+static u8_t buf[CONFIG_LOG_BACKEND_UART_BUFFER_SIZE];
+
+#ifdef CONFIG_UART_ASYNC_API
+/* Line is copied to the second buffer so that the next record can be
+ * formatted while the previous one is being transmitted.
+ */
+static u8_t tx_buf[CONFIG_LOG_BACKEND_UART_BUFFER_SIZE];
+static K_SEM_DEFINE(tx_sem, 1, 1);
+static bool async;
+
+static void uart_callback(struct uart_event *evt, void *user_data)
+{
+	switch (evt->type) {
+	case UART_TX_DONE:
+	case UART_TX_ABORTED:
+		k_sem_give(&tx_sem);
+		break;
+	default:
+		break;
+	}
+}
+
+static bool tx_wait(struct device *dev, bool block)
+{
+	if (block) {
+		return k_sem_take(&tx_sem, K_FOREVER) == 0;
+	}
+
+	for (int i = 0; i < TX_PANIC_WAIT_US; i++) {
+		if (k_sem_take(&tx_sem, K_NO_WAIT) == 0) {
+			return true;
+		}
+
+		k_busy_wait(1);
+	}
+
+	(void)uart_tx_abort(dev);
+
+	return k_sem_take(&tx_sem, K_NO_WAIT) == 0;
+}
+
+static int async_out(struct device *dev, u8_t *data, size_t length)
+{
+	bool block = !k_is_in_isr() && !IS_ENABLED(CONFIG_LOG_INPLACE_PROCESS);
+
+	if (!tx_wait(dev, block)) {
+		return -EBUSY;
+	}
+
+	memcpy(tx_buf, data, length);
+
+	return uart_tx(dev, tx_buf, length, K_FOREVER);
+}
+#endif /* CONFIG_UART_ASYNC_API */
 
 static int char_out(u8_t *data, size_t length, void *ctx)
 {
 	struct device *dev = (struct device *)ctx;
 
+#ifdef CONFIG_UART_ASYNC_API
+	if (async) {
+		if (async_out(dev, data, length) == 0) {
+			return length;
+		}
+
+		/* Fall back to polling if transfer cannot be started. */
+		async = false;
+	}
+#endif
+
 	for (size_t i = 0; i < length; i++) {
 		uart_poll_out(dev, data[i]);
 	}
@@ -23,9 +95,7 @@ static int char_out(u8_t *data, size_t length, void *ctx)
 	return length;
 }
 
-static u8_t buf;
-
-LOG_OUTPUT_DEFINE(log_output, char_out, &buf, 1);
+LOG_OUTPUT_DEFINE(log_output, char_out, buf, sizeof(buf));
 
 static void put(const struct log_backend *const backend,
 		struct log_msg *msg)
@@ -56,10 +126,27 @@ static void log_backend_uart_init(void)
 	assert(dev);
 
 	log_output_ctx_set(&log_output, dev);
+
+	if (IS_ENABLED(CONFIG_LOG_BACKEND_DICTIONARY)) {
+		log_output_flags_set(&log_output, LOG_OUTPUT_FLAG_DICTIONARY);
+	}
+
+#ifdef CONFIG_UART_ASYNC_API
+	async = (uart_callback_set(dev, uart_callback, NULL) == 0);
+#endif
 }
 
 static void panic(struct log_backend const *const backend)
 {
+#ifdef CONFIG_UART_ASYNC_API
+	/* Complete pending transfer and switch to polling. */
+	if (async) {
+		async = false;
+		(void)tx_wait((struct device *)log_output.control_block->ctx,
+			      false);
+	}
+#endif
+
 	log_output_flush(&log_output);
 }
 
@@ -5,6 +5,7 @@
  */
 #include <logging/log_msg.h>
 #include "log_list.h"
+#include "log_queue.h"
 #include <logging/log.h>
 #include <logging/log_backend.h>
 #include <logging/log_ctrl.h>
@@ -27,11 +28,20 @@ struct log_strdup_buf {
 	(sizeof(struct log_strdup_buf) * CONFIG_LOG_STRDUP_BUF_COUNT)
 
 static const char *log_strdup_fail_msg = "<log_strdup alloc failed>";
-struct k_mem_slab log_strdup_pool;
 static u8_t __noinit __aligned(sizeof(u32_t))
 		log_strdup_pool_buf[LOG_STRDUP_POOL_BUFFER_SIZE];
 
+#ifdef CONFIG_LOG_LOCKLESS
+#define NUM_OF_MSGS (CONFIG_LOG_BUFFER_SIZE / sizeof(union log_msg_chunk))
+
+static struct log_pool log_strdup_lockless_pool;
+static struct log_queue queue;
+static atomic_t queue_slots[NUM_OF_MSGS];
+static atomic_t processing;
+#else
+struct k_mem_slab log_strdup_pool;
 static struct log_list_t list;
+#endif
 static atomic_t initialized;
 static bool panic_mode;
 static bool backend_attached;
@@ -47,21 +57,51 @@ static u32_t dummy_timestamp(void)
 	return 0;
 }
 
+static inline void msg_enqueue(struct log_msg *msg)
+{
+#ifdef CONFIG_LOG_LOCKLESS
+	log_queue_put(&queue, msg);
+#else
+	unsigned int key = irq_lock();
+
+	log_list_add_tail(&list, msg);
+
+	irq_unlock(key);
+#endif
+}
+
+static inline struct log_msg *msg_dequeue(void)
+{
+#ifdef CONFIG_LOG_LOCKLESS
+	return log_queue_get(&queue);
+#else
+	unsigned int key = irq_lock();
+	struct log_msg *msg = log_list_head_get(&list);
+
+	irq_unlock(key);
+
+	return msg;
+#endif
+}
+
+static inline bool msg_pending(void)
+{
+#ifdef CONFIG_LOG_LOCKLESS
+	return log_queue_peek(&queue);
+#else
+	return (log_list_head_peek(&list) != NULL);
+#endif
+}
+
 static inline void msg_finalize(struct log_msg *msg,
 				struct log_msg_ids src_level)
 {
-	unsigned int key;
-
 	msg->hdr.ids = src_level;
 	msg->hdr.timestamp = timestamp_func();
 
 	atomic_inc(&buffered_cnt);
 
-	key = irq_lock();
-
-	log_list_add_tail(&list, msg);
-
-	irq_unlock(key);
+	msg_enqueue(msg);
 
 	if (IS_ENABLED(CONFIG_LOG_INPLACE_PROCESS) || panic_mode) {
 		(void)log_process(false);
@@ -224,11 +264,18 @@ static u32_t timestamp_get(void)
 void log_core_init(void)
 {
 	log_msg_pool_init();
+#ifdef CONFIG_LOG_LOCKLESS
+	log_queue_init(&queue, &log_msg_lockless_pool, queue_slots);
+	log_pool_init(&log_strdup_lockless_pool, log_strdup_pool_buf,
+		      sizeof(struct log_strdup_buf),
+		      CONFIG_LOG_STRDUP_BUF_COUNT);
+#else
 	log_list_init(&list);
 
 	k_mem_slab_init(&log_strdup_pool, log_strdup_pool_buf,
 				sizeof(struct log_strdup_buf),
 				CONFIG_LOG_STRDUP_BUF_COUNT);
+#endif
 
 	/* Set default timestamp. */
 	timestamp_func = timestamp_get;
@@ -389,10 +436,18 @@ bool log_process(bool bypass)
 	if (!backend_attached && !bypass) {
 		return false;
 	}
-	unsigned int key = irq_lock();
 
-	msg = log_list_head_get(&list);
-	irq_unlock(key);
+#ifdef CONFIG_LOG_LOCKLESS
+	/* Queue has a single consumer. Context which finds processing in
+	 * progress leaves messages to it. In panic mode interrupted context
+	 * is not going to continue.
+	 */
+	if (!atomic_cas(&processing, 0, 1) && !panic_mode) {
+		return false;
+	}
+#endif
+
+	msg = msg_dequeue();
 
 	if (msg != NULL) {
 		atomic_dec(&buffered_cnt);
@@ -403,7 +458,11 @@ bool log_process(bool bypass)
 		dropped_notify();
 	}
 
-	return (log_list_head_peek(&list) != NULL);
+#ifdef CONFIG_LOG_LOCKLESS
+	atomic_clear(&processing);
+#endif
+
+	return msg_pending();
 }
 
 u32_t log_buffered_cnt(void)
@@ -544,7 +603,12 @@ char *log_strdup(const char *str)
 	struct log_strdup_buf *dup;
 	int err;
 
+#ifdef CONFIG_LOG_LOCKLESS
+	dup = log_pool_alloc(&log_strdup_lockless_pool);
+	err = (dup == NULL) ? -ENOMEM : 0;
+#else
 	err = k_mem_slab_alloc(&log_strdup_pool, (void **)&dup, K_NO_WAIT);
+#endif
 	if (err != 0) {
 		/* failed to allocate */
 		return (char *)log_strdup_fail_msg;
@@ -578,7 +642,11 @@ void log_free(void *str)
 						  buf);
 
 	if (atomic_dec(&dup->refcount) == 1) {
+#ifdef CONFIG_LOG_LOCKLESS
+		log_pool_free(&log_strdup_lockless_pool, dup);
+#else
 		k_mem_slab_free(&log_strdup_pool, (void **)&dup);
+#endif
 	}
 }
 
@@ -8,17 +8,54 @@
 #include <logging/log_ctrl.h>
 #include <logging/log_core.h>
 #include <string.h>
+#include "log_queue.h"
 
 #define MSG_SIZE sizeof(union log_msg_chunk)
 #define NUM_OF_MSGS (CONFIG_LOG_BUFFER_SIZE / MSG_SIZE)
 
+#ifdef CONFIG_LOG_LOCKLESS
+BUILD_ASSERT_MSG(NUM_OF_MSGS <= LOG_POOL_MAX_BLOCKS,
+		 "Too many messages for lock-free pool");
+
+struct log_pool log_msg_lockless_pool;
+#else
 struct k_mem_slab log_msg_pool;
+#endif
 static u8_t __noinit __aligned(sizeof(u32_t))
 		log_msg_pool_buf[CONFIG_LOG_BUFFER_SIZE];
 
 void log_msg_pool_init(void)
 {
+#ifdef CONFIG_LOG_LOCKLESS
+	log_pool_init(&log_msg_lockless_pool, log_msg_pool_buf, MSG_SIZE,
+		      NUM_OF_MSGS);
+#else
 	k_mem_slab_init(&log_msg_pool, log_msg_pool_buf, MSG_SIZE, NUM_OF_MSGS);
+#endif
+}
+
+union log_msg_chunk *log_msg_chunk_pool_alloc(void)
+{
+	union log_msg_chunk *chunk = NULL;
+
+#ifdef CONFIG_LOG_LOCKLESS
+	chunk = log_pool_alloc(&log_msg_lockless_pool);
+#else
+	if (k_mem_slab_alloc(&log_msg_pool, (void **)&chunk, K_NO_WAIT) != 0) {
+		chunk = NULL;
+	}
+#endif
+
+	return chunk;
+}
+
+static void chunk_free(void *chunk)
+{
+#ifdef CONFIG_LOG_LOCKLESS
+	log_pool_free(&log_msg_lockless_pool, chunk);
+#else
+	k_mem_slab_free(&log_msg_pool, &chunk);
+#endif
 }
 
 void log_msg_get(struct log_msg *msg)
@@ -32,7 +69,7 @@ static void cont_free(struct log_msg_cont *cont)
 
 	while (cont != NULL) {
 		next = cont->next;
-		k_mem_slab_free(&log_msg_pool, (void **)&cont);
+		chunk_free(cont);
 		cont = next;
 	}
 }
@@ -58,22 +95,19 @@ static void msg_free(struct log_msg *msg)
 		cont_free(msg->payload.ext.next);
 	}
 
-	k_mem_slab_free(&log_msg_pool, (void **)&msg);
+	chunk_free(msg);
 }
 
 union log_msg_chunk *log_msg_no_space_handle(void)
 {
 	union log_msg_chunk *msg = NULL;
 	bool more;
-	int err;
 
 	if (IS_ENABLED(CONFIG_LOG_MODE_OVERFLOW)) {
 		do {
 			more = log_process(true);
-			err = k_mem_slab_alloc(&log_msg_pool,
-					       (void **)&msg,
-					       K_NO_WAIT);
-		} while ((err != 0) && more);
+			msg = log_msg_chunk_pool_alloc();
+		} while ((msg == NULL) && more);
 	}
 	return msg;
 
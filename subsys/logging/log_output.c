@@ -12,6 +12,8 @@
 #include <time.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+#include <misc/byteorder.h>
 
 #define LOG_COLOR_CODE_DEFAULT "\x1B[0m"
 #define LOG_COLOR_CODE_RED     "\x1B[1;31m"
@@ -19,6 +21,23 @@
 
 #define HEXDUMP_BYTES_IN_LINE 8
 
+/* Dictionary record layout (little endian):
+ * u8 magic, u8 type | level << 4, u16 domain_id << 10 | source_id,
+ * u32 timestamp followed by type specific data.
+ */
+#define DICT_MAGIC 0xA5
+#define DICT_TYPE_STD 1
+#define DICT_TYPE_HEXDUMP 2
+#define DICT_TYPE_RAW_STRING 3
+#define DICT_TYPE_DROPPED 4
+
+/* Dictionary records are only compiled in if a backend may send them. */
+#define DICT_SUPPORTED (IS_ENABLED(CONFIG_LOG_BACKEND_DICTIONARY) || \
+			IS_ENABLED(CONFIG_LOG_BACKEND_FLASH))
+
+/* Longest string argument sent in the dictionary record. */
+#define DICT_STR_MAX_LEN 255
+
 #define  DROPPED_COLOR_PREFIX \
 	_LOG_EVAL(CONFIG_LOG_BACKEND_SHOW_COLOR, (LOG_COLOR_CODE_RED), ())
 
@@ -459,6 +478,181 @@ static void raw_string_print(struct log_msg *msg,
 	}
 }
 
+static void dict_bytes_out(const struct log_output *log_output,
+			   const void *data, size_t len)
+{
+	struct log_output_control_block *cb = log_output->control_block;
+	const u8_t *src = data;
+	size_t cpy_len;
+
+	while (len > 0) {
+		cpy_len = min(len, log_output->size - cb->offset);
+		memcpy(&log_output->buf[cb->offset], src, cpy_len);
+		cb->offset += cpy_len;
+		src += cpy_len;
+		len -= cpy_len;
+
+		if (cb->offset == log_output->size) {
+			log_output_flush(log_output);
+		}
+	}
+}
+
+static void dict_u16_out(const struct log_output *log_output, u16_t val)
+{
+	u8_t buf[sizeof(u16_t)];
+
+	sys_put_le16(val, buf);
+	dict_bytes_out(log_output, buf, sizeof(buf));
+}
+
+static void dict_u32_out(const struct log_output *log_output, u32_t val)
+{
+	u8_t buf[sizeof(u32_t)];
+
+	sys_put_le32(val, buf);
+	dict_bytes_out(log_output, buf, sizeof(buf));
+}
+
+static void dict_hdr_out(const struct log_output *log_output, u8_t type,
+			 u32_t level, u32_t ids, u32_t timestamp)
+{
+	u8_t hdr[] = { DICT_MAGIC, type | (level << 4) };
+
+	dict_bytes_out(log_output, hdr, sizeof(hdr));
+	dict_u16_out(log_output, ids);
+	dict_u32_out(log_output, timestamp);
+}
+
+/* Returns mask of arguments consumed by %s conversions. Strings cannot be
+ * resolved from the ELF file on the host so they are sent along.
+ */
+static u32_t dict_str_args_get(const char *fmt)
+{
+	u32_t mask = 0U;
+	u32_t arg = 0U;
+
+	while ((fmt = strchr(fmt, '%')) != NULL) {
+		fmt++;
+
+		if (*fmt == '%') {
+			fmt++;
+			continue;
+		}
+
+		/* Skip flags, width, precision and length modifiers. */
+		while ((*fmt != '\0') && (strchr("-+ #0123456789.*hljztL",
+						  *fmt) != NULL)) {
+			if (*fmt == '*') {
+				arg++;
+			}
+
+			fmt++;
+		}
+
+		if (*fmt == '\0') {
+			break;
+		}
+
+		if ((*fmt == 's') && (arg < LOG_MAX_NARGS)) {
+			mask |= BIT(arg);
+		}
+
+		arg++;
+		fmt++;
+	}
+
+	return mask;
+}
+
+static void dict_std_out(struct log_msg *msg,
+			 const struct log_output *log_output)
+{
+	const char *str = log_msg_str_get(msg);
+	u32_t nargs = log_msg_nargs_get(msg);
+	u32_t str_args = dict_str_args_get(str);
+	const char *arg_str;
+	u8_t len = nargs;
+	int i;
+
+	dict_u32_out(log_output, (u32_t)(uintptr_t)str);
+	dict_bytes_out(log_output, &len, sizeof(len));
+
+	for (i = 0; i < nargs; i++) {
+		dict_u32_out(log_output, log_msg_arg_get(msg, i));
+	}
+
+	for (i = 0; i < nargs; i++) {
+		if (!(str_args & BIT(i))) {
+			continue;
+		}
+
+		arg_str = (const char *)(uintptr_t)log_msg_arg_get(msg, i);
+		if (arg_str == NULL) {
+			arg_str = "(null)";
+		}
+
+		for (len = 0; len < DICT_STR_MAX_LEN; len++) {
+			if (arg_str[len] == '\0') {
+				break;
+			}
+		}
+
+		dict_bytes_out(log_output, &len, sizeof(len));
+		dict_bytes_out(log_output, arg_str, len);
+	}
+}
+
+static void dict_hexdump_out(struct log_msg *msg,
+			     const struct log_output *log_output)
+{
+	u32_t length = log_msg_hexdump_length_get(msg);
+	u8_t buf[HEXDUMP_BYTES_IN_LINE];
+	size_t offset = 0;
+	size_t chunk;
+
+	if (!log_msg_is_raw_string(msg)) {
+		dict_u32_out(log_output,
+			     (u32_t)(uintptr_t)log_msg_str_get(msg));
+	}
+
+	dict_u16_out(log_output, length);
+
+	do {
+		chunk = sizeof(buf);
+		log_msg_hexdump_data_get(msg, buf, &chunk, offset);
+		dict_bytes_out(log_output, buf, chunk);
+		offset += chunk;
+	} while (chunk > 0);
+}
+
+static void dict_msg_process(const struct log_output *log_output,
+			     struct log_msg *msg)
+{
+	u8_t type;
+
+	if (log_msg_is_std(msg)) {
+		type = DICT_TYPE_STD;
+	} else if (log_msg_is_raw_string(msg)) {
+		type = DICT_TYPE_RAW_STRING;
+	} else {
+		type = DICT_TYPE_HEXDUMP;
+	}
+
+	dict_hdr_out(log_output, type, log_msg_level_get(msg),
+		     (log_msg_domain_id_get(msg) << 10) |
+		     log_msg_source_id_get(msg),
+		     log_msg_timestamp_get(msg));
+
+	if (type == DICT_TYPE_STD) {
+		dict_std_out(msg, log_output);
+	} else {
+		dict_hexdump_out(msg, log_output);
+	}
+
+	log_output_flush(log_output);
+}
+
 static int prefix_print(struct log_msg *msg,
 			const struct log_output *log_output,
 			u32_t flags, bool func_on)
@@ -523,8 +717,17 @@ void log_output_msg_process(const struct log_output *log_output,
 			    struct log_msg *msg,
 			    u32_t flags)
 {
-	int prefix_offset = prefix_print(msg, log_output, flags,
-					 log_msg_is_std(msg));
+	int prefix_offset;
+
+	flags |= log_output->control_block->flags;
+
+	if (DICT_SUPPORTED && (flags & LOG_OUTPUT_FLAG_DICTIONARY)) {
+		dict_msg_process(log_output, msg);
+		return;
+	}
+
+	prefix_offset = prefix_print(msg, log_output, flags,
+				     log_msg_is_std(msg));
 
 	if (log_msg_is_std(msg)) {
 		std_print(msg, log_output);
@@ -549,6 +752,14 @@ void log_output_dropped_process(const struct log_output *log_output, u32_t cnt)
 	log_output_func_t outf = log_output->func;
 	struct device *dev = (struct device *)log_output->control_block->ctx;
 
+	if (DICT_SUPPORTED &&
+	    (log_output->control_block->flags & LOG_OUTPUT_FLAG_DICTIONARY)) {
+		dict_hdr_out(log_output, DICT_TYPE_DROPPED, 0, 0, 0);
+		dict_u32_out(log_output, cnt);
+		log_output_flush(log_output);
+		return;
+	}
+
 	cnt = min(cnt, 9999);
 	len = snprintf(buf, sizeof(buf), "%d", cnt);
 
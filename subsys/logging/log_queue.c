@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "log_queue.h"
+#include <misc/__assert.h>
+#include <stddef.h>
+
+#define POOL_IDX_MASK 0xFFFFU
+#define POOL_TAG_INC 0x10000U
+
+static inline void *block_get(struct log_pool *pool, u32_t idx)
+{
+	return pool->buf + idx * pool->block_size;
+}
+
+static inline u32_t block_idx_get(struct log_pool *pool, void *block)
+{
+	return ((u8_t *)block - pool->buf) / pool->block_size;
+}
+
+/* Free block holds index of the next free block, incremented by one. */
+static inline volatile u32_t *block_next(struct log_pool *pool, u32_t idx)
+{
+	return (volatile u32_t *)block_get(pool, idx);
+}
+
+static inline atomic_val_t head_next(atomic_val_t head, u32_t idx)
+{
+	return (atomic_val_t)((((u32_t)head + POOL_TAG_INC) & ~POOL_IDX_MASK) |
+			      idx);
+}
+
+void log_pool_init(struct log_pool *pool, void *buf, u32_t block_size,
+		   u32_t count)
+{
+	__ASSERT_NO_MSG(count <= LOG_POOL_MAX_BLOCKS);
+	__ASSERT_NO_MSG((block_size % sizeof(u32_t)) == 0);
+
+	pool->buf = buf;
+	pool->block_size = block_size;
+	pool->count = count;
+
+	for (u32_t i = 0; i < count; i++) {
+		*block_next(pool, i) = (i + 1 < count) ? i + 2 : 0;
+	}
+
+	atomic_set(&pool->head, count ? 1 : 0);
+	atomic_clear(&pool->used);
+}
+
+void *log_pool_alloc(struct log_pool *pool)
+{
+	atomic_val_t head;
+	u32_t next;
+	u32_t idx;
+
+	do {
+		head = atomic_get(&pool->head);
+		idx = (u32_t)head & POOL_IDX_MASK;
+		if (idx == 0) {
+			return NULL;
+		}
+
+		/* Block may be taken and reused concurrently, in that case
+		 * value is stale but head tag has changed and swap fails.
+		 */
+		next = *block_next(pool, idx - 1) & POOL_IDX_MASK;
+	} while (!atomic_cas(&pool->head, head, head_next(head, next)));
+
+	atomic_inc(&pool->used);
+
+	return block_get(pool, idx - 1);
+}
+
+void log_pool_free(struct log_pool *pool, void *block)
+{
+	u32_t idx = block_idx_get(pool, block);
+	atomic_val_t head;
+
+	__ASSERT_NO_MSG(idx < pool->count);
+
+	do {
+		head = atomic_get(&pool->head);
+		*block_next(pool, idx) = (u32_t)head & POOL_IDX_MASK;
+	} while (!atomic_cas(&pool->head, head, head_next(head, idx + 1)));
+
+	atomic_dec(&pool->used);
+}
+
+void log_queue_init(struct log_queue *queue, struct log_pool *pool,
+		    atomic_t *slots)
+{
+	queue->pool = pool;
+	queue->slots = slots;
+
+	for (u32_t i = 0; i < pool->count; i++) {
+		atomic_clear(&slots[i]);
+	}
+
+	atomic_clear(&queue->wr_idx);
+	atomic_clear(&queue->rd_idx);
+}
+
+void log_queue_put(struct log_queue *queue, void *block)
+{
+	u32_t count = queue->pool->count;
+	atomic_val_t idx;
+	atomic_val_t next;
+
+	/* Every queued block comes from the pool and ring has a slot for each
+	 * of them, so reserved slot is always free.
+	 */
+	do {
+		idx = atomic_get(&queue->wr_idx);
+		next = (idx + 1 == count) ? 0 : idx + 1;
+	} while (!atomic_cas(&queue->wr_idx, idx, next));
+
+	atomic_set(&queue->slots[idx],
+		   block_idx_get(queue->pool, block) + 1);
+}
+
+void *log_queue_get(struct log_queue *queue)
+{
+	atomic_val_t idx = atomic_get(&queue->rd_idx);
+	atomic_val_t val = atomic_get(&queue->slots[idx]);
+
+	if (val == 0) {
+		return NULL;
+	}
+
+	atomic_clear(&queue->slots[idx]);
+	atomic_set(&queue->rd_idx,
+		   (idx + 1 == queue->pool->count) ? 0 : idx + 1);
+
+	return block_get(queue->pool, val - 1);
+}
+
+bool log_queue_peek(struct log_queue *queue)
+{
+	atomic_val_t idx = atomic_get(&queue->rd_idx);
+
+	return atomic_get(&queue->slots[idx]) != 0;
+}
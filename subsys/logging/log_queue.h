@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef LOG_QUEUE_H_
+#define LOG_QUEUE_H_
+
+#include <zephyr/types.h>
+#include <atomic.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Maximum number of blocks in the pool. */
+#define LOG_POOL_MAX_BLOCKS 0xFFFE
+
+/** @brief Lock-free pool of fixed size blocks.
+ *
+ * Free blocks form a stack linked by block indexes. Head holds index of the
+ * first free block incremented by one (0 when pool is empty) in lower half
+ * and a modification counter in upper half, which protects against ABA
+ * problem when block is freed and allocated again during a compare and swap.
+ */
+struct log_pool {
+	atomic_t head;
+	atomic_t used;
+	u8_t *buf;
+	u32_t block_size;
+	u32_t count;
+};
+
+/** @brief Lock-free multi-producer single-consumer queue of pool blocks.
+ *
+ * Queue is a ring of block indexes with a slot for every block in the pool,
+ * so it cannot overflow. Producers reserve a slot by moving the write index
+ * and store the block index in it. Consumer takes blocks in order of slot
+ * reservation and stops at a slot which is reserved but not yet filled.
+ */
+struct log_queue {
+	struct log_pool *pool;
+	atomic_t *slots;
+	atomic_t wr_idx;
+	atomic_t rd_idx;
+};
+
+/** @brief Initialize pool.
+ *
+ * @param pool		Pool.
+ * @param buf		Buffer, aligned to 4 bytes.
+ * @param block_size	Block size, multiple of 4 bytes.
+ * @param count		Number of blocks, up to @ref LOG_POOL_MAX_BLOCKS.
+ */
+void log_pool_init(struct log_pool *pool, void *buf, u32_t block_size,
+		   u32_t count);
+
+/** @brief Allocate block from the pool. Safe to call from any context.
+ *
+ * @param pool Pool.
+ *
+ * @return Allocated block or NULL if pool is empty.
+ */
+void *log_pool_alloc(struct log_pool *pool);
+
+/** @brief Return block to the pool. Safe to call from any context.
+ *
+ * @param pool	Pool.
+ * @param block	Block.
+ */
+void log_pool_free(struct log_pool *pool, void *block);
+
+/** @brief Get number of allocated blocks.
+ *
+ * @param pool Pool.
+ *
+ * @return Number of allocated blocks.
+ */
+static inline u32_t log_pool_num_used_get(struct log_pool *pool)
+{
+	return atomic_get(&pool->used);
+}
+
+/** @brief Initialize queue.
+ *
+ * @param queue	Queue.
+ * @param pool	Pool from which all queued blocks are allocated.
+ * @param slots	Array of pool->count slots.
+ */
+void log_queue_init(struct log_queue *queue, struct log_pool *pool,
+		    atomic_t *slots);
+
+/** @brief Add block to the queue. Safe to call from any context.
+ *
+ * @param queue	Queue.
+ * @param block	Block allocated from the queue pool.
+ */
+void log_queue_put(struct log_queue *queue, void *block);
+
+/** @brief Take block from the head of the queue.
+ *
+ * Only one context at a time may take blocks from the queue.
+ *
+ * @param queue	Queue.
+ *
+ * @return Block or NULL if queue is empty or head block is being added.
+ */
+void *log_queue_get(struct log_queue *queue);
+
+/** @brief Check if block can be taken from the queue.
+ *
+ * @param queue	Queue.
+ *
+ * @return True if log_queue_get() would return a block.
+ */
+bool log_queue_peek(struct log_queue *queue);
+
+/** @brief Pool of log message chunks used when CONFIG_LOG_LOCKLESS is set. */
+extern struct log_pool log_msg_lockless_pool;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_QUEUE_H_ */
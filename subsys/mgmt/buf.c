@@ -25,18 +25,96 @@ mcumgr_buf_free(struct net_buf *nb)
 	net_buf_unref(nb);
 }
 
+/*
+ * The reader works on net_buf fragment chains.  The fragment of the last
+ * access is remembered, so that the mostly sequential accesses of the
+ * parser do not walk the chain from its head every time.
+ */
+static struct net_buf *
+cbor_nb_reader_seek(struct cbor_nb_reader *cnr, int offset, int *frag_off)
+{
+	struct net_buf *frag;
+	int off;
+
+	if (offset < 0) {
+		return NULL;
+	}
+
+	if (cnr->frag != NULL && offset >= cnr->frag_off) {
+		frag = cnr->frag;
+		off = cnr->frag_off;
+	} else {
+		frag = cnr->nb;
+		off = 0;
+	}
+
+	while (frag != NULL && offset >= off + frag->len) {
+		off += frag->len;
+		frag = frag->frags;
+	}
+
+	if (frag != NULL) {
+		cnr->frag = frag;
+		cnr->frag_off = off;
+		*frag_off = offset - off;
+	}
+
+	return frag;
+}
+
+/* Returns a pointer to len bytes if they are in one fragment. */
+static const uint8_t *
+cbor_nb_reader_ptr(struct cbor_nb_reader *cnr, int offset, size_t len)
+{
+	struct net_buf *frag;
+	int frag_off;
+
+	frag = cbor_nb_reader_seek(cnr, offset, &frag_off);
+	if (frag == NULL || frag_off + len > frag->len) {
+		return NULL;
+	}
+
+	return frag->data + frag_off;
+}
+
+/* Copies len bytes which may span fragments. */
+static int
+cbor_nb_reader_copy(struct cbor_nb_reader *cnr, void *dst, int offset,
+		    size_t len)
+{
+	const uint8_t *ptr;
+
+	if (offset < 0 || offset + len > cnr->r.message_size) {
+		return -1;
+	}
+
+	ptr = cbor_nb_reader_ptr(cnr, offset, len);
+	if (ptr != NULL) {
+		memcpy(dst, ptr, len);
+		return 0;
+	}
+
+	if (net_buf_linearize(dst, len, cnr->nb, offset, len) != len) {
+		return -1;
+	}
+
+	return 0;
+}
+
 static uint8_t
 cbor_nb_reader_get8(struct cbor_decoder_reader *d, int offset)
 {
 	struct cbor_nb_reader *cnr;
+	const uint8_t *ptr;
 
 	cnr = (struct cbor_nb_reader *) d;
 
-	if (offset < 0 || offset >= cnr->nb->len) {
+	ptr = cbor_nb_reader_ptr(cnr, offset, 1);
+	if (ptr == NULL) {
 		return UINT8_MAX;
 	}
 
-	return cnr->nb->data[offset];
+	return *ptr;
 }
 
 static uint16_t
@@ -47,11 +125,10 @@ cbor_nb_reader_get16(struct cbor_decoder_reader *d, int offset)
 
 	cnr = (struct cbor_nb_reader *) d;
 
-	if (offset < 0 || offset > cnr->nb->len - (int)sizeof(val)) {
+	if (cbor_nb_reader_copy(cnr, &val, offset, sizeof(val)) != 0) {
 		return UINT16_MAX;
 	}
 
-	memcpy(&val, cnr->nb->data + offset, sizeof(val));
 	return cbor_ntohs(val);
 }
 
@@ -63,11 +140,10 @@ cbor_nb_reader_get32(struct cbor_decoder_reader *d, int offset)
 
 	cnr = (struct cbor_nb_reader *) d;
 
-	if (offset < 0 || offset > cnr->nb->len - (int)sizeof(val)) {
+	if (cbor_nb_reader_copy(cnr, &val, offset, sizeof(val)) != 0) {
 		return UINT32_MAX;
 	}
 
-	memcpy(&val, cnr->nb->data + offset, sizeof(val));
 	return cbor_ntohl(val);
 }
 
@@ -79,27 +155,49 @@ cbor_nb_reader_get64(struct cbor_decoder_reader *d, int offset)
 
 	cnr = (struct cbor_nb_reader *) d;
 
-	if (offset < 0 || offset > cnr->nb->len - (int)sizeof(val)) {
+	if (cbor_nb_reader_copy(cnr, &val, offset, sizeof(val)) != 0) {
 		return UINT64_MAX;
 	}
 
-	memcpy(&val, cnr->nb->data + offset, sizeof(val));
 	return cbor_ntohll(val);
 }
 
+/*
+ * Returns nonzero if the data matches, like the other tinycbor readers;
+ * the parser relies on it to compare strings.
+ */
 static uintptr_t
 cbor_nb_reader_cmp(struct cbor_decoder_reader *d, char *buf, int offset,
 		   size_t len)
 {
 	struct cbor_nb_reader *cnr;
+	struct net_buf *frag;
+	int frag_off;
+	size_t size;
 
 	cnr = (struct cbor_nb_reader *) d;
 
-	if (offset < 0 || offset > cnr->nb->len - (int)len) {
-		return -1;
+	if (offset < 0 || offset + len > cnr->r.message_size) {
+		return 0;
 	}
 
-	return memcmp(cnr->nb->data + offset, buf, len);
+	while (len > 0) {
+		frag = cbor_nb_reader_seek(cnr, offset, &frag_off);
+		if (frag == NULL) {
+			return 0;
+		}
+
+		size = min(len, frag->len - frag_off);
+		if (memcmp(frag->data + frag_off, buf, size) != 0) {
+			return 0;
+		}
+
+		buf += size;
+		offset += size;
+		len -= size;
+	}
+
+	return 1;
 }
 
 static uintptr_t
@@ -110,21 +208,36 @@ cbor_nb_reader_cpy(struct cbor_decoder_reader *d, char *dst, int offset,
 
 	cnr = (struct cbor_nb_reader *) d;
 
-	if (offset < 0 || offset > cnr->nb->len - (int)len) {
-		return -1;
+	if (cbor_nb_reader_copy(cnr, dst, offset, len) != 0) {
+		return 0;
 	}
 
-	return (uintptr_t)memcpy(dst, cnr->nb->data + offset, len);
+	return (uintptr_t)dst;
 }
 
+/*
+ * Strings are returned in place.  A chunk is cut at the end of its fragment;
+ * the parser then asks for the rest of it.
+ */
 static uintptr_t
 cbor_nb_get_string_chunk(struct cbor_decoder_reader *d, int offset,
 			 size_t *len)
 {
 	struct cbor_nb_reader *cnr;
+	struct net_buf *frag;
+	int frag_off;
 
 	cnr = (struct cbor_nb_reader *) d;
-	return (uintptr_t)cnr->nb->data + offset;
+
+	frag = cbor_nb_reader_seek(cnr, offset, &frag_off);
+	if (frag == NULL) {
+		*len = 0;
+		return 0;
+	}
+
+	*len = min(*len, frag->len - frag_off);
+
+	return (uintptr_t)frag->data + frag_off;
 }
 
 void
@@ -140,22 +253,51 @@ cbor_nb_reader_init(struct cbor_nb_reader *cnr,
 	cnr->r.get_string_chunk = &cbor_nb_get_string_chunk;
 
 	cnr->nb = nb;
-	cnr->r.message_size = nb->len;
+	cnr->frag = NULL;
+	cnr->frag_off = 0;
+	cnr->r.message_size = net_buf_frags_len(nb);
 }
 
+/*
+ * Data which does not fit is written to new fragments from the pool of the
+ * first buffer.
+ */
 static int
 cbor_nb_write(struct cbor_encoder_writer *writer, const char *data, int len)
 {
 	struct cbor_nb_writer *cnw;
+	struct net_buf *frag;
+	size_t size;
 
 	cnw = (struct cbor_nb_writer *) writer;
-	if (len > net_buf_tailroom(cnw->nb)) {
-		return CborErrorOutOfMemory;
+	frag = net_buf_frag_last(cnw->nb);
+
+	while (len > 0) {
+		if (net_buf_tailroom(frag) == 0) {
+			if (!cnw->chain) {
+				return CborErrorOutOfMemory;
+			}
+
+			frag = net_buf_alloc(net_buf_pool_get(cnw->nb->pool_id),
+					     K_NO_WAIT);
+			if (frag == NULL) {
+				return CborErrorOutOfMemory;
+			}
+
+			net_buf_frag_add(cnw->nb, frag);
+		}
+
+		size = min(len, net_buf_tailroom(frag));
+		if (!cnw->chain && size < len) {
+			return CborErrorOutOfMemory;
+		}
+
+		net_buf_add_mem(frag, data, size);
+		cnw->enc.bytes_written += size;
+		data += size;
+		len -= size;
 	}
 
-	net_buf_add_mem(cnw->nb, data, len);
-	cnw->enc.bytes_written += len;
-
 	return CborNoError;
 }
 
@@ -163,6 +305,14 @@ void
 cbor_nb_writer_init(struct cbor_nb_writer *cnw, struct net_buf *nb)
 {
 	cnw->nb = nb;
+	cnw->chain = false;
 	cnw->enc.bytes_written = 0;
 	cnw->enc.write = &cbor_nb_write;
 }
+
+void
+cbor_nb_chain_writer_init(struct cbor_nb_writer *cnw, struct net_buf *nb)
+{
+	cbor_nb_writer_init(cnw, nb);
+	cnw->chain = true;
+}
@@ -61,22 +61,26 @@ static void
 zephyr_smp_trim_front(void *buf, size_t len, void *arg)
 {
 	struct net_buf *nb;
-
-	nb = buf;
-	if (len > nb->len) {
-		len = nb->len;
+	size_t size;
+
+	/* Emptied fragments stay in the chain; the first one is the handle
+	 * the caller holds.
+	 */
+	for (nb = buf; nb != NULL && len > 0; nb = nb->frags) {
+		size = min(len, nb->len);
+		net_buf_pull(nb, size);
+		len -= size;
 	}
-
-	net_buf_pull(nb, len);
 }
 
 /**
  * Splits an appropriately-sized fragment from the front of a net_buf, as
  * neeeded.  If the length of the net_buf is greater than specified maximum
- * fragment size, a new net_buf is allocated, and data is moved from the source
- * net_buf to the new net_buf.  If the net_buf is small enough to fit in a
- * single fragment, the source net_buf is returned unmodified, and the supplied
- * pointer is set to NULL.
+ * fragment size, or the net_buf is a chain of several buffers, a new net_buf
+ * is allocated, and data is moved from the source net_buf to the new net_buf.
+ * If the net_buf is small enough to fit in a single fragment, the source
+ * net_buf is returned unmodified, and the supplied pointer is set to NULL.
+ * A source chain which has been consumed entirely is freed.
  *
  * This function is expected to be called in a loop until the entire source
  * net_buf has been consumed.  For example:
@@ -109,20 +113,30 @@ zephyr_smp_split_frag(struct net_buf **nb, void *arg, u16_t mtu)
 {
 	struct net_buf *frag;
 	struct net_buf *src;
+	size_t len;
 
 	src = *nb;
 
-	if (src->len <= mtu) {
+	if (src->frags == NULL && src->len <= mtu) {
 		*nb = NULL;
 		frag = src;
 	} else {
 		frag = zephyr_smp_alloc_rsp(src, arg);
+		if (frag == NULL) {
+			return NULL;
+		}
 
 		/* Copy fragment payload into new buffer. */
-		net_buf_add_mem(frag, src->data, mtu);
+		len = min(mtu, net_buf_tailroom(frag));
+		len = net_buf_linearize(net_buf_tail(frag), len, src, 0, len);
+		net_buf_add(frag, len);
 
 		/* Remove fragment from total response. */
-		zephyr_smp_trim_front(src, mtu, NULL);
+		zephyr_smp_trim_front(src, len, NULL);
+		if (net_buf_frags_len(src) == 0) {
+			zephyr_smp_free_buf(src, arg);
+			*nb = NULL;
+		}
 	}
 
 	return frag;
@@ -131,7 +145,13 @@ zephyr_smp_split_frag(struct net_buf **nb, void *arg, u16_t mtu)
 static void
 zephyr_smp_reset_buf(void *buf, void *arg)
 {
-	net_buf_reset(buf);
+	struct net_buf *nb = buf;
+
+	while (nb->frags != NULL) {
+		net_buf_frag_del(nb, nb->frags);
+	}
+
+	net_buf_reset(nb);
 }
 
 static int
@@ -155,7 +175,7 @@ zephyr_smp_write_at(struct cbor_encoder_writer *writer, size_t offset,
 	memcpy(nb->data + offset, data, len);
 	if (nb->len < offset + len) {
 		nb->len = offset + len;
-		writer->bytes_written = nb->len;
+		writer->bytes_written = net_buf_frags_len(nb);
 	}
 
 	return 0;
@@ -174,9 +194,11 @@ zephyr_smp_tx_rsp(struct smp_streamer *ns, void *rsp, void *arg)
 	zst = arg;
 	nb = rsp;
 
+	/* The response is consumed on error as well. */
 	mtu = zst->zst_get_mtu(rsp);
 	if (mtu == 0) {
 		/* The transport cannot support a transmission right now. */
+		zephyr_smp_free_buf(nb, zst);
 		return MGMT_ERR_EUNKNOWN;
 	}
 
@@ -184,11 +206,13 @@ zephyr_smp_tx_rsp(struct smp_streamer *ns, void *rsp, void *arg)
 	while (nb != NULL) {
 		frag = zephyr_smp_split_frag(&nb, zst, mtu);
 		if (frag == NULL) {
+			zephyr_smp_free_buf(nb, zst);
 			return MGMT_ERR_ENOMEM;
 		}
 
 		rc = zst->zst_output(zst, frag);
 		if (rc != 0) {
+			zephyr_smp_free_buf(nb, zst);
 			return MGMT_ERR_EUNKNOWN;
 		}
 	}
@@ -231,7 +255,7 @@ zephyr_smp_init_writer(struct cbor_encoder_writer *writer, void *buf,
 	struct cbor_nb_writer *czw;
 
 	czw = (struct cbor_nb_writer *)writer;
-	cbor_nb_writer_init(czw, buf);
+	cbor_nb_chain_writer_init(czw, buf);
 
 	return 0;
 }
@@ -15,11 +15,14 @@
 #include <bluetooth/bluetooth.h>
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt.h>
+#include <bluetooth/conn.h>
 
 #include <mgmt/smp_bt.h>
 #include <mgmt/buf.h>
 
 #include <mgmt/smp.h>
+#include <mgmt/mgmt.h>
+#include <misc/byteorder.h>
 
 struct device;
 
@@ -43,6 +46,95 @@ static struct bt_uuid_128 smp_bt_chr_uuid = BT_UUID_INIT_128(
 	0x48, 0x7c, 0x99, 0x74, 0x11, 0x26, 0x9e, 0xae,
 	0x01, 0x4e, 0xce, 0xfb, 0x28, 0x78, 0x2e, 0xda);
 
+#ifdef CONFIG_MCUMGR_SMP_BT_REASSEMBLY
+/* Request being reassembled from consecutive writes. */
+static struct net_buf *smp_bt_rx_nb;
+
+static void smp_bt_ud_free(void *ud);
+
+static void smp_bt_rx_drop(void)
+{
+	if (smp_bt_rx_nb != NULL) {
+		smp_bt_ud_free(net_buf_user_data(smp_bt_rx_nb));
+		mcumgr_buf_free(smp_bt_rx_nb);
+		smp_bt_rx_nb = NULL;
+	}
+}
+
+/* Returns true if the buffer ends with a complete SMP frame. */
+static bool smp_bt_rx_complete(const struct net_buf *nb)
+{
+	size_t off = 0;
+
+	while (off + sizeof(struct mgmt_hdr) <= nb->len) {
+		/* The length field is at the same offset in every header. */
+		off += sizeof(struct mgmt_hdr) +
+		       sys_get_be16(&nb->data[off + 2]);
+	}
+
+	return off == nb->len;
+}
+
+/**
+ * Write handler for the SMP characteristic; collects consecutive writes and
+ * processes the SMP request once the received data ends on a frame boundary.
+ */
+static ssize_t smp_bt_chr_write(struct bt_conn *conn,
+				const struct bt_gatt_attr *attr,
+				const void *buf, u16_t len, u16_t offset,
+				u8_t flags)
+{
+	struct smp_bt_user_data *ud;
+
+	if (smp_bt_rx_nb != NULL) {
+		ud = net_buf_user_data(smp_bt_rx_nb);
+		if (ud->conn != conn) {
+			/* A new peer does not continue the old request. */
+			smp_bt_rx_drop();
+		}
+	}
+
+	if (smp_bt_rx_nb == NULL) {
+		smp_bt_rx_nb = mcumgr_buf_alloc();
+		if (smp_bt_rx_nb == NULL) {
+			return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES);
+		}
+
+		ud = net_buf_user_data(smp_bt_rx_nb);
+		ud->conn = bt_conn_ref(conn);
+	}
+
+	if (len > net_buf_tailroom(smp_bt_rx_nb)) {
+		smp_bt_rx_drop();
+		return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES);
+	}
+
+	net_buf_add_mem(smp_bt_rx_nb, buf, len);
+
+	if (smp_bt_rx_complete(smp_bt_rx_nb)) {
+		zephyr_smp_rx_req(&smp_bt_transport, smp_bt_rx_nb);
+		smp_bt_rx_nb = NULL;
+	}
+
+	return len;
+}
+
+static void smp_bt_disconnected(struct bt_conn *conn, u8_t reason)
+{
+	struct smp_bt_user_data *ud;
+
+	if (smp_bt_rx_nb != NULL) {
+		ud = net_buf_user_data(smp_bt_rx_nb);
+		if (ud->conn == conn) {
+			smp_bt_rx_drop();
+		}
+	}
+}
+
+static struct bt_conn_cb smp_bt_conn_cb = {
+	.disconnected = smp_bt_disconnected,
+};
+#else
 /**
  * Write handler for the SMP characteristic; processes an incoming SMP request.
  */
@@ -55,6 +147,10 @@ static ssize_t smp_bt_chr_write(struct bt_conn *conn,
 	struct net_buf *nb;
 
 	nb = mcumgr_buf_alloc();
+	if (nb == NULL) {
+		return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES);
+	}
+
 	net_buf_add_mem(nb, buf, len);
 
 	ud = net_buf_user_data(nb);
@@ -64,6 +160,7 @@ static ssize_t smp_bt_chr_write(struct bt_conn *conn,
 
 	return len;
 }
+#endif
 
 static void smp_bt_ccc_changed(const struct bt_gatt_attr *attr, u16_t value)
 {
@@ -188,6 +285,10 @@ static int smp_bt_init(struct device *dev)
 	zephyr_smp_transport_init(&smp_bt_transport, smp_bt_tx_pkt,
 				  smp_bt_get_mtu, smp_bt_ud_copy,
 				  smp_bt_ud_free);
+
+#ifdef CONFIG_MCUMGR_SMP_BT_REASSEMBLY
+	bt_conn_cb_register(&smp_bt_conn_cb);
+#endif
 	return 0;
 }
 
@@ -51,6 +51,9 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 #ifdef CONFIG_LWM2M_RW_JSON_SUPPORT
 #include "lwm2m_rw_json.h"
 #endif
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+#include "lwm2m_rw_senml_cbor.h"
+#endif
 #ifdef CONFIG_LWM2M_RD_CLIENT_SUPPORT
 #include "lwm2m_rd_client.h"
 #endif
@@ -137,6 +140,9 @@ static sys_slist_t engine_obj_inst_list;
 static sys_slist_t engine_observer_list;
 static sys_slist_t engine_service_list;
 
+/* observers attached to a whole object (path level < 2) */
+static u8_t engine_obj_observer_count;
+
 #define NUM_BLOCK1_CONTEXT	CONFIG_LWM2M_NUM_BLOCK1_CONTEXT
 
 /* TODO: figure out what's correct value */
@@ -407,6 +413,48 @@ int lwm2m_notify_observer_path(struct lwm2m_obj_path *path)
 				     path->res_id);
 }
 
+static int engine_notify_res(struct lwm2m_engine_obj_inst *obj_inst,
+			     struct lwm2m_engine_res_inst *res)
+{
+	/* skip walking the observer list if nobody can match this resource */
+	if (!res->observer_count && !obj_inst->observer_count &&
+	    !engine_obj_observer_count) {
+		return 0;
+	}
+
+	return lwm2m_notify_observer(obj_inst->obj->obj_id,
+				     obj_inst->obj_inst_id, res->res_id);
+}
+
+static void engine_update_observer_count(const struct lwm2m_obj_path *path,
+					 int delta)
+{
+	struct lwm2m_engine_obj_inst *obj_inst;
+	int i;
+
+	if (path->level < 2) {
+		engine_obj_observer_count += delta;
+		return;
+	}
+
+	obj_inst = get_engine_obj_inst(path->obj_id, path->obj_inst_id);
+	if (!obj_inst) {
+		return;
+	}
+
+	if (path->level == 2) {
+		obj_inst->observer_count += delta;
+		return;
+	}
+
+	for (i = 0; i < obj_inst->resource_count; i++) {
+		if (obj_inst->resources[i].res_id == path->res_id) {
+			obj_inst->resources[i].observer_count += delta;
+			return;
+		}
+	}
+}
+
 static int engine_add_observer(struct lwm2m_message *msg,
 			       const u8_t *token, u8_t tkl,
 			       struct lwm2m_obj_path *path,
@@ -550,6 +598,7 @@ static int engine_add_observer(struct lwm2m_message *msg,
 	observe_node_data[i].counter = 1U;
 	sys_slist_append(&engine_observer_list,
 			 &observe_node_data[i].node);
+	engine_update_observer_count(path, 1);
 
 	LOG_DBG("OBSERVER ADDED %u/%u/%u(%u) token:'%s' addr:%s",
 		path->obj_id, path->obj_inst_id, path->res_id, path->level,
@@ -584,6 +633,7 @@ static int engine_remove_observer(const u8_t *token, u8_t tkl)
 	}
 
 	sys_slist_remove(&engine_observer_list, prev_node, &found_obj->node);
+	engine_update_observer_count(&found_obj->path, -1);
 	(void)memset(found_obj, 0, sizeof(*found_obj));
 
 	LOG_DBG("observer '%s' removed", sprint_token(token, tkl));
@@ -606,6 +656,7 @@ static void engine_remove_observer_by_id(u16_t obj_id, s32_t obj_inst_id)
 		}
 
 		sys_slist_remove(&engine_observer_list, prev_node, &obs->node);
+		engine_update_observer_count(&obs->path, -1);
 		(void)memset(obs, 0, sizeof(*obs));
 	}
 }
@@ -1204,6 +1255,12 @@ static int select_writer(struct lwm2m_output_context *out, u16_t accept)
 		break;
 #endif
 
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		out->writer = &senml_cbor_writer;
+		break;
+#endif
+
 	default:
 		LOG_WRN("Unknown content type %u", accept);
 		return -ENOMSG;
@@ -1416,41 +1473,16 @@ int lwm2m_engine_set_res_data(char *pathstr, void *data_ptr, u16_t data_len,
 	return ret;
 }
 
-static int lwm2m_engine_set(char *pathstr, void *value, u16_t len)
+static int engine_set_res(struct lwm2m_engine_obj_inst *obj_inst,
+			  struct lwm2m_engine_obj_field *obj_field,
+			  struct lwm2m_engine_res_inst *res,
+			  void *value, u16_t len)
 {
-	struct lwm2m_obj_path path;
-	struct lwm2m_engine_obj_inst *obj_inst;
-	struct lwm2m_engine_obj_field *obj_field;
-	struct lwm2m_engine_res_inst *res = NULL;
 	void *data_ptr = NULL;
 	size_t data_len = 0;
 	int ret = 0;
 	bool changed = false;
 
-	LOG_DBG("path:%s, value:%p, len:%d", pathstr, value, len);
-
-	/* translate path -> path_obj */
-	ret = string_to_path(pathstr, &path, '/');
-	if (ret < 0) {
-		return ret;
-	}
-
-	if (path.level < 3) {
-		LOG_ERR("path must have 3 parts");
-		return -EINVAL;
-	}
-
-	/* look up resource obj */
-	ret = path_to_objs(&path, &obj_inst, &obj_field, &res);
-	if (ret < 0) {
-		return ret;
-	}
-
-	if (!res) {
-		LOG_ERR("res instance %d not found", path.res_id);
-		return -ENOENT;
-	}
-
 	if (LWM2M_HAS_RES_FLAG(res, LWM2M_RES_DATA_FLAG_RO)) {
 		LOG_ERR("res data pointer is read-only");
 		return -EACCES;
@@ -1474,7 +1506,7 @@ static int lwm2m_engine_set(char *pathstr, void *value, u16_t len)
 	if (len > res->data_len -
 		(obj_field->data_type == LWM2M_RES_TYPE_STRING ? 1 : 0)) {
 		LOG_ERR("length %u is too long for resource %d data",
-			len, path.res_id);
+			len, res->res_id);
 		return -ENOMEM;
 	}
 
@@ -1556,12 +1588,47 @@ static int lwm2m_engine_set(char *pathstr, void *value, u16_t len)
 	}
 
 	if (changed) {
-		NOTIFY_OBSERVER_PATH(&path);
+		engine_notify_res(obj_inst, res);
 	}
 
 	return ret;
 }
 
+static int lwm2m_engine_set(char *pathstr, void *value, u16_t len)
+{
+	struct lwm2m_obj_path path;
+	struct lwm2m_engine_obj_inst *obj_inst;
+	struct lwm2m_engine_obj_field *obj_field;
+	struct lwm2m_engine_res_inst *res = NULL;
+	int ret = 0;
+
+	LOG_DBG("path:%s, value:%p, len:%d", pathstr, value, len);
+
+	/* translate path -> path_obj */
+	ret = string_to_path(pathstr, &path, '/');
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (path.level < 3) {
+		LOG_ERR("path must have 3 parts");
+		return -EINVAL;
+	}
+
+	/* look up resource obj */
+	ret = path_to_objs(&path, &obj_inst, &obj_field, &res);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (!res) {
+		LOG_ERR("res instance %d not found", path.res_id);
+		return -ENOENT;
+	}
+
+	return engine_set_res(obj_inst, obj_field, res, value, len);
+}
+
 int lwm2m_engine_set_opaque(char *pathstr, char *data_ptr, u16_t data_len)
 {
 	return lwm2m_engine_set(pathstr, data_ptr, data_len);
@@ -1662,40 +1729,14 @@ int lwm2m_engine_get_res_data(char *pathstr, void **data_ptr, u16_t *data_len,
 	return 0;
 }
 
-static int lwm2m_engine_get(char *pathstr, void *buf, u16_t buflen)
+static int engine_get_res(struct lwm2m_engine_obj_inst *obj_inst,
+			  struct lwm2m_engine_obj_field *obj_field,
+			  struct lwm2m_engine_res_inst *res,
+			  void *buf, u16_t buflen)
 {
-	int ret = 0;
-	struct lwm2m_obj_path path;
-	struct lwm2m_engine_obj_inst *obj_inst;
-	struct lwm2m_engine_obj_field *obj_field;
-	struct lwm2m_engine_res_inst *res = NULL;
 	void *data_ptr = NULL;
 	size_t data_len = 0;
 
-	LOG_DBG("path:%s, buf:%p, buflen:%d", pathstr, buf, buflen);
-
-	/* translate path -> path_obj */
-	ret = string_to_path(pathstr, &path, '/');
-	if (ret < 0) {
-		return ret;
-	}
-
-	if (path.level < 3) {
-		LOG_ERR("path must have 3 parts");
-		return -EINVAL;
-	}
-
-	/* look up resource obj */
-	ret = path_to_objs(&path, &obj_inst, &obj_field, &res);
-	if (ret < 0) {
-		return ret;
-	}
-
-	if (!res) {
-		LOG_ERR("res instance %d not found", path.res_id);
-		return -ENOENT;
-	}
-
 	/* setup initial data elements */
 	data_ptr = res->data_ptr;
 	data_len = res->data_len;
@@ -1784,6 +1825,41 @@ static int lwm2m_engine_get(char *pathstr, void *buf, u16_t buflen)
 	return 0;
 }
 
+static int lwm2m_engine_get(char *pathstr, void *buf, u16_t buflen)
+{
+	int ret = 0;
+	struct lwm2m_obj_path path;
+	struct lwm2m_engine_obj_inst *obj_inst;
+	struct lwm2m_engine_obj_field *obj_field;
+	struct lwm2m_engine_res_inst *res = NULL;
+
+	LOG_DBG("path:%s, buf:%p, buflen:%d", pathstr, buf, buflen);
+
+	/* translate path -> path_obj */
+	ret = string_to_path(pathstr, &path, '/');
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (path.level < 3) {
+		LOG_ERR("path must have 3 parts");
+		return -EINVAL;
+	}
+
+	/* look up resource obj */
+	ret = path_to_objs(&path, &obj_inst, &obj_field, &res);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (!res) {
+		LOG_ERR("res instance %d not found", path.res_id);
+		return -ENOENT;
+	}
+
+	return engine_get_res(obj_inst, obj_field, res, buf, buflen);
+}
+
 int lwm2m_engine_get_opaque(char *pathstr, void *buf, u16_t buflen)
 {
 	return lwm2m_engine_get(pathstr, buf, buflen);
@@ -1857,6 +1933,258 @@ int lwm2m_engine_get_float64(char *pathstr, float64_value_t *buf)
 	return lwm2m_engine_get(pathstr, buf, sizeof(float64_value_t));
 }
 
+/* pre-resolved resource handle functions */
+
+int lwm2m_engine_get_res_handle(char *pathstr,
+				struct lwm2m_res_handle *handle)
+{
+	struct lwm2m_obj_path path;
+	int ret;
+
+	if (!handle) {
+		return -EINVAL;
+	}
+
+	(void)memset(handle, 0, sizeof(*handle));
+
+	/* translate path -> path_obj */
+	ret = string_to_path(pathstr, &path, '/');
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (path.level < 3) {
+		LOG_ERR("path must have 3 parts");
+		return -EINVAL;
+	}
+
+	/* look up resource obj */
+	ret = path_to_objs(&path, &handle->obj_inst, &handle->obj_field,
+			   &handle->res);
+	if (ret < 0) {
+		return ret;
+	}
+
+	handle->obj_id = path.obj_id;
+	handle->obj_inst_id = path.obj_inst_id;
+	handle->res_id = path.res_id;
+
+	return 0;
+}
+
+static int res_handle_check(const struct lwm2m_res_handle *handle)
+{
+	if (!handle || !handle->res) {
+		return -EINVAL;
+	}
+
+	/* object instances are zeroed on delete and may be re-used */
+	if (!handle->obj_inst->obj ||
+	    handle->obj_inst->obj->obj_id != handle->obj_id ||
+	    handle->obj_inst->obj_inst_id != handle->obj_inst_id ||
+	    handle->res->res_id != handle->res_id) {
+		LOG_ERR("stale handle for %u/%u/%u", handle->obj_id,
+			handle->obj_inst_id, handle->res_id);
+		return -ENOENT;
+	}
+
+	return 0;
+}
+
+static int lwm2m_engine_handle_set(const struct lwm2m_res_handle *handle,
+				   void *value, u16_t len)
+{
+	int ret;
+
+	ret = res_handle_check(handle);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return engine_set_res(handle->obj_inst, handle->obj_field,
+			      handle->res, value, len);
+}
+
+static int lwm2m_engine_handle_get(const struct lwm2m_res_handle *handle,
+				   void *buf, u16_t buflen)
+{
+	int ret;
+
+	ret = res_handle_check(handle);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return engine_get_res(handle->obj_inst, handle->obj_field,
+			      handle->res, buf, buflen);
+}
+
+int lwm2m_engine_handle_set_opaque(const struct lwm2m_res_handle *handle,
+				   char *data_ptr, u16_t data_len)
+{
+	return lwm2m_engine_handle_set(handle, data_ptr, data_len);
+}
+
+int lwm2m_engine_handle_set_string(const struct lwm2m_res_handle *handle,
+				   char *data_ptr)
+{
+	return lwm2m_engine_handle_set(handle, data_ptr, strlen(data_ptr));
+}
+
+int lwm2m_engine_handle_set_u8(const struct lwm2m_res_handle *handle,
+			       u8_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 1);
+}
+
+int lwm2m_engine_handle_set_u16(const struct lwm2m_res_handle *handle,
+				u16_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 2);
+}
+
+int lwm2m_engine_handle_set_u32(const struct lwm2m_res_handle *handle,
+				u32_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 4);
+}
+
+int lwm2m_engine_handle_set_u64(const struct lwm2m_res_handle *handle,
+				u64_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 8);
+}
+
+int lwm2m_engine_handle_set_s8(const struct lwm2m_res_handle *handle,
+			       s8_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 1);
+}
+
+int lwm2m_engine_handle_set_s16(const struct lwm2m_res_handle *handle,
+				s16_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 2);
+}
+
+int lwm2m_engine_handle_set_s32(const struct lwm2m_res_handle *handle,
+				s32_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 4);
+}
+
+int lwm2m_engine_handle_set_s64(const struct lwm2m_res_handle *handle,
+				s64_t value)
+{
+	return lwm2m_engine_handle_set(handle, &value, 8);
+}
+
+int lwm2m_engine_handle_set_bool(const struct lwm2m_res_handle *handle,
+				 bool value)
+{
+	u8_t temp = (value != 0 ? 1 : 0);
+
+	return lwm2m_engine_handle_set(handle, &temp, 1);
+}
+
+int lwm2m_engine_handle_set_float32(const struct lwm2m_res_handle *handle,
+				    float32_value_t *value)
+{
+	return lwm2m_engine_handle_set(handle, value, sizeof(float32_value_t));
+}
+
+int lwm2m_engine_handle_set_float64(const struct lwm2m_res_handle *handle,
+				    float64_value_t *value)
+{
+	return lwm2m_engine_handle_set(handle, value, sizeof(float64_value_t));
+}
+
+int lwm2m_engine_handle_get_opaque(const struct lwm2m_res_handle *handle,
+				   void *buf, u16_t buflen)
+{
+	return lwm2m_engine_handle_get(handle, buf, buflen);
+}
+
+int lwm2m_engine_handle_get_string(const struct lwm2m_res_handle *handle,
+				   void *buf, u16_t buflen)
+{
+	return lwm2m_engine_handle_get(handle, buf, buflen);
+}
+
+int lwm2m_engine_handle_get_u8(const struct lwm2m_res_handle *handle,
+			       u8_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 1);
+}
+
+int lwm2m_engine_handle_get_u16(const struct lwm2m_res_handle *handle,
+				u16_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 2);
+}
+
+int lwm2m_engine_handle_get_u32(const struct lwm2m_res_handle *handle,
+				u32_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 4);
+}
+
+int lwm2m_engine_handle_get_u64(const struct lwm2m_res_handle *handle,
+				u64_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 8);
+}
+
+int lwm2m_engine_handle_get_s8(const struct lwm2m_res_handle *handle,
+			       s8_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 1);
+}
+
+int lwm2m_engine_handle_get_s16(const struct lwm2m_res_handle *handle,
+				s16_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 2);
+}
+
+int lwm2m_engine_handle_get_s32(const struct lwm2m_res_handle *handle,
+				s32_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 4);
+}
+
+int lwm2m_engine_handle_get_s64(const struct lwm2m_res_handle *handle,
+				s64_t *value)
+{
+	return lwm2m_engine_handle_get(handle, value, 8);
+}
+
+int lwm2m_engine_handle_get_bool(const struct lwm2m_res_handle *handle,
+				 bool *value)
+{
+	int ret = 0;
+	s8_t temp = 0;
+
+	ret = lwm2m_engine_handle_get_s8(handle, &temp);
+	if (!ret) {
+		*value = temp != 0;
+	}
+
+	return ret;
+}
+
+int lwm2m_engine_handle_get_float32(const struct lwm2m_res_handle *handle,
+				    float32_value_t *buf)
+{
+	return lwm2m_engine_handle_get(handle, buf, sizeof(float32_value_t));
+}
+
+int lwm2m_engine_handle_get_float64(const struct lwm2m_res_handle *handle,
+				    float64_value_t *buf)
+{
+	return lwm2m_engine_handle_get(handle, buf, sizeof(float64_value_t));
+}
+
 int lwm2m_engine_get_resource(char *pathstr, struct lwm2m_engine_res_inst **res)
 {
 	int ret;
@@ -2721,6 +3049,11 @@ static int do_read_op(struct lwm2m_engine_obj *obj,
 		return do_read_op_json(obj, context, content_format);
 #endif
 
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_read_op_senml_cbor(obj, context, content_format);
+#endif
+
 	default:
 		LOG_ERR("Unsupported content-format: %u", content_format);
 		return -ENOMSG;
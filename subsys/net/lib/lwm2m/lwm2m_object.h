@@ -240,6 +240,9 @@ struct lwm2m_engine_res_inst {
 	u16_t data_len;
 	u16_t res_id;
 	u8_t  data_flags;
+
+	/* number of observers attached directly to this resource */
+	u8_t  observer_count;
 };
 
 struct lwm2m_engine_obj_inst {
@@ -252,6 +255,9 @@ struct lwm2m_engine_obj_inst {
 	/* object instance member data */
 	u16_t obj_inst_id;
 	u16_t resource_count;
+
+	/* number of observers attached to the whole object instance */
+	u8_t  observer_count;
 };
 
 struct lwm2m_output_context {
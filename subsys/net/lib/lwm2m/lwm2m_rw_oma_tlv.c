@@ -126,89 +126,83 @@ static void tlv_setup(struct oma_tlv *tlv, u8_t type, u16_t id,
 	}
 }
 
-static int oma_tlv_put_u8(struct lwm2m_output_context *out,
-			  u8_t value, bool insert)
+/* type byte + 16-bit id + 24-bit length */
+#define OMA_TLV_HEADER_MAX	6
+
+static u8_t oma_tlv_header(const struct oma_tlv *tlv, u8_t *buf)
 {
-	if (insert) {
-		if (!net_pkt_insert(out->out_cpkt->pkt, out->frag,
-				    out->offset, 1, &value,
-				    BUF_ALLOC_TIMEOUT)) {
-			return -ENOMEM;
-		}
+	u8_t pos = 0U;
+	u8_t len_type;
+	int i;
 
-		out->offset++;
-	} else {
-		out->frag = net_pkt_write(out->out_cpkt->pkt, out->frag,
-				  out->offset, &out->offset, 1, &value,
-				  BUF_ALLOC_TIMEOUT);
-		if (!out->frag && out->offset == 0xffff) {
-			return -ENOMEM;
+	/* len_type is the same as number of bytes required for length */
+	len_type = get_len_type(tlv);
+
+	/* first type byte in TLV header */
+	buf[pos++] = (tlv->type << 6) |
+		     (tlv->id > 255 ? (1 << 5) : 0) |
+		     (len_type << 3) |
+		     (len_type == 0 ? tlv->length : 0);
+
+	/* The ID */
+	if (tlv->id > 255) {
+		buf[pos++] = (tlv->id >> 8) & 0xff;
+	}
+
+	buf[pos++] = tlv->id & 0xff;
+
+	for (i = 2; i >= 0; i--) {
+		if (len_type > i) {
+			buf[pos++] = (tlv->length >> (i * 8)) & 0xff;
 		}
 	}
 
-	return 0;
+	return pos;
 }
 
 static size_t oma_tlv_put(const struct oma_tlv *tlv,
 			  struct lwm2m_output_context *out,
 			  u8_t *value, bool insert)
 {
-	size_t pos;
-	int ret, i;
-	u8_t len_type, tmp;
+	u8_t buf[OMA_TLV_HEADER_MAX + sizeof(s64_t)];
+	size_t pos, inline_len = 0;
 
-	/* len_type is the same as number of bytes required for length */
-	len_type = get_len_type(tlv);
+	pos = oma_tlv_header(tlv, buf);
 
-	/* first type byte in TLV header */
-	tmp = (tlv->type << 6) |
-	      (tlv->id > 255 ? (1 << 5) : 0) |
-	      (len_type << 3) |
-	      (len_type == 0 ? tlv->length : 0);
-
-	ret = oma_tlv_put_u8(out, tmp, insert);
-	if (ret < 0) {
-		/* TODO: Generate error? */
-		return 0;
-	}
-
-	pos = 1;
-
-	/* The ID */
-	if (tlv->id > 255) {
-		ret = oma_tlv_put_u8(out, (tlv->id >> 8) & 0xff, insert);
-		if (ret < 0) {
+	if (insert) {
+		/*
+		 * The header of a container is only known once its content
+		 * has been written: insert it in one go so the data behind
+		 * the mark is moved only once.
+		 */
+		if (!net_pkt_insert(out->out_cpkt->pkt, out->frag,
+				    out->offset, pos, buf,
+				    BUF_ALLOC_TIMEOUT)) {
 			/* TODO: Generate error? */
 			return 0;
 		}
 
-		pos++;
+		out->offset += pos;
+		return pos + tlv->length;
 	}
 
-	ret = oma_tlv_put_u8(out, tlv->id & 0xff, insert);
-	if (ret < 0) {
-		/* TODO: Generate error? */
-		return 0;
+	/* fixed size values are written together with their header */
+	if (value != NULL && tlv->length <= sizeof(s64_t)) {
+		memcpy(buf + pos, value, tlv->length);
+		inline_len = tlv->length;
 	}
 
-	pos++;
-
-	for (i = 2; i >= 0; i--) {
-		if (len_type > i) {
-			ret = oma_tlv_put_u8(out,
-					     (tlv->length >> (i * 8)) & 0xff,
-					     insert);
-			if (ret < 0) {
-				/* TODO: Generate error? */
-				return 0;
-			}
-
-			pos++;
-		}
+	out->frag = net_pkt_write(out->out_cpkt->pkt, out->frag,
+				  out->offset, &out->offset,
+				  pos + inline_len, buf,
+				  BUF_ALLOC_TIMEOUT);
+	if (!out->frag && out->offset == 0xffff) {
+		/* TODO: Generate error? */
+		return 0;
 	}
 
 	/* finally add the value */
-	if (value != NULL && tlv->length > 0 && !insert) {
+	if (value != NULL && tlv->length > inline_len) {
 		out->frag = net_pkt_write(out->out_cpkt->pkt, out->frag,
 					  out->offset, &out->offset,
 					  tlv->length, value,
@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) 2018 Foundries.io
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SenML-CBOR writer (RFC 8428)
+ *
+ * Records are encoded straight into the outgoing CoAP packet: the outer
+ * pack uses an indefinite length array and the number of entries of each
+ * record map is known up front, so nothing that was already written has to
+ * be revisited.
+ */
+
+#define LOG_MODULE_NAME net_lwm2m_senml_cbor
+#define LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(LOG_MODULE_NAME);
+
+#include <stddef.h>
+#include <stdint.h>
+#include <cbor.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_rw_senml_cbor.h"
+#include "lwm2m_engine.h"
+
+static int senml_cbor_write(struct cbor_encoder_writer *writer,
+			    const char *data, int len)
+{
+	struct senml_cbor_out_formatter_data *fd =
+		(struct senml_cbor_out_formatter_data *)writer;
+	struct lwm2m_output_context *out = fd->out;
+
+	out->frag = net_pkt_write(out->out_cpkt->pkt, out->frag,
+				  out->offset, &out->offset, len,
+				  (u8_t *)data, BUF_ALLOC_TIMEOUT);
+	if (!out->frag && out->offset == 0xffff) {
+		return CborErrorOutOfMemory;
+	}
+
+	writer->bytes_written += len;
+	return CborNoError;
+}
+
+static size_t put_begin(struct lwm2m_output_context *out,
+			struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	int len;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	if (path->level >= 2) {
+		len = snprintk(fd->base_name, sizeof(fd->base_name),
+			       "/%u/%u/", path->obj_id, path->obj_inst_id);
+	} else {
+		len = snprintk(fd->base_name, sizeof(fd->base_name),
+			       "/%u/", path->obj_id);
+	}
+
+	if (len < 0) {
+		/* TODO: Generate error? */
+		return 0;
+	}
+
+	fd->out = out;
+	fd->writer.write = senml_cbor_write;
+	fd->writer.bytes_written = 0;
+	cbor_encoder_cust_writer_init(&fd->encoder, &fd->writer, 0);
+
+	if (cbor_encoder_create_array(&fd->encoder, &fd->pack,
+				      CborIndefiniteLength) != CborNoError) {
+		LOG_ERR("unable to start SenML pack");
+		return 0;
+	}
+
+	return fd->writer.bytes_written;
+}
+
+static size_t put_end(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	int start;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	start = fd->writer.bytes_written;
+	if (cbor_encoder_close_container(&fd->encoder,
+					 &fd->pack) != CborNoError) {
+		LOG_ERR("unable to close SenML pack");
+		return 0;
+	}
+
+	return fd->writer.bytes_written - start;
+}
+
+static size_t put_begin_ri(struct lwm2m_output_context *out,
+			   struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags |= WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+static size_t put_end_ri(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+/* open a record map and write its name, leaving the value label to go */
+static CborError put_record_begin(struct senml_cbor_out_formatter_data *fd,
+				  struct lwm2m_obj_path *path,
+				  CborEncoder *record, int label)
+{
+	char name[SENML_NAME_LEN];
+	CborError err;
+	int len;
+
+	if (fd->path_level >= 2) {
+		if (fd->writer_flags & WRITER_RESOURCE_INSTANCE) {
+			len = snprintk(name, sizeof(name), "%u/%u",
+				       path->res_id, path->res_inst_id);
+		} else {
+			len = snprintk(name, sizeof(name), "%u",
+				       path->res_id);
+		}
+	} else {
+		if (fd->writer_flags & WRITER_RESOURCE_INSTANCE) {
+			len = snprintk(name, sizeof(name), "%u/%u/%u",
+				       path->obj_inst_id, path->res_id,
+				       path->res_inst_id);
+		} else {
+			len = snprintk(name, sizeof(name), "%u/%u",
+				       path->obj_inst_id, path->res_id);
+		}
+	}
+
+	if (len < 0) {
+		return CborErrorInternalError;
+	}
+
+	/* the base name only needs to be sent with the first record */
+	err = cbor_encoder_create_map(&fd->pack, record,
+				      fd->base_written ? 2 : 3);
+	if (!fd->base_written) {
+		err |= cbor_encode_int(record, SENML_LABEL_BASE_NAME);
+		err |= cbor_encode_text_stringz(record, fd->base_name);
+		fd->base_written = true;
+	}
+
+	err |= cbor_encode_int(record, SENML_LABEL_NAME);
+	err |= cbor_encode_text_string(record, name, len);
+	err |= cbor_encode_int(record, label);
+
+	return err;
+}
+
+static size_t put_record_end(struct senml_cbor_out_formatter_data *fd,
+			     CborEncoder *record, CborError err, int start)
+{
+	err |= cbor_encoder_close_container(&fd->pack, record);
+	if (err != CborNoError) {
+		LOG_ERR("unable to encode SenML record (%d)", err);
+		return 0;
+	}
+
+	return fd->writer.bytes_written - start;
+}
+
+static size_t put_s64(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, s64_t value)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	CborEncoder record;
+	CborError err;
+	int start;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	start = fd->writer.bytes_written;
+	err = put_record_begin(fd, path, &record, SENML_LABEL_VALUE);
+	err |= cbor_encode_int(&record, value);
+
+	return put_record_end(fd, &record, err, start);
+}
+
+static size_t put_s32(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, s32_t value)
+{
+	return put_s64(out, path, (s64_t)value);
+}
+
+static size_t put_s16(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, s16_t value)
+{
+	return put_s64(out, path, (s64_t)value);
+}
+
+static size_t put_s8(struct lwm2m_output_context *out,
+		     struct lwm2m_obj_path *path, s8_t value)
+{
+	return put_s64(out, path, (s64_t)value);
+}
+
+static size_t put_string(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	CborEncoder record;
+	CborError err;
+	int start;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	start = fd->writer.bytes_written;
+	err = put_record_begin(fd, path, &record, SENML_LABEL_STRING);
+	err |= cbor_encode_text_string(&record, buf, buflen);
+
+	return put_record_end(fd, &record, err, start);
+}
+
+static size_t put_opaque(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	CborEncoder record;
+	CborError err;
+	int start;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	start = fd->writer.bytes_written;
+	err = put_record_begin(fd, path, &record, SENML_LABEL_DATA);
+	err |= cbor_encode_byte_string(&record, (u8_t *)buf, buflen);
+
+	return put_record_end(fd, &record, err, start);
+}
+
+static size_t put_bool(struct lwm2m_output_context *out,
+		       struct lwm2m_obj_path *path,
+		       bool value)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	CborEncoder record;
+	CborError err;
+	int start;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	start = fd->writer.bytes_written;
+	err = put_record_begin(fd, path, &record, SENML_LABEL_BOOL);
+	err |= cbor_encode_boolean(&record, value);
+
+	return put_record_end(fd, &record, err, start);
+}
+
+#if defined(CONFIG_CBOR_FLOATING_POINT)
+#define BINARY64_SIGN		(1ULL << 63)
+#define BINARY64_EXP_SHIFT	52
+#define BINARY64_EXP_BIAS	1023
+#define BINARY64_FRAC_MASK	((1ULL << BINARY64_EXP_SHIFT) - 1)
+
+/*
+ * Converts the fixed point value val1 + val2 / scale, where val2 carries the
+ * sign of val1, to an IEEE 754 binary64 with integer arithmetic only.  The
+ * result is rounded to nearest, ties to even.
+ */
+static u64_t fixed_to_binary64(s64_t val1, s64_t val2, u32_t scale)
+{
+	bool neg = val1 < 0 || (val1 == 0 && val2 < 0);
+	u64_t ip = val1 < 0 ? -(u64_t)val1 : val1;
+	u64_t frac = val2 < 0 ? -(u64_t)val2 : val2;
+	u64_t mant = 0;
+	u64_t round;
+	int shift = 0;
+	int exp;
+
+	ip += frac / scale;
+	frac %= scale;
+
+	if (ip == 0 && frac == 0) {
+		return 0;
+	}
+
+	/* left align the integer part, exp is the weight of bit 63 */
+	if (ip != 0) {
+		mant = ip;
+		while (!(mant & BINARY64_SIGN)) {
+			mant <<= 1;
+			shift++;
+		}
+
+		exp = 63 - shift;
+	} else {
+		exp = -1;
+		while (frac * 2 < scale) {
+			frac *= 2;
+			exp--;
+		}
+
+		shift = 64;
+	}
+
+	/* fill the bits below the integer part from the fraction */
+	while (shift-- > 0) {
+		frac *= 2;
+		if (frac >= scale) {
+			frac -= scale;
+			mant |= 1ULL << shift;
+		}
+	}
+
+	/* keep 53 significant bits, frac is what is left below them */
+	round = mant & 0x7ff;
+	mant >>= 11;
+	if (round > 0x400 || (round == 0x400 && (frac != 0 || (mant & 1)))) {
+		mant++;
+		if (mant >> (BINARY64_EXP_SHIFT + 1)) {
+			mant >>= 1;
+			exp++;
+		}
+	}
+
+	return (neg ? BINARY64_SIGN : 0) |
+	       ((u64_t)(exp + BINARY64_EXP_BIAS) << BINARY64_EXP_SHIFT) |
+	       (mant & BINARY64_FRAC_MASK);
+}
+
+#else
+
+static CborError encode_magnitude(CborEncoder *encoder, bool neg, u64_t mag)
+{
+	if (neg && mag != 0) {
+		return cbor_encode_negative_int(encoder, mag - 1);
+	}
+
+	return cbor_encode_uint(encoder, mag);
+}
+
+/*
+ * Encodes the fixed point value val1 + val2 / scale, where val2 carries the
+ * sign of val1, as a CBOR decimal fraction [exponent, mantissa].  Trailing
+ * zero decimals are dropped, as are the last decimals of values whose
+ * mantissa would not fit in 64 bits.  Integral values are plain integers.
+ */
+static CborError encode_decimal(CborEncoder *record, s64_t val1, s64_t val2,
+				u32_t scale)
+{
+	bool neg = val1 < 0 || (val1 == 0 && val2 < 0);
+	u64_t mant = val1 < 0 ? -(u64_t)val1 : val1;
+	u64_t frac = val2 < 0 ? -(u64_t)val2 : val2;
+	CborEncoder fraction;
+	CborError err;
+	int exp = 0;
+
+	mant += frac / scale;
+	frac %= scale;
+
+	while (frac != 0 && mant <= (UINT64_MAX - 9) / 10) {
+		scale /= 10;
+		mant = mant * 10 + frac / scale;
+		frac %= scale;
+		exp--;
+	}
+
+	if (exp == 0) {
+		return encode_magnitude(record, neg, mant);
+	}
+
+	err = cbor_encode_tag(record, CborDecimalTag);
+	err |= cbor_encoder_create_array(record, &fraction, 2);
+	err |= cbor_encode_int(&fraction, exp);
+	err |= encode_magnitude(&fraction, neg, mant);
+	err |= cbor_encoder_close_container(record, &fraction);
+
+	return err;
+}
+
+#endif
+
+/*
+ * SenML values are plain numbers.  With tinycbor floating point support the
+ * fixed point value is sent as a double, which holds the six and nine
+ * decimals of float32_value_t and float64_value_t; otherwise it is sent as
+ * a decimal fraction, or as an integer if it has no fractional part.
+ */
+static CborError encode_fixed(CborEncoder *record, s64_t val1, s64_t val2,
+			      u32_t scale)
+{
+#if defined(CONFIG_CBOR_FLOATING_POINT)
+	u64_t value = fixed_to_binary64(val1, val2, scale);
+
+	return cbor_encode_floating_point(record, CborDoubleType, &value);
+#else
+	return encode_decimal(record, val1, val2, scale);
+#endif
+}
+
+static size_t put_float32fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float32_value_t *value)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	CborEncoder record;
+	CborError err;
+	int start;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	start = fd->writer.bytes_written;
+	err = put_record_begin(fd, path, &record, SENML_LABEL_VALUE);
+	err |= encode_fixed(&record, value->val1, value->val2, 1000000);
+
+	return put_record_end(fd, &record, err, start);
+}
+
+static size_t put_float64fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float64_value_t *value)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	CborEncoder record;
+	CborError err;
+	int start;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	start = fd->writer.bytes_written;
+	err = put_record_begin(fd, path, &record, SENML_LABEL_VALUE);
+	err |= encode_fixed(&record, value->val1, value->val2, 1000000000);
+
+	return put_record_end(fd, &record, err, start);
+}
+
+const struct lwm2m_writer senml_cbor_writer = {
+	.put_begin = put_begin,
+	.put_end = put_end,
+	.put_begin_ri = put_begin_ri,
+	.put_end_ri = put_end_ri,
+	.put_s8 = put_s8,
+	.put_s16 = put_s16,
+	.put_s32 = put_s32,
+	.put_s64 = put_s64,
+	.put_string = put_string,
+	.put_float32fix = put_float32fix,
+	.put_float64fix = put_float64fix,
+	.put_bool = put_bool,
+	.put_opaque = put_opaque,
+};
+
+int do_read_op_senml_cbor(struct lwm2m_engine_obj *obj,
+			  struct lwm2m_engine_context *context,
+			  int content_format)
+{
+	struct senml_cbor_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	engine_set_out_user_data(context->out, &fd);
+	/* save the level for output processing */
+	fd.path_level = context->path->level;
+	ret = lwm2m_perform_read_op(obj, context, content_format);
+	engine_clear_out_user_data(context->out);
+
+	return ret;
+}
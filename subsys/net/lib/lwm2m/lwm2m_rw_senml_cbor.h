@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2018 Foundries.io
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LWM2M_RW_SENML_CBOR_H_
+#define LWM2M_RW_SENML_CBOR_H_
+
+#include <cbor.h>
+
+#include "lwm2m_object.h"
+
+/* SenML labels (RFC 8428, section 6) */
+#define SENML_LABEL_BASE_NAME	-2
+#define SENML_LABEL_NAME	0
+#define SENML_LABEL_VALUE	2
+#define SENML_LABEL_STRING	3
+#define SENML_LABEL_BOOL	4
+#define SENML_LABEL_DATA	8
+
+/* "/65535/65535/" */
+#define SENML_BASE_NAME_LEN	14
+/* "65535/65535/65535" */
+#define SENML_NAME_LEN		18
+
+struct senml_cbor_out_formatter_data {
+	/* tinycbor writer, must stay the first member */
+	struct cbor_encoder_writer writer;
+	struct lwm2m_output_context *out;
+	CborEncoder encoder;
+	CborEncoder pack;
+	char base_name[SENML_BASE_NAME_LEN];
+	u8_t writer_flags;
+	u8_t path_level;
+	bool base_written;
+};
+
+extern const struct lwm2m_writer senml_cbor_writer;
+
+int do_read_op_senml_cbor(struct lwm2m_engine_obj *obj,
+			  struct lwm2m_engine_context *context,
+			  int content_format);
+
+#endif /* LWM2M_RW_SENML_CBOR_H_ */
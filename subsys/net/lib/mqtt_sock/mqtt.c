@@ -25,16 +25,116 @@ static void client_reset(struct mqtt_client *client)
 	client->internal.last_activity = 0;
 	client->internal.rx_buf_datalen = 0;
 	client->internal.remaining_payload = 0;
+#if defined(CONFIG_MQTT_LIB_SESSION)
+	client->internal.tx_queued = 0;
+#endif
 }
 
-/** @brief Initialize tx buffer. */
+static u32_t tx_queued(const struct mqtt_client *client)
+{
+#if defined(CONFIG_MQTT_LIB_SESSION)
+	return client->internal.tx_queued;
+#else
+	return 0;
+#endif
+}
+
+/** @brief Initialize tx buffer, past any data queued for transmission. */
 static void tx_buf_init(struct mqtt_client *client, struct buf_ctx *buf)
 {
-	memset(client->tx_buf, 0, client->tx_buf_size);
-	buf->cur = client->tx_buf;
+	u32_t queued = tx_queued(client);
+
+	memset(client->tx_buf + queued, 0, client->tx_buf_size - queued);
+	buf->cur = client->tx_buf + queued;
 	buf->end = client->tx_buf + client->tx_buf_size;
 }
 
+#if defined(CONFIG_MQTT_LIB_SESSION)
+int tx_queue_flush(struct mqtt_client *client)
+{
+	u32_t len = client->internal.tx_queued;
+	int err_code;
+
+	if (len == 0) {
+		return 0;
+	}
+
+	MQTT_TRC("[%p]: Transport writing %d queued bytes.", client, len);
+
+	client->internal.tx_queued = 0;
+
+	err_code = mqtt_transport_write(client, client->tx_buf, len);
+	if (err_code < 0) {
+		return err_code;
+	}
+
+	client->internal.last_activity = mqtt_sys_tick_in_ms_get();
+	mqtt_session_sent(client);
+
+	return 0;
+}
+
+int tx_queue_append(struct mqtt_client *client, const u8_t *data,
+		    u32_t datalen)
+{
+	int err_code;
+
+	if (datalen > client->tx_buf_size - client->internal.tx_queued) {
+		err_code = tx_queue_flush(client);
+		if (err_code < 0) {
+			return err_code;
+		}
+	}
+
+	/* Too big to be coalesced, send it on its own. */
+	if (datalen > client->tx_buf_size) {
+		err_code = mqtt_transport_write(client, data, datalen);
+		if (err_code < 0) {
+			return err_code;
+		}
+
+		client->internal.last_activity = mqtt_sys_tick_in_ms_get();
+		mqtt_session_sent(client);
+
+		return 0;
+	}
+
+	/* Data may already be in the tx buffer, right past the queue. */
+	memmove(client->tx_buf + client->internal.tx_queued, data, datalen);
+	client->internal.tx_queued += datalen;
+
+	return 0;
+}
+
+/** @brief Make queued data go out before (or together with) a packet that is
+ *         about to be written.
+ */
+static int tx_queue_prepend(struct mqtt_client *client, const u8_t **data,
+			    u32_t *datalen)
+{
+	u8_t *queue_end = client->tx_buf + client->internal.tx_queued;
+
+	if (client->internal.tx_queued == 0) {
+		return 0;
+	}
+
+	/* Packets encoded with tx_buf_init() sit past the queue, so both can
+	 * be sent with a single write.
+	 */
+	if ((*data >= queue_end) &&
+	    (*data + *datalen <= client->tx_buf + client->tx_buf_size)) {
+		memmove(queue_end, *data, *datalen);
+		*data = client->tx_buf;
+		*datalen += client->internal.tx_queued;
+		client->internal.tx_queued = 0;
+
+		return 0;
+	}
+
+	return tx_queue_flush(client);
+}
+#endif /* CONFIG_MQTT_LIB_SESSION */
+
 /**@brief Notifies disconnection event to the application.
  *
  * @param[in] client Identifies the client for which the procedure is requested.
@@ -141,6 +241,14 @@ static int client_write(struct mqtt_client *client, const u8_t *data,
 {
 	int err_code;
 
+#if defined(CONFIG_MQTT_LIB_SESSION)
+	err_code = tx_queue_prepend(client, &data, &datalen);
+	if (err_code < 0) {
+		client_disconnect(client, err_code);
+		return err_code;
+	}
+#endif
+
 	MQTT_TRC("[%p]: Transport writing %d bytes.", client, datalen);
 
 	err_code = mqtt_transport_write(client, data, datalen);
@@ -153,6 +261,9 @@ static int client_write(struct mqtt_client *client, const u8_t *data,
 
 	MQTT_TRC("[%p]: Transport write complete.", client);
 	client->internal.last_activity = mqtt_sys_tick_in_ms_get();
+#if defined(CONFIG_MQTT_LIB_SESSION)
+	mqtt_session_sent(client);
+#endif
 
 	return 0;
 }
@@ -250,6 +361,168 @@ error:
 	return err_code;
 }
 
+#if defined(CONFIG_MQTT_LIB_SESSION)
+/** @brief Queue retransmissions that are due and send the tx queue. */
+static int session_send(struct mqtt_client *client)
+{
+	int err_code = 0;
+
+	if (MQTT_HAS_STATE(client, MQTT_STATE_CONNECTED)) {
+		err_code = mqtt_session_retransmit(client);
+	}
+
+	if (err_code == 0) {
+		err_code = tx_queue_flush(client);
+	}
+
+	if (err_code < 0) {
+		client_disconnect(client, err_code);
+	}
+
+	return err_code;
+}
+
+static int session_publish_qos0(struct mqtt_client *client,
+				const struct mqtt_publish_param *param)
+{
+	const struct mqtt_binstr *payload = &param->message.payload;
+	struct buf_ctx packet;
+	int err_code;
+
+	tx_buf_init(client, &packet);
+
+	err_code = publish_encode(param, &packet);
+	if ((err_code == -ENOMEM) && (client->internal.tx_queued > 0)) {
+		/* Make room by sending what is queued, then try again. */
+		err_code = tx_queue_flush(client);
+		if (err_code < 0) {
+			goto error;
+		}
+
+		tx_buf_init(client, &packet);
+
+		err_code = publish_encode(param, &packet);
+	}
+
+	if (err_code < 0) {
+		return err_code;
+	}
+
+	/* Coalesce header and payload whenever the payload fits. */
+	if (payload->len <= client->tx_buf + client->tx_buf_size - packet.end) {
+		memcpy(packet.end, payload->data, payload->len);
+		packet.end += payload->len;
+
+		err_code = tx_queue_append(client, packet.cur,
+					   packet.end - packet.cur);
+	} else {
+		err_code = tx_queue_append(client, packet.cur,
+					   packet.end - packet.cur);
+		if (err_code == 0) {
+			err_code = tx_queue_append(client, payload->data,
+						   payload->len);
+		}
+	}
+
+error:
+	if (err_code < 0) {
+		client_disconnect(client, err_code);
+	}
+
+	return err_code;
+}
+
+int mqtt_session_publish(struct mqtt_client *client,
+			 const struct mqtt_publish_param *param)
+{
+	const u8_t *packet;
+	int message_id;
+	u32_t len;
+	int err_code;
+
+	NULL_PARAM_CHECK(client);
+	NULL_PARAM_CHECK(param);
+
+	MQTT_TRC("[CID %p]:[State 0x%02x]: >> Topic size 0x%08x, "
+		 "Data size 0x%08x", client, client->internal.state,
+		 param->message.topic.topic.size,
+		 param->message.payload.len);
+
+	mqtt_mutex_lock(client);
+
+	err_code = verify_tx_state(client);
+	if (err_code < 0) {
+		goto error;
+	}
+
+	if (param->message.topic.qos == MQTT_QOS_0_AT_MOST_ONCE) {
+		err_code = session_publish_qos0(client, param);
+		goto error;
+	}
+
+	message_id = mqtt_session_store(client, param, &packet, &len);
+	if (message_id < 0) {
+		err_code = message_id;
+		goto error;
+	}
+
+	err_code = tx_queue_append(client, packet, len);
+	if (err_code < 0) {
+		mqtt_session_forget(client, message_id);
+		client_disconnect(client, err_code);
+		goto error;
+	}
+
+	err_code = message_id;
+
+error:
+	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
+		 client, client->internal.state, err_code);
+
+	mqtt_mutex_unlock(client);
+
+	return err_code;
+}
+
+int mqtt_session_flush(struct mqtt_client *client)
+{
+	int err_code;
+
+	NULL_PARAM_CHECK(client);
+
+	mqtt_mutex_lock(client);
+
+	err_code = verify_tx_state(client);
+	if (err_code == 0) {
+		err_code = tx_queue_flush(client);
+		if (err_code < 0) {
+			client_disconnect(client, err_code);
+		}
+	}
+
+	mqtt_mutex_unlock(client);
+
+	return err_code;
+}
+
+int mqtt_session_restore(struct mqtt_client *client, const u8_t *packet,
+			 u32_t len)
+{
+	int err_code;
+
+	NULL_PARAM_CHECK(client);
+	NULL_PARAM_CHECK(packet);
+
+	mqtt_mutex_lock(client);
+
+	err_code = mqtt_session_put(client, packet, len);
+
+	mqtt_mutex_unlock(client);
+
+	return err_code;
+}
+#endif /* CONFIG_MQTT_LIB_SESSION */
+
 int mqtt_publish_qos1_ack(struct mqtt_client *client,
 			  const struct mqtt_puback_param *param)
 {
@@ -566,6 +839,12 @@ int mqtt_live(struct mqtt_client *client)
 		    (elapsed_time >= (MQTT_KEEPALIVE * 1000))) {
 			(void)mqtt_ping(client);
 		}
+
+#if defined(CONFIG_MQTT_LIB_SESSION)
+		if (MQTT_HAS_STATE(client, MQTT_STATE_CONNECTED)) {
+			(void)session_send(client);
+		}
+#endif
 	}
 
 	mqtt_mutex_unlock(client);
@@ -586,11 +865,29 @@ int mqtt_input(struct mqtt_client *client)
 	if (MQTT_HAS_STATE(client, MQTT_STATE_DISCONNECTING)) {
 		client_disconnect(client, 0);
 	} else if (MQTT_HAS_STATE(client, MQTT_STATE_TCP_CONNECTED)) {
+#if defined(CONFIG_MQTT_LIB_SESSION)
+		/* Acks can only come for messages which have been sent. */
+		err_code = session_send(client);
+		if (err_code < 0) {
+			goto exit;
+		}
+#endif
+
 		err_code = client_read(client);
+
+#if defined(CONFIG_MQTT_LIB_SESSION)
+		/* Send PUBRELs and retransmissions queued while reading. */
+		if (err_code == 0) {
+			err_code = session_send(client);
+		}
+#endif
 	} else {
 		err_code = -EACCES;
 	}
 
+#if defined(CONFIG_MQTT_LIB_SESSION)
+exit:
+#endif
 	mqtt_mutex_unlock(client);
 
 	return err_code;
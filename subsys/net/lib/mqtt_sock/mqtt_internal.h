@@ -392,6 +392,108 @@ int subscribe_ack_decode(struct buf_ctx *buf,
 int unsubscribe_ack_decode(struct buf_ctx *buf,
 			   struct mqtt_unsuback_param *param);
 
+#if defined(CONFIG_MQTT_LIB_SESSION)
+/**@brief Queue data to be sent with the next transport write.
+ *
+ * @param[in] client Identifies the client for which data is queued.
+ * @param[in] data Data to be queued, may be located in the tx buffer.
+ * @param[in] datalen Length of the data.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int tx_queue_append(struct mqtt_client *client, const u8_t *data,
+		    u32_t datalen);
+
+/**@brief Send all queued data with a single transport write.
+ *
+ * @param[in] client Identifies the client for which data is sent.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int tx_queue_flush(struct mqtt_client *client);
+
+/**@brief Assign a message id to a QoS 1/2 publish message and keep a copy of
+ *        the encoded message in the in-flight window.
+ *
+ * @param[in] client Identifies the client for which the message is stored.
+ * @param[in] param Publish message to be stored.
+ * @param[out] packet Encoded message, ready to be sent.
+ * @param[out] len Length of the encoded message.
+ *
+ * @return Message id if the procedure is successful, an error code otherwise.
+ */
+int mqtt_session_store(struct mqtt_client *client,
+		       const struct mqtt_publish_param *param,
+		       const u8_t **packet, u32_t *len);
+
+/**@brief Put back a previously stored packet in the in-flight window.
+ *
+ * @param[in] client Identifies the client for which the packet is restored.
+ * @param[in] packet PUBLISH or PUBREL packet.
+ * @param[in] len Length of the packet.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_session_put(struct mqtt_client *client, const u8_t *packet,
+		     u32_t len);
+
+/**@brief Remove a message from the in-flight window.
+ *
+ * @param[in] client Identifies the client for which the message is removed.
+ * @param[in] message_id Message id of the message.
+ */
+void mqtt_session_forget(struct mqtt_client *client, u16_t message_id);
+
+/**@brief Process an acknowledgment for an outgoing publish message.
+ *
+ * @param[in] client Identifies the client for which the ack was received.
+ * @param[in] type MQTT_PKT_TYPE_PUBACK, MQTT_PKT_TYPE_PUBREC or
+ *                 MQTT_PKT_TYPE_PUBCOMP.
+ * @param[in] message_id Message id being acknowledged.
+ *
+ * @return 1 if the message belongs to the session layer, 0 if it does not,
+ *         an error code otherwise.
+ */
+int mqtt_session_ack(struct mqtt_client *client, u8_t type,
+		     u16_t message_id);
+
+/**@brief Record the transmission time of the in-flight messages queued so
+ *        far, called once the tx queue has been written to the transport.
+ *
+ * @param[in] client Identifies the client for which data has been sent.
+ */
+void mqtt_session_sent(struct mqtt_client *client);
+
+/**@brief Queue in-flight messages for retransmission once the broker has
+ *        accepted the connection, or drop them for a clean session.
+ *
+ * @param[in] client Identifies the client which has been connected.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_session_resume(struct mqtt_client *client);
+
+/**@brief Queue in-flight messages whose retransmission timeout expired.
+ *
+ * @param[in] client Identifies the client for which the procedure is
+ *                   requested.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_session_retransmit(struct mqtt_client *client);
+#else
+static inline int mqtt_session_ack(struct mqtt_client *client, u8_t type,
+				   u16_t message_id)
+{
+	return 0;
+}
+
+static inline int mqtt_session_resume(struct mqtt_client *client)
+{
+	return 0;
+}
+#endif /* CONFIG_MQTT_LIB_SESSION */
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/** @file mqtt_session.c
+ *
+ * @brief MQTT in-flight window for outgoing QoS 1/2 messages.
+ *
+ * Every in-flight message owns an equal share of the session storage,
+ * holding the packet to be sent again if the message is not acknowledged:
+ * the PUBLISH packet until PUBACK/PUBREC is received, then the PUBREL packet
+ * until PUBCOMP is received for QoS 2.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_mqtt_session, CONFIG_MQTT_LOG_LEVEL);
+
+#include <net/mqtt.h>
+
+#include "mqtt_internal.h"
+#include "mqtt_os.h"
+
+#define INFLIGHT_COUNT CONFIG_MQTT_LIB_SESSION_WINDOW
+#define INFLIGHT_BIT(idx) ((u64_t)1 << (idx))
+
+static u32_t slot_size(const struct mqtt_client *client)
+{
+	if (client->session_buf == NULL) {
+		return 0;
+	}
+
+	return client->session_buf_size / INFLIGHT_COUNT;
+}
+
+static u8_t *slot_packet(const struct mqtt_client *client, int idx)
+{
+	return client->session_buf + idx * slot_size(client);
+}
+
+static int inflight_find(const struct mqtt_client *client, u16_t message_id)
+{
+	int i;
+
+	for (i = 0; i < INFLIGHT_COUNT; i++) {
+		if ((client->internal.inflight[i].len > 0) &&
+		    (client->internal.inflight[i].message_id == message_id)) {
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
+
+static int inflight_alloc(const struct mqtt_client *client)
+{
+	int i;
+
+	for (i = 0; i < INFLIGHT_COUNT; i++) {
+		if (client->internal.inflight[i].len == 0) {
+			return i;
+		}
+	}
+
+	return -EBUSY;
+}
+
+static void inflight_notify(struct mqtt_client *client, int idx)
+{
+	struct mqtt_inflight *inflight = &client->internal.inflight[idx];
+
+	if (client->session_cb == NULL) {
+		return;
+	}
+
+	client->session_cb(client, inflight->message_id,
+			   inflight->len ? slot_packet(client, idx) : NULL,
+			   inflight->len);
+}
+
+static void inflight_free(struct mqtt_client *client, int idx)
+{
+	client->internal.inflight[idx].len = 0;
+
+	inflight_notify(client, idx);
+}
+
+static u16_t message_id_next(struct mqtt_client *client)
+{
+	u16_t message_id;
+
+	/* Message id zero is not permitted by spec. */
+	do {
+		message_id = ++client->internal.last_message_id;
+	} while ((message_id == 0) ||
+		 (inflight_find(client, message_id) >= 0));
+
+	return message_id;
+}
+
+/** @brief Move an encoded frame to the beginning of its slot. */
+static u32_t slot_compact(const struct mqtt_client *client, int idx,
+			  const struct buf_ctx *frame, u32_t extra)
+{
+	u32_t len = frame->end - frame->cur;
+
+	memmove(slot_packet(client, idx), frame->cur, len);
+
+	return len + extra;
+}
+
+int mqtt_session_store(struct mqtt_client *client,
+		       const struct mqtt_publish_param *param,
+		       const u8_t **packet, u32_t *len)
+{
+	struct mqtt_publish_param publish = *param;
+	struct mqtt_inflight *inflight;
+	struct buf_ctx buf;
+	u32_t header_len;
+	int err_code;
+	int idx;
+
+	idx = inflight_alloc(client);
+	if (idx < 0) {
+		return idx;
+	}
+
+	buf.cur = slot_packet(client, idx);
+	buf.end = buf.cur + slot_size(client);
+
+	publish.message_id = message_id_next(client);
+	publish.dup_flag = 0;
+
+	err_code = publish_encode(&publish, &buf);
+	if (err_code < 0) {
+		return err_code;
+	}
+
+	/* Payload is stored right after the header, if it fits. */
+	header_len = buf.end - buf.cur;
+	if (publish.message.payload.len > slot_size(client) - header_len) {
+		MQTT_ERR("[CID %p]: Message too big for session storage",
+			 client);
+		return -ENOMEM;
+	}
+
+	inflight = &client->internal.inflight[idx];
+	inflight->message_id = publish.message_id;
+	inflight->len = slot_compact(client, idx, &buf,
+				     publish.message.payload.len);
+	inflight->queued = true;
+
+	memcpy(slot_packet(client, idx) + header_len,
+	       publish.message.payload.data, publish.message.payload.len);
+
+	inflight_notify(client, idx);
+
+	*packet = slot_packet(client, idx);
+	*len = inflight->len;
+
+	return publish.message_id;
+}
+
+int mqtt_session_put(struct mqtt_client *client, const u8_t *packet,
+		     u32_t len)
+{
+	struct mqtt_inflight *inflight;
+	u8_t type_and_flags;
+	u32_t var_length;
+	u16_t topic_length;
+	struct buf_ctx buf;
+	int err_code;
+	int idx;
+
+	buf.cur = (u8_t *)packet;
+	buf.end = (u8_t *)packet + len;
+
+	err_code = fixed_header_decode(&buf, &type_and_flags, &var_length);
+	if ((err_code < 0) || (var_length != buf.end - buf.cur)) {
+		return -EINVAL;
+	}
+
+	switch (type_and_flags & 0xF0) {
+	case MQTT_PKT_TYPE_PUBLISH:
+		if ((type_and_flags & MQTT_HEADER_QOS_MASK) == 0) {
+			return -EINVAL;
+		}
+
+		/* Skip the topic, the message id comes right after it. */
+		if (var_length < sizeof(u16_t)) {
+			return -EINVAL;
+		}
+
+		topic_length = (buf.cur[0] << 8) | buf.cur[1];
+		buf.cur += sizeof(u16_t) + topic_length;
+		break;
+	case MQTT_PKT_TYPE_PUBREL:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	if ((buf.end - buf.cur) < (int)sizeof(u16_t)) {
+		return -EINVAL;
+	}
+
+	if (len > slot_size(client)) {
+		return -ENOMEM;
+	}
+
+	idx = inflight_alloc(client);
+	if (idx < 0) {
+		return idx;
+	}
+
+	inflight = &client->internal.inflight[idx];
+	inflight->message_id = (buf.cur[0] << 8) | buf.cur[1];
+
+	if ((inflight->message_id == 0) ||
+	    (inflight_find(client, inflight->message_id) >= 0)) {
+		return -EINVAL;
+	}
+
+	memcpy(slot_packet(client, idx), packet, len);
+	inflight->len = len;
+	inflight->sent_at = mqtt_sys_tick_in_ms_get();
+	inflight->queued = false;
+
+	return 0;
+}
+
+void mqtt_session_forget(struct mqtt_client *client, u16_t message_id)
+{
+	int idx = inflight_find(client, message_id);
+
+	if (idx >= 0) {
+		inflight_free(client, idx);
+	}
+}
+
+static int inflight_send(struct mqtt_client *client, int idx)
+{
+	struct mqtt_inflight *inflight = &client->internal.inflight[idx];
+	u8_t *packet = slot_packet(client, idx);
+
+	if ((packet[0] & 0xF0) == MQTT_PKT_TYPE_PUBLISH) {
+		packet[0] |= MQTT_HEADER_DUP_MASK;
+	}
+
+	inflight->queued = true;
+
+	return tx_queue_append(client, packet, inflight->len);
+}
+
+void mqtt_session_sent(struct mqtt_client *client)
+{
+	u32_t now = mqtt_sys_tick_in_ms_get();
+	int i;
+
+	for (i = 0; i < INFLIGHT_COUNT; i++) {
+		struct mqtt_inflight *inflight = &client->internal.inflight[i];
+
+		if (inflight->queued) {
+			inflight->sent_at = now;
+			inflight->queued = false;
+		}
+	}
+}
+
+static int pubrel_store(struct mqtt_client *client, int idx)
+{
+	struct mqtt_inflight *inflight = &client->internal.inflight[idx];
+	const struct mqtt_pubrel_param param = {
+		.message_id = inflight->message_id
+	};
+	struct buf_ctx buf;
+	int err_code;
+
+	buf.cur = slot_packet(client, idx);
+	buf.end = buf.cur + slot_size(client);
+
+	err_code = publish_release_encode(&param, &buf);
+	if (err_code < 0) {
+		return err_code;
+	}
+
+	inflight->len = slot_compact(client, idx, &buf, 0);
+	inflight_notify(client, idx);
+
+	return 0;
+}
+
+int mqtt_session_ack(struct mqtt_client *client, u8_t type,
+		     u16_t message_id)
+{
+	int idx = inflight_find(client, message_id);
+	u8_t header;
+	int err_code;
+
+	if (idx < 0) {
+		return 0;
+	}
+
+	header = slot_packet(client, idx)[0];
+
+	switch (type) {
+	case MQTT_PKT_TYPE_PUBACK:
+		if ((header & (0xF0 | MQTT_HEADER_QOS_MASK)) !=
+		    (MQTT_PKT_TYPE_PUBLISH | (MQTT_QOS_1_AT_LEAST_ONCE << 1))) {
+			return 0;
+		}
+
+		inflight_free(client, idx);
+		return 1;
+
+	case MQTT_PKT_TYPE_PUBREC:
+		if ((header & (0xF0 | MQTT_HEADER_QOS_MASK)) ==
+		    (MQTT_PKT_TYPE_PUBLISH | (MQTT_QOS_2_EXACTLY_ONCE << 1))) {
+			err_code = pubrel_store(client, idx);
+			if (err_code < 0) {
+				return err_code;
+			}
+		} else if ((header & 0xF0) != MQTT_PKT_TYPE_PUBREL) {
+			return 0;
+		}
+
+		/* PUBREL is also sent again for a duplicate PUBREC. */
+		err_code = inflight_send(client, idx);
+		if (err_code < 0) {
+			return err_code;
+		}
+
+		return 1;
+
+	case MQTT_PKT_TYPE_PUBCOMP:
+		if ((header & 0xF0) != MQTT_PKT_TYPE_PUBREL) {
+			return 0;
+		}
+
+		inflight_free(client, idx);
+		return 1;
+
+	default:
+		return 0;
+	}
+}
+
+/** @brief Send again messages not sent for min_age ms, oldest first. */
+static int inflight_resend(struct mqtt_client *client, u32_t min_age)
+{
+	u64_t pending = 0;
+	int err_code;
+	int oldest;
+	int i;
+
+	for (i = 0; i < INFLIGHT_COUNT; i++) {
+		const struct mqtt_inflight *inflight =
+			&client->internal.inflight[i];
+
+		if ((inflight->len > 0) && !inflight->queued &&
+		    (mqtt_elapsed_time_in_ms_get(inflight->sent_at) >=
+		     min_age)) {
+			pending |= INFLIGHT_BIT(i);
+		}
+	}
+
+	/* Original order has to be preserved when resending messages. */
+	while (pending) {
+		oldest = -1;
+
+		for (i = 0; i < INFLIGHT_COUNT; i++) {
+			if (!(pending & INFLIGHT_BIT(i))) {
+				continue;
+			}
+
+			if ((oldest < 0) ||
+			    ((s32_t)(client->internal.inflight[i].sent_at -
+				     client->internal.inflight[oldest].sent_at)
+			     < 0)) {
+				oldest = i;
+			}
+		}
+
+		pending &= ~INFLIGHT_BIT(oldest);
+
+		MQTT_TRC("[CID %p]: Resending message id 0x%04x", client,
+			 client->internal.inflight[oldest].message_id);
+
+		err_code = inflight_send(client, oldest);
+		if (err_code < 0) {
+			return err_code;
+		}
+	}
+
+	return 0;
+}
+
+int mqtt_session_resume(struct mqtt_client *client)
+{
+	int i;
+
+	/* Packets queued on the previous connection were dropped with it. */
+	for (i = 0; i < INFLIGHT_COUNT; i++) {
+		client->internal.inflight[i].queued = false;
+	}
+
+	/* A clean session discards any state left from the previous one. */
+	if (client->clean_session) {
+		for (i = 0; i < INFLIGHT_COUNT; i++) {
+			if (client->internal.inflight[i].len > 0) {
+				inflight_free(client, i);
+			}
+		}
+
+		return 0;
+	}
+
+	return inflight_resend(client, 0);
+}
+
+int mqtt_session_retransmit(struct mqtt_client *client)
+{
+	if (CONFIG_MQTT_LIB_SESSION_RETRANSMIT_TIMEOUT == 0) {
+		return 0;
+	}
+
+	return inflight_resend(client,
+			       CONFIG_MQTT_LIB_SESSION_RETRANSMIT_TIMEOUT);
+}
@@ -15,9 +15,23 @@
 extern "C" {
 #endif
 
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+struct settings_fcb_index_entry {
+	u32_t hash;		/* of the name */
+	struct fcb_entry loc;	/* of the most recent record */
+};
+#endif
+
 struct settings_fcb {
 	struct settings_store cf_store;
 	struct fcb cf_fcb;
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+	struct settings_fcb_index_entry
+		cf_index[CONFIG_SETTINGS_FCB_INDEX_SIZE];
+	u16_t cf_index_cnt;
+	bool cf_index_valid;	/* all records are indexed */
+	bool cf_index_full;	/* some names did not fit */
+#endif
 };
 
 extern int settings_fcb_src(struct settings_fcb *cf);
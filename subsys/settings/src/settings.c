@@ -81,17 +81,68 @@ int settings_parse_name(char *name, int *name_argc, char *name_argv[])
 	return 0;
 }
 
+/*
+ * Return the length of subtree if name is subtree itself or an item in it,
+ * 0 otherwise.
+ */
+size_t settings_name_in_subtree(const char *name, const char *subtree)
+{
+	size_t len = strlen(subtree);
+
+	if (strncmp(name, subtree, len)) {
+		return 0;
+	}
+
+	if (name[len] != '\0' && name[len] != *SETTINGS_NAME_SEPARATOR) {
+		return 0;
+	}
+
+	return len;
+}
+
+/*
+ * Find the handler with the longest name matching the start of name, and
+ * separate the rest of name into argv array after the handler name. Only
+ * the part of name below the handler is split, so handlers can be
+ * registered for any level of the tree, e.g. "bt/mesh" next to "bt".
+ */
 static struct settings_handler *settings_parse_and_lookup(char *name,
 							  int *name_argc,
 							  char *name_argv[])
 {
+	struct settings_handler *ch;
+	struct settings_handler *best = NULL;
+	size_t best_len = 0;
+	size_t len;
 	int rc;
 
-	rc = settings_parse_name(name, name_argc, name_argv);
+	SYS_SLIST_FOR_EACH_CONTAINER(&settings_handlers, ch, node) {
+		len = settings_name_in_subtree(name, ch->name);
+		if (len > best_len) {
+			best = ch;
+			best_len = len;
+		}
+	}
+
+	if (!best) {
+		return NULL;
+	}
+
+	name_argv[0] = name;
+	*name_argc = 1;
+
+	if (name[best_len] == '\0') {
+		return best;
+	}
+
+	name[best_len] = '\0';
+	rc = settings_parse_name(&name[best_len + 1], name_argc, &name_argv[1]);
 	if (rc) {
 		return NULL;
 	}
-	return settings_handler_lookup(name_argv[0]);
+	(*name_argc)++;
+
+	return best;
 }
 
 int settings_set_value_priv(char *name, void *val_read_cb_ctx, off_t off,
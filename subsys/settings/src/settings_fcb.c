@@ -8,6 +8,7 @@
 #include <errno.h>
 #include <fcb.h>
 #include <string.h>
+#include <crc.h>
 
 #include "settings/settings.h"
 #include "settings/settings_fcb.h"
@@ -18,18 +19,72 @@
 struct settings_fcb_load_cb_arg {
 	load_cb cb;
 	void *cb_arg;
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+	struct settings_fcb *cf;
+#endif
 };
 
 static int settings_fcb_load(struct settings_store *cs, load_cb cb,
 			     void *cb_arg);
 static int settings_fcb_save(struct settings_store *cs, const char *name,
 			     const char *value, size_t val_len);
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+static int settings_fcb_load_name(struct settings_store *cs, const char *name,
+				  load_cb cb, void *cb_arg);
+#endif
 
 static struct settings_store_itf settings_fcb_itf = {
 	.csi_load = settings_fcb_load,
 	.csi_save = settings_fcb_save,
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+	.csi_load_name = settings_fcb_load_name,
+#endif
 };
 
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+static void settings_fcb_index_reset(struct settings_fcb *cf)
+{
+	cf->cf_index_cnt = 0;
+	cf->cf_index_valid = false;
+	cf->cf_index_full = false;
+}
+
+static struct settings_fcb_index_entry *
+settings_fcb_index_find(struct settings_fcb *cf, u32_t hash)
+{
+	for (int i = 0; i < cf->cf_index_cnt; i++) {
+		if (cf->cf_index[i].hash == hash) {
+			return &cf->cf_index[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Record loc as the most recent record of name. Names with the same hash
+ * share an entry, the lookup compares the name stored at the location.
+ */
+static void settings_fcb_index_update(struct settings_fcb *cf,
+				      const char *name, size_t name_len,
+				      const struct fcb_entry *loc)
+{
+	struct settings_fcb_index_entry *entry;
+	u32_t hash;
+
+	hash = crc32_ieee((const u8_t *)name, name_len);
+	entry = settings_fcb_index_find(cf, hash);
+	if (!entry) {
+		if (cf->cf_index_cnt == ARRAY_SIZE(cf->cf_index)) {
+			cf->cf_index_full = true;
+			return;
+		}
+		entry = &cf->cf_index[cf->cf_index_cnt++];
+		entry->hash = hash;
+	}
+	entry->loc = *loc;
+}
+#endif
+
 int settings_fcb_src(struct settings_fcb *cf)
 {
 	int rc;
@@ -62,6 +117,9 @@ int settings_fcb_src(struct settings_fcb *cf)
 		}
 	}
 
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+	settings_fcb_index_reset(cf);
+#endif
 	cf->cf_store.cs_itf = &settings_fcb_itf;
 	settings_src_register(&cf->cf_store);
 
@@ -93,6 +151,13 @@ static int settings_fcb_load_cb(struct fcb_entry_ctx *entry_ctx, void *arg)
 	}
 	buf[len_read] = '\0';
 
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+	if (argp->cf) {
+		settings_fcb_index_update(argp->cf, buf, len_read,
+					  &entry_ctx->loc);
+	}
+#endif
+
 	/*name, val-read_cb-ctx, val-off*/
 	/* take into account '=' separator after the name */
 	argp->cb(buf, (void *)&entry_ctx->loc, len_read + 1, argp->cb_arg);
@@ -108,13 +173,69 @@ static int settings_fcb_load(struct settings_store *cs, load_cb cb,
 
 	arg.cb = cb;
 	arg.cb_arg = cb_arg;
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+	/* a complete walk builds the index, if it is not up to date */
+	arg.cf = NULL;
+	if (!cf->cf_index_valid) {
+		settings_fcb_index_reset(cf);
+		arg.cf = cf;
+	}
+#endif
 	rc = fcb_walk(&cf->cf_fcb, 0, settings_fcb_load_cb, &arg);
 	if (rc) {
 		return -EINVAL;
 	}
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+	cf->cf_index_valid = true;
+#endif
 	return 0;
 }
 
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+/* ::csi_load_name implementation */
+static int settings_fcb_load_name(struct settings_store *cs, const char *name,
+				  load_cb cb, void *cb_arg)
+{
+	struct settings_fcb *cf = (struct settings_fcb *)cs;
+	struct settings_fcb_index_entry *entry;
+	struct fcb_entry_ctx entry_ctx;
+	char buf[SETTINGS_MAX_NAME_LEN + SETTINGS_EXTRA_LEN + 1];
+	size_t name_len;
+	size_t len_read;
+	int rc;
+
+	if (!cf->cf_index_valid) {
+		return settings_fcb_load(cs, cb, cb_arg);
+	}
+
+	name_len = strlen(name);
+	entry = settings_fcb_index_find(cf,
+					crc32_ieee((const u8_t *)name,
+						   name_len));
+	if (!entry) {
+		if (cf->cf_index_full) {
+			return settings_fcb_load(cs, cb, cb_arg);
+		}
+		/* never stored */
+		return 0;
+	}
+
+	entry_ctx.loc = entry->loc;
+	entry_ctx.fap = cf->cf_fcb.fap;
+
+	rc = settings_line_name_read(buf, sizeof(buf), &len_read,
+				     (void *)&entry_ctx);
+	if (rc || len_read != name_len || memcmp(buf, name, name_len)) {
+		/* another name with the same hash */
+		return settings_fcb_load(cs, cb, cb_arg);
+	}
+	buf[len_read] = '\0';
+
+	cb(buf, (void *)&entry_ctx, len_read + 1, cb_arg);
+	return 0;
+}
+#endif
+
 static int read_handler(void *ctx, off_t off, char *buf, size_t *len)
 {
 	struct fcb_entry_ctx *entry_ctx = ctx;
@@ -147,6 +268,11 @@ static void settings_fcb_compress(struct settings_fcb *cf)
 		return; /* XXX */
 	}
 
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+	/* records are moved, the next walk rebuilds the index */
+	settings_fcb_index_reset(cf);
+#endif
+
 	rbs = flash_area_align(cf->cf_fcb.fap);
 
 	loc1.fap = cf->cf_fcb.fap;
@@ -272,6 +398,12 @@ static int settings_fcb_save(struct settings_store *cs, const char *name,
 			rc = i;
 		}
 	}
+
+#ifdef CONFIG_SETTINGS_FCB_INDEX
+	if (!rc && cf->cf_index_valid) {
+		settings_fcb_index_update(cf, name, strlen(name), &loc.loc);
+	}
+#endif
 	return rc;
 }
 
@@ -106,6 +106,8 @@ void settings_line_io_init(int (*read_cb)(void *ctx, off_t off, char *buf,
 int settings_set_value_priv(char *name, void *val_read_cb_ctx, off_t off,
 			    u8_t is_runtime);
 
+size_t settings_name_in_subtree(const char *name, const char *subtree);
+
 /*
  * API for config storage.
  */
@@ -114,6 +116,11 @@ typedef void (*load_cb)(char *name, void *val_read_cb_ctx, off_t off,
 
 struct settings_store_itf {
 	int (*csi_load)(struct settings_store *cs, load_cb cb, void *cb_arg);
+	/* Optional. Calls cb at least for the most recent item of name, cb
+	 * must ignore the other names it may get.
+	 */
+	int (*csi_load_name)(struct settings_store *cs, const char *name,
+			     load_cb cb, void *cb_arg);
 	int (*csi_save_start)(struct settings_store *cs);
 	int (*csi_save)(struct settings_store *cs, const char *name,
 			const char *value, size_t val_len);
@@ -45,10 +45,18 @@ void settings_dst_register(struct settings_store *cs)
 	settings_save_dst = cs;
 }
 
+/* cb_arg is the subtree to load, or NULL for all items */
 static void settings_load_cb(char *name, void *val_read_cb_ctx, off_t off,
 			     void *cb_arg)
 {
-	 int rc = settings_set_value_priv(name, val_read_cb_ctx, off, 0);
+	const char *subtree = cb_arg;
+	int rc;
+
+	if (subtree && !settings_name_in_subtree(name, subtree)) {
+		return;
+	}
+
+	rc = settings_set_value_priv(name, val_read_cb_ctx, off, 0);
 	__ASSERT(rc == 0, "set-value operation failure\n");
 	(void)rc;
 }
@@ -70,6 +78,65 @@ int settings_load(void)
 	return settings_commit(NULL);
 }
 
+/*
+ * Commit the handlers which may have got items of the subtree: the ones
+ * registered inside it and the one the subtree itself belongs to.
+ */
+static int settings_commit_subtree(const char *subtree)
+{
+	struct settings_handler *ch;
+	struct settings_handler *owner = NULL;
+	size_t owner_len = 0;
+	size_t len;
+	int rc;
+	int rc2;
+
+	rc = 0;
+	SYS_SLIST_FOR_EACH_CONTAINER(&settings_handlers, ch, node) {
+		len = settings_name_in_subtree(subtree, ch->name);
+		if (len > owner_len) {
+			owner = ch;
+			owner_len = len;
+		}
+
+		if (ch->h_commit &&
+		    settings_name_in_subtree(ch->name, subtree)) {
+			rc2 = ch->h_commit();
+			if (!rc) {
+				rc = rc2;
+			}
+		}
+	}
+
+	/* an owner named like the subtree was committed above */
+	if (owner && owner->h_commit && owner_len < strlen(subtree)) {
+		rc2 = owner->h_commit();
+		if (!rc) {
+			rc = rc2;
+		}
+	}
+	return rc;
+}
+
+int settings_load_subtree(const char *subtree)
+{
+	struct settings_store *cs;
+
+	if (!subtree) {
+		return settings_load();
+	}
+
+	/*
+	 * Items outside of the subtree are still read from the stores, as
+	 * records are kept in order of writing, but they are not parsed nor
+	 * passed to a handler.
+	 */
+	SYS_SLIST_FOR_EACH_CONTAINER(&settings_load_srcs, cs, cs_next) {
+		cs->cs_itf->csi_load(cs, settings_load_cb, (void *)subtree);
+	}
+	return settings_commit_subtree(subtree);
+}
+
 /* val_off - offset of value-string within line entries */
 static int settings_cmp(char const *val, size_t val_len, void *val_read_cb_ctx,
 		 off_t val_off)
@@ -153,7 +220,12 @@ int settings_save_one(const char *name, void *value, size_t val_len)
 	cdca.val = (char *)value;
 	cdca.is_dup = 0;
 	cdca.val_len = val_len;
-	cs->cs_itf->csi_load(cs, settings_dup_check_cb, &cdca);
+	if (cs->cs_itf->csi_load_name) {
+		cs->cs_itf->csi_load_name(cs, name, settings_dup_check_cb,
+					  &cdca);
+	} else {
+		cs->cs_itf->csi_load(cs, settings_dup_check_cb, &cdca);
+	}
 	if (cdca.is_dup == 1) {
 		return 0;
 	}
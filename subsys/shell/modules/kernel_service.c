@@ -9,6 +9,7 @@
 #include <shell/shell.h>
 #include <init.h>
 #include <debug/object_tracing.h>
+#include <debug/latency_stats.h>
 #include <misc/reboot.h>
 #include <misc/stack.h>
 #include <string.h>
@@ -123,6 +124,236 @@ static int cmd_kernel_stacks(const struct shell *shell,
 }
 #endif
 
+#if defined(CONFIG_THREAD_MONITOR) && defined(CONFIG_THREAD_RUNTIME_STATS)
+static u32_t cycles_to_ms(u64_t cycles)
+{
+	return (u32_t)(cycles * MSEC_PER_SEC / sys_clock_hw_cycles_per_sec());
+}
+
+/* Share of the cycles in tenths of percent. */
+static u32_t permille(u64_t part, u64_t total)
+{
+	return total ? (u32_t)(part * 1000 / total) : 0;
+}
+
+struct runtime_dump_ctx {
+	const struct shell *shell;
+	struct k_cpu_runtime_stats all;
+};
+
+static void shell_runtime_dump(const struct k_thread *thread, void *user_data)
+{
+	struct runtime_dump_ctx *ctx = user_data;
+	struct k_thread_runtime_stats stats;
+	const char *tname;
+	u32_t pm;
+
+	k_thread_runtime_stats_get((k_tid_t)thread, &stats);
+	tname = k_thread_name_get((struct k_thread *)thread);
+	pm = permille(stats.execution_cycles, ctx->all.total_cycles);
+
+	shell_fprintf(ctx->shell, SHELL_NORMAL,
+		      "%s%p %-10s %10u ms %3u.%u %%\n",
+		      (thread == k_current_get()) ? "*" : " ",
+		      thread, tname ? tname : "NA",
+		      cycles_to_ms(stats.execution_cycles), pm / 10, pm % 10);
+}
+
+static int cmd_kernel_runtime(const struct shell *shell,
+			      size_t argc, char **argv)
+{
+	struct runtime_dump_ctx ctx = { .shell = shell };
+	struct k_cpu_runtime_stats stats;
+	u32_t pm;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	for (int i = 0; i < CONFIG_MP_NUM_CPUS; i++) {
+		k_cpu_runtime_stats_get(i, &stats);
+		pm = permille(stats.total_cycles - stats.idle_cycles,
+			      stats.total_cycles);
+		shell_fprintf(shell, SHELL_NORMAL,
+			      "CPU %d: busy %u.%u %% of %u ms\n", i,
+			      pm / 10, pm % 10,
+			      cycles_to_ms(stats.total_cycles));
+	}
+
+	/* Thread shares are relative to the time accounted on all CPUs. */
+	k_cpu_runtime_stats_all_get(&ctx.all);
+	shell_fprintf(shell, SHELL_NORMAL, "Threads:\n");
+	k_thread_foreach(shell_runtime_dump, &ctx);
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_OBJECT_STATS) || defined(CONFIG_LATENCY_STATS)
+static u32_t cycles_to_us(u64_t cycles)
+{
+	return (u32_t)(cycles * USEC_PER_SEC / sys_clock_hw_cycles_per_sec());
+}
+#endif
+
+#if defined(CONFIG_OBJECT_STATS)
+
+static void shell_obj_stats_dump(const struct shell *shell, const char *kind,
+				 const void *obj,
+				 const struct k_obj_stats *obj_stats)
+{
+	struct k_obj_stats stats;
+	unsigned int key;
+	u32_t wait_avg;
+
+	/* Take a consistent snapshot, object is updated with irqs locked. */
+	key = irq_lock();
+	stats = *obj_stats;
+	irq_unlock(key);
+
+	wait_avg = stats.blocked ?
+		   cycles_to_us(stats.wait_total / stats.blocked) : 0;
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "%-5s %p %8u %8u %7u %6u %8u %8u", kind, obj,
+		      stats.takes, stats.gives, stats.blocked, stats.failed,
+		      cycles_to_us(stats.wait_max), wait_avg);
+
+	if (stats.hold_total != 0U) {
+		shell_fprintf(shell, SHELL_NORMAL, " %8u %8u",
+			      cycles_to_us(stats.hold_max),
+			      (u32_t)(stats.hold_total * MSEC_PER_SEC /
+				      sys_clock_hw_cycles_per_sec()));
+	}
+
+	shell_fprintf(shell, SHELL_NORMAL, "\n");
+}
+
+#define OBJ_STATS_DUMP(shell, type, name, kind)				\
+	do {								\
+		type *obj = SYS_TRACING_HEAD(type, name);		\
+									\
+		for (; obj != NULL;					\
+		     obj = SYS_TRACING_NEXT(type, name, obj)) {		\
+			shell_obj_stats_dump(shell, kind, obj,		\
+					     SYS_TRACING_STATS(obj));	\
+		}							\
+	} while (false)
+
+static int cmd_kernel_objects(const struct shell *shell,
+			      size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "Times in us, hold total in ms. FIFOs and LIFOs are "
+		      "listed as queues.\n");
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "%-5s %-10s %8s %8s %7s %6s %8s %8s %8s %8s\n",
+		      "Type", "Object", "Takes", "Gives", "Blocked", "Failed",
+		      "WaitMax", "WaitAvg", "HoldMax", "HoldTot");
+
+	OBJ_STATS_DUMP(shell, struct k_sem, k_sem, "sem");
+	OBJ_STATS_DUMP(shell, struct k_mutex, k_mutex, "mutex");
+	OBJ_STATS_DUMP(shell, struct k_queue, k_queue, "queue");
+	OBJ_STATS_DUMP(shell, struct k_msgq, k_msgq, "msgq");
+	OBJ_STATS_DUMP(shell, struct k_mem_slab, k_mem_slab, "slab");
+
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_LATENCY_STATS)
+static const char * const latency_names[SYS_LATENCY_TYPES] = {
+	[SYS_LATENCY_IRQ_LOCKED] = "IRQ locked",
+	[SYS_LATENCY_ISR_ENTRY] = "ISR entry",
+	[SYS_LATENCY_THREAD_WAKEUP] = "ISR to thread",
+	[SYS_LATENCY_SCHED_LOCKED] = "Sched locked",
+};
+
+static void shell_latency_dump(const struct shell *shell,
+			       enum sys_latency_type type)
+{
+	static struct sys_latency_hist hist;
+	u32_t upper;
+
+	sys_latency_get(type, &hist);
+
+	shell_fprintf(shell, SHELL_NORMAL, "%s: %u samples",
+		      latency_names[type], hist.count);
+	if (hist.count == 0U) {
+		shell_fprintf(shell, SHELL_NORMAL, "\n");
+		return;
+	}
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      ", avg %u us, max %u us\n"
+		      "  p50 %u us, p90 %u us, p99 %u us, p99.9 %u us\n",
+		      cycles_to_us(hist.total / hist.count),
+		      cycles_to_us(hist.max),
+		      cycles_to_us(sys_latency_percentile(&hist, 500)),
+		      cycles_to_us(sys_latency_percentile(&hist, 900)),
+		      cycles_to_us(sys_latency_percentile(&hist, 990)),
+		      cycles_to_us(sys_latency_percentile(&hist, 999)));
+
+	for (int i = 0; i < SYS_LATENCY_BUCKETS; i++) {
+		if (hist.buckets[i] == 0U) {
+			continue;
+		}
+
+		upper = (i == SYS_LATENCY_BUCKETS - 1) ?
+			UINT32_MAX : (u32_t)((1ULL << i) - 1);
+		shell_fprintf(shell, SHELL_NORMAL, "  <= %10u cycles: %u\n",
+			      upper, hist.buckets[i]);
+	}
+
+	for (int i = 0; i < CONFIG_LATENCY_STATS_SITES; i++) {
+		if (hist.sites[i].site == NULL) {
+			break;
+		}
+
+		shell_fprintf(shell, SHELL_NORMAL,
+			      "  site %p: %u samples, max %u us\n",
+			      hist.sites[i].site, hist.sites[i].count,
+			      cycles_to_us(hist.sites[i].max));
+	}
+}
+
+static int cmd_kernel_latency_show(const struct shell *shell,
+				   size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	for (int i = 0; i < SYS_LATENCY_TYPES; i++) {
+		shell_latency_dump(shell, i);
+	}
+
+	return 0;
+}
+
+static int cmd_kernel_latency_reset(const struct shell *shell,
+				    size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	sys_latency_reset();
+	shell_fprintf(shell, SHELL_NORMAL, "Latency histograms cleared\n");
+
+	return 0;
+}
+
+SHELL_CREATE_STATIC_SUBCMD_SET(sub_kernel_latency)
+{
+	/* Alphabetically sorted. */
+	SHELL_CMD(reset, NULL, "Clear latency histograms.",
+		  cmd_kernel_latency_reset),
+	SHELL_CMD(show, NULL, "Show latency histograms.",
+		  cmd_kernel_latency_show),
+	SHELL_SUBCMD_SET_END /* Array terminated. */
+};
+#endif
+
 #if defined(CONFIG_REBOOT)
 static int cmd_kernel_reboot_warm(const struct shell *shell,
 				  size_t argc, char **argv)
@@ -155,9 +386,20 @@ SHELL_CREATE_STATIC_SUBCMD_SET(sub_kernel)
 {
 	/* Alphabetically sorted. */
 	SHELL_CMD(cycles, NULL, "Kernel cycles.", cmd_kernel_cycles),
+#if defined(CONFIG_LATENCY_STATS)
+	SHELL_CMD(latency, &sub_kernel_latency, "Latency histograms.", NULL),
+#endif
+#if defined(CONFIG_OBJECT_STATS)
+	SHELL_CMD(objects, NULL, "List kernel objects usage statistics.",
+		  cmd_kernel_objects),
+#endif
 #if defined(CONFIG_REBOOT)
 	SHELL_CMD(reboot, &sub_kernel_reboot, "Reboot.", NULL),
 #endif
+#if defined(CONFIG_THREAD_MONITOR) && defined(CONFIG_THREAD_RUNTIME_STATS)
+	SHELL_CMD(runtime, NULL, "List threads execution time.",
+		  cmd_kernel_runtime),
+#endif
 #if defined(CONFIG_INIT_STACKS) && defined(CONFIG_THREAD_MONITOR) \
 				&& defined(CONFIG_THREAD_STACK_INFO)
 	SHELL_CMD(stacks, NULL, "List threads stack usage.", cmd_kernel_stacks),
@@ -224,6 +224,13 @@ static const struct shell_static_entry *find_cmd(
 	const struct shell_static_entry *entry = NULL;
 	size_t idx = 0;
 
+	if (lvl == SHELL_CMD_ROOT_LVL) {
+		const struct shell_cmd_entry *root_cmd;
+
+		root_cmd = shell_root_cmd_find(cmd_str);
+		return root_cmd ? root_cmd->u.entry : NULL;
+	}
+
 	do {
 		shell_cmd_get(cmd, lvl, idx++, &entry, d_entry);
 		if (entry && (strcmp(cmd_str, entry->syntax) == 0)) {
@@ -349,6 +356,23 @@ static void find_completion_candidates(const struct shell_static_entry *cmd,
 	*longest = 0U;
 	*cnt = 0;
 
+	/* Root commands are sorted, only the matching range is scanned. */
+	if (cmd == NULL) {
+		*cnt = shell_root_cmd_prefix_find(incompl_cmd, incompl_cmd_len,
+						  first_idx);
+
+		for (idx = *first_idx; idx < *first_idx + *cnt; idx++) {
+			size_t slen;
+
+			shell_cmd_get(NULL, SHELL_CMD_ROOT_LVL, idx,
+				      &candidate, &dynamic_entry);
+			slen = strlen(candidate->syntax);
+			*longest = (slen > *longest) ? slen : *longest;
+		}
+
+		return;
+	}
+
 	while (true) {
 		shell_cmd_get(cmd ? cmd->subcmd : NULL, cmd ? 1 : 0,
 			      idx, &candidate, &dynamic_entry);
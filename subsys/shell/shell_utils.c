@@ -224,14 +224,36 @@ static inline u32_t shell_root_cmd_count(void)
 				sizeof(struct shell_cmd_entry);
 }
 
+/* Root commands are placed in sections named after their syntax and the
+ * linker sorts them by name, so they can be searched with bisection.
+ */
+static size_t root_cmd_lower_bound(const char *str, size_t len)
+{
+	size_t lo = 0;
+	size_t hi = shell_root_cmd_count();
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		const char *syntax = shell_root_cmd_get(mid)->u.entry->syntax;
+
+		if (strncmp(syntax, str, len) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
 /* Function returning pointer to root command matching requested syntax. */
 const struct shell_cmd_entry *shell_root_cmd_find(const char *syntax)
 {
-	const size_t cmd_count = shell_root_cmd_count();
+	size_t idx = root_cmd_lower_bound(syntax, SIZE_MAX);
 	const struct shell_cmd_entry *cmd;
 
-	for (size_t cmd_idx = 0; cmd_idx < cmd_count; ++cmd_idx) {
-		cmd = shell_root_cmd_get(cmd_idx);
+	if (idx < shell_root_cmd_count()) {
+		cmd = shell_root_cmd_get(idx);
 		if (strcmp(syntax, cmd->u.entry->syntax) == 0) {
 			return cmd;
 		}
@@ -240,6 +262,35 @@ const struct shell_cmd_entry *shell_root_cmd_find(const char *syntax)
 	return NULL;
 }
 
+size_t shell_root_cmd_prefix_find(const char *prefix, size_t len,
+				  size_t *first_idx)
+{
+	size_t lo;
+	size_t hi = shell_root_cmd_count();
+
+	if (len == 0) {
+		*first_idx = 0;
+		return hi;
+	}
+
+	lo = root_cmd_lower_bound(prefix, len);
+	*first_idx = lo;
+
+	/* Matching commands are contiguous, find the end of the range. */
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		const char *syntax = shell_root_cmd_get(mid)->u.entry->syntax;
+
+		if (strncmp(syntax, prefix, len) == 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo - *first_idx;
+}
+
 void shell_cmd_get(const struct shell_cmd_entry *command, size_t lvl,
 		   size_t idx, const struct shell_static_entry **entry,
 		   struct shell_static_entry *d_entry)
@@ -66,6 +66,12 @@ int shell_command_add(char *buff, u16_t *buff_len,
 
 const struct shell_cmd_entry *shell_root_cmd_find(const char *syntax);
 
+/* Function returning number of root commands starting with given prefix.
+ * Index of the first one is written to first_idx.
+ */
+size_t shell_root_cmd_prefix_find(const char *prefix, size_t len,
+				  size_t *first_idx);
+
 void shell_spaces_trim(char *str);
 
 static inline void transport_buffer_flush(const struct shell *shell)
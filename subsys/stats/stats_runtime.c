@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <kernel.h>
+#include <init.h>
+#include <stats.h>
+
+/* CPU execution time from the kernel runtime statistics, in cycles of
+ * k_cycle_get_32(). Values are summed over all CPUs and refreshed
+ * periodically, utilization is the busy to total ratio between two reads.
+ */
+STATS_SECT_START(cpu_stats)
+STATS_SECT_ENTRY64(total)
+STATS_SECT_ENTRY64(busy)
+STATS_SECT_ENTRY64(idle)
+STATS_SECT_ENTRY64(freq)
+STATS_SECT_END;
+
+STATS_NAME_START(cpu_stats)
+STATS_NAME(cpu_stats, total)
+STATS_NAME(cpu_stats, busy)
+STATS_NAME(cpu_stats, idle)
+STATS_NAME(cpu_stats, freq)
+STATS_NAME_END(cpu_stats);
+
+static STATS_SECT_DECL(cpu_stats) cpu_stats;
+
+static struct k_delayed_work update_work;
+
+static void cpu_stats_update(struct k_work *work)
+{
+	struct k_cpu_runtime_stats stats;
+
+	ARG_UNUSED(work);
+
+	k_cpu_runtime_stats_all_get(&stats);
+
+	cpu_stats.total = stats.total_cycles;
+	cpu_stats.busy = stats.total_cycles - stats.idle_cycles;
+	cpu_stats.idle = stats.idle_cycles;
+	cpu_stats.freq = sys_clock_hw_cycles_per_sec();
+
+	k_delayed_work_submit(&update_work,
+			      CONFIG_STATS_CPU_RUNTIME_INTERVAL);
+}
+
+static int cpu_stats_init(struct device *dev)
+{
+	int err;
+
+	ARG_UNUSED(dev);
+
+	err = STATS_INIT_AND_REG(cpu_stats, STATS_SIZE_64, "cpu");
+	if (err) {
+		return err;
+	}
+
+	k_delayed_work_init(&update_work, cpu_stats_update);
+	cpu_stats_update(NULL);
+
+	return 0;
+}
+
+SYS_INIT(cpu_stats_init, APPLICATION, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
@@ -34,6 +34,8 @@ struct driver_map_entry {
 static const struct driver_map_entry  flash_drivers_map[] = {
 #ifdef DT_FLASH_DEV_NAME /* SoC embedded flash driver */
 	{SOC_FLASH_0_ID, DT_FLASH_DEV_NAME},
+#elif defined(CONFIG_FLASH_SIMULATOR) /* Simulated flash stands in for it */
+	{SOC_FLASH_0_ID, CONFIG_FLASH_SIMULATOR_DEV_NAME},
 #endif
 #ifdef CONFIG_SPI_FLASH_W25QXXDV
 	{SPI_FLASH_0_ID, CONFIG_SPI_FLASH_W25QXXDV_DRV_NAME},
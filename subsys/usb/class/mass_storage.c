@@ -58,6 +58,7 @@ LOG_MODULE_REGISTER(usb_msc);
 #define THREAD_OP_READ_QUEUED		1
 #define THREAD_OP_WRITE_QUEUED		3
 #define THREAD_OP_WRITE_DONE		4
+#define THREAD_OP_SYNC_QUEUED		5
 
 #define MASS_STORAGE_IN_EP_ADDR		0x82
 #define MASS_STORAGE_OUT_EP_ADDR	0x01
@@ -577,6 +578,11 @@ static void CBWDecode(u8_t *buf, u16_t size)
 				}
 			}
 			break;
+		case SYNCHRONIZE_CACHE10:
+			LOG_DBG(">> SYNC_CACHE10");
+			thread_op = THREAD_OP_SYNC_QUEUED;
+			k_sem_give(&disk_wait_sem);
+			break;
 		case MEDIA_REMOVAL:
 			LOG_DBG(">> MEDIA_REMOVAL");
 			csw.Status = CSW_PASSED;
@@ -886,8 +892,28 @@ static void mass_thread_main(int arg1, int unused)
 				LOG_ERR("!!!!! Disk Write Error %d !!!!!",
 					addr/BLOCK_SIZE);
 			}
+
+			/* the command completes with data on the medium */
+			if (((length == defered_wr_sz) ||
+			     (stage != PROCESS_CBW)) &&
+			    disk_access_ioctl(disk_pdrv,
+					      DISK_IOCTL_CTRL_SYNC, NULL)) {
+				LOG_ERR("!!!!! Disk Sync Error !!!!!");
+			}
+
 			thread_memory_write_done();
 			break;
+		case THREAD_OP_SYNC_QUEUED:
+			if (disk_access_ioctl(disk_pdrv,
+					      DISK_IOCTL_CTRL_SYNC, NULL)) {
+				LOG_ERR("!! Disk Sync Error !");
+				csw.Status = CSW_FAILED;
+			} else {
+				csw.Status = CSW_PASSED;
+			}
+
+			sendCSW();
+			break;
 		default:
 			LOG_ERR("XXXXXX thread_op  %d ! XXXXX", thread_op);
 		}
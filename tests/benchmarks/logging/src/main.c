@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Logger throughput benchmark
+ *
+ * Several threads and a timer interrupt log concurrently. Each round measures
+ * the time needed by the threads to issue their log calls, messages are
+ * processed once all threads are done.
+ */
+
+#include <zephyr.h>
+#include <tc_util.h>
+#include <logging/log.h>
+#include <logging/log_backend.h>
+#include <logging/log_ctrl.h>
+
+LOG_MODULE_REGISTER(bench, LOG_LEVEL_INF);
+
+#define THREADS 4
+#define CALLS_PER_THREAD 100
+#define YIELD_PERIOD 8
+#define ISR_CALLS_MAX 64
+#define ROUNDS 10
+#define STACK_SIZE 1024
+#define THREAD_PRIO 5
+
+static atomic_t received;
+static atomic_t isr_calls;
+
+static K_THREAD_STACK_ARRAY_DEFINE(stacks, THREADS, STACK_SIZE);
+static struct k_thread threads[THREADS];
+static K_SEM_DEFINE(done_sem, 0, THREADS);
+
+static void put(const struct log_backend *const backend,
+		struct log_msg *msg)
+{
+	log_msg_get(msg);
+	atomic_inc(&received);
+	log_msg_put(msg);
+}
+
+static void panic(struct log_backend const *const backend)
+{
+	ARG_UNUSED(backend);
+}
+
+const struct log_backend_api log_backend_count_api = {
+	.put = put,
+	.panic = panic,
+};
+
+LOG_BACKEND_DEFINE(backend_count, log_backend_count_api, false);
+
+static void timer_handler(struct k_timer *timer)
+{
+	for (int i = 0; i < 4; i++) {
+		if (atomic_inc(&isr_calls) >= ISR_CALLS_MAX) {
+			atomic_dec(&isr_calls);
+			return;
+		}
+
+		LOG_INF("isr %d %d", i, (u32_t)timer);
+	}
+}
+
+static K_TIMER_DEFINE(timer, timer_handler, NULL);
+
+/* Threads exercise standard, log_strdup() and hexdump messages. */
+static void producer(void *p1, void *p2, void *p3)
+{
+	int id = (int)p1;
+	char str[] = "transient";
+	u8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+	for (int i = 0; i < CALLS_PER_THREAD; i++) {
+		switch (id % 4) {
+		case 2:
+			LOG_INF("thread %d: %s", id, log_strdup(str));
+			break;
+		case 3:
+			LOG_HEXDUMP_INF(data, sizeof(data), "hexdump");
+			break;
+		default:
+			LOG_INF("thread %d call %d", id, i);
+			break;
+		}
+
+		if ((i % YIELD_PERIOD) == (YIELD_PERIOD - 1)) {
+			k_yield();
+		}
+	}
+
+	k_sem_give(&done_sem);
+}
+
+static u32_t round_run(int round, u32_t *cycles)
+{
+	u32_t start;
+	u32_t calls;
+
+	atomic_clear(&isr_calls);
+
+	start = k_cycle_get_32();
+	k_timer_start(&timer, K_MSEC(1), K_MSEC(1));
+
+	for (int i = 0; i < THREADS; i++) {
+		k_thread_create(&threads[i], stacks[i], STACK_SIZE, producer,
+				(void *)i, NULL, NULL, THREAD_PRIO, 0,
+				K_NO_WAIT);
+	}
+
+	for (int i = 0; i < THREADS; i++) {
+		k_sem_take(&done_sem, K_FOREVER);
+	}
+
+	*cycles = k_cycle_get_32() - start;
+	k_timer_stop(&timer);
+
+	calls = THREADS * CALLS_PER_THREAD + atomic_get(&isr_calls);
+
+	while (log_process(false)) {
+	}
+
+	TC_PRINT("Round %2d: %u calls in %u cycles, %u calls/s\n", round,
+		 calls, *cycles,
+		 (u32_t)(((u64_t)calls * sys_clock_hw_cycles_per_sec()) /
+			 *cycles));
+
+	return calls;
+}
+
+void main(void)
+{
+	u64_t total_cycles = 0;
+	u32_t total_calls = 0;
+	u32_t cycles;
+
+	TC_START("Logging benchmark");
+	TC_PRINT("%d threads, timer interrupt, %s queue\n", THREADS,
+		 IS_ENABLED(CONFIG_LOG_LOCKLESS) ? "lock-free" : "locked");
+
+	log_backend_enable(&backend_count, NULL, LOG_LEVEL_DBG);
+
+	for (int round = 0; round < ROUNDS; round++) {
+		total_calls += round_run(round, &cycles);
+		total_cycles += cycles;
+	}
+
+	TC_PRINT("Average: %u calls/s, %u messages lost\n",
+		 (u32_t)(((u64_t)total_calls * sys_clock_hw_cycles_per_sec()) /
+			 total_cycles),
+		 total_calls - (u32_t)atomic_get(&received));
+
+	TC_END_REPORT(atomic_get(&received) == total_calls ?
+		      TC_PASS : TC_FAIL);
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <flash.h>
+#include <stats.h>
+#include <string.h>
+
+#define SECTOR_SIZE CONFIG_FLASH_SIMULATOR_SECTOR_SIZE
+#define SECTOR_COUNT CONFIG_FLASH_SIMULATOR_SECTOR_COUNT
+#define WRITE_BLOCK_SIZE CONFIG_FLASH_SIMULATOR_WRITE_BLOCK_SIZE
+#define ERASE_VALUE CONFIG_FLASH_SIMULATOR_ERASE_VALUE
+
+/* Sector used by the tests which is erased before every test. */
+#define TEST_OFFSET SECTOR_SIZE
+
+static struct device *flash_dev;
+static u8_t buf[SECTOR_SIZE];
+
+static void erase_test_sector(void)
+{
+	int rc;
+
+	rc = flash_write_protection_set(flash_dev, false);
+	zassert_equal(rc, 0, "disabling write protection failed");
+
+	rc = flash_erase(flash_dev, TEST_OFFSET, SECTOR_SIZE);
+	zassert_equal(rc, 0, "erase failed");
+}
+
+static void test_erased_read(void)
+{
+	erase_test_sector();
+
+	zassert_equal(flash_read(flash_dev, TEST_OFFSET, buf, sizeof(buf)), 0,
+		      "read failed");
+
+	for (int i = 0; i < sizeof(buf); i++) {
+		zassert_equal(buf[i], ERASE_VALUE, "byte %d not erased", i);
+	}
+}
+
+static void test_write_read(void)
+{
+	u8_t data[4 * WRITE_BLOCK_SIZE];
+	u8_t rd[sizeof(data)];
+
+	erase_test_sector();
+
+	for (int i = 0; i < sizeof(data); i++) {
+		data[i] = i;
+	}
+
+	zassert_equal(flash_write(flash_dev, TEST_OFFSET, data, sizeof(data)),
+		      0, "write failed");
+	zassert_equal(flash_read(flash_dev, TEST_OFFSET, rd, sizeof(rd)), 0,
+		      "read failed");
+	zassert_mem_equal(rd, data, sizeof(data), "read back wrong data");
+}
+
+static void test_invalid_access(void)
+{
+	u8_t data[WRITE_BLOCK_SIZE] = { 0 };
+
+	erase_test_sector();
+
+	if (WRITE_BLOCK_SIZE > 1) {
+		zassert_equal(flash_write(flash_dev, TEST_OFFSET + 1, data,
+					  sizeof(data)),
+			      -EINVAL, "unaligned write accepted");
+	}
+
+	zassert_equal(flash_read(flash_dev, SECTOR_SIZE * SECTOR_COUNT, data,
+				 sizeof(data)),
+		      -EINVAL, "read past the end accepted");
+	zassert_equal(flash_erase(flash_dev, TEST_OFFSET + 1, SECTOR_SIZE),
+		      -EINVAL, "unaligned erase accepted");
+	zassert_equal(flash_erase(flash_dev, TEST_OFFSET, SECTOR_SIZE - 1),
+		      -EINVAL, "partial sector erase accepted");
+}
+
+static void test_write_protection(void)
+{
+	u8_t data[WRITE_BLOCK_SIZE] = { 0 };
+
+	erase_test_sector();
+
+	zassert_equal(flash_write_protection_set(flash_dev, true), 0,
+		      "enabling write protection failed");
+	zassert_equal(flash_write(flash_dev, TEST_OFFSET, data, sizeof(data)),
+		      -EACCES, "protected write accepted");
+	zassert_equal(flash_erase(flash_dev, TEST_OFFSET, SECTOR_SIZE),
+		      -EACCES, "protected erase accepted");
+}
+
+static void test_double_write(void)
+{
+	u8_t data[WRITE_BLOCK_SIZE];
+	int rc;
+
+	erase_test_sector();
+
+	(void)memset(data, 0x55, sizeof(data));
+	zassert_equal(flash_write(flash_dev, TEST_OFFSET, data, sizeof(data)),
+		      0, "write failed");
+
+	rc = flash_write(flash_dev, TEST_OFFSET, data, sizeof(data));
+	if (IS_ENABLED(CONFIG_FLASH_SIMULATOR_DOUBLE_WRITES)) {
+		zassert_equal(rc, 0, "double write rejected");
+	} else {
+		zassert_equal(rc, -EIO, "double write accepted");
+	}
+}
+
+static void test_page_layout(void)
+{
+	struct flash_pages_info info;
+
+	zassert_equal(flash_get_page_count(flash_dev), SECTOR_COUNT,
+		      "wrong page count");
+	zassert_equal(flash_get_page_info_by_offs(flash_dev,
+						  TEST_OFFSET + 1, &info),
+		      0, "page info failed");
+	zassert_equal(info.start_offset, TEST_OFFSET, "wrong page start");
+	zassert_equal(info.size, SECTOR_SIZE, "wrong page size");
+	zassert_equal(info.index, TEST_OFFSET / SECTOR_SIZE,
+		      "wrong page index");
+}
+
+struct wear_walk {
+	const char *name;
+	u32_t value;
+};
+
+static int wear_walk_cb(struct stats_hdr *hdr, void *arg, const char *name,
+			uint16_t off)
+{
+	struct wear_walk *walk = arg;
+
+	if (strcmp(name, walk->name) == 0) {
+		walk->value = *(u32_t *)((u8_t *)hdr + off);
+		return 1;
+	}
+
+	return 0;
+}
+
+static u32_t sector_erase_cycles(const char *name)
+{
+	struct stats_hdr *hdr = stats_group_find("flash_sim_wear");
+	struct wear_walk walk = { .name = name };
+
+	zassert_not_null(hdr, "wear statistics not registered");
+	zassert_not_equal(stats_walk(hdr, wear_walk_cb, &walk), 0,
+			  "no wear entry %s", name);
+
+	return walk.value;
+}
+
+static void test_wear_stats(void)
+{
+	u32_t before;
+
+	if (!IS_ENABLED(CONFIG_FLASH_SIMULATOR_STATS)) {
+		ztest_test_skip();
+	}
+
+	before = sector_erase_cycles("s1");
+
+	erase_test_sector();
+	erase_test_sector();
+
+	zassert_equal(sector_erase_cycles("s1"), before + 2,
+		      "erase cycles not counted");
+}
+
+void test_main(void)
+{
+	flash_dev = device_get_binding(CONFIG_FLASH_SIMULATOR_DEV_NAME);
+
+	ztest_test_suite(flash_simulator,
+			 ztest_unit_test(test_erased_read),
+			 ztest_unit_test(test_write_read),
+			 ztest_unit_test(test_invalid_access),
+			 ztest_unit_test(test_write_protection),
+			 ztest_unit_test(test_double_write),
+			 ztest_unit_test(test_page_layout),
+			 ztest_unit_test(test_wear_stats));
+	ztest_run_test_suite(flash_simulator);
+}
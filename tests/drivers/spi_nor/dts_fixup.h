@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* SPI NOR flash on the emulated SPI bus of native_posix */
+
+#define DT_SPI_NOR_DRV_NAME		"SPI_NOR"
+#define DT_SPI_NOR_SPI_NAME		CONFIG_SPI_EMUL_DRV_NAME
+#define DT_SPI_NOR_SPI_SLAVE_ID		0
+#define DT_SPI_NOR_SPI_FREQ_0		80000000
+
+#define DT_SPI_NOR_SIZE			CONFIG_SPI_EMUL_NOR_SIZE
+#define FLASH_ERASE_BLOCK_SIZE		4096
+#define FLASH_WRITE_BLOCK_SIZE		1
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SPI NOR flash driver on the emulated SPI bus. Besides correctness, the
+ * read and write throughput is reported in bus time at the configured SPI
+ * frequency, together with the number of SPI transactions, which do not
+ * depend on the platform.
+ */
+
+#include <ztest.h>
+#include <flash.h>
+#include <stats.h>
+#include <string.h>
+#include <generated_dts_board.h>
+
+#define FLASH_SIZE CONFIG_SPI_EMUL_NOR_SIZE
+#define SECTOR_SIZE 4096
+#define CHUNK_SIZE 4096
+#define PERF_SIZE (256 * 1024)
+
+/* Both sides of the 16 MiB boundary of 3-byte addresses */
+#define LOW_OFFSET 0x800000
+#define HIGH_OFFSET (LOW_OFFSET + 0x1000000)
+
+static struct device *flash_dev;
+static u8_t wr_buf[CHUNK_SIZE];
+static u8_t rd_buf[CHUNK_SIZE];
+
+struct stat_walk {
+	const char *name;
+	u64_t value;
+};
+
+struct perf_sample {
+	u32_t ms;
+	u32_t transactions;
+	u32_t bytes;
+};
+
+static int stat_walk_cb(struct stats_hdr *hdr, void *arg, const char *name,
+			uint16_t off)
+{
+	struct stat_walk *walk = arg;
+
+	if (strcmp(name, walk->name) == 0) {
+		walk->value = *(u64_t *)((u8_t *)hdr + off);
+		return 1;
+	}
+
+	return 0;
+}
+
+static u32_t bus_stat(const char *name)
+{
+	struct stats_hdr *hdr = stats_group_find("spi_emul");
+	struct stat_walk walk = { .name = name };
+
+	zassert_not_null(hdr, "bus statistics not registered");
+	zassert_not_equal(stats_walk(hdr, stat_walk_cb, &walk), 0,
+			  "no %s counter", name);
+
+	return walk.value;
+}
+
+static void fill_pattern(u8_t *buf, size_t len, u32_t off)
+{
+	for (size_t i = 0; i < len; i++) {
+		buf[i] = (off + i) ^ ((off + i) >> 8);
+	}
+}
+
+static void sample_start(struct perf_sample *sample)
+{
+	sample->transactions = bus_stat("transactions");
+	sample->bytes = bus_stat("bytes");
+	sample->ms = k_uptime_get_32();
+}
+
+static void sample_end(struct perf_sample *sample, const char *name,
+		       u32_t bytes)
+{
+	sample->ms = k_uptime_get_32() - sample->ms;
+	sample->transactions = bus_stat("transactions") - sample->transactions;
+	sample->bytes = bus_stat("bytes") - sample->bytes;
+
+	TC_PRINT("%s: %u bytes in %u ms", name, bytes, sample->ms);
+	if (sample->ms) {
+		TC_PRINT(" (%u KiB/s)",
+			 bytes * MSEC_PER_SEC / 1024 / sample->ms);
+	}
+	TC_PRINT(", %u transactions, %u bytes on the bus\n",
+		 sample->transactions, sample->bytes);
+}
+
+static void flash_erase_range(off_t off, size_t len)
+{
+	zassert_equal(flash_write_protection_set(flash_dev, false), 0,
+		      "disabling write protection failed");
+	zassert_equal(flash_erase(flash_dev, off, len), 0, "erase failed");
+}
+
+static void check_erased(off_t off, size_t len)
+{
+	zassert_equal(flash_read(flash_dev, off, rd_buf, len), 0,
+		      "read failed");
+	for (size_t i = 0; i < len; i++) {
+		zassert_equal(rd_buf[i], 0xFF, "byte %u not erased", off + i);
+	}
+}
+
+static void test_init(void)
+{
+	const struct flash_pages_layout *layout;
+	size_t layout_size;
+	const struct flash_driver_api *api;
+
+	flash_dev = device_get_binding(DT_SPI_NOR_DRV_NAME);
+	zassert_not_null(flash_dev, "no flash device");
+
+	api = flash_dev->driver_api;
+	api->page_layout(flash_dev, &layout, &layout_size);
+	zassert_equal(layout_size, 1, "wrong layout");
+	zassert_equal(layout->pages_size * layout->pages_count, FLASH_SIZE,
+		      "wrong flash size");
+}
+
+/* Programs are split at page boundaries, reads return any length */
+static void test_unaligned_write(void)
+{
+	off_t off = SECTOR_SIZE + 100;
+	size_t len = 1000;
+
+	flash_erase_range(SECTOR_SIZE, SECTOR_SIZE);
+
+	fill_pattern(wr_buf, len, off);
+	zassert_equal(flash_write(flash_dev, off, wr_buf, len), 0,
+		      "write failed");
+
+	zassert_equal(flash_read(flash_dev, off, rd_buf, len), 0,
+		      "read failed");
+	zassert_mem_equal(rd_buf, wr_buf, len, "wrong data");
+
+	check_erased(SECTOR_SIZE, 100);
+	check_erased(off + len, 16);
+}
+
+/* The largest erase instruction which fits is used */
+static void test_erase_selection(void)
+{
+	u32_t erases = bus_stat("erases");
+
+	/* 64 KiB, 32 KiB and 4 KiB blocks */
+	flash_erase_range(0x10000, 0x19000);
+	zassert_equal(bus_stat("erases") - erases, 3,
+		      "unexpected number of erase instructions");
+
+	/* a misaligned start is erased in sectors up to a 64 KiB boundary */
+	erases = bus_stat("erases");
+	flash_erase_range(0x3E000, 0x12000);
+	zassert_equal(bus_stat("erases") - erases, 3,
+		      "unexpected number of erase instructions");
+
+	zassert_not_equal(flash_erase(flash_dev, SECTOR_SIZE / 2, SECTOR_SIZE),
+			  0, "misaligned erase succeeded");
+}
+
+/* Flash above 16 MiB is addressed without aliasing the lower half */
+static void test_high_address(void)
+{
+	flash_erase_range(LOW_OFFSET, SECTOR_SIZE);
+	flash_erase_range(HIGH_OFFSET, SECTOR_SIZE);
+
+	fill_pattern(wr_buf, SECTOR_SIZE, HIGH_OFFSET);
+	zassert_equal(flash_write(flash_dev, HIGH_OFFSET, wr_buf, SECTOR_SIZE),
+		      0, "write failed");
+
+	zassert_equal(flash_read(flash_dev, HIGH_OFFSET, rd_buf, SECTOR_SIZE),
+		      0, "read failed");
+	zassert_mem_equal(rd_buf, wr_buf, SECTOR_SIZE, "wrong data");
+
+	check_erased(LOW_OFFSET, SECTOR_SIZE);
+}
+
+static void test_write_throughput(void)
+{
+	struct perf_sample sample;
+
+	flash_erase_range(0, PERF_SIZE);
+
+	sample_start(&sample);
+
+	for (u32_t off = 0; off < PERF_SIZE; off += CHUNK_SIZE) {
+		fill_pattern(wr_buf, CHUNK_SIZE, off);
+		zassert_equal(flash_write(flash_dev, off, wr_buf, CHUNK_SIZE),
+			      0, "write failed");
+	}
+
+	sample_end(&sample, "write", PERF_SIZE);
+}
+
+static void test_read_throughput(void)
+{
+	struct perf_sample sample;
+
+	sample_start(&sample);
+
+	for (u32_t off = 0; off < PERF_SIZE; off += CHUNK_SIZE) {
+		zassert_equal(flash_read(flash_dev, off, rd_buf, CHUNK_SIZE),
+			      0, "read failed");
+	}
+
+	sample_end(&sample, "read", PERF_SIZE);
+
+	/* one status poll and one read instruction per chunk */
+	zassert_true(sample.transactions <= 2 * PERF_SIZE / CHUNK_SIZE,
+		     "read split into several transactions");
+
+	for (u32_t off = 0; off < PERF_SIZE; off += CHUNK_SIZE) {
+		zassert_equal(flash_read(flash_dev, off, rd_buf, CHUNK_SIZE),
+			      0, "read failed");
+		fill_pattern(wr_buf, CHUNK_SIZE, off);
+		zassert_mem_equal(rd_buf, wr_buf, CHUNK_SIZE, "wrong data");
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(spi_nor,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_unaligned_write),
+			 ztest_unit_test(test_erase_selection),
+			 ztest_unit_test(test_high_address),
+			 ztest_unit_test(test_write_throughput),
+			 ztest_unit_test(test_read_throughput));
+	ztest_run_test_suite(spi_nor);
+}
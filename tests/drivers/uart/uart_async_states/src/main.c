@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @addtogroup t_driver_uart
+ * @{
+ * @defgroup t_uart_async_states test_uart_async_states
+ * @brief TestPurpose: check the asynchronous API without a loopback
+ * @details
+ * - Test Steps
+ *   -# Enable reception, provide the next buffer from the
+ *      UART_RX_BUF_REQUEST event and disable reception while no data
+ *      arrives.
+ *   -# Call the RX functions in states where they are not allowed.
+ *   -# Abort a transmission which has not finished and one which has.
+ * - Expected Results
+ *   -# Both buffers are released before UART_RX_DISABLED is reported.
+ *   -# The calls fail with the error codes documented in uart.h.
+ *   -# An unfinished transmission reports UART_TX_ABORTED with the number
+ *      of bytes sent, aborting a finished one fails with -EFAULT.
+ * @}
+ */
+
+#include <uart.h>
+#include <ztest.h>
+
+#define UART_DEVICE_NAME CONFIG_UART_CONSOLE_ON_DEV_NAME
+
+#define RX_BUF_SIZE 16
+#define RX_TIMEOUT 50
+#define MAX_EVENTS 8
+
+static struct device *dev;
+static u8_t rx_buf[2][RX_BUF_SIZE];
+static const u8_t tx_data[] = "async tx abort\r\n";
+
+static struct uart_event events[MAX_EVENTS];
+static int event_cnt;
+static bool buf_rsp;
+static int buf_rsp_err;
+
+static void uart_async_handler(struct uart_event *evt, void *user_data)
+{
+	if (event_cnt < MAX_EVENTS) {
+		events[event_cnt] = *evt;
+	}
+	event_cnt++;
+
+	if (evt->type == UART_RX_BUF_REQUEST && buf_rsp) {
+		buf_rsp = false;
+		buf_rsp_err = uart_rx_buf_rsp(dev, rx_buf[1], RX_BUF_SIZE);
+	}
+}
+
+static void events_reset(void)
+{
+	event_cnt = 0;
+	buf_rsp = false;
+	buf_rsp_err = 0;
+}
+
+/* Returns the number of recorded events of the given type */
+static int events_count(enum uart_event_type type)
+{
+	int cnt = 0;
+
+	for (int i = 0; i < min(event_cnt, MAX_EVENTS); i++) {
+		if (events[i].type == type) {
+			cnt++;
+		}
+	}
+
+	return cnt;
+}
+
+static void rx_disable_check(void)
+{
+	zassert_equal(uart_rx_disable(dev), 0, "uart_rx_disable failed");
+	k_sleep(RX_TIMEOUT);
+
+	zassert_true(event_cnt > 0 && event_cnt <= MAX_EVENTS,
+		     "wrong number of events");
+	zassert_equal(events[event_cnt - 1].type, UART_RX_DISABLED,
+		      "RX_DISABLED not reported last");
+	zassert_equal(events_count(UART_RX_DISABLED), 1,
+		      "RX_DISABLED not reported once");
+}
+
+static void test_setup(void)
+{
+	int err;
+
+	dev = device_get_binding(UART_DEVICE_NAME);
+	zassert_not_null(dev, "UART device not found");
+
+	err = uart_callback_set(dev, uart_async_handler, NULL);
+	if (err == -ENOTSUP) {
+		ztest_test_skip();
+		return;
+	}
+	zassert_equal(err, 0, "uart_callback_set failed");
+}
+
+/* The buffer given on UART_RX_BUF_REQUEST is released on disable */
+static void test_rx_buf_rsp(void)
+{
+	events_reset();
+	buf_rsp = true;
+
+	zassert_equal(uart_rx_enable(dev, rx_buf[0], RX_BUF_SIZE, RX_TIMEOUT),
+		      0, "uart_rx_enable failed");
+	k_sleep(RX_TIMEOUT);
+
+	zassert_equal(events_count(UART_RX_BUF_REQUEST), 1,
+		      "RX_BUF_REQUEST not reported");
+	zassert_equal(buf_rsp_err, 0, "uart_rx_buf_rsp failed");
+	zassert_equal(uart_rx_buf_rsp(dev, rx_buf[0], RX_BUF_SIZE), -EBUSY,
+		      "second next buffer accepted");
+	zassert_equal(uart_rx_enable(dev, rx_buf[0], RX_BUF_SIZE, RX_TIMEOUT),
+		      -EBUSY, "reception enabled twice");
+
+	rx_disable_check();
+
+	/* No data arrives on the idle line, the buffers are returned */
+	zassert_equal(events_count(UART_RX_BUF_RELEASED), 2,
+		      "buffers not released");
+	for (int i = 0; i < event_cnt; i++) {
+		if (events[i].type == UART_RX_BUF_RELEASED) {
+			zassert_true(events[i].data.rx_buf.buf == rx_buf[0] ||
+				     events[i].data.rx_buf.buf == rx_buf[1],
+				     "unknown buffer released");
+		}
+	}
+}
+
+/* Reception without a next buffer can be disabled and enabled again */
+static void test_rx_reenable(void)
+{
+	for (int i = 0; i < 2; i++) {
+		events_reset();
+
+		zassert_equal(uart_rx_enable(dev, rx_buf[i], RX_BUF_SIZE,
+					     RX_TIMEOUT),
+			      0, "uart_rx_enable failed");
+		k_sleep(RX_TIMEOUT);
+
+		rx_disable_check();
+		zassert_equal(events_count(UART_RX_BUF_RELEASED), 1,
+			      "buffer not released");
+		zassert_equal(events[event_cnt - 2].type, UART_RX_BUF_RELEASED,
+			      "buffer not released before disabling");
+		zassert_equal_ptr(events[event_cnt - 2].data.rx_buf.buf,
+				  rx_buf[i], "wrong buffer released");
+	}
+}
+
+/* RX calls are refused while reception is disabled */
+static void test_rx_disabled(void)
+{
+	events_reset();
+
+	zassert_equal(uart_rx_buf_rsp(dev, rx_buf[0], RX_BUF_SIZE), -EACCES,
+		      "buffer accepted while disabled");
+	zassert_equal(uart_rx_disable(dev), -EFAULT,
+		      "disabled reception disabled again");
+	zassert_equal(event_cnt, 0, "event reported");
+}
+
+/* Aborting reports the bytes sent so far, or fails when TX is done */
+static void test_tx_abort(void)
+{
+	size_t len = sizeof(tx_data) - 1;
+	int err;
+
+	events_reset();
+
+	zassert_equal(uart_tx_abort(dev), -EFAULT, "idle TX aborted");
+
+	/* Keep drivers which transmit from a work item from starting */
+	k_sched_lock();
+	zassert_equal(uart_tx(dev, tx_data, len, K_FOREVER), 0,
+		      "uart_tx failed");
+	err = uart_tx_abort(dev);
+	k_sched_unlock();
+	k_sleep(RX_TIMEOUT);
+
+	zassert_equal(event_cnt, 1, "wrong number of events");
+	zassert_equal_ptr(events[0].data.tx.buf, tx_data, "wrong buffer");
+
+	if (err == 0) {
+		zassert_equal(events[0].type, UART_TX_ABORTED,
+			      "TX_ABORTED not reported");
+		zassert_true(events[0].data.tx.len <= len,
+			     "wrong length reported");
+	} else {
+		zassert_equal(err, -EFAULT, "uart_tx_abort failed");
+		zassert_equal(events[0].type, UART_TX_DONE,
+			      "TX_DONE not reported");
+		zassert_equal(events[0].data.tx.len, len,
+			      "wrong length reported");
+	}
+
+	/* A finished transmission cannot be aborted */
+	events_reset();
+	zassert_equal(uart_tx(dev, tx_data, len, K_FOREVER), 0,
+		      "uart_tx failed");
+	k_sleep(RX_TIMEOUT);
+	zassert_equal(uart_tx_abort(dev), -EFAULT, "finished TX aborted");
+	zassert_equal(event_cnt, 1, "wrong number of events");
+	zassert_equal(events[0].type, UART_TX_DONE, "TX_DONE not reported");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(uart_async_states_test,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_rx_buf_rsp),
+			 ztest_unit_test(test_rx_reenable),
+			 ztest_unit_test(test_rx_disabled),
+			 ztest_unit_test(test_tx_abort));
+	ztest_run_test_suite(uart_async_states_test);
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @addtogroup t_driver_uart
+ * @{
+ * @defgroup t_uart_throughput test_uart_throughput
+ * @brief TestPurpose: compare UART transmission modes
+ * @details
+ * - Test Steps
+ *   -# Send the same block of data using uart_poll_out() for every byte,
+ *      using uart_fifo_fill() from the TX interrupt
+ *      (CONFIG_UART_INTERRUPT_DRIVEN) and using uart_tx()
+ *      (CONFIG_UART_ASYNC_API).
+ *   -# Measure total transmission time and the time the sending thread
+ *      spends in the driver.
+ * - Expected Results
+ *   -# Whole block is transmitted in every mode supported by the
+ *      configuration, results are printed for comparison.
+ * @}
+ */
+
+#include <uart.h>
+#include <ztest.h>
+
+#define UART_DEVICE_NAME CONFIG_UART_CONSOLE_ON_DEV_NAME
+
+#define LINE_LEN 64
+#define DATA_SIZE (16 * LINE_LEN)
+
+/* Whole block at 9600 baud with a margin. */
+#define TX_TIMEOUT K_SECONDS(3)
+
+static u8_t data[DATA_SIZE];
+static K_SEM_DEFINE(tx_done, 0, 1);
+
+struct result {
+	u32_t total;	/* Cycles until the whole block was transmitted */
+	u32_t busy;	/* Cycles the sending thread spent in the driver */
+};
+
+static void data_init(void)
+{
+	for (int i = 0; i < DATA_SIZE; i++) {
+		if (i % LINE_LEN == LINE_LEN - 2) {
+			data[i] = '\r';
+		} else if (i % LINE_LEN == LINE_LEN - 1) {
+			data[i] = '\n';
+		} else {
+			data[i] = 'a' + (i % 26);
+		}
+	}
+}
+
+static void result_print(const char *mode, struct result *res)
+{
+	u32_t total_us = SYS_CLOCK_HW_CYCLES_TO_NS(res->total) / 1000;
+	u32_t busy_us = SYS_CLOCK_HW_CYCLES_TO_NS(res->busy) / 1000;
+
+	TC_PRINT("%s: %d bytes in %u us (%u B/s), thread busy %u us\n",
+		 mode, DATA_SIZE, total_us,
+		 total_us ? (u32_t)((u64_t)DATA_SIZE * USEC_PER_SEC / total_us)
+			  : 0,
+		 busy_us);
+}
+
+void test_uart_throughput_poll(void)
+{
+	struct device *dev = device_get_binding(UART_DEVICE_NAME);
+	struct result res;
+	u32_t start;
+
+	zassert_not_null(dev, "UART device not found");
+	data_init();
+
+	start = k_cycle_get_32();
+	for (int i = 0; i < DATA_SIZE; i++) {
+		uart_poll_out(dev, data[i]);
+	}
+	res.total = k_cycle_get_32() - start;
+	res.busy = res.total;
+
+	result_print("poll", &res);
+}
+
+#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+static volatile int tx_cnt;
+
+static void uart_irq_handler(struct device *dev)
+{
+	uart_irq_update(dev);
+
+	if (!uart_irq_tx_ready(dev)) {
+		return;
+	}
+
+	if (tx_cnt < DATA_SIZE) {
+		tx_cnt += uart_fifo_fill(dev, &data[tx_cnt],
+					 DATA_SIZE - tx_cnt);
+	} else if (uart_irq_tx_complete(dev)) {
+		uart_irq_tx_disable(dev);
+		k_sem_give(&tx_done);
+	}
+}
+
+void test_uart_throughput_irq(void)
+{
+	struct device *dev = device_get_binding(UART_DEVICE_NAME);
+	struct result res;
+	u32_t start;
+
+	zassert_not_null(dev, "UART device not found");
+	data_init();
+	tx_cnt = 0;
+
+	uart_irq_callback_set(dev, uart_irq_handler);
+
+	start = k_cycle_get_32();
+	uart_irq_tx_enable(dev);
+	res.busy = k_cycle_get_32() - start;
+
+	zassert_equal(k_sem_take(&tx_done, TX_TIMEOUT), 0, "TX timeout");
+	res.total = k_cycle_get_32() - start;
+	zassert_equal(tx_cnt, DATA_SIZE, "Data not transmitted");
+
+	result_print("irq", &res);
+}
+#else
+void test_uart_throughput_irq(void)
+{
+	ztest_test_skip();
+}
+#endif /* CONFIG_UART_INTERRUPT_DRIVEN */
+
+#ifdef CONFIG_UART_ASYNC_API
+static size_t tx_len;
+
+static void uart_async_handler(struct uart_event *evt, void *user_data)
+{
+	if (evt->type == UART_TX_DONE || evt->type == UART_TX_ABORTED) {
+		tx_len = evt->data.tx.len;
+		k_sem_give(&tx_done);
+	}
+}
+
+void test_uart_throughput_async(void)
+{
+	struct device *dev = device_get_binding(UART_DEVICE_NAME);
+	struct result res;
+	u32_t start;
+	int err;
+
+	zassert_not_null(dev, "UART device not found");
+	data_init();
+	tx_len = 0;
+
+	err = uart_callback_set(dev, uart_async_handler, NULL);
+	if (err == -ENOTSUP) {
+		ztest_test_skip();
+		return;
+	}
+
+	start = k_cycle_get_32();
+	err = uart_tx(dev, data, DATA_SIZE, K_FOREVER);
+	res.busy = k_cycle_get_32() - start;
+	zassert_equal(err, 0, "uart_tx failed");
+
+	zassert_equal(k_sem_take(&tx_done, TX_TIMEOUT), 0, "TX timeout");
+	res.total = k_cycle_get_32() - start;
+	zassert_equal(tx_len, DATA_SIZE, "Data not transmitted");
+
+	result_print("async", &res);
+}
+#else
+void test_uart_throughput_async(void)
+{
+	ztest_test_skip();
+}
+#endif /* CONFIG_UART_ASYNC_API */
+
+void test_main(void)
+{
+	ztest_test_suite(uart_throughput_test,
+			 ztest_unit_test(test_uart_throughput_poll),
+			 ztest_unit_test(test_uart_throughput_irq),
+			 ztest_unit_test(test_uart_throughput_async));
+	ztest_run_test_suite(uart_throughput_test);
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <irq_offload.h>
+#include <debug/latency_stats.h>
+
+#define STACK_SIZE (512 + CONFIG_TEST_EXTRA_STACKSIZE)
+#define BUSY_US 2000
+
+static K_THREAD_STACK_DEFINE(waiter_stack, STACK_SIZE);
+static struct k_thread waiter_thread;
+static K_SEM_DEFINE(wakeup_sem, 0, 1);
+static struct sys_latency_hist hist;
+
+static u32_t us_to_cycles(u32_t us)
+{
+	return (u64_t)us * sys_clock_hw_cycles_per_sec() / USEC_PER_SEC;
+}
+
+/* Longest sample is always kept with its site. */
+static void check_site(const struct sys_latency_hist *h)
+{
+	for (int i = 0; i < CONFIG_LATENCY_STATS_SITES; i++) {
+		if (h->sites[i].max == h->max) {
+			zassert_not_null(h->sites[i].site, NULL);
+			return;
+		}
+	}
+
+	zassert_unreachable("longest sample has no site");
+}
+
+/**
+ * @brief Test percentiles of a histogram
+ *
+ * @see sys_latency_percentile()
+ */
+void test_latency_percentile(void)
+{
+	struct sys_latency_hist h = { 0 };
+
+	zassert_equal(sys_latency_percentile(&h, 990), 0, NULL);
+
+	h.buckets[1] = 90;	/* 1 cycle */
+	h.buckets[5] = 9;	/* 16 - 31 cycles */
+	h.buckets[10] = 1;	/* 512 - 1023 cycles */
+	h.count = 100;
+	h.max = 600;
+
+	zassert_equal(sys_latency_percentile(&h, 500), 1, NULL);
+	zassert_equal(sys_latency_percentile(&h, 900), 1, NULL);
+	zassert_equal(sys_latency_percentile(&h, 990), 31, NULL);
+	zassert_equal(sys_latency_percentile(&h, 999), 600, NULL);
+	zassert_equal(sys_latency_percentile(&h, 1000), 600, NULL);
+}
+
+/**
+ * @brief Test that interrupt locked sections are recorded
+ *
+ * @see irq_lock(), sys_latency_get(), sys_latency_reset()
+ */
+void test_latency_irq_locked(void)
+{
+	unsigned int key, nested;
+
+	sys_latency_reset();
+	sys_latency_get(SYS_LATENCY_IRQ_LOCKED, &hist);
+	zassert_equal(hist.max, 0, "histogram not cleared");
+
+	key = irq_lock();
+	nested = irq_lock();
+	k_busy_wait(BUSY_US);
+	irq_unlock(nested);
+	k_busy_wait(BUSY_US);
+	irq_unlock(key);
+
+	/* Section is measured from the outermost lock. */
+	sys_latency_get(SYS_LATENCY_IRQ_LOCKED, &hist);
+	zassert_true(hist.count >= 1, NULL);
+	zassert_true(hist.max >= us_to_cycles(2 * BUSY_US),
+		     "locked section not recorded");
+	check_site(&hist);
+}
+
+/**
+ * @brief Test that scheduler lock hold time is recorded
+ *
+ * @see k_sched_lock(), k_sched_unlock()
+ */
+void test_latency_sched_locked(void)
+{
+	sys_latency_reset();
+
+	k_sched_lock();
+	k_busy_wait(BUSY_US);
+	k_sched_unlock();
+
+	sys_latency_get(SYS_LATENCY_SCHED_LOCKED, &hist);
+	zassert_equal(hist.count, 1, NULL);
+	zassert_true(hist.max >= us_to_cycles(BUSY_US),
+		     "scheduler lock not recorded");
+	check_site(&hist);
+}
+
+static void waiter_entry(void *p1, void *p2, void *p3)
+{
+	k_sem_take(&wakeup_sem, K_FOREVER);
+}
+
+static void wakeup_isr(void *arg)
+{
+	k_sem_give(&wakeup_sem);
+}
+
+/**
+ * @brief Test that wakeup of a thread from an ISR is recorded
+ *
+ * @see k_sem_give()
+ */
+void test_latency_thread_wakeup(void)
+{
+	k_thread_create(&waiter_thread, waiter_stack, STACK_SIZE,
+			waiter_entry, NULL, NULL, NULL,
+			K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
+	k_sleep(10);
+
+	sys_latency_reset();
+
+	/* Waiter runs only when this cooperative thread sleeps. */
+	irq_offload(wakeup_isr, NULL);
+	k_busy_wait(BUSY_US);
+	k_sleep(10);
+
+	sys_latency_get(SYS_LATENCY_THREAD_WAKEUP, &hist);
+	zassert_true(hist.count >= 1, NULL);
+	zassert_true(hist.max >= us_to_cycles(BUSY_US),
+		     "wakeup not recorded");
+	check_site(&hist);
+
+	k_thread_abort(&waiter_thread);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(latency_stats,
+			 ztest_unit_test(test_latency_percentile),
+			 ztest_unit_test(test_latency_irq_locked),
+			 ztest_unit_test(test_latency_sched_locked),
+			 ztest_unit_test(test_latency_thread_wakeup));
+	ztest_run_test_suite(latency_stats);
+}
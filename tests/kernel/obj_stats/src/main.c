@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <debug/object_tracing.h>
+
+#define STACK_SIZE (512 + CONFIG_TEST_EXTRA_STACKSIZE)
+#define WAIT_MS 20
+
+static K_THREAD_STACK_DEFINE(helper_stack, STACK_SIZE);
+static struct k_thread helper_thread;
+
+K_SEM_DEFINE(static_sem, 0, 1);
+
+static struct k_sem sem;
+static struct k_mutex mutex;
+static struct k_fifo fifo;
+static struct k_msgq msgq;
+static struct k_mem_slab slab;
+
+static char __aligned(4) msgq_buf[2 * sizeof(u32_t)];
+static char __aligned(4) slab_buf[2 * 8];
+
+static u32_t ms_to_cycles(u32_t ms)
+{
+	return (u64_t)ms * sys_clock_hw_cycles_per_sec() / MSEC_PER_SEC;
+}
+
+static void sem_give_entry(void *p1, void *p2, void *p3)
+{
+	k_sleep(WAIT_MS);
+	k_sem_give(&sem);
+}
+
+/**
+ * @brief Test semaphore take, give, failed and blocked counts
+ *
+ * @see k_sem_take(), k_sem_give()
+ */
+void test_obj_stats_sem(void)
+{
+	struct k_obj_stats *stats = SYS_TRACING_STATS(&sem);
+
+	k_sem_init(&sem, 0, 2);
+
+	k_sem_give(&sem);
+	k_sem_give(&sem);
+	zassert_equal(k_sem_take(&sem, K_NO_WAIT), 0, NULL);
+	zassert_equal(k_sem_take(&sem, K_NO_WAIT), 0, NULL);
+	zassert_equal(k_sem_take(&sem, K_NO_WAIT), -EBUSY, NULL);
+
+	zassert_equal(stats->gives, 2, NULL);
+	zassert_equal(stats->takes, 2, NULL);
+	zassert_equal(stats->failed, 1, NULL);
+	zassert_equal(stats->blocked, 0, NULL);
+
+	/* Timed out wait is blocked and failed. */
+	zassert_equal(k_sem_take(&sem, WAIT_MS), -EAGAIN, NULL);
+	zassert_equal(stats->blocked, 1, NULL);
+	zassert_equal(stats->failed, 2, NULL);
+	zassert_true(stats->wait_max >= ms_to_cycles(WAIT_MS - 1),
+		     "wait time not recorded");
+
+	/* Successful wait is blocked and taken. */
+	k_thread_create(&helper_thread, helper_stack, STACK_SIZE,
+			sem_give_entry, NULL, NULL, NULL,
+			K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
+	zassert_equal(k_sem_take(&sem, K_FOREVER), 0, NULL);
+	zassert_equal(stats->blocked, 2, NULL);
+	zassert_equal(stats->takes, 3, NULL);
+	zassert_equal(stats->gives, 3, NULL);
+	zassert_true(stats->wait_total >= 2 * ms_to_cycles(WAIT_MS - 1),
+		     "wait time not accumulated");
+
+	k_thread_abort(&helper_thread);
+}
+
+/**
+ * @brief Test mutex hold time
+ *
+ * @see k_mutex_lock(), k_mutex_unlock()
+ */
+void test_obj_stats_mutex(void)
+{
+	struct k_obj_stats *stats = SYS_TRACING_STATS(&mutex);
+
+	k_mutex_init(&mutex);
+
+	zassert_equal(k_mutex_lock(&mutex, K_NO_WAIT), 0, NULL);
+	/* Recursive locking does not restart the hold time. */
+	zassert_equal(k_mutex_lock(&mutex, K_NO_WAIT), 0, NULL);
+	k_busy_wait(WAIT_MS * USEC_PER_MSEC);
+	k_mutex_unlock(&mutex);
+	k_mutex_unlock(&mutex);
+
+	zassert_equal(stats->takes, 2, NULL);
+	zassert_equal(stats->gives, 2, NULL);
+	zassert_true(stats->hold_max >= ms_to_cycles(WAIT_MS),
+		     "hold time not recorded");
+	zassert_equal(stats->hold_total, stats->hold_max, NULL);
+}
+
+/**
+ * @brief Test FIFO, message queue and memory slab counts
+ *
+ * @see k_fifo_get(), k_msgq_put(), k_mem_slab_alloc()
+ */
+void test_obj_stats_data(void)
+{
+	struct k_obj_stats *stats;
+	static u32_t item[2];
+	u32_t msg = 0;
+	void *block;
+
+	k_fifo_init(&fifo);
+	stats = SYS_TRACING_STATS(&fifo._queue);
+	k_fifo_put(&fifo, item);
+	zassert_equal_ptr(k_fifo_get(&fifo, K_NO_WAIT), item, NULL);
+	zassert_is_null(k_fifo_get(&fifo, K_NO_WAIT), NULL);
+	zassert_equal(stats->gives, 1, NULL);
+	zassert_equal(stats->takes, 1, NULL);
+	zassert_equal(stats->failed, 1, NULL);
+
+	k_msgq_init(&msgq, msgq_buf, sizeof(u32_t), 2);
+	stats = SYS_TRACING_STATS(&msgq);
+	zassert_equal(k_msgq_put(&msgq, &msg, K_NO_WAIT), 0, NULL);
+	zassert_equal(k_msgq_put(&msgq, &msg, K_NO_WAIT), 0, NULL);
+	zassert_equal(k_msgq_put(&msgq, &msg, WAIT_MS), -EAGAIN, NULL);
+	zassert_equal(k_msgq_get(&msgq, &msg, K_NO_WAIT), 0, NULL);
+	zassert_equal(stats->gives, 2, NULL);
+	zassert_equal(stats->takes, 1, NULL);
+	zassert_equal(stats->blocked, 1, NULL);
+	zassert_equal(stats->failed, 1, NULL);
+
+	k_mem_slab_init(&slab, slab_buf, 8, 2);
+	stats = SYS_TRACING_STATS(&slab);
+	zassert_equal(k_mem_slab_alloc(&slab, &block, K_NO_WAIT), 0, NULL);
+	k_mem_slab_free(&slab, &block);
+	zassert_equal(stats->takes, 1, NULL);
+	zassert_equal(stats->gives, 1, NULL);
+}
+
+/**
+ * @brief Test that statically defined objects are listed with statistics
+ *
+ * @see SYS_TRACING_STATS()
+ */
+void test_obj_stats_list(void)
+{
+	struct k_sem *obj = SYS_TRACING_HEAD(struct k_sem, k_sem);
+
+	k_sem_give(&static_sem);
+
+	while (obj != NULL && obj != &static_sem) {
+		obj = SYS_TRACING_NEXT(struct k_sem, k_sem, obj);
+	}
+
+	zassert_equal_ptr(obj, &static_sem, "semaphore not listed");
+	zassert_equal(SYS_TRACING_STATS(obj)->gives, 1, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(obj_stats,
+			 ztest_unit_test(test_obj_stats_sem),
+			 ztest_unit_test(test_obj_stats_mutex),
+			 ztest_unit_test(test_obj_stats_data),
+			 ztest_unit_test(test_obj_stats_list));
+	ztest_run_test_suite(obj_stats);
+}
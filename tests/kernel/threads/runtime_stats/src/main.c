@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+
+#define STACK_SIZE (512 + CONFIG_TEST_EXTRA_STACKSIZE)
+#define BUSY_MS 50
+
+static K_THREAD_STACK_DEFINE(busy_stack, STACK_SIZE);
+static struct k_thread busy_thread;
+
+static u32_t ms_to_cycles(u32_t ms)
+{
+	return (u64_t)ms * sys_clock_hw_cycles_per_sec() / MSEC_PER_SEC;
+}
+
+static void busy_entry(void *p1, void *p2, void *p3)
+{
+	k_busy_wait(BUSY_MS * USEC_PER_MSEC);
+}
+
+/**
+ * @brief Test that a running thread is accounted
+ *
+ * @see k_thread_runtime_stats_get()
+ */
+void test_thread_runtime_stats(void)
+{
+	struct k_thread_runtime_stats before, after;
+
+	zassert_equal(k_thread_runtime_stats_get(NULL, &before), -EINVAL, NULL);
+	zassert_equal(k_thread_runtime_stats_get(k_current_get(), NULL),
+		      -EINVAL, NULL);
+
+	k_thread_runtime_stats_get(k_current_get(), &before);
+	k_busy_wait(BUSY_MS * USEC_PER_MSEC);
+	k_thread_runtime_stats_get(k_current_get(), &after);
+
+	/* Cycles of the running thread are included before switch out. */
+	zassert_true(after.execution_cycles - before.execution_cycles >=
+		     ms_to_cycles(BUSY_MS), "busy wait not accounted");
+
+	k_thread_runtime_stats_get(k_current_get(), &before);
+	k_sleep(BUSY_MS);
+	k_thread_runtime_stats_get(k_current_get(), &after);
+
+	zassert_true(after.execution_cycles - before.execution_cycles <
+		     ms_to_cycles(BUSY_MS), "sleep accounted to the thread");
+}
+
+/**
+ * @brief Test that another thread is accounted separately
+ *
+ * @see k_thread_runtime_stats_get()
+ */
+void test_thread_runtime_stats_other(void)
+{
+	struct k_thread_runtime_stats self_before, self_after, stats;
+	k_tid_t tid;
+
+	k_thread_runtime_stats_get(k_current_get(), &self_before);
+
+	tid = k_thread_create(&busy_thread, busy_stack, STACK_SIZE,
+			      busy_entry, NULL, NULL, NULL,
+			      K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
+	k_thread_runtime_stats_get(tid, &stats);
+	zassert_equal(stats.execution_cycles, 0, "new thread has run");
+
+	/* Busy thread runs while the test thread sleeps. */
+	k_sleep(BUSY_MS * 2);
+	k_thread_abort(tid);
+
+	k_thread_runtime_stats_get(tid, &stats);
+	k_thread_runtime_stats_get(k_current_get(), &self_after);
+
+	zassert_true(stats.execution_cycles >= ms_to_cycles(BUSY_MS),
+		     "busy thread not accounted");
+	zassert_true(self_after.execution_cycles -
+		     self_before.execution_cycles < ms_to_cycles(BUSY_MS),
+		     "busy thread accounted to the test thread");
+}
+
+/**
+ * @brief Test CPU totals and idle time
+ *
+ * @see k_cpu_runtime_stats_get(), k_cpu_runtime_stats_all_get()
+ */
+void test_cpu_runtime_stats(void)
+{
+	struct k_cpu_runtime_stats before, after, all;
+
+	zassert_equal(k_cpu_runtime_stats_get(-1, &before), -EINVAL, NULL);
+	zassert_equal(k_cpu_runtime_stats_get(CONFIG_MP_NUM_CPUS, &before),
+		      -EINVAL, NULL);
+	zassert_equal(k_cpu_runtime_stats_get(0, NULL), -EINVAL, NULL);
+
+	k_cpu_runtime_stats_get(0, &before);
+	k_sleep(BUSY_MS);
+	k_cpu_runtime_stats_get(0, &after);
+
+	zassert_true(after.total_cycles - before.total_cycles >=
+		     ms_to_cycles(BUSY_MS), "total not accounted");
+	zassert_true(after.idle_cycles - before.idle_cycles > 0,
+		     "idle not accounted");
+	zassert_true(after.idle_cycles <= after.total_cycles, NULL);
+
+	k_cpu_runtime_stats_all_get(&all);
+	zassert_true(all.total_cycles >= after.total_cycles, NULL);
+	zassert_true(all.idle_cycles >= after.idle_cycles, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(runtime_stats,
+			 ztest_unit_test(test_thread_runtime_stats),
+			 ztest_unit_test(test_thread_runtime_stats_other),
+			 ztest_unit_test(test_cpu_runtime_stats));
+	ztest_run_test_suite(runtime_stats);
+}
@@ -409,6 +409,216 @@ static void test_json_key_not_in_descr(void)
 	zassert_equal(ret, 0, "No items should be decoded");
 }
 
+struct many_fields {
+	int f00, f01, f02, f03, f04, f05, f06, f07, f08, f09;
+	int f10, f11, f12, f13, f14, f15, f16, f17, f18, f19;
+	int f20, f21, f22, f23, f24, f25, f26, f27, f28, f29;
+	int f30, f31, f32, f33, f34, f35, f36, f37, f38, f39;
+};
+
+#define MANY_FIELD(n) JSON_OBJ_DESCR_PRIM(struct many_fields, n, \
+					  JSON_TOK_NUMBER)
+
+static const struct json_obj_descr many_fields_descr[] = {
+	MANY_FIELD(f00), MANY_FIELD(f01), MANY_FIELD(f02), MANY_FIELD(f03),
+	MANY_FIELD(f04), MANY_FIELD(f05), MANY_FIELD(f06), MANY_FIELD(f07),
+	MANY_FIELD(f08), MANY_FIELD(f09), MANY_FIELD(f10), MANY_FIELD(f11),
+	MANY_FIELD(f12), MANY_FIELD(f13), MANY_FIELD(f14), MANY_FIELD(f15),
+	MANY_FIELD(f16), MANY_FIELD(f17), MANY_FIELD(f18), MANY_FIELD(f19),
+	MANY_FIELD(f20), MANY_FIELD(f21), MANY_FIELD(f22), MANY_FIELD(f23),
+	MANY_FIELD(f24), MANY_FIELD(f25), MANY_FIELD(f26), MANY_FIELD(f27),
+	MANY_FIELD(f28), MANY_FIELD(f29), MANY_FIELD(f30), MANY_FIELD(f31),
+	MANY_FIELD(f32), MANY_FIELD(f33), MANY_FIELD(f34), MANY_FIELD(f35),
+	MANY_FIELD(f36), MANY_FIELD(f37), MANY_FIELD(f38), MANY_FIELD(f39),
+};
+
+static void test_json_decoding_many_fields(void)
+{
+	struct many_fields mf;
+	char encoded[] = "{\"f39\":39,\"f00\":0,\"f01\":1,\"f02\":2,"
+		"\"f03\":3,\"f04\":4,\"f05\":5,\"f06\":6,\"f07\":7,"
+		"\"f08\":8,\"f09\":9,\"f10\":10,\"f11\":11,\"f12\":12,"
+		"\"f13\":13,\"f14\":14,\"f15\":15,\"f16\":16,\"f17\":17,"
+		"\"f18\":18,\"f19\":19,\"f20\":20,\"f21\":21,\"f22\":22,"
+		"\"f23\":23,\"f24\":24,\"f25\":25,\"f26\":26,\"f27\":27,"
+		"\"f28\":28,\"f29\":29,\"f30\":30,\"f31\":31,\"f32\":32,"
+		"\"f33\":33,\"f34\":34,\"f35\":35,\"f36\":36,\"f38\":38,"
+		"\"f37\":37}";
+	const int *field = &mf.f00;
+	s64_t ret;
+	int i;
+
+	ret = json_obj_parse(encoded, sizeof(encoded) - 1, many_fields_descr,
+			     ARRAY_SIZE(many_fields_descr), &mf);
+	zassert_equal(ret, ((s64_t)1 << ARRAY_SIZE(many_fields_descr)) - 1,
+		      "All fields decoded correctly");
+
+	for (i = 0; i < ARRAY_SIZE(many_fields_descr); i++) {
+		zassert_equal(field[i], i, "Field decoded correctly");
+	}
+}
+
+static void test_json_stream_decoding(void)
+{
+	char encoded[] = "{\"some_string\":\"zephyr \\\"123\\\"\","
+		"\"unknown\":{\"a\":[1,{\"b\":null},\"c\"],\"d\":-1.5},"
+		"\"some_int\":-42,"
+		"\"some_bool\":true,"
+		"\"some_nested_struct\":{\"nested_int\":1234,"
+		"\"nested_bool\":false,\"nested_string\":\"\\u00e9\"},"
+		"\"some_array\":[11, 22,\n33],"
+		"\"another_b!@l\":true,"
+		"\"if\":false,"
+		"\"another-array\":[],"
+		"\"4nother_ne$+\":{\"nested_int\":2147483647,"
+		"\"nested_bool\":true,\"nested_string\":\"\"}"
+		"}";
+	const int expected_array[] = { 11, 22, 33 };
+	const size_t len = sizeof(encoded) - 1;
+	struct json_stream_parser parser;
+	struct test_struct ts;
+	char strings[32];
+	size_t chunk, pos;
+	s64_t ret;
+
+	/* The outcome must not depend on how the input is split */
+	for (chunk = 1; chunk <= len; chunk++) {
+		memset(&ts, 0, sizeof(ts));
+		json_stream_parser_init(&parser, test_descr,
+					ARRAY_SIZE(test_descr), &ts,
+					strings, sizeof(strings));
+
+		for (pos = 0; pos < len; pos += chunk) {
+			ret = json_stream_parse(&parser, encoded + pos,
+						min(chunk, len - pos));
+			zassert_equal(ret, 0, "Chunk parsed correctly");
+		}
+
+		ret = json_stream_parser_finish(&parser);
+		zassert_equal(ret, (1 << ARRAY_SIZE(test_descr)) - 1,
+			      "All fields decoded correctly");
+
+		zassert_true(!strcmp(ts.some_string, "zephyr \\\"123\\\""),
+			     "String decoded correctly");
+		zassert_equal(ts.some_int, -42,
+			      "Negative integer decoded correctly");
+		zassert_true(ts.some_bool, "Boolean decoded correctly");
+		zassert_equal(ts.some_nested_struct.nested_int, 1234,
+			      "Nested integer decoded correctly");
+		zassert_false(ts.some_nested_struct.nested_bool,
+			      "Nested boolean decoded correctly");
+		zassert_true(!strcmp(ts.some_nested_struct.nested_string,
+				     "\\u00e9"),
+			     "Nested string decoded correctly");
+		zassert_equal(ts.some_array_len, 3,
+			      "Array has correct number of items");
+		zassert_true(!memcmp(ts.some_array, expected_array,
+				     sizeof(expected_array)),
+			     "Array decoded with expected values");
+		zassert_true(ts.another_bxxl,
+			     "Named boolean decoded correctly");
+		zassert_false(ts.if_, "Named boolean decoded correctly");
+		zassert_equal(ts.another_array_len, 0,
+			      "Empty named array decoded correctly");
+		zassert_equal(ts.xnother_nexx.nested_int, 2147483647,
+			      "Largest integer decoded correctly");
+		zassert_true(ts.xnother_nexx.nested_bool,
+			     "Named nested boolean decoded correctly");
+		zassert_true(!strcmp(ts.xnother_nexx.nested_string, ""),
+			     "Empty string decoded correctly");
+	}
+}
+
+static s64_t stream_parse_all(char *encoded, char *strings,
+			      size_t strings_size)
+{
+	struct json_stream_parser parser;
+	struct test_struct ts;
+	int ret;
+
+	json_stream_parser_init(&parser, test_descr, ARRAY_SIZE(test_descr),
+				&ts, strings, strings_size);
+
+	ret = json_stream_parse(&parser, encoded, strlen(encoded));
+	if (ret < 0) {
+		zassert_equal(json_stream_parse(&parser, "}", 1), ret,
+			      "Errors are sticky");
+	}
+
+	return json_stream_parser_finish(&parser);
+}
+
+static void test_json_stream_errors(void)
+{
+	char strings[8];
+
+	zassert_equal(stream_parse_all("{\"some_int\":42", strings,
+				       sizeof(strings)),
+		      -EINVAL, "Truncated document rejected");
+	zassert_equal(stream_parse_all("{\"some_string\":\"too long\"}",
+				       strings, sizeof(strings)),
+		      -ENOMEM, "String buffer overflow detected");
+	zassert_equal(stream_parse_all("{\"some_int\":\"42\"}", strings,
+				       sizeof(strings)),
+		      -EINVAL, "Wrong type rejected");
+	zassert_equal(stream_parse_all("{\"some_int\":2147483648}", strings,
+				       sizeof(strings)),
+		      -ERANGE, "Integer overflow detected");
+	zassert_equal(stream_parse_all("{\"another-array\":"
+				       "[1,2,3,4,5,6,7,8,9,10,11]}",
+				       strings, sizeof(strings)),
+		      -ENOSPC, "Array overflow detected");
+	zassert_equal(stream_parse_all("{\"some_int\":1,}", strings,
+				       sizeof(strings)),
+		      -EINVAL, "Trailing comma rejected");
+	zassert_equal(stream_parse_all("{\"some_string\":\"\\x\"}", strings,
+				       sizeof(strings)),
+		      -EINVAL, "Invalid escape rejected");
+}
+
+struct chunk_sink {
+	char buf[128];
+	size_t used;
+	bool short_chunk;
+};
+
+static int append_chunk(const char *bytes, size_t len, void *data)
+{
+	struct chunk_sink *sink = data;
+
+	zassert_false(sink->short_chunk, "Only the last chunk may be short");
+	zassert_true(len <= sizeof(sink->buf) - sink->used,
+		     "Output fits in the sink");
+
+	sink->short_chunk = len != 7;
+	memcpy(sink->buf + sink->used, bytes, len);
+	sink->used += len;
+
+	return 0;
+}
+
+static void test_json_obj_encode_chunked(void)
+{
+	struct test_nested nested = {
+		.nested_int = -1234,
+		.nested_bool = true,
+		.nested_string = "this should be escaped: \t",
+	};
+	char encoded[] = "{\"nested_int\":-1234,\"nested_bool\":true,"
+		"\"nested_string\":\"this should be escaped: \\t\"}";
+	struct chunk_sink sink = { .used = 0 };
+	char chunk[7];
+	int ret;
+
+	ret = json_obj_encode_chunked(nested_descr, ARRAY_SIZE(nested_descr),
+				      &nested, chunk, sizeof(chunk),
+				      append_chunk, &sink);
+	zassert_equal(ret, 0, "Encoding function returned no errors");
+	zassert_equal(sink.used, sizeof(encoded) - 1, "Encoded length correct");
+	zassert_true(!memcmp(sink.buf, encoded, sink.used),
+		     "Encoded contents consistent");
+}
+
 static void test_json_escape(void)
 {
 	char buf[42];
@@ -507,6 +717,10 @@ void test_main(void)
 			 ztest_unit_test(test_json_wrong_token),
 			 ztest_unit_test(test_json_item_wrong_type),
 			 ztest_unit_test(test_json_key_not_in_descr),
+			 ztest_unit_test(test_json_decoding_many_fields),
+			 ztest_unit_test(test_json_stream_decoding),
+			 ztest_unit_test(test_json_stream_errors),
+			 ztest_unit_test(test_json_obj_encode_chunked),
 			 ztest_unit_test(test_json_escape),
 			 ztest_unit_test(test_json_escape_one),
 			 ztest_unit_test(test_json_escape_empty),
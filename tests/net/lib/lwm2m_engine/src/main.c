@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Pre-resolved resource handles and the observer index of the LwM2M
+ * engine. Observers are registered by the test itself, playing the LwM2M
+ * server over a loopback UDP socket.
+ */
+
+#include <ztest.h>
+#include <misc/byteorder.h>
+#include <net/socket.h>
+#include <net/coap.h>
+#include <net/lwm2m.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_engine.h"
+
+#define PEER_ADDR	CONFIG_NET_CONFIG_MY_IPV6_ADDR
+#define SERVER_PORT	5684
+#define CLIENT_PORT	CONFIG_LWM2M_LOCAL_PORT
+
+#define WAIT_MS		1000
+
+#define TEMP_INST	"3303/0"
+#define SENSOR_VALUE	"3303/0/5700"
+#define UNITS		"3303/0/5701"
+#define BATTERY_LEVEL	"3/0/9"
+#define MEMORY_FREE	"3/0/10"
+
+#define OBSERVE_REGISTER	0
+#define OBSERVE_DEREGISTER	1
+
+static struct lwm2m_ctx client;
+static struct sockaddr_in6 client_addr;
+static int server_sock = -1;
+static u16_t next_mid;
+
+/*
+ * Sends a confirmable GET with an Observe option for path, returns the
+ * code of the piggybacked response.
+ */
+static u8_t server_observe(const char *path, u8_t token, u8_t observe)
+{
+	struct pollfd pfd = {
+		.fd = server_sock,
+		.events = POLLIN,
+	};
+	u8_t req[32];
+	u8_t rsp[128];
+	u16_t mid = ++next_mid;
+	u8_t delta = COAP_OPTION_URI_PATH - COAP_OPTION_OBSERVE;
+	size_t len = 0;
+	ssize_t ret;
+
+	req[len++] = 0x40 | (COAP_TYPE_CON << 4) | sizeof(token);
+	req[len++] = COAP_METHOD_GET;
+	sys_put_be16(mid, &req[len]);
+	len += sizeof(mid);
+	req[len++] = token;
+	req[len++] = (COAP_OPTION_OBSERVE << 4) | sizeof(observe);
+	req[len++] = observe;
+
+	while (*path) {
+		size_t seg_len = strcspn(path, "/");
+
+		zassert_true(seg_len < 13 && len + 1 + seg_len <= sizeof(req),
+			     "path too long");
+		req[len++] = (delta << 4) | seg_len;
+		memcpy(&req[len], path, seg_len);
+		len += seg_len;
+		delta = 0;
+
+		path += seg_len;
+		if (*path == '/') {
+			path++;
+		}
+	}
+
+	zassert_equal(sendto(server_sock, req, len, 0,
+			     (struct sockaddr *)&client_addr,
+			     sizeof(client_addr)),
+		      len, "request not sent");
+
+	/* skip notifications the engine sends in the meantime */
+	while (true) {
+		zassert_true(poll(&pfd, 1, WAIT_MS) > 0, "no response");
+
+		ret = recv(server_sock, rsp, sizeof(rsp), 0);
+		zassert_true(ret >= 4, "response too short");
+
+		if (((rsp[0] >> 4) & 0x03) == COAP_TYPE_ACK &&
+		    sys_get_be16(&rsp[2]) == mid) {
+			break;
+		}
+	}
+
+	zassert_equal(rsp[0] & 0x0F, sizeof(token), "wrong token length");
+	zassert_equal(rsp[4], token, "wrong token");
+
+	return rsp[1];
+}
+
+static void observe(const char *path, u8_t token)
+{
+	zassert_equal(server_observe(path, token, OBSERVE_REGISTER),
+		      COAP_RESPONSE_CODE_CONTENT, "observe %s failed", path);
+}
+
+static void observe_cancel(const char *path, u8_t token)
+{
+	zassert_equal(server_observe(path, token, OBSERVE_DEREGISTER),
+		      COAP_RESPONSE_CODE_CONTENT, "cancel %s failed", path);
+}
+
+/*
+ * The observer index lets a write skip the observer list only when the
+ * full scan would not find a matching observer either.
+ */
+static void check_index(const struct lwm2m_res_handle *handle,
+			int observers)
+{
+	bool indexed = handle->res->observer_count ||
+		       handle->obj_inst->observer_count;
+
+	zassert_equal(lwm2m_notify_observer(handle->obj_id,
+					    handle->obj_inst_id,
+					    handle->res_id),
+		      observers, "wrong number of observers");
+	zassert_equal(indexed, observers > 0, "observer index out of sync");
+}
+
+static void test_setup(void)
+{
+	struct sockaddr_in6 server_addr = {
+		.sin6_family = AF_INET6,
+		.sin6_port = htons(SERVER_PORT),
+	};
+
+	zassert_equal(lwm2m_engine_create_obj_inst(TEMP_INST), 0,
+		      "instance not created");
+
+	client_addr.sin6_family = AF_INET6;
+	client_addr.sin6_port = htons(CLIENT_PORT);
+	zassert_equal(inet_pton(AF_INET6, PEER_ADDR, &client_addr.sin6_addr),
+		      1, "wrong address");
+	server_addr.sin6_addr = client_addr.sin6_addr;
+
+	server_sock = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(server_sock >= 0, "no socket");
+	zassert_equal(bind(server_sock, (struct sockaddr *)&server_addr,
+			   sizeof(server_addr)),
+		      0, "bind failed");
+
+	client.net_init_timeout = K_SECONDS(5);
+	client.net_timeout = K_SECONDS(5);
+	zassert_equal(lwm2m_engine_start(&client, PEER_ADDR, SERVER_PORT), 0,
+		      "engine not started");
+}
+
+/* Handles access the same data as the path based functions */
+static void test_handle_set_get(void)
+{
+	struct lwm2m_res_handle battery, memory, sensor, units;
+	float32_value_t temp = { .val1 = 21, .val2 = 500000 };
+	float32_value_t temp_out;
+	char str[8];
+	u8_t u8_out;
+	s32_t s32_out;
+
+	zassert_equal(lwm2m_engine_get_res_handle(BATTERY_LEVEL, &battery), 0,
+		      "handle not resolved");
+	zassert_equal(lwm2m_engine_get_res_handle(MEMORY_FREE, &memory), 0,
+		      "handle not resolved");
+	zassert_equal(lwm2m_engine_get_res_handle(SENSOR_VALUE, &sensor), 0,
+		      "handle not resolved");
+	zassert_equal(lwm2m_engine_get_res_handle(UNITS, &units), 0,
+		      "handle not resolved");
+
+	zassert_equal(lwm2m_engine_handle_set_u8(&battery, 87), 0,
+		      "set failed");
+	zassert_equal(lwm2m_engine_get_u8(BATTERY_LEVEL, &u8_out), 0,
+		      "get failed");
+	zassert_equal(u8_out, 87, "wrong value");
+
+	zassert_equal(lwm2m_engine_set_s32(MEMORY_FREE, 15), 0, "set failed");
+	zassert_equal(lwm2m_engine_handle_get_s32(&memory, &s32_out), 0,
+		      "get failed");
+	zassert_equal(s32_out, 15, "wrong value");
+
+	zassert_equal(lwm2m_engine_handle_set_float32(&sensor, &temp), 0,
+		      "set failed");
+	zassert_equal(lwm2m_engine_get_float32(SENSOR_VALUE, &temp_out), 0,
+		      "get failed");
+	zassert_equal(temp_out.val1, temp.val1, "wrong value");
+	zassert_equal(temp_out.val2, temp.val2, "wrong value");
+
+	zassert_equal(lwm2m_engine_handle_set_string(&units, "Cel"), 0,
+		      "set failed");
+	zassert_equal(lwm2m_engine_handle_get_string(&units, str, sizeof(str)),
+		      0, "get failed");
+	zassert_equal(strcmp(str, "Cel"), 0, "wrong value");
+
+	/* strings which do not fit are refused */
+	zassert_equal(lwm2m_engine_handle_set_string(&units,
+			"far too long for the units"), -ENOMEM,
+		      "long string accepted");
+}
+
+/* Paths which do not name an existing resource give no handle */
+static void test_handle_invalid(void)
+{
+	struct lwm2m_res_handle handle;
+	u8_t value;
+
+	zassert_equal(lwm2m_engine_get_res_handle(TEMP_INST, &handle),
+		      -EINVAL, "handle to an instance");
+	zassert_equal(lwm2m_engine_handle_get_u8(&handle, &value), -EINVAL,
+		      "unresolved handle used");
+
+	zassert_equal(lwm2m_engine_get_res_handle("3303/7/5700", &handle),
+		      -ENOENT, "handle to a missing instance");
+	zassert_equal(lwm2m_engine_handle_set_u8(&handle, 1), -EINVAL,
+		      "unresolved handle used");
+
+	zassert_equal(lwm2m_engine_get_res_handle(BATTERY_LEVEL, NULL),
+		      -EINVAL, "no handle filled in");
+}
+
+/* Observers of a resource and of its instance are indexed */
+static void test_observer_index(void)
+{
+	struct lwm2m_res_handle sensor, units;
+
+	zassert_equal(lwm2m_engine_get_res_handle(SENSOR_VALUE, &sensor), 0,
+		      "handle not resolved");
+	zassert_equal(lwm2m_engine_get_res_handle(UNITS, &units), 0,
+		      "handle not resolved");
+
+	check_index(&sensor, 0);
+	check_index(&units, 0);
+
+	observe(SENSOR_VALUE, 1);
+	zassert_equal(sensor.res->observer_count, 1, "observer not counted");
+	check_index(&sensor, 1);
+	check_index(&units, 0);
+
+	observe(TEMP_INST, 2);
+	zassert_equal(sensor.obj_inst->observer_count, 1,
+		      "observer not counted");
+	check_index(&sensor, 2);
+	check_index(&units, 1);
+
+	/* registering the same path again keeps a single observer */
+	observe(SENSOR_VALUE, 3);
+	check_index(&sensor, 2);
+
+	observe_cancel(SENSOR_VALUE, 3);
+	check_index(&sensor, 1);
+	check_index(&units, 1);
+
+	observe_cancel(TEMP_INST, 2);
+	check_index(&sensor, 0);
+	check_index(&units, 0);
+
+	/* writes without observers still update the resource */
+	zassert_equal(lwm2m_engine_handle_set_string(&units, "K"), 0,
+		      "set failed");
+}
+
+/* Deleting the instance invalidates handles and drops its observers */
+static void test_handle_stale(void)
+{
+	struct lwm2m_res_handle sensor;
+	float32_value_t temp = { .val1 = 4 };
+
+	zassert_equal(lwm2m_engine_get_res_handle(SENSOR_VALUE, &sensor), 0,
+		      "handle not resolved");
+	observe(SENSOR_VALUE, 4);
+	check_index(&sensor, 1);
+
+	zassert_equal(lwm2m_delete_obj_inst(IPSO_OBJECT_TEMP_SENSOR_ID, 0), 0,
+		      "instance not deleted");
+	zassert_equal(lwm2m_notify_observer(IPSO_OBJECT_TEMP_SENSOR_ID, 0,
+					    sensor.res_id),
+		      0, "observer of deleted instance kept");
+	zassert_equal(lwm2m_engine_handle_set_float32(&sensor, &temp),
+		      -ENOENT, "stale handle used");
+	zassert_equal(lwm2m_engine_handle_get_float32(&sensor, &temp),
+		      -ENOENT, "stale handle used");
+
+	/* the storage of the deleted instance is reused for another one */
+	zassert_equal(lwm2m_engine_create_obj_inst("3303/1"), 0,
+		      "instance not created");
+	zassert_equal(lwm2m_engine_handle_get_float32(&sensor, &temp),
+		      -ENOENT, "handle to another instance used");
+	zassert_equal(sensor.obj_inst->observer_count, 0,
+		      "observer count not reset");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lwm2m_engine,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_handle_set_get),
+			 ztest_unit_test(test_handle_invalid),
+			 ztest_unit_test(test_observer_index),
+			 ztest_unit_test(test_handle_stale));
+	ztest_run_test_suite(lwm2m_engine);
+}
@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SenML-CBOR writer round trip. The writer is fed through the engine output
+ * helpers, the resulting pack is decoded again with tinycbor.
+ */
+
+#include <ztest.h>
+#include <net/net_pkt.h>
+
+#include "lwm2m_engine.h"
+#include "lwm2m_rw_senml_cbor.h"
+#include "cbor_buf_reader.h"
+
+#define PACK_SIZE	512
+#define MAX_RECORDS	16
+#define NO_LABEL	-1
+
+struct record {
+	char bn[SENML_BASE_NAME_LEN];
+	char n[SENML_NAME_LEN];
+	int label;
+	CborValue value;
+};
+
+static struct senml_cbor_out_formatter_data fd;
+static struct lwm2m_output_context out;
+static struct coap_packet cpkt;
+static struct net_pkt *pkt;
+
+static u8_t pack[PACK_SIZE];
+static size_t pack_len;
+static struct cbor_buf_reader reader;
+static CborParser parser;
+static struct record records[MAX_RECORDS];
+
+static void pack_begin(u8_t path_level)
+{
+	struct net_buf *frag;
+
+	pkt = net_pkt_get_reserve_tx(K_NO_WAIT);
+	zassert_not_null(pkt, "no packet");
+	frag = net_pkt_get_frag(pkt, K_NO_WAIT);
+	zassert_not_null(frag, "no fragment");
+	net_pkt_frag_add(pkt, frag);
+
+	(void)memset(&fd, 0, sizeof(fd));
+	fd.path_level = path_level;
+	cpkt.pkt = pkt;
+
+	out.writer = &senml_cbor_writer;
+	out.out_cpkt = &cpkt;
+	out.frag = frag;
+	out.offset = 0;
+	engine_set_out_user_data(&out, &fd);
+}
+
+/* len is the sum of what the writer reported */
+static void pack_end(size_t len)
+{
+	pack_len = net_pkt_get_len(pkt);
+	zassert_equal(pack_len, len, "wrong length reported");
+	zassert_true(pack_len <= sizeof(pack), "pack too large");
+	zassert_equal(net_frag_linearize(pack, sizeof(pack), pkt, 0, pack_len),
+		      pack_len, "pack not copied");
+
+	engine_clear_out_user_data(&out);
+	net_pkt_unref(pkt);
+}
+
+static void record_decode(CborValue *map, struct record *rec)
+{
+	CborValue it;
+	CborError err;
+	size_t len;
+	int label;
+
+	zassert_true(cbor_value_is_map(map), "record not a map");
+	zassert_equal(cbor_value_enter_container(map, &it), CborNoError,
+		      "record not entered");
+
+	(void)memset(rec, 0, sizeof(*rec));
+	rec->label = NO_LABEL;
+
+	while (!cbor_value_at_end(&it)) {
+		zassert_equal(cbor_value_get_int(&it, &label), CborNoError,
+			      "label not an integer");
+		zassert_equal(cbor_value_advance_fixed(&it), CborNoError,
+			      "label not skipped");
+
+		switch (label) {
+		case SENML_LABEL_BASE_NAME:
+			len = sizeof(rec->bn);
+			err = cbor_value_copy_text_string(&it, rec->bn, &len,
+							  &it);
+			break;
+		case SENML_LABEL_NAME:
+			len = sizeof(rec->n);
+			err = cbor_value_copy_text_string(&it, rec->n, &len,
+							  &it);
+			break;
+		default:
+			zassert_equal(rec->label, NO_LABEL, "several values");
+			rec->label = label;
+			rec->value = it;
+			err = cbor_value_skip_tag(&it);
+			if (err == CborNoError) {
+				err = cbor_value_advance(&it);
+			}
+			break;
+		}
+
+		zassert_equal(err, CborNoError, "label %d not decoded", label);
+	}
+
+	zassert_equal(cbor_value_leave_container(map, &it), CborNoError,
+		      "record not left");
+}
+
+/* Returns the number of records in the pack */
+static int pack_decode(void)
+{
+	CborValue value;
+	CborValue map;
+	int count = 0;
+
+	cbor_buf_reader_init(&reader, pack, pack_len);
+	zassert_equal(cbor_parser_cust_reader_init(&reader.r, 0, &parser,
+						   &value),
+		      CborNoError, "parser not initialized");
+	zassert_true(cbor_value_is_array(&value), "pack not an array");
+	zassert_false(cbor_value_is_length_known(&value),
+		      "pack of definite length");
+	zassert_equal(cbor_value_enter_container(&value, &map), CborNoError,
+		      "pack not entered");
+
+	while (!cbor_value_at_end(&map)) {
+		zassert_true(count < MAX_RECORDS, "too many records");
+		record_decode(&map, &records[count++]);
+	}
+
+	zassert_equal(cbor_value_leave_container(&value, &map), CborNoError,
+		      "pack not left");
+	zassert_true(cbor_value_at_end(&value), "data after the pack");
+
+	return count;
+}
+
+static void check_record(int i, const char *bn, const char *n, int label)
+{
+	zassert_equal(strcmp(records[i].bn, bn), 0,
+		      "wrong base name in record %d", i);
+	zassert_equal(strcmp(records[i].n, n), 0, "wrong name in record %d",
+		      i);
+	zassert_equal(records[i].label, label, "wrong label in record %d", i);
+}
+
+static void check_int(int i, s64_t exp)
+{
+	s64_t value;
+
+	zassert_true(cbor_value_is_integer(&records[i].value),
+		     "record %d not an integer", i);
+	zassert_equal(cbor_value_get_int64(&records[i].value, &value),
+		      CborNoError, "record %d not decoded", i);
+	zassert_equal(value, exp, "wrong value in record %d", i);
+}
+
+/* Expected encodings of a fixed point value */
+struct fixed_exp {
+	/* Double, rounded to nearest */
+	double value;
+	/* Decimal fraction without floating point support, an integer if
+	 * the exponent is zero.
+	 */
+	s64_t mant;
+	int exp10;
+};
+
+static void check_fixed(int i, const struct fixed_exp *exp)
+{
+	CborValue fraction;
+	CborValue it;
+	CborTag tag;
+	double value;
+	s64_t mant;
+	size_t len;
+	int exp10;
+
+	if (IS_ENABLED(CONFIG_CBOR_FLOATING_POINT)) {
+		zassert_true(cbor_value_is_double(&records[i].value),
+			     "record %d not a double", i);
+		zassert_equal(cbor_value_get_double(&records[i].value, &value),
+			      CborNoError, "record %d not decoded", i);
+		zassert_true(value == exp->value, "wrong value in record %d",
+			     i);
+		return;
+	}
+
+	if (exp->exp10 == 0) {
+		check_int(i, exp->mant);
+		return;
+	}
+
+	fraction = records[i].value;
+	zassert_true(cbor_value_is_tag(&fraction), "record %d not tagged", i);
+	zassert_equal(cbor_value_get_tag(&fraction, &tag), CborNoError,
+		      "record %d tag not decoded", i);
+	zassert_equal(tag, CborDecimalTag, "record %d not a decimal", i);
+	zassert_equal(cbor_value_skip_tag(&fraction), CborNoError,
+		      "record %d tag not skipped", i);
+
+	zassert_true(cbor_value_is_array(&fraction),
+		     "record %d decimal not an array", i);
+	zassert_equal(cbor_value_get_array_length(&fraction, &len),
+		      CborNoError, "record %d decimal not decoded", i);
+	zassert_equal(len, 2, "record %d decimal of wrong length", i);
+	zassert_equal(cbor_value_enter_container(&fraction, &it), CborNoError,
+		      "record %d decimal not entered", i);
+
+	zassert_equal(cbor_value_get_int(&it, &exp10), CborNoError,
+		      "record %d exponent not decoded", i);
+	zassert_equal(cbor_value_advance_fixed(&it), CborNoError,
+		      "record %d exponent not skipped", i);
+	zassert_equal(cbor_value_get_int64(&it, &mant), CborNoError,
+		      "record %d mantissa not decoded", i);
+
+	zassert_equal(exp10, exp->exp10, "wrong exponent in record %d", i);
+	zassert_equal(mant, exp->mant, "wrong mantissa in record %d", i);
+}
+
+/*
+ * Fixed point values are sent as doubles, or as decimal fractions without
+ * floating point support.
+ */
+static void test_fixed_point(void)
+{
+	static const struct {
+		float32_value_t value;
+		struct fixed_exp exp;
+	} f32[] = {
+		{ { 1, 500000 }, { 1.5, 15, -1 } },
+		{ { -123, -456000 }, { -123.456, -123456, -3 } },
+		{ { 0, 1 }, { 0.000001, 1, -6 } },
+		{ { 0, -500000 }, { -0.5, -5, -1 } },
+		{ { 0, 0 }, { 0.0, 0, 0 } },
+		{ { 2147483647, 999999 },
+		  { 2147483647.999999, 2147483647999999LL, -6 } },
+	};
+	static const struct {
+		float64_value_t value;
+		struct fixed_exp exp;
+	} f64[] = {
+		{ { 3, 141592653 }, { 3.141592653, 3141592653LL, -9 } },
+		{ { -1234567890123LL, -500000000 },
+		  { -1234567890123.5, -12345678901235LL, -1 } },
+		{ { 0, 1 }, { 0.000000001, 1, -9 } },
+		{ { 9007199254740993LL, 0 },
+		  { 9007199254740992.0, 9007199254740993LL, 0 } },
+		/* Decimals which do not fit in the mantissa are dropped */
+		{ { 20000000000LL, 123456789 },
+		  { 20000000000.123456789, 2000000000012345678LL, -8 } },
+		{ { 9223372036854775807LL, 999999999 },
+		  { 9223372036854775808.0, 9223372036854775807LL, 0 } },
+	};
+	struct lwm2m_obj_path path = {
+		.obj_id = 3303, .obj_inst_id = 0, .level = 3
+	};
+	char name[SENML_NAME_LEN];
+	size_t len;
+	int count;
+	int i;
+
+	pack_begin(path.level);
+	len = engine_put_begin(&out, &path);
+
+	for (i = 0; i < ARRAY_SIZE(f32); i++) {
+		path.res_id = i;
+		len += engine_put_float32fix(&out, &path,
+					     (float32_value_t *)&f32[i].value);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(f64); i++) {
+		path.res_id = ARRAY_SIZE(f32) + i;
+		len += engine_put_float64fix(&out, &path,
+					     (float64_value_t *)&f64[i].value);
+	}
+
+	len += engine_put_end(&out, &path);
+	pack_end(len);
+
+	count = pack_decode();
+	zassert_equal(count, ARRAY_SIZE(f32) + ARRAY_SIZE(f64),
+		      "wrong number of records");
+
+	for (i = 0; i < count; i++) {
+		snprintk(name, sizeof(name), "%d", i);
+		check_record(i, i == 0 ? "/3303/0/" : "", name,
+			     SENML_LABEL_VALUE);
+
+		if (i < ARRAY_SIZE(f32)) {
+			check_fixed(i, &f32[i].exp);
+		} else {
+			check_fixed(i, &f64[i - ARRAY_SIZE(f32)].exp);
+		}
+	}
+}
+
+/* Every writer callback yields a record with the matching label */
+static void test_types(void)
+{
+	static const u8_t opaque[] = { 0x00, 0xff, 0x10 };
+	struct lwm2m_obj_path path = {
+		.obj_id = 3303, .obj_inst_id = 2, .res_id = 5700, .level = 1
+	};
+	char str[] = "text";
+	char text[sizeof(str)];
+	u8_t buf[sizeof(opaque)];
+	size_t len;
+	bool flag;
+
+	pack_begin(path.level);
+	len = engine_put_begin(&out, &path);
+	len += engine_put_s8(&out, &path, -5);
+	len += engine_put_s16(&out, &path, 1000);
+	len += engine_put_s32(&out, &path, -100000);
+	len += engine_put_s64(&out, &path, 1LL << 40);
+	len += engine_put_string(&out, &path, str, strlen(str));
+	len += engine_put_bool(&out, &path, true);
+	len += engine_put_opaque(&out, &path, (char *)opaque, sizeof(opaque));
+
+	path.res_id = 5701;
+	path.res_inst_id = 1;
+	len += engine_put_begin_ri(&out, &path);
+	len += engine_put_s32(&out, &path, 7);
+	len += engine_put_end_ri(&out, &path);
+
+	len += engine_put_end(&out, &path);
+	pack_end(len);
+
+	zassert_equal(pack_decode(), 8, "wrong number of records");
+
+	check_record(0, "/3303/", "2/5700", SENML_LABEL_VALUE);
+	check_int(0, -5);
+	check_record(1, "", "2/5700", SENML_LABEL_VALUE);
+	check_int(1, 1000);
+	check_record(2, "", "2/5700", SENML_LABEL_VALUE);
+	check_int(2, -100000);
+	check_record(3, "", "2/5700", SENML_LABEL_VALUE);
+	check_int(3, 1LL << 40);
+
+	check_record(4, "", "2/5700", SENML_LABEL_STRING);
+	zassert_true(cbor_value_is_text_string(&records[4].value),
+		     "string not a text");
+	len = sizeof(text);
+	zassert_equal(cbor_value_copy_text_string(&records[4].value, text,
+						  &len, NULL),
+		      CborNoError, "string not decoded");
+	zassert_equal(strcmp(text, str), 0, "wrong string");
+
+	check_record(5, "", "2/5700", SENML_LABEL_BOOL);
+	zassert_equal(cbor_value_get_boolean(&records[5].value, &flag),
+		      CborNoError, "boolean not decoded");
+	zassert_true(flag, "wrong boolean");
+
+	check_record(6, "", "2/5700", SENML_LABEL_DATA);
+	len = sizeof(buf);
+	zassert_equal(cbor_value_copy_byte_string(&records[6].value, buf,
+						  &len, NULL),
+		      CborNoError, "data not decoded");
+	zassert_equal(len, sizeof(opaque), "wrong data length");
+	zassert_equal(memcmp(buf, opaque, len), 0, "wrong data");
+
+	check_record(7, "", "2/5701/1", SENML_LABEL_VALUE);
+	check_int(7, 7);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lwm2m_senml_cbor,
+			 ztest_unit_test(test_fixed_point),
+			 ztest_unit_test(test_types));
+	ztest_run_test_suite(lwm2m_senml_cbor);
+}
@@ -0,0 +1,638 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Session layer of the MQTT library, run against a broker played by the
+ * test itself over a loopback TCP connection. A stream socket returns at
+ * most one received segment per recv() call, so the broker can tell how
+ * many transport writes the client has made.
+ */
+
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/mqtt.h>
+
+#include "mqtt_internal.h"
+
+#define BROKER_ADDR	CONFIG_NET_CONFIG_MY_IPV4_ADDR
+#define BROKER_PORT	1883
+
+#define WINDOW		CONFIG_MQTT_LIB_SESSION_WINDOW
+#define SLOT_SIZE	64
+#define PACKET_MAX	64
+
+#define WAIT_MS		1000
+#define IDLE_MS		100
+#define RETRANSMIT_MS	CONFIG_MQTT_LIB_SESSION_RETRANSMIT_TIMEOUT
+
+/* Packet as seen by the broker */
+struct packet {
+	u8_t type;
+	u8_t flags;
+	u16_t message_id;
+	const u8_t *payload;
+	u32_t payload_len;
+	u32_t len;
+	u8_t data[PACKET_MAX];
+};
+
+/* Packets reported through the session storage hook */
+struct stored {
+	u16_t message_id;
+	u32_t len;
+	u8_t data[SLOT_SIZE];
+};
+
+static struct mqtt_client client;
+static struct sockaddr_in broker;
+static u8_t rx_buf[128];
+static u8_t tx_buf[128];
+static u8_t session_buf[WINDOW * SLOT_SIZE];
+
+static struct mqtt_evt last_evt;
+static int evt_cnt;
+
+static struct stored store[WINDOW];
+static int store_cnt;
+
+static int listen_sock = -1;
+static int conn_sock = -1;
+static u8_t broker_buf[256];
+static size_t broker_len;
+
+static const char topic[] = "sensors";
+static const char payload[] = "21.5";
+
+static void evt_handler(struct mqtt_client *const c,
+			const struct mqtt_evt *evt)
+{
+	last_evt = *evt;
+	evt_cnt++;
+}
+
+static void session_handler(struct mqtt_client *c, u16_t message_id,
+			    const u8_t *packet, u32_t len)
+{
+	int i;
+
+	for (i = 0; i < store_cnt; i++) {
+		if (store[i].message_id == message_id) {
+			break;
+		}
+	}
+
+	if (packet == NULL) {
+		zassert_true(i < store_cnt, "unknown message forgotten");
+		memmove(&store[i], &store[i + 1],
+			(store_cnt - i - 1) * sizeof(store[0]));
+		store_cnt--;
+		return;
+	}
+
+	zassert_true(i < WINDOW, "more messages stored than in flight");
+	zassert_true(len <= SLOT_SIZE, "stored packet too long");
+
+	store[i].message_id = message_id;
+	store[i].len = len;
+	memcpy(store[i].data, packet, len);
+
+	if (i == store_cnt) {
+		store_cnt++;
+	}
+}
+
+static void client_init(u8_t clean_session)
+{
+	mqtt_client_init(&client);
+
+	client.broker = &broker;
+	client.evt_cb = evt_handler;
+	client.client_id.utf8 = (u8_t *)"session_test";
+	client.client_id.size = strlen("session_test");
+	client.clean_session = clean_session;
+	client.rx_buf = rx_buf;
+	client.rx_buf_size = sizeof(rx_buf);
+	client.tx_buf = tx_buf;
+	client.tx_buf_size = sizeof(tx_buf);
+	client.transport.type = MQTT_TRANSPORT_NON_SECURE;
+	client.session_buf = session_buf;
+	client.session_buf_size = sizeof(session_buf);
+	client.session_cb = session_handler;
+}
+
+/* Waits for data from the client and reads one segment of it */
+static size_t broker_fill(int timeout)
+{
+	struct pollfd pfd = {
+		.fd = conn_sock,
+		.events = POLLIN,
+	};
+	ssize_t len;
+
+	if (poll(&pfd, 1, timeout) <= 0) {
+		return 0;
+	}
+
+	len = recv(conn_sock, &broker_buf[broker_len],
+		   sizeof(broker_buf) - broker_len, 0);
+	zassert_true(len > 0, "broker connection closed");
+
+	broker_len += len;
+
+	return len;
+}
+
+/* Takes the next complete packet from the received data, if any */
+static bool broker_packet(struct packet *pkt)
+{
+	u32_t remaining = 0U;
+	u32_t hdr_len = 1U;
+	const u8_t *var;
+	u32_t topic_len;
+	u8_t shift = 0U;
+
+	do {
+		if (hdr_len >= broker_len) {
+			return false;
+		}
+
+		remaining |= (broker_buf[hdr_len] & 0x7F) << shift;
+		shift += 7U;
+	} while (broker_buf[hdr_len++] & 0x80);
+
+	if (hdr_len + remaining > broker_len) {
+		return false;
+	}
+
+	pkt->len = hdr_len + remaining;
+	zassert_true(pkt->len <= sizeof(pkt->data), "packet too long");
+	memcpy(pkt->data, broker_buf, pkt->len);
+
+	broker_len -= pkt->len;
+	memmove(broker_buf, &broker_buf[pkt->len], broker_len);
+
+	pkt->type = pkt->data[0] & 0xF0;
+	pkt->flags = pkt->data[0] & 0x0F;
+	pkt->message_id = 0U;
+	pkt->payload = NULL;
+	pkt->payload_len = 0U;
+
+	var = &pkt->data[hdr_len];
+
+	switch (pkt->type) {
+	case MQTT_PKT_TYPE_PUBLISH:
+		topic_len = sys_get_be16(var) + sizeof(u16_t);
+		if (pkt->flags & MQTT_HEADER_QOS_MASK) {
+			pkt->message_id = sys_get_be16(&var[topic_len]);
+			topic_len += sizeof(u16_t);
+		}
+
+		pkt->payload = &var[topic_len];
+		pkt->payload_len = remaining - topic_len;
+		break;
+	case MQTT_PKT_TYPE_PUBACK:
+	case MQTT_PKT_TYPE_PUBREC:
+	case MQTT_PKT_TYPE_PUBREL:
+	case MQTT_PKT_TYPE_PUBCOMP:
+		pkt->message_id = sys_get_be16(var);
+		break;
+	default:
+		pkt->payload = var;
+		pkt->payload_len = remaining;
+		break;
+	}
+
+	return true;
+}
+
+static void broker_expect(struct packet *pkt, u8_t type)
+{
+	while (!broker_packet(pkt)) {
+		zassert_not_equal(broker_fill(WAIT_MS), 0,
+				  "no packet from the client");
+	}
+
+	zassert_equal(pkt->type, type, "unexpected packet 0x%02x",
+		      pkt->data[0]);
+}
+
+static void broker_expect_publish(u16_t message_id, u8_t qos, bool dup)
+{
+	struct packet pkt;
+
+	broker_expect(&pkt, MQTT_PKT_TYPE_PUBLISH);
+	zassert_equal(pkt.message_id, message_id, "wrong message id");
+	zassert_equal((pkt.flags & MQTT_HEADER_QOS_MASK) >> 1, qos,
+		      "wrong QoS");
+	zassert_equal(!!(pkt.flags & MQTT_HEADER_DUP_MASK), dup,
+		      "wrong DUP flag");
+	zassert_equal(pkt.payload_len, strlen(payload), "wrong payload");
+	zassert_equal(memcmp(pkt.payload, payload, pkt.payload_len), 0,
+		      "wrong payload");
+}
+
+static void broker_expect_ack(u8_t type, u16_t message_id)
+{
+	struct packet pkt;
+
+	broker_expect(&pkt, type);
+	zassert_equal(pkt.message_id, message_id, "wrong message id");
+
+	if (type == MQTT_PKT_TYPE_PUBREL) {
+		zassert_equal(pkt.flags, 0x02, "wrong PUBREL flags");
+	}
+}
+
+static void broker_expect_idle(void)
+{
+	zassert_equal(broker_len, 0, "unexpected data from the client");
+	zassert_equal(broker_fill(IDLE_MS), 0, "unexpected packet sent");
+}
+
+static void broker_send(const u8_t *data, size_t len)
+{
+	zassert_equal(send(conn_sock, data, len, 0), len,
+		      "broker send failed");
+}
+
+static void broker_send_ack(u8_t type, u16_t message_id)
+{
+	u8_t ack[] = { type, 2, message_id >> 8, message_id };
+
+	broker_send(ack, sizeof(ack));
+}
+
+/* Runs mqtt_input() once data from the broker has arrived */
+static void client_input(void)
+{
+	struct pollfd pfd = {
+		.fd = client.transport.tcp.sock,
+		.events = POLLIN,
+	};
+
+	zassert_equal(poll(&pfd, 1, WAIT_MS), 1, "no data from the broker");
+	zassert_equal(mqtt_input(&client), 0, "mqtt_input failed");
+}
+
+static void client_connect(u8_t session_present)
+{
+	u8_t connack[] = { MQTT_PKT_TYPE_CONNACK, 2, session_present, 0 };
+	struct packet pkt;
+
+	evt_cnt = 0;
+
+	zassert_equal(mqtt_connect(&client), 0, "mqtt_connect failed");
+
+	conn_sock = accept(listen_sock, NULL, NULL);
+	zassert_true(conn_sock >= 0, "accept failed");
+	broker_len = 0;
+
+	/* Connect flags follow the protocol name and level */
+	broker_expect(&pkt, MQTT_PKT_TYPE_CONNECT);
+	zassert_equal(!!(pkt.payload[7] & 0x02), client.clean_session,
+		      "wrong clean session flag");
+
+	broker_send(connack, sizeof(connack));
+	client_input();
+
+	zassert_equal(last_evt.type, MQTT_EVT_CONNACK, "not connected");
+	zassert_equal(last_evt.result, 0, "connection refused");
+}
+
+static void broker_close(void)
+{
+	zassert_equal(close(conn_sock), 0, "close failed");
+	conn_sock = -1;
+}
+
+static void client_disconnect(void)
+{
+	struct packet pkt;
+
+	zassert_equal(mqtt_disconnect(&client), 0, "mqtt_disconnect failed");
+	broker_expect(&pkt, MQTT_PKT_TYPE_DISCONNECT);
+
+	/* Socket is closed by the next call into the library */
+	zassert_equal(mqtt_live(&client), 0, "mqtt_live failed");
+	zassert_equal(last_evt.type, MQTT_EVT_DISCONNECT, "not disconnected");
+
+	broker_close();
+}
+
+static int publish(u8_t qos)
+{
+	struct mqtt_publish_param param = {
+		.message.topic.topic.utf8 = (u8_t *)topic,
+		.message.topic.topic.size = strlen(topic),
+		.message.topic.qos = qos,
+		.message.payload.data = (u8_t *)payload,
+		.message.payload.len = strlen(payload),
+	};
+
+	return mqtt_session_publish(&client, &param);
+}
+
+static void test_setup(void)
+{
+	int ret;
+
+	listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(listen_sock >= 0, "socket open failed");
+
+	broker.sin_family = AF_INET;
+	broker.sin_port = htons(BROKER_PORT);
+	ret = inet_pton(AF_INET, BROKER_ADDR, &broker.sin_addr);
+	zassert_equal(ret, 1, "inet_pton failed");
+
+	zassert_equal(bind(listen_sock, (struct sockaddr *)&broker,
+			   sizeof(broker)), 0, "bind failed");
+	zassert_equal(listen(listen_sock, 1), 0, "listen failed");
+}
+
+/* No more than WINDOW messages await acknowledgment */
+static void test_inflight_window(void)
+{
+	int ids[WINDOW];
+	int i;
+
+	client_init(1);
+	client_connect(0);
+
+	for (i = 0; i < WINDOW; i++) {
+		ids[i] = publish(MQTT_QOS_1_AT_LEAST_ONCE);
+		zassert_true(ids[i] > 0, "publish failed");
+		zassert_equal(store_cnt, i + 1, "message not stored");
+	}
+
+	zassert_equal(publish(MQTT_QOS_1_AT_LEAST_ONCE), -EBUSY,
+		      "window exceeded");
+	zassert_equal(publish(MQTT_QOS_2_EXACTLY_ONCE), -EBUSY,
+		      "window exceeded");
+	zassert_equal(publish(MQTT_QOS_0_AT_MOST_ONCE), 0,
+		      "QoS 0 message limited by the window");
+	zassert_equal(mqtt_session_flush(&client), 0, "flush failed");
+
+	for (i = 0; i < WINDOW; i++) {
+		broker_expect_publish(ids[i], MQTT_QOS_1_AT_LEAST_ONCE, false);
+	}
+	broker_expect_publish(0, MQTT_QOS_0_AT_MOST_ONCE, false);
+
+	/* an acknowledgment makes room for one more message */
+	broker_send_ack(MQTT_PKT_TYPE_PUBACK, ids[1]);
+	client_input();
+	zassert_equal(last_evt.type, MQTT_EVT_PUBACK, "PUBACK not notified");
+	zassert_equal(last_evt.param.puback.message_id, ids[1],
+		      "wrong message acknowledged");
+	zassert_equal(store_cnt, WINDOW - 1, "message not forgotten");
+
+	ids[1] = publish(MQTT_QOS_1_AT_LEAST_ONCE);
+	zassert_true(ids[1] > 0, "publish failed");
+	zassert_equal(publish(MQTT_QOS_1_AT_LEAST_ONCE), -EBUSY,
+		      "window exceeded");
+
+	for (i = 0; i < WINDOW; i++) {
+		zassert_true(i == 1 || ids[i] != ids[1],
+			     "message id reused while in flight");
+	}
+
+	zassert_equal(mqtt_session_flush(&client), 0, "flush failed");
+	broker_expect_publish(ids[1], MQTT_QOS_1_AT_LEAST_ONCE, false);
+
+	for (i = 0; i < WINDOW; i++) {
+		broker_send_ack(MQTT_PKT_TYPE_PUBACK, ids[i]);
+		client_input();
+	}
+	zassert_equal(store_cnt, 0, "acknowledged message kept");
+
+	client_disconnect();
+}
+
+/* Queued messages and an acknowledgment go out with a single write */
+static void test_coalescing(void)
+{
+	struct mqtt_puback_param puback = {
+		.message_id = 0x1234,
+	};
+	struct packet pkt;
+	int id;
+
+	client_init(1);
+	client_connect(0);
+
+	id = publish(MQTT_QOS_1_AT_LEAST_ONCE);
+	zassert_true(id > 0, "publish failed");
+	zassert_equal(publish(MQTT_QOS_0_AT_MOST_ONCE), 0, "publish failed");
+	broker_expect_idle();
+
+	zassert_equal(mqtt_publish_qos1_ack(&client, &puback), 0,
+		      "PUBACK not sent");
+	zassert_not_equal(broker_fill(WAIT_MS), 0, "nothing sent");
+
+	zassert_true(broker_packet(&pkt), "first message not sent");
+	zassert_equal(pkt.message_id, id, "wrong message sent first");
+	zassert_true(broker_packet(&pkt), "second message not sent");
+	zassert_equal(pkt.type, MQTT_PKT_TYPE_PUBLISH, "wrong packet");
+	zassert_true(broker_packet(&pkt), "not sent with the same write");
+	zassert_equal(pkt.type, MQTT_PKT_TYPE_PUBACK, "wrong packet");
+	zassert_equal(pkt.message_id, puback.message_id, "wrong message id");
+
+	/* messages published later are sent with the next flush */
+	zassert_equal(publish(MQTT_QOS_0_AT_MOST_ONCE), 0, "publish failed");
+	zassert_equal(publish(MQTT_QOS_0_AT_MOST_ONCE), 0, "publish failed");
+	broker_expect_idle();
+
+	zassert_equal(mqtt_session_flush(&client), 0, "flush failed");
+	zassert_not_equal(broker_fill(WAIT_MS), 0, "nothing sent");
+	zassert_true(broker_packet(&pkt) && broker_packet(&pkt),
+		     "not sent with the same write");
+
+	broker_send_ack(MQTT_PKT_TYPE_PUBACK, id);
+	client_input();
+
+	client_disconnect();
+}
+
+/* Unacknowledged messages are sent again with DUP after the timeout */
+static void test_retransmit(void)
+{
+	int id;
+
+	client_init(1);
+	client_connect(0);
+
+	id = publish(MQTT_QOS_1_AT_LEAST_ONCE);
+	zassert_true(id > 0, "publish failed");
+	zassert_equal(mqtt_session_flush(&client), 0, "flush failed");
+	broker_expect_publish(id, MQTT_QOS_1_AT_LEAST_ONCE, false);
+
+	zassert_equal(mqtt_live(&client), 0, "mqtt_live failed");
+	broker_expect_idle();
+
+	k_sleep(RETRANSMIT_MS);
+	zassert_equal(mqtt_live(&client), 0, "mqtt_live failed");
+	broker_expect_publish(id, MQTT_QOS_1_AT_LEAST_ONCE, true);
+
+	/* the timeout starts again from the retransmission */
+	zassert_equal(mqtt_live(&client), 0, "mqtt_live failed");
+	broker_expect_idle();
+
+	broker_send_ack(MQTT_PKT_TYPE_PUBACK, id);
+	client_input();
+	zassert_equal(store_cnt, 0, "acknowledged message kept");
+
+	k_sleep(RETRANSMIT_MS);
+	zassert_equal(mqtt_live(&client), 0, "mqtt_live failed");
+	broker_expect_idle();
+
+	client_disconnect();
+}
+
+/* PUBREL is sent on PUBREC and kept until PUBCOMP */
+static void test_qos2(void)
+{
+	int id;
+
+	client_init(1);
+	client_connect(0);
+
+	id = publish(MQTT_QOS_2_EXACTLY_ONCE);
+	zassert_true(id > 0, "publish failed");
+	zassert_equal(mqtt_session_flush(&client), 0, "flush failed");
+	broker_expect_publish(id, MQTT_QOS_2_EXACTLY_ONCE, false);
+
+	evt_cnt = 0;
+	broker_send_ack(MQTT_PKT_TYPE_PUBREC, id);
+	client_input();
+	zassert_equal(evt_cnt, 0, "PUBREC notified");
+	broker_expect_ack(MQTT_PKT_TYPE_PUBREL, id);
+
+	zassert_equal(store_cnt, 1, "PUBREL not stored");
+	zassert_equal(store[0].data[0], MQTT_PKT_TYPE_PUBREL | 0x02,
+		      "PUBREL not stored");
+
+	/* a duplicate PUBREC is answered again */
+	broker_send_ack(MQTT_PKT_TYPE_PUBREC, id);
+	client_input();
+	broker_expect_ack(MQTT_PKT_TYPE_PUBREL, id);
+
+	/* PUBREL is retransmitted like a PUBLISH, DUP does not apply */
+	k_sleep(RETRANSMIT_MS);
+	zassert_equal(mqtt_live(&client), 0, "mqtt_live failed");
+	broker_expect_ack(MQTT_PKT_TYPE_PUBREL, id);
+
+	broker_send_ack(MQTT_PKT_TYPE_PUBCOMP, id);
+	client_input();
+	zassert_equal(last_evt.type, MQTT_EVT_PUBCOMP, "PUBCOMP not notified");
+	zassert_equal(last_evt.param.pubcomp.message_id, id,
+		      "wrong message completed");
+	zassert_equal(store_cnt, 0, "completed message kept");
+
+	client_disconnect();
+}
+
+/* In-flight messages are resent when the session is resumed, also after
+ * being restored from the storage hook
+ */
+static void test_session_restore(void)
+{
+	struct stored saved[WINDOW];
+	int saved_cnt;
+	int id1;
+	int id2;
+	int id3;
+	int i;
+
+	client_init(0);
+	client_connect(0);
+
+	id1 = publish(MQTT_QOS_1_AT_LEAST_ONCE);
+	id2 = publish(MQTT_QOS_2_EXACTLY_ONCE);
+	zassert_true(id1 > 0 && id2 > 0, "publish failed");
+	zassert_equal(mqtt_session_flush(&client), 0, "flush failed");
+	broker_expect_publish(id1, MQTT_QOS_1_AT_LEAST_ONCE, false);
+	broker_expect_publish(id2, MQTT_QOS_2_EXACTLY_ONCE, false);
+
+	broker_send_ack(MQTT_PKT_TYPE_PUBREC, id2);
+	client_input();
+	broker_expect_ack(MQTT_PKT_TYPE_PUBREL, id2);
+
+	/* connection is lost */
+	zassert_equal(mqtt_abort(&client), 0, "mqtt_abort failed");
+	broker_close();
+
+	client_connect(1);
+	broker_expect_publish(id1, MQTT_QOS_1_AT_LEAST_ONCE, true);
+	broker_expect_ack(MQTT_PKT_TYPE_PUBREL, id2);
+	broker_expect_idle();
+
+	zassert_equal(mqtt_abort(&client), 0, "mqtt_abort failed");
+	broker_close();
+
+	/* device restarts, the session is put back from the storage */
+	zassert_equal(store_cnt, 2, "in-flight messages not stored");
+	memcpy(saved, store, sizeof(saved));
+	saved_cnt = store_cnt;
+
+	(void)memset(session_buf, 0, sizeof(session_buf));
+	client_init(0);
+
+	for (i = 0; i < saved_cnt; i++) {
+		zassert_equal(mqtt_session_restore(&client, saved[i].data,
+						   saved[i].len),
+			      0, "restore failed");
+	}
+
+	zassert_equal(mqtt_session_restore(&client, saved[0].data,
+					   saved[0].len),
+		      -EINVAL, "message restored twice");
+
+	client_connect(1);
+	broker_expect_publish(id1, MQTT_QOS_1_AT_LEAST_ONCE, true);
+	broker_expect_ack(MQTT_PKT_TYPE_PUBREL, id2);
+
+	/* new message ids do not collide with restored ones */
+	id3 = publish(MQTT_QOS_1_AT_LEAST_ONCE);
+	zassert_true(id3 > 0, "publish failed");
+	zassert_true(id3 != id1 && id3 != id2, "message id reused");
+	zassert_equal(mqtt_session_flush(&client), 0, "flush failed");
+	broker_expect_publish(id3, MQTT_QOS_1_AT_LEAST_ONCE, false);
+
+	broker_send_ack(MQTT_PKT_TYPE_PUBACK, id1);
+	client_input();
+	broker_send_ack(MQTT_PKT_TYPE_PUBCOMP, id2);
+	client_input();
+	broker_send_ack(MQTT_PKT_TYPE_PUBACK, id3);
+	client_input();
+	zassert_equal(store_cnt, 0, "acknowledged message kept");
+
+	client_disconnect();
+
+	/* a clean session drops a restored message */
+	client_init(1);
+	zassert_equal(mqtt_session_restore(&client, saved[0].data,
+					   saved[0].len),
+		      0, "restore failed");
+	store[0] = saved[0];
+	store_cnt = 1;
+
+	client_connect(0);
+	broker_expect_idle();
+	zassert_equal(store_cnt, 0, "in-flight message kept");
+
+	client_disconnect();
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mqtt_session,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_inflight_window),
+			 ztest_unit_test(test_coalescing),
+			 ztest_unit_test(test_retransmit),
+			 ztest_unit_test(test_qos2),
+			 ztest_unit_test(test_session_restore));
+	ztest_run_test_suite(mqtt_session);
+}
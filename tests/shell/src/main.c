@@ -273,6 +273,37 @@ SHELL_CREATE_DYNAMIC_CMD(m_sub_test_dynamic, dynamic_cmd_get);
 SHELL_CMD_REGISTER(test_dynamic, &m_sub_test_dynamic, NULL, cmd_dynamic);
 
 
+static int cmd_root_a(const struct shell *shell, size_t argc, char **argv)
+{
+	return 1;
+}
+
+static int cmd_root_ab(const struct shell *shell, size_t argc, char **argv)
+{
+	return 2;
+}
+
+static int cmd_root_b(const struct shell *shell, size_t argc, char **argv)
+{
+	return 3;
+}
+
+/* Root commands sharing a prefix, placed around each other when sorted. */
+SHELL_CMD_REGISTER(test_root_ab, NULL, NULL, cmd_root_ab);
+SHELL_CMD_REGISTER(test_root_b, NULL, NULL, cmd_root_b);
+SHELL_CMD_REGISTER(test_root_a, NULL, NULL, cmd_root_a);
+
+static void test_shell_root_cmd_lookup(void)
+{
+	test_shell_execute_cmd("test_root_a", 1);
+	test_shell_execute_cmd("test_root_ab", 2);
+	test_shell_execute_cmd("test_root_b", 3);
+	test_shell_execute_cmd("test_root", -ENOEXEC);
+	test_shell_execute_cmd("test_root_abc", -ENOEXEC);
+	test_shell_execute_cmd("test_root_c", -ENOEXEC);
+	test_shell_execute_cmd("~", -ENOEXEC);
+}
+
 void test_main(void)
 {
 	ztest_test_suite(shell_test_suite,
@@ -283,7 +314,8 @@ void test_main(void)
 			ztest_unit_test(test_cmd_resize),
 			ztest_unit_test(test_shell_module),
 			ztest_unit_test(test_shell_wildcards_static),
-			ztest_unit_test(test_shell_wildcards_dynamic));
+			ztest_unit_test(test_shell_wildcards_dynamic),
+			ztest_unit_test(test_shell_root_cmd_lookup));
 
 	ztest_run_test_suite(shell_test_suite);
 }
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * CTF tracing with the native_posix file backend. Kernel activity is
+ * recorded, flushed to the host file and decoded again according to the
+ * layout given in subsys/debug/tracing/ctf/metadata.
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+#include <irq_offload.h>
+#include <tracing.h>
+#include <misc/byteorder.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define STACK_SIZE	1024
+#define STREAM_MAX	16384
+
+/* Event IDs of ctf/metadata */
+#define EVENT_TRACE_START		0x01
+#define EVENT_LOST_EVENTS		0x02
+#define EVENT_THREAD_SWITCHED_OUT	0x10
+#define EVENT_THREAD_SWITCHED_IN	0x11
+#define EVENT_THREAD_CREATE		0x13
+#define EVENT_THREAD_INFO		0x19
+#define EVENT_ISR_ENTER			0x20
+#define EVENT_CALL_START		0x40
+#define EVENT_CALL_END			0x41
+
+#define HEADER_SIZE	5
+
+struct event {
+	u32_t timestamp;
+	u8_t id;
+	const u8_t *fields;
+};
+
+static K_THREAD_STACK_DEFINE(helper_stack, STACK_SIZE);
+static struct k_thread helper_thread;
+static K_SEM_DEFINE(helper_sem, 0, 1);
+static K_MUTEX_DEFINE(test_mutex);
+
+static u8_t stream[STREAM_MAX];
+static size_t stream_len;
+static bool isr_run;
+
+/* Size of the fields following the header, -1 for an unknown event */
+static int fields_size(u8_t id)
+{
+	switch (id) {
+	case EVENT_TRACE_START:
+	case EVENT_LOST_EVENTS:
+	case EVENT_CALL_START:
+	case EVENT_CALL_END:
+		return 4;
+	case 0x10 ... 0x18:
+		return 5;
+	case EVENT_THREAD_INFO:
+		return 12;
+	case 0x20 ... 0x22:
+	case 0x30:
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+static void stream_read(void)
+{
+	ssize_t ret;
+	int fd;
+
+	tracing_ctf_flush();
+
+	fd = open(CONFIG_TRACING_CTF_POSIX_FILE, O_RDONLY);
+	zassert_true(fd >= 0, "trace file not written");
+
+	stream_len = 0;
+	do {
+		ret = read(fd, &stream[stream_len], STREAM_MAX - stream_len);
+		zassert_true(ret >= 0, "trace file not readable");
+		stream_len += ret;
+	} while (ret > 0 && stream_len < STREAM_MAX);
+
+	close(fd);
+
+	zassert_true(stream_len < STREAM_MAX, "trace file too large");
+}
+
+/* Decodes the event at the given offset, returns the offset of the next */
+static size_t event_get(size_t off, struct event *evt)
+{
+	int size;
+
+	zassert_true(off + HEADER_SIZE <= stream_len, "truncated header");
+
+	evt->timestamp = sys_get_le32(&stream[off]);
+	evt->id = stream[off + 4];
+	evt->fields = &stream[off + HEADER_SIZE];
+
+	size = fields_size(evt->id);
+	zassert_true(size >= 0, "unknown event 0x%02x at %u", evt->id,
+		     (unsigned int)off);
+	zassert_true(off + HEADER_SIZE + size <= stream_len,
+		     "truncated event 0x%02x", evt->id);
+
+	return off + HEADER_SIZE + size;
+}
+
+static bool thread_is(const struct event *evt, struct k_thread *thread)
+{
+	return sys_get_le32(evt->fields) == (u32_t)(uintptr_t)thread;
+}
+
+static void helper(void *p1, void *p2, void *p3)
+{
+	k_sem_take(&helper_sem, K_FOREVER);
+}
+
+static void isr(void *param)
+{
+	isr_run = true;
+}
+
+/* The stream starts with the clock frequency and is in time order */
+static void test_stream_start(void)
+{
+	struct event evt;
+	u32_t prev;
+	size_t off;
+
+	stream_read();
+
+	off = event_get(0, &evt);
+	zassert_equal(evt.id, EVENT_TRACE_START, "no trace_start event");
+	zassert_equal(sys_get_le32(evt.fields), sys_clock_hw_cycles_per_sec(),
+		      "wrong clock frequency");
+
+	prev = evt.timestamp;
+	while (off < stream_len) {
+		off = event_get(off, &evt);
+		zassert_true(evt.timestamp >= prev, "timestamp went back");
+		prev = evt.timestamp;
+	}
+}
+
+/* Thread, interrupt and kernel object events are recorded */
+static void test_kernel_events(void)
+{
+	bool created = false;
+	bool switched_out = false;
+	bool switched_in = false;
+	bool isr_enter = false;
+	u32_t calls[2][SYS_TRACE_ID_SEMA_TAKE + 1] = { 0 };
+	struct event evt;
+	u32_t first;
+	u32_t prev;
+	u32_t call;
+	size_t off;
+
+	stream_read();
+	off = stream_len;
+
+	/* helper runs while the test thread sleeps and blocks on the
+	 * semaphore, the give lets it finish with the next sleep
+	 */
+	k_thread_create(&helper_thread, helper_stack, STACK_SIZE, helper,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
+	k_sleep(1);
+
+	irq_offload(isr, NULL);
+	zassert_true(isr_run, "offloaded function not run");
+	k_busy_wait(100);
+
+	k_mutex_lock(&test_mutex, K_FOREVER);
+	k_mutex_unlock(&test_mutex);
+	k_sem_give(&helper_sem);
+	k_sleep(1);
+
+	stream_read();
+	zassert_true(stream_len > off, "no events recorded");
+
+	first = sys_get_le32(&stream[off]);
+	prev = first;
+	while (off < stream_len) {
+		off = event_get(off, &evt);
+		zassert_true(evt.timestamp >= prev, "timestamp went back");
+		prev = evt.timestamp;
+
+		switch (evt.id) {
+		case EVENT_THREAD_CREATE:
+			created |= thread_is(&evt, &helper_thread);
+			break;
+		case EVENT_THREAD_SWITCHED_OUT:
+			switched_out |= thread_is(&evt, &helper_thread);
+			break;
+		case EVENT_THREAD_SWITCHED_IN:
+			switched_in = true;
+			break;
+		case EVENT_ISR_ENTER:
+			isr_enter = true;
+			break;
+		case EVENT_CALL_START:
+		case EVENT_CALL_END:
+			call = sys_get_le32(evt.fields);
+			if (call < ARRAY_SIZE(calls[0])) {
+				calls[evt.id - EVENT_CALL_START][call]++;
+			}
+			break;
+		case EVENT_LOST_EVENTS:
+			zassert_unreachable("%u events lost",
+					    sys_get_le32(evt.fields));
+			break;
+		}
+	}
+
+	zassert_true(prev > first, "timestamps do not increase");
+	zassert_true(created, "no thread_create event");
+	zassert_true(switched_out, "helper not switched out");
+	zassert_true(switched_in, "no thread_switched_in event");
+	zassert_true(isr_enter, "no isr_enter event");
+
+	/* k_mutex_unlock() records the start of the call only */
+	zassert_not_equal(calls[0][SYS_TRACE_ID_MUTEX_UNLOCK], 0,
+			  "no mutex_unlock event");
+
+	for (int i = 0; i < 2; i++) {
+		zassert_not_equal(calls[i][SYS_TRACE_ID_MUTEX_LOCK], 0,
+				  "no mutex_lock event");
+		zassert_not_equal(calls[i][SYS_TRACE_ID_SEMA_TAKE], 0,
+				  "no sema_take event");
+		zassert_not_equal(calls[i][SYS_TRACE_ID_SEMA_GIVE], 0,
+				  "no sema_give event");
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(tracing_ctf,
+			 ztest_unit_test(test_stream_start),
+			 ztest_unit_test(test_kernel_events));
+	ztest_run_test_suite(tracing_ctf);
+}
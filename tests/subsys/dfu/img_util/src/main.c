@@ -7,6 +7,7 @@
 #include <ztest.h>
 #include <flash.h>
 #include <dfu/flash_img.h>
+#include <string.h>
 
 void test_collecting(void)
 {
@@ -34,8 +35,10 @@ void test_collecting(void)
 						 false) == 0, "pass", "fail");
 	}
 
-	zassert(flash_img_buffered_write(&ctx, data, 0, true) == 0, "pass",
-					 "fail");
+	/* the data is written even if it is not an image */
+	zassert(flash_img_buffered_write(&ctx, data, 0, true) ==
+		(IS_ENABLED(CONFIG_IMG_ENABLE_IMAGE_CHECK) ? -EINVAL : 0),
+		"pass", "fail");
 
 	k = 0U;
 	for (i = 0U; i < 300 * sizeof(data); i++) {
@@ -46,9 +49,149 @@ void test_collecting(void)
 	}
 }
 
+#ifdef CONFIG_IMG_ERASE_PROGRESSIVELY
+#define SLOT_END (FLASH_AREA_IMAGE_1_OFFSET + FLASH_AREA_IMAGE_1_SIZE)
+#define TRAILER_SIZE 64
+
+/* A trailer left at the end of the slot is erased by the final write */
+void test_trailer_erase(void)
+{
+	struct device *flash_dev;
+	struct flash_img_context ctx;
+	u8_t data[TRAILER_SIZE];
+
+	flash_dev = device_get_binding(DT_FLASH_DEV_NAME);
+
+	(void)memset(data, 0xA5, sizeof(data));
+
+	flash_write_protection_set(flash_dev, false);
+	flash_erase(flash_dev, FLASH_AREA_IMAGE_1_OFFSET,
+		    FLASH_AREA_IMAGE_1_SIZE);
+	zassert_equal(flash_write(flash_dev, FLASH_AREA_IMAGE_1_OFFSET, data,
+				  sizeof(data)),
+		      0, "flash write failed");
+	zassert_equal(flash_write(flash_dev, SLOT_END - sizeof(data), data,
+				  sizeof(data)),
+		      0, "flash write failed");
+	flash_write_protection_set(flash_dev, true);
+
+	flash_img_init(&ctx, flash_dev);
+	for (int i = 0; i < 3; i++) {
+		zassert_equal(flash_img_buffered_write(&ctx, data,
+						       sizeof(data), false),
+			      0, "write failed");
+	}
+
+	zassert_equal(flash_read(flash_dev, SLOT_END - sizeof(data), data,
+				 sizeof(data)),
+		      0, "flash read failed");
+	zassert_equal(data[0], 0xA5, "trailer erased before the final write");
+
+	zassert_equal(flash_img_buffered_write(&ctx, data, 0, true),
+		      IS_ENABLED(CONFIG_IMG_ENABLE_IMAGE_CHECK) ? -EINVAL : 0,
+		      "final write failed");
+
+	zassert_equal(flash_read(flash_dev, SLOT_END - sizeof(data), data,
+				 sizeof(data)),
+		      0, "flash read failed");
+	for (int i = 0; i < sizeof(data); i++) {
+		zassert_equal(data[i], 0xFF, "trailer not erased");
+	}
+}
+#else
+void test_trailer_erase(void)
+{
+}
+#endif
+
+#ifdef CONFIG_IMG_ENABLE_IMAGE_CHECK
+#define IMAGE_HDR_SIZE 32
+#define IMAGE_BODY_SIZE 1000
+#define IMAGE_HASHED_SIZE (IMAGE_HDR_SIZE + IMAGE_BODY_SIZE)
+#define IMAGE_SIZE (IMAGE_HASHED_SIZE + 8 + TC_SHA256_DIGEST_SIZE)
+
+static u8_t image[IMAGE_SIZE];
+
+static void image_build(void)
+{
+	struct tc_sha256_state_struct sha;
+	u32_t magic = 0x96f3b83d;
+	u16_t hdr_size = IMAGE_HDR_SIZE;
+	u32_t body_size = IMAGE_BODY_SIZE;
+	u8_t *tlv = &image[IMAGE_HASHED_SIZE];
+
+	(void)memset(image, 0, IMAGE_HDR_SIZE);
+	memcpy(&image[0], &magic, sizeof(magic));
+	memcpy(&image[8], &hdr_size, sizeof(hdr_size));
+	memcpy(&image[12], &body_size, sizeof(body_size));
+
+	for (int i = IMAGE_HDR_SIZE; i < IMAGE_HASHED_SIZE; i++) {
+		image[i] = i * 7;
+	}
+
+	/* TLV info: magic and total size, then the SHA-256 TLV */
+	tlv[0] = 0x07;
+	tlv[1] = 0x69;
+	tlv[2] = IMAGE_SIZE - IMAGE_HASHED_SIZE;
+	tlv[3] = 0;
+	tlv[4] = 0x10;
+	tlv[5] = 0;
+	tlv[6] = TC_SHA256_DIGEST_SIZE;
+	tlv[7] = 0;
+
+	tc_sha256_init(&sha);
+	tc_sha256_update(&sha, image, IMAGE_HASHED_SIZE);
+	tc_sha256_final(&tlv[8], &sha);
+}
+
+static int image_write(struct device *flash_dev)
+{
+	struct flash_img_context ctx;
+	size_t off;
+	int rc;
+
+	flash_write_protection_set(flash_dev, false);
+	flash_erase(flash_dev, FLASH_AREA_IMAGE_1_OFFSET,
+		    FLASH_AREA_IMAGE_1_SIZE);
+	flash_write_protection_set(flash_dev, true);
+
+	flash_img_init(&ctx, flash_dev);
+
+	/* chunks which do not line up with the blocks */
+	for (off = 0; off + 7 < sizeof(image); off += 7) {
+		rc = flash_img_buffered_write(&ctx, &image[off], 7, false);
+		if (rc) {
+			return rc;
+		}
+	}
+
+	return flash_img_buffered_write(&ctx, &image[off],
+					sizeof(image) - off, true);
+}
+
+void test_image_check(void)
+{
+	struct device *flash_dev;
+
+	flash_dev = device_get_binding(DT_FLASH_DEV_NAME);
+
+	image_build();
+	zassert_equal(image_write(flash_dev), 0, "valid image rejected");
+
+	image[IMAGE_HASHED_SIZE - 1] ^= 0x01;
+	zassert_equal(image_write(flash_dev), -EIO, "corrupt image accepted");
+}
+#else
+void test_image_check(void)
+{
+}
+#endif
+
 void test_main(void)
 {
 	ztest_test_suite(test_util,
-			ztest_unit_test(test_collecting));
+			ztest_unit_test(test_collecting),
+			ztest_unit_test(test_trailer_erase),
+			ztest_unit_test(test_image_check));
 	ztest_run_test_suite(test_util);
 }
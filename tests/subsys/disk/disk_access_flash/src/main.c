@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <disk_access.h>
+#include <flash.h>
+#include <stats.h>
+#include <string.h>
+
+#define DISK_NAME CONFIG_DISK_FLASH_VOLUME_NAME
+#define SECTOR_SIZE 512
+#define BLOCK_SECTORS (CONFIG_DISK_ERASE_BLOCK_SIZE / SECTOR_SIZE)
+
+static struct device *flash_dev;
+static u8_t wr_buf[CONFIG_DISK_ERASE_BLOCK_SIZE];
+static u8_t rd_buf[CONFIG_DISK_ERASE_BLOCK_SIZE];
+
+struct stat_walk {
+	const char *name;
+	u64_t value;
+};
+
+static int stat_walk_cb(struct stats_hdr *hdr, void *arg, const char *name,
+			uint16_t off)
+{
+	struct stat_walk *walk = arg;
+
+	if (strcmp(name, walk->name) == 0) {
+		walk->value = *(u64_t *)((u8_t *)hdr + off);
+		return 1;
+	}
+
+	return 0;
+}
+
+static u32_t flash_erases(void)
+{
+	struct stats_hdr *hdr = stats_group_find("flash_sim");
+	struct stat_walk walk = { .name = "erases" };
+
+	zassert_not_null(hdr, "flash statistics not registered");
+	zassert_not_equal(stats_walk(hdr, stat_walk_cb, &walk), 0,
+			  "no erase counter");
+
+	return walk.value;
+}
+
+static void fill_pattern(u8_t *buf, size_t len, u8_t seed)
+{
+	for (size_t i = 0; i < len; i++) {
+		buf[i] = seed + i;
+	}
+}
+
+static void disk_sync(void)
+{
+	zassert_equal(disk_access_ioctl(DISK_NAME, DISK_IOCTL_CTRL_SYNC, NULL),
+		      0, "sync failed");
+}
+
+static void test_init(void)
+{
+	u32_t val;
+
+	zassert_equal(disk_access_init(DISK_NAME), 0, "init failed");
+	zassert_equal(disk_access_ioctl(DISK_NAME, DISK_IOCTL_GET_SECTOR_COUNT,
+					&val),
+		      0, "sector count failed");
+	zassert_equal(val, CONFIG_DISK_VOLUME_SIZE / SECTOR_SIZE,
+		      "wrong sector count");
+
+	flash_dev = device_get_binding(CONFIG_DISK_FLASH_DEV_NAME);
+	zassert_not_null(flash_dev, "no flash device");
+}
+
+/* Sectors of an erase block written one by one cost a single erase */
+static void test_sector_writes_coalesced(void)
+{
+	u32_t erases = flash_erases();
+
+	fill_pattern(wr_buf, sizeof(wr_buf), 1);
+
+	for (int i = 0; i < BLOCK_SECTORS; i++) {
+		zassert_equal(disk_access_write(DISK_NAME,
+						&wr_buf[i * SECTOR_SIZE], i, 1),
+			      0, "write of sector %d failed", i);
+	}
+
+	zassert_equal(disk_access_read(DISK_NAME, rd_buf, 0, BLOCK_SECTORS),
+		      0, "read failed");
+	zassert_mem_equal(rd_buf, wr_buf, sizeof(wr_buf), "wrong disk data");
+
+	disk_sync();
+
+	zassert_equal(flash_erases() - erases,
+		      IS_ENABLED(CONFIG_DISK_FLASH_WRITE_BACK) ?
+		      1 : BLOCK_SECTORS, "unexpected number of erases");
+
+	zassert_equal(flash_read(flash_dev, CONFIG_DISK_FLASH_START, rd_buf,
+				 sizeof(rd_buf)),
+		      0, "flash read failed");
+	zassert_mem_equal(rd_buf, wr_buf, sizeof(wr_buf), "wrong flash data");
+}
+
+static void test_unchanged_write(void)
+{
+	u32_t erases = flash_erases();
+
+	zassert_equal(disk_access_write(DISK_NAME, wr_buf, 0, BLOCK_SECTORS),
+		      0, "write failed");
+	zassert_equal(disk_access_write(DISK_NAME, &wr_buf[SECTOR_SIZE], 1, 1),
+		      0, "write failed");
+	disk_sync();
+
+	zassert_equal(flash_erases(), erases, "unchanged data rewritten");
+}
+
+/* Writes to more blocks than are cached evict the least recently used */
+static void test_eviction(void)
+{
+	int blocks = CONFIG_DISK_FLASH_CACHE_BLOCKS + 1;
+
+	for (int i = 0; i < blocks; i++) {
+		fill_pattern(wr_buf, SECTOR_SIZE, i + 2);
+		zassert_equal(disk_access_write(DISK_NAME, wr_buf,
+						(i + 1) * BLOCK_SECTORS, 1),
+			      0, "write to block %d failed", i + 1);
+	}
+
+	for (int i = 0; i < blocks; i++) {
+		fill_pattern(wr_buf, SECTOR_SIZE, i + 2);
+		zassert_equal(disk_access_read(DISK_NAME, rd_buf,
+					       (i + 1) * BLOCK_SECTORS, 1),
+			      0, "read of block %d failed", i + 1);
+		zassert_mem_equal(rd_buf, wr_buf, SECTOR_SIZE,
+				  "wrong data in evicted block");
+	}
+
+	disk_sync();
+}
+
+/* Without write-back, data is on the flash without synchronization */
+static void test_write_through(void)
+{
+	if (IS_ENABLED(CONFIG_DISK_FLASH_WRITE_BACK)) {
+		ztest_test_skip();
+	}
+
+	fill_pattern(wr_buf, sizeof(wr_buf), 0x55);
+
+	zassert_equal(disk_access_write(DISK_NAME, wr_buf, 0, 1), 0,
+		      "write failed");
+	zassert_equal(disk_access_write(DISK_NAME, &wr_buf[SECTOR_SIZE],
+					BLOCK_SECTORS + 1, BLOCK_SECTORS - 1),
+		      0, "write failed");
+
+	zassert_equal(disk_access_init(DISK_NAME), 0, "init failed");
+
+	zassert_equal(flash_read(flash_dev, CONFIG_DISK_FLASH_START, rd_buf,
+				 SECTOR_SIZE),
+		      0, "flash read failed");
+	zassert_mem_equal(rd_buf, wr_buf, SECTOR_SIZE, "sector not written");
+
+	zassert_equal(flash_read(flash_dev, CONFIG_DISK_FLASH_START +
+				 (BLOCK_SECTORS + 1) * SECTOR_SIZE, rd_buf,
+				 sizeof(rd_buf) - SECTOR_SIZE),
+		      0, "flash read failed");
+	zassert_mem_equal(rd_buf, &wr_buf[SECTOR_SIZE],
+			  sizeof(rd_buf) - SECTOR_SIZE, "sectors not written");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(disk_access_flash,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_sector_writes_coalesced),
+			 ztest_unit_test(test_unchanged_write),
+			 ztest_unit_test(test_eviction),
+			 ztest_unit_test(test_write_through));
+	ztest_run_test_suite(disk_access_flash);
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Sequential and random read throughput of a fragmented FAT file. Besides
+ * the time, the amount of data read from flash is reported, which does not
+ * depend on the platform.
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+#include <fs.h>
+#include <ff.h>
+#include <stats.h>
+#include <string.h>
+
+#define FATFS_MNTP	"/NAND:"
+#define DATA_FILE	FATFS_MNTP"/data.bin"
+#define FILL_FILE	FATFS_MNTP"/fill.bin"
+
+#define FILE_SIZE	(256 * 1024)
+/* Written interleaved with the fill file, so the data file is fragmented */
+#define FRAGMENT_SIZE	(16 * 1024)
+#define CHUNK_SIZE	4096
+#define RANDOM_READS	64
+#define RANDOM_SIZE	512
+
+static FATFS fat_fs;
+
+static struct fs_mount_t fatfs_mnt = {
+	.type = FS_FATFS,
+	.mnt_point = FATFS_MNTP,
+	.fs_data = &fat_fs,
+};
+
+static u8_t buf[CHUNK_SIZE];
+
+struct perf_sample {
+	u32_t ms;
+	u32_t flash_bytes;
+};
+
+static u8_t pattern(u32_t off)
+{
+	return off ^ (off >> 8) ^ (off >> 16);
+}
+
+static void fill_pattern(u8_t *dst, u32_t off, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		dst[i] = pattern(off + i);
+	}
+}
+
+static void check_pattern(const u8_t *src, u32_t off, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		zassert_equal(src[i], pattern(off + i),
+			      "wrong data at offset %u", off + i);
+	}
+}
+
+static int stat_walk_cb(struct stats_hdr *hdr, void *arg, const char *name,
+			uint16_t off)
+{
+	if (strcmp(name, "bytes_read") == 0) {
+		*(u64_t *)arg = *(u64_t *)((u8_t *)hdr + off);
+		return 1;
+	}
+
+	return 0;
+}
+
+static u32_t flash_bytes_read(void)
+{
+	struct stats_hdr *hdr = stats_group_find("flash_sim");
+	u64_t bytes = 0;
+
+	if (hdr) {
+		(void)stats_walk(hdr, stat_walk_cb, &bytes);
+	}
+
+	return bytes;
+}
+
+static void sample_start(struct perf_sample *sample)
+{
+	sample->flash_bytes = flash_bytes_read();
+	sample->ms = k_uptime_get_32();
+}
+
+static void sample_end(struct perf_sample *sample, const char *name,
+		       u32_t bytes)
+{
+	sample->ms = k_uptime_get_32() - sample->ms;
+	sample->flash_bytes = flash_bytes_read() - sample->flash_bytes;
+
+	TC_PRINT("%s: %u bytes in %u ms", name, bytes, sample->ms);
+	if (sample->ms) {
+		TC_PRINT(" (%u KiB/s)",
+			 bytes * MSEC_PER_SEC / 1024 / sample->ms);
+	}
+	TC_PRINT(", %u bytes read from flash\n", sample->flash_bytes);
+}
+
+static void test_setup(void)
+{
+	struct fs_file_t data;
+	struct fs_file_t fill;
+
+	zassert_equal(fs_mount(&fatfs_mnt), 0, "mount failed");
+
+	(void)fs_unlink(DATA_FILE);
+	(void)fs_unlink(FILL_FILE);
+
+	zassert_equal(fs_open(&data, DATA_FILE), 0, "open failed");
+	zassert_equal(fs_open(&fill, FILL_FILE), 0, "open failed");
+
+	for (u32_t off = 0; off < FILE_SIZE; off += CHUNK_SIZE) {
+		fill_pattern(buf, off, CHUNK_SIZE);
+		zassert_equal(fs_write(&data, buf, CHUNK_SIZE), CHUNK_SIZE,
+			      "data write failed");
+
+		if ((off + CHUNK_SIZE) % FRAGMENT_SIZE == 0) {
+			zassert_equal(fs_sync(&data), 0, "sync failed");
+			zassert_equal(fs_write(&fill, buf, CHUNK_SIZE),
+				      CHUNK_SIZE, "fill write failed");
+			zassert_equal(fs_sync(&fill), 0, "sync failed");
+		}
+	}
+
+	zassert_equal(fs_close(&fill), 0, "close failed");
+	zassert_equal(fs_close(&data), 0, "close failed");
+}
+
+static void test_sequential_read(void)
+{
+	struct perf_sample sample;
+	struct fs_file_t data;
+
+	zassert_equal(fs_open(&data, DATA_FILE), 0, "open failed");
+
+	sample_start(&sample);
+
+	for (u32_t off = 0; off < FILE_SIZE; off += CHUNK_SIZE) {
+		zassert_equal(fs_read(&data, buf, CHUNK_SIZE), CHUNK_SIZE,
+			      "read failed");
+		check_pattern(buf, off, CHUNK_SIZE);
+	}
+
+	sample_end(&sample, "sequential read", FILE_SIZE);
+
+	zassert_equal(fs_close(&data), 0, "close failed");
+}
+
+static void test_random_read(void)
+{
+	struct perf_sample sample;
+	struct fs_file_t data;
+	u32_t seed = 1U;
+
+	zassert_equal(fs_open(&data, DATA_FILE), 0, "open failed");
+
+	sample_start(&sample);
+
+	for (int i = 0; i < RANDOM_READS; i++) {
+		u32_t off;
+
+		/* Park-Miller, to be reproducible on all platforms */
+		seed = (u64_t)seed * 48271U % 0x7fffffffU;
+		off = seed % (FILE_SIZE / RANDOM_SIZE) * RANDOM_SIZE;
+
+		zassert_equal(fs_seek(&data, off, FS_SEEK_SET), 0,
+			      "seek failed");
+		zassert_equal(fs_read(&data, buf, RANDOM_SIZE), RANDOM_SIZE,
+			      "read failed");
+		check_pattern(buf, off, RANDOM_SIZE);
+	}
+
+	sample_end(&sample, "random read", RANDOM_READS * RANDOM_SIZE);
+
+	zassert_equal(fs_close(&data), 0, "close failed");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(fat_fs_perf,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_sequential_read),
+			 ztest_unit_test(test_random_read));
+	ztest_run_test_suite(fat_fs_perf);
+}
@@ -31,4 +31,12 @@ void fcb_test_init(void)
 	fcb->f_magic = 0;
 	rc = fcb_init(TEST_FCB_FLASH_AREA_ID, fcb);
 	zassert_true(rc == 0,  "fcb_init call failure");
+
+	fcb->f_version = 1;
+	rc = fcb_init(TEST_FCB_FLASH_AREA_ID, fcb);
+	zassert_true(rc == FCB_ERR_VERSION, "fcb_init call should fail");
+
+	fcb->f_version = 0;
+	rc = fcb_init(TEST_FCB_FLASH_AREA_ID, fcb);
+	zassert_true(rc == 0,  "fcb_init call failure");
 }
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "fcb_test.h"
+
+#define SUMMARY_ELEMS	300
+#define SUMMARY_LEN	128
+
+static int summary_key_cb(struct fcb_entry_ctx *entry_ctx, u32_t *key)
+{
+	return flash_area_read(entry_ctx->fap,
+			       FCB_ENTRY_FA_DATA_OFF(entry_ctx->loc),
+			       key, sizeof(*key));
+}
+
+static void summary_fcb_init(void)
+{
+	struct fcb *fcb = &test_fcb;
+	int rc;
+
+	(void)memset(fcb, 0, sizeof(*fcb));
+	fcb->f_sector_cnt = 4;
+	fcb->f_sectors = test_fcb_sector;
+	fcb->f_summary = true;
+	fcb->f_key_cb = summary_key_cb;
+
+	rc = fcb_init(TEST_FCB_FLASH_AREA_ID, fcb);
+	zassert_true(rc == 0, "fcb_init call failure");
+}
+
+static u32_t summary_read_key(struct fcb_entry *loc)
+{
+	u32_t key;
+	int rc;
+
+	rc = flash_area_read(test_fcb.fap, FCB_ENTRY_FA_DATA_OFF((*loc)),
+			     &key, sizeof(key));
+	zassert_true(rc == 0, "flash_area_read call failure");
+
+	return key;
+}
+
+static int summary_walk_cb(struct fcb_entry_ctx *entry_ctx, void *arg)
+{
+	u32_t *key = arg;
+	u32_t found;
+
+	found = summary_read_key(&entry_ctx->loc);
+	zassert_true(found == key[0], "walk served a wrong key");
+	key[1]++;
+
+	return 0;
+}
+
+static void summary_check_seek(u32_t seq)
+{
+	struct fcb_entry loc;
+	int rc;
+
+	rc = fcb_seek_seq(&test_fcb, seq, &loc);
+	zassert_true(rc == 0, "fcb_seek_seq call failure");
+	zassert_true(summary_read_key(&loc) == seq, "seek to wrong element");
+}
+
+static void summary_append(u32_t key, struct fcb_entry *loc, bool finish)
+{
+	u8_t test_data[SUMMARY_LEN];
+	int rc;
+
+	(void)memset(test_data, key, sizeof(test_data));
+	memcpy(test_data, &key, sizeof(key));
+
+	rc = fcb_append(&test_fcb, sizeof(test_data), loc);
+	zassert_true(rc == 0, "fcb_append call failure");
+
+	rc = flash_area_write(test_fcb.fap, FCB_ENTRY_FA_DATA_OFF((*loc)),
+			      test_data, sizeof(test_data));
+	zassert_true(rc == 0, "flash_area_write call failure");
+
+	if (finish) {
+		rc = fcb_append_finish(&test_fcb, loc);
+		zassert_true(rc == 0, "fcb_append_finish call failure");
+	}
+}
+
+void fcb_test_summary(void)
+{
+	struct fcb *fcb = &test_fcb;
+	struct fcb_summary sum;
+	struct fcb_entry loc;
+	u8_t test_data[SUMMARY_LEN];
+	u32_t first_seq;
+	u32_t next_seq;
+	u32_t walk[2];
+	u32_t cnt0;
+	u32_t i;
+	int rc;
+
+	summary_fcb_init();
+
+	rc = fcb_seq_range(fcb, &first_seq, &next_seq);
+	zassert_true(rc == 0, "fcb_seq_range call failure");
+	zassert_true(first_seq == 0U && next_seq == 0U, "fcb not empty");
+
+	for (i = 0U; i < SUMMARY_ELEMS; i++) {
+		(void)memset(test_data, i, sizeof(test_data));
+		memcpy(test_data, &i, sizeof(i));
+
+		rc = fcb_append(fcb, sizeof(test_data), &loc);
+		zassert_true(rc == 0, "fcb_append call failure");
+
+		rc = flash_area_write(fcb->fap, FCB_ENTRY_FA_DATA_OFF(loc),
+				      test_data, sizeof(test_data));
+		zassert_true(rc == 0, "flash_area_write call failure");
+
+		rc = fcb_append_finish(fcb, &loc);
+		zassert_true(rc == 0, "fcb_append_finish call failure");
+	}
+	zassert_true(fcb->f_active.fe_sector == &test_fcb_sector[2],
+		     "elements should span three sectors");
+
+	rc = fcb_sector_summary(fcb, &test_fcb_sector[0], &sum);
+	zassert_true(rc == 0, "fcb_sector_summary call failure");
+	zassert_true(sum.fsum_first_seq == 0U, "wrong first sequence number");
+	zassert_true(sum.fsum_key_min == 0U &&
+		     sum.fsum_key_max == sum.fsum_count - 1,
+		     "wrong key range");
+	cnt0 = sum.fsum_count;
+
+	rc = fcb_sector_summary(fcb, &test_fcb_sector[1], &sum);
+	zassert_true(rc == 0, "fcb_sector_summary call failure");
+	zassert_true(sum.fsum_first_seq == cnt0, "wrong first sequence number");
+
+	rc = fcb_sector_summary(fcb, &test_fcb_sector[3], &sum);
+	zassert_true(rc != 0, "summary of a sector not in use");
+
+	rc = fcb_seq_range(fcb, &first_seq, &next_seq);
+	zassert_true(rc == 0, "fcb_seq_range call failure");
+	zassert_true(first_seq == 0U && next_seq == SUMMARY_ELEMS,
+		     "wrong sequence range");
+
+	summary_check_seek(0U);
+	summary_check_seek(cnt0);
+	summary_check_seek(SUMMARY_ELEMS - 1);
+	rc = fcb_seek_seq(fcb, SUMMARY_ELEMS, &loc);
+	zassert_true(rc == FCB_ERR_NOVAR, "seek past the last element");
+
+	walk[0] = 200U;
+	walk[1] = 0U;
+	rc = fcb_walk_key(fcb, walk[0], summary_walk_cb, walk);
+	zassert_true(rc == 0, "fcb_walk_key call failure");
+	zassert_true(walk[1] == 1U, "key not found once");
+
+	/* Summaries of closed sectors are found after restart */
+	summary_fcb_init();
+
+	rc = fcb_seq_range(fcb, &first_seq, &next_seq);
+	zassert_true(rc == 0, "fcb_seq_range call failure");
+	zassert_true(first_seq == 0U && next_seq == SUMMARY_ELEMS,
+		     "wrong sequence range after restart");
+	summary_check_seek(SUMMARY_ELEMS - 1);
+
+	rc = fcb_offset_last_n(fcb, 5, &loc);
+	zassert_true(rc == 0, "fcb_offset_last_n call failure");
+	zassert_true(summary_read_key(&loc) == SUMMARY_ELEMS - 5,
+		     "fcb_offset_last_n: fetched wrong n-th location");
+
+	/* Sequence numbers survive rotation */
+	rc = fcb_rotate(fcb);
+	zassert_true(rc == 0, "fcb_rotate call failure");
+
+	rc = fcb_seq_range(fcb, &first_seq, &next_seq);
+	zassert_true(rc == 0, "fcb_seq_range call failure");
+	zassert_true(first_seq == cnt0 && next_seq == SUMMARY_ELEMS,
+		     "wrong sequence range after rotate");
+	rc = fcb_seek_seq(fcb, 0U, &loc);
+	zassert_true(rc == FCB_ERR_NOVAR, "seek to a rotated element");
+	summary_check_seek(cnt0);
+}
+
+void fcb_test_summary_restart(void)
+{
+	struct fcb *fcb = &test_fcb;
+	struct fcb_entry loc;
+	u32_t first_seq;
+	u32_t next_seq;
+	u32_t i;
+	int rc;
+
+	summary_fcb_init();
+
+	for (i = 0U; i < 10; i++) {
+		summary_append(i, &loc, true);
+	}
+
+	/* Only the active sector is left, there is no summary to follow */
+	rc = fcb_rotate(fcb);
+	zassert_true(rc == 0, "fcb_rotate call failure");
+	zassert_true(fcb->f_oldest == fcb->f_active.fe_sector,
+		     "active sector should be the only one in use");
+
+	for (; i < 15; i++) {
+		summary_append(i, &loc, true);
+	}
+
+	summary_fcb_init();
+
+	rc = fcb_seq_range(fcb, &first_seq, &next_seq);
+	zassert_true(rc == 0, "fcb_seq_range call failure");
+	zassert_true(first_seq == 10U && next_seq == 15U,
+		     "sequence numbers restarted");
+	summary_check_seek(12U);
+
+	summary_append(i, &loc, true);
+	summary_check_seek(i);
+}
+
+void fcb_test_summary_late_finish(void)
+{
+	struct fcb *fcb = &test_fcb;
+	struct flash_sector *sector;
+	struct fcb_entry late;
+	struct fcb_entry loc;
+	u32_t walk[2];
+	u32_t i;
+	int rc;
+
+	summary_fcb_init();
+	sector = fcb->f_active.fe_sector;
+
+	/* The sector gets closed before its last element is finished */
+	summary_append(0xa5a5U, &late, false);
+	for (i = 0U; fcb->f_active.fe_sector == sector; i++) {
+		summary_append(i, &loc, true);
+	}
+
+	rc = fcb_append_finish(fcb, &late);
+	zassert_true(rc == 0, "fcb_append_finish call failure");
+
+	walk[0] = 0xa5a5U;
+	walk[1] = 0U;
+	rc = fcb_walk_key(fcb, walk[0], summary_walk_cb, walk);
+	zassert_true(rc == 0, "fcb_walk_key call failure");
+	zassert_true(walk[1] == 1U, "late element not found");
+
+	/* The summary written to flash covers it as well */
+	summary_fcb_init();
+
+	walk[1] = 0U;
+	rc = fcb_walk_key(fcb, walk[0], summary_walk_cb, walk);
+	zassert_true(rc == 0, "fcb_walk_key call failure");
+	zassert_true(walk[1] == 1U, "late element not found after restart");
+}
@@ -142,6 +142,9 @@ void fcb_test_reset(void);
 void fcb_test_rotate(void);
 void fcb_test_multi_scratch(void);
 void fcb_test_last_of_n(void);
+void fcb_test_summary(void);
+void fcb_test_summary_restart(void);
+void fcb_test_summary_late_finish(void);
 
 void test_main(void)
 {
@@ -173,7 +176,18 @@ void test_main(void)
 							teardown_nothing),
 			 ztest_unit_test_setup_teardown(fcb_test_last_of_n,
 							fcb_pretest_4_sectors,
-							teardown_nothing)
+							teardown_nothing),
+			 ztest_unit_test_setup_teardown(fcb_test_summary,
+							fcb_pretest_4_sectors,
+							teardown_nothing),
+			 ztest_unit_test_setup_teardown(
+				fcb_test_summary_restart,
+				fcb_pretest_4_sectors,
+				teardown_nothing),
+			 ztest_unit_test_setup_teardown(
+				fcb_test_summary_late_finish,
+				fcb_pretest_4_sectors,
+				teardown_nothing)
 			 );
 
 	ztest_run_test_suite(test_fcb);
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * NVS on the flash simulator, which busy-waits for the program and erase
+ * times of SoC flash. Besides correctness, the latency distribution of
+ * writes issued back-to-back and at a steady rate is reported, together with
+ * the number of writes which waited for a sector erase, either doing garbage
+ * collection themselves or waiting for the file system lock.
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+#include <flash.h>
+#include <nvs/nvs.h>
+#include <string.h>
+
+#define NVS_SECTOR_SIZE		4096
+#define NVS_SECTOR_COUNT	4
+
+#define BENCH_IDS		8
+#define BENCH_LEN		64
+#define BENCH_WRITES		2000
+#define STEADY_WRITES		500
+#define STEADY_PERIOD_MS	25
+
+/* A write taking longer than this waited for a sector erase */
+#define STALL_US		(CONFIG_FLASH_SIMULATOR_ERASE_TIME_US / 10)
+
+static struct nvs_fs fs;
+static u32_t latency_us[BENCH_WRITES];
+
+static void fill_pattern(u8_t *buf, size_t len, u32_t seed)
+{
+	for (size_t i = 0; i < len; i++) {
+		buf[i] = seed + i;
+	}
+}
+
+static void nvs_setup(bool clear)
+{
+	struct device *flash_dev;
+
+	flash_dev = device_get_binding(CONFIG_FLASH_SIMULATOR_DEV_NAME);
+	zassert_not_null(flash_dev, "no flash device");
+
+	if (clear) {
+		zassert_equal(flash_write_protection_set(flash_dev, false), 0,
+			      "disabling write protection failed");
+		zassert_equal(flash_erase(flash_dev, 0,
+					  NVS_SECTOR_SIZE * NVS_SECTOR_COUNT),
+			      0, "erase failed");
+	}
+
+	(void)memset(&fs, 0, sizeof(fs));
+	fs.offset = 0;
+	fs.sector_size = NVS_SECTOR_SIZE;
+	fs.sector_count = NVS_SECTOR_COUNT;
+
+	zassert_equal(nvs_init(&fs, CONFIG_FLASH_SIMULATOR_DEV_NAME), 0,
+		      "nvs_init failed");
+}
+
+static void check_entry(u16_t id, u32_t seed)
+{
+	u8_t expected[BENCH_LEN];
+	u8_t buf[BENCH_LEN];
+
+	fill_pattern(expected, sizeof(expected), seed);
+	zassert_equal(nvs_read(&fs, id, buf, sizeof(buf)), sizeof(buf),
+		      "nvs_read failed for id %u", id);
+	zassert_mem_equal(buf, expected, sizeof(buf), "wrong data");
+}
+
+/* Compaction moves the valid entries to a fresh sector, once */
+static void test_nvs_compact(void)
+{
+	u8_t buf[BENCH_LEN];
+
+	nvs_setup(true);
+
+	zassert_equal(nvs_compact(&fs, NVS_SECTOR_SIZE), 0,
+		      "compacted without writes");
+
+	for (u16_t id = 1; id <= BENCH_IDS; id++) {
+		fill_pattern(buf, sizeof(buf), id);
+		zassert_equal(nvs_write(&fs, id, buf, sizeof(buf)),
+			      sizeof(buf), "nvs_write failed");
+	}
+
+	zassert_equal(nvs_compact(&fs, 0), 0, "compacted with free space");
+
+	zassert_equal(nvs_compact(&fs, NVS_SECTOR_SIZE), 1,
+		      "compaction not done");
+
+	zassert_equal(nvs_compact(&fs, NVS_SECTOR_SIZE), 0,
+		      "compacted moved entries again");
+
+	for (u16_t id = 1; id <= BENCH_IDS; id++) {
+		check_entry(id, id);
+	}
+
+	/* compacted entries are found after restart */
+	nvs_setup(false);
+	for (u16_t id = 1; id <= BENCH_IDS; id++) {
+		check_entry(id, id);
+	}
+}
+
+static void sort_u32(u32_t *val, size_t cnt)
+{
+	for (size_t i = 1; i < cnt; i++) {
+		u32_t v = val[i];
+		size_t j = i;
+
+		while (j > 0 && val[j - 1] > v) {
+			val[j] = val[j - 1];
+			j--;
+		}
+		val[j] = v;
+	}
+}
+
+static u32_t percentile(const u32_t *sorted, size_t cnt, u32_t pct)
+{
+	return sorted[(cnt - 1) * pct / 100];
+}
+
+/* Writes period_ms apart, or back-to-back for 0, and returns the number of
+ * writes which waited for an erase.
+ */
+static u32_t write_bench(u32_t writes, s32_t period_ms)
+{
+	u8_t buf[BENCH_LEN];
+	u32_t stalled = 0U;
+	u32_t stall_us = 0U;
+	u32_t start;
+
+	nvs_setup(true);
+
+	for (u32_t i = 0; i < writes; i++) {
+		u16_t id = 1 + i % BENCH_IDS;
+
+		fill_pattern(buf, sizeof(buf), i);
+
+		start = k_cycle_get_32();
+		zassert_equal(nvs_write(&fs, id, buf, sizeof(buf)),
+			      sizeof(buf), "nvs_write failed");
+		latency_us[i] = SYS_CLOCK_HW_CYCLES_TO_NS(k_cycle_get_32() -
+							  start) / 1000;
+		if (latency_us[i] >= STALL_US) {
+			stalled++;
+			stall_us += latency_us[i];
+		}
+
+		if (period_ms) {
+			k_sleep(period_ms);
+		}
+	}
+
+	for (u32_t i = writes - BENCH_IDS; i < writes; i++) {
+		check_entry(1 + i % BENCH_IDS, i);
+	}
+
+	sort_u32(latency_us, writes);
+
+	TC_PRINT("%u writes of %u bytes every %d ms: p50 %u us, p90 %u us, "
+		 "p99 %u us, max %u us\n", writes, BENCH_LEN, period_ms,
+		 percentile(latency_us, writes, 50),
+		 percentile(latency_us, writes, 90),
+		 percentile(latency_us, writes, 99),
+		 latency_us[writes - 1]);
+	TC_PRINT("%u writes waited for an erase, for %u us in total\n",
+		 stalled, stall_us);
+
+	return stalled;
+}
+
+/* Writes back-to-back leave background gc no time, erases are reported */
+static void test_write_burst(void)
+{
+	zassert_not_equal(write_bench(BENCH_WRITES, 0), 0,
+			  "no write waited for gc");
+}
+
+/* Writes at a steady rate, as a control loop storing its state would. With
+ * background gc the erase completes between the writes and no write waits,
+ * neither in gc nor for the file system lock.
+ */
+static void test_write_steady(void)
+{
+	u32_t stalled = write_bench(STEADY_WRITES, STEADY_PERIOD_MS);
+
+	if (IS_ENABLED(CONFIG_NVS_BACKGROUND_GC)) {
+		zassert_equal(stalled, 0, "write waited for gc");
+	} else {
+		zassert_not_equal(stalled, 0, "no write waited for gc");
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nvs,
+			 ztest_unit_test(test_nvs_compact),
+			 ztest_unit_test(test_write_burst),
+			 ztest_unit_test(test_write_steady));
+	ztest_run_test_suite(nvs);
+}
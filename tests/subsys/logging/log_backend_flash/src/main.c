@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Test flash log backend
+ */
+
+#include <logging/log.h>
+#include <logging/log_backend_flash.h>
+#include <logging/log_ctrl.h>
+
+#include <tc_util.h>
+#include <stdbool.h>
+#include <zephyr.h>
+#include <ztest.h>
+
+LOG_MODULE_REGISTER(test, LOG_LEVEL_INF);
+
+/* Enough messages to fill all sectors. */
+#define WRAP_MSG_CNT 1000
+
+struct walk_ctx {
+	u32_t cnt;
+	u32_t first_seq;
+	u32_t last_seq;
+	u64_t first_time;
+	u64_t prev_time;
+	bool ordered;
+};
+
+static int walk_cb(const struct log_backend_flash_block *block, void *ctx)
+{
+	struct walk_ctx *walk = ctx;
+	u64_t time = LOG_BACKEND_FLASH_TIME(block->boot, block->timestamp);
+
+	zassert_true(block->len > 0, "Empty block.");
+	zassert_equal(block->data[0], 0xA5, "Unexpected record.");
+
+	if (walk->cnt == 0) {
+		walk->first_seq = block->seq;
+		walk->first_time = time;
+	} else if (block->seq != walk->last_seq + 1 ||
+		   time < walk->prev_time) {
+		walk->ordered = false;
+	}
+
+	walk->last_seq = block->seq;
+	walk->prev_time = time;
+	walk->cnt++;
+
+	return 0;
+}
+
+static void walk(struct walk_ctx *ctx, u64_t min_time, u32_t min_seq)
+{
+	int rc;
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->ordered = true;
+
+	rc = log_backend_flash_walk(min_time, min_seq, walk_cb, ctx);
+	zassert_equal(rc, 0, "Unexpected walk result.");
+	zassert_true(ctx->ordered, "Blocks out of order.");
+}
+
+static void log_msgs(u32_t cnt)
+{
+	for (u32_t i = 0; i < cnt; i++) {
+		LOG_INF("test message %d", i);
+
+		while (log_process(false)) {
+		}
+	}
+
+	zassert_equal(log_backend_flash_flush(), 0, "Flush failed.");
+}
+
+static void test_log_backend_flash_store(void)
+{
+	struct walk_ctx ctx;
+	u32_t seq;
+
+	zassert_equal(log_backend_flash_clear(), 0, "Clear failed.");
+	seq = log_backend_flash_next_seq_get();
+
+	walk(&ctx, 0, 0);
+	zassert_equal(ctx.cnt, 0, "Log not empty after clear.");
+
+	log_msgs(20);
+
+	walk(&ctx, 0, 0);
+	zassert_true(ctx.cnt > 1, "Expected messages in several blocks.");
+	zassert_equal(ctx.first_seq, seq, "Unexpected first block.");
+	zassert_equal(ctx.last_seq + 1, log_backend_flash_next_seq_get(),
+		      "Unexpected last block.");
+}
+
+static void test_log_backend_flash_wrap(void)
+{
+	struct walk_ctx ctx;
+	u32_t seq;
+
+	zassert_equal(log_backend_flash_clear(), 0, "Clear failed.");
+	seq = log_backend_flash_next_seq_get();
+
+	log_msgs(WRAP_MSG_CNT);
+
+	walk(&ctx, 0, 0);
+	zassert_true(ctx.first_seq > seq, "Oldest blocks not overwritten.");
+	zassert_equal(ctx.last_seq + 1, log_backend_flash_next_seq_get(),
+		      "Newest block missing.");
+}
+
+static void test_log_backend_flash_seek(void)
+{
+	struct walk_ctx all;
+	struct walk_ctx ctx;
+	u32_t mid_seq;
+	u64_t mid_time;
+
+	zassert_equal(log_backend_flash_clear(), 0, "Clear failed.");
+	log_msgs(WRAP_MSG_CNT);
+
+	walk(&all, 0, 0);
+	zassert_true(all.cnt > 4, "Not enough blocks.");
+
+	/* Seek to the block in the middle of the log. */
+	mid_seq = all.first_seq + all.cnt / 2;
+	walk(&ctx, 0, mid_seq);
+	zassert_equal(ctx.first_seq, mid_seq, "Seek by sequence failed.");
+	zassert_equal(ctx.last_seq, all.last_seq, "Seek by sequence failed.");
+	mid_time = ctx.first_time;
+
+	/* Preceding blocks may start with the same timestamp. */
+	walk(&ctx, mid_time, 0);
+	zassert_true(ctx.first_time >= mid_time, "Seek by time failed.");
+	zassert_true(ctx.first_seq <= mid_seq, "Seek by time skipped blocks.");
+	zassert_equal(ctx.last_seq, all.last_seq, "Seek by time failed.");
+}
+
+static u32_t test_timestamp;
+
+static u32_t test_timestamp_get(void)
+{
+	return test_timestamp;
+}
+
+static u32_t cycle_timestamp_get(void)
+{
+	return k_cycle_get_32();
+}
+
+static int last_block_cb(const struct log_backend_flash_block *block,
+			 void *ctx)
+{
+	*(struct log_backend_flash_block *)ctx = *block;
+
+	return 0;
+}
+
+static void test_log_backend_flash_timestamp_wrap(void)
+{
+	struct log_backend_flash_block before;
+	struct log_backend_flash_block after;
+	u32_t seq;
+
+	zassert_equal(log_backend_flash_clear(), 0, "Clear failed.");
+	log_set_timestamp_func(test_timestamp_get, 1000);
+
+	test_timestamp = 0xFFFFFFF0;
+	log_msgs(1);
+	seq = log_backend_flash_next_seq_get();
+	zassert_equal(log_backend_flash_walk(0, seq - 1, last_block_cb,
+					     &before), 0, "Walk failed.");
+
+	test_timestamp = 0x10;
+	log_msgs(1);
+	seq = log_backend_flash_next_seq_get();
+	zassert_equal(log_backend_flash_walk(0, seq - 1, last_block_cb,
+					     &after), 0, "Walk failed.");
+
+	log_set_timestamp_func(cycle_timestamp_get,
+			       CONFIG_SYS_CLOCK_HW_CYCLES_PER_SEC);
+
+	/* Wrap is not a reboot, only the extended timestamp grows. */
+	zassert_equal(after.boot, before.boot, "Wrap counted as a boot.");
+	zassert_equal((u32_t)after.timestamp, 0x10, "Unexpected timestamp.");
+	zassert_equal(after.timestamp >> 32, (before.timestamp >> 32) + 1,
+		      "Wrap not counted.");
+	zassert_true(LOG_BACKEND_FLASH_TIME(after.boot, after.timestamp) >
+		     LOG_BACKEND_FLASH_TIME(before.boot, before.timestamp),
+		     "Time key not growing.");
+}
+
+static void test_log_backend_flash_clear(void)
+{
+	struct walk_ctx ctx;
+	u32_t seq;
+
+	log_msgs(10);
+	seq = log_backend_flash_next_seq_get();
+
+	zassert_equal(log_backend_flash_clear(), 0, "Clear failed.");
+
+	walk(&ctx, 0, 0);
+	zassert_equal(ctx.cnt, 0, "Log not empty after clear.");
+	zassert_equal(log_backend_flash_next_seq_get(), seq,
+		      "Sequence numbering restarted.");
+}
+
+/*test case main entry*/
+void test_main(void)
+{
+	ztest_test_suite(test_log_backend_flash,
+			 ztest_unit_test(test_log_backend_flash_store),
+			 ztest_unit_test(test_log_backend_flash_wrap),
+			 ztest_unit_test(test_log_backend_flash_seek),
+			 ztest_unit_test(test_log_backend_flash_timestamp_wrap),
+			 ztest_unit_test(test_log_backend_flash_clear));
+	ztest_run_test_suite(test_log_backend_flash);
+}
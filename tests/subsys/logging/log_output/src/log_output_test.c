@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Test dictionary based log output
+ */
+
+#include <logging/log_msg.h>
+#include <logging/log_output.h>
+#include <logging/log.h>
+#include <misc/byteorder.h>
+
+#include <tc_util.h>
+#include <stdbool.h>
+#include <zephyr.h>
+#include <ztest.h>
+
+#define TEST_SOURCE_ID 3
+#define TEST_TIMESTAMP 0x12345678
+
+static u8_t mock_buffer[64];
+static u32_t mock_len;
+
+static int mock_output(u8_t *data, size_t size, void *ctx)
+{
+	zassert_true(mock_len + size <= sizeof(mock_buffer),
+		     "Output overflow.");
+
+	memcpy(&mock_buffer[mock_len], data, size);
+	mock_len += size;
+
+	return size;
+}
+
+/* Small buffer so that records are flushed in pieces. */
+static u8_t buf[4];
+
+LOG_OUTPUT_DEFINE(log_output, mock_output, buf, sizeof(buf));
+
+static const char fmt[] = "%d %s";
+static const char hexdump_str[] = "data";
+
+static void msg_ids_set(struct log_msg *msg)
+{
+	msg->hdr.ids.level = LOG_LEVEL_INF;
+	msg->hdr.ids.domain_id = 0;
+	msg->hdr.ids.source_id = TEST_SOURCE_ID;
+	msg->hdr.timestamp = TEST_TIMESTAMP;
+}
+
+static void validate_hdr(u8_t type)
+{
+	u8_t exp_hdr[] = {
+		0xA5, type | (LOG_LEVEL_INF << 4),
+		TEST_SOURCE_ID, 0x00,
+		0x78, 0x56, 0x34, 0x12
+	};
+
+	zassert_true(mock_len >= sizeof(exp_hdr), "Record too short.");
+	zassert_equal(memcmp(mock_buffer, exp_hdr, sizeof(exp_hdr)), 0,
+		      "Unexpected record header.");
+}
+
+static void test_log_output_dict_std(void)
+{
+	static const char str_arg[] = "abc";
+	u8_t *data = &mock_buffer[8];
+	struct log_msg *msg;
+
+	mock_len = 0;
+	msg = log_msg_create_2(fmt, 5, (u32_t)str_arg);
+	zassert_true(msg != NULL, "Failed to allocate message.");
+	msg_ids_set(msg);
+
+	log_output_msg_process(&log_output, msg, LOG_OUTPUT_FLAG_DICTIONARY);
+	log_msg_put(msg);
+
+	validate_hdr(1);
+	zassert_equal(mock_len, 8 + 4 + 1 + 2 * 4 + 1 + strlen(str_arg),
+		      "Unexpected record length.");
+	zassert_equal(sys_get_le32(data), (u32_t)fmt,
+		      "Unexpected format string address.");
+	zassert_equal(data[4], 2, "Unexpected number of arguments.");
+	zassert_equal(sys_get_le32(&data[5]), 5, "Unexpected argument.");
+	zassert_equal(sys_get_le32(&data[9]), (u32_t)str_arg,
+		      "Unexpected argument.");
+	zassert_equal(data[13], strlen(str_arg),
+		      "Unexpected string length.");
+	zassert_equal(memcmp(&data[14], str_arg, strlen(str_arg)), 0,
+		      "Unexpected string argument.");
+}
+
+static void test_log_output_dict_hexdump(void)
+{
+	u8_t hexdump[20];
+	u8_t *data = &mock_buffer[8];
+	struct log_msg *msg;
+
+	for (int i = 0; i < sizeof(hexdump); i++) {
+		hexdump[i] = i;
+	}
+
+	mock_len = 0;
+	msg = log_msg_hexdump_create(hexdump_str, hexdump, sizeof(hexdump));
+	zassert_true(msg != NULL, "Failed to allocate message.");
+	msg_ids_set(msg);
+
+	log_output_msg_process(&log_output, msg, LOG_OUTPUT_FLAG_DICTIONARY);
+	log_msg_put(msg);
+
+	validate_hdr(2);
+	zassert_equal(mock_len, 8 + 4 + 2 + sizeof(hexdump),
+		      "Unexpected record length.");
+	zassert_equal(sys_get_le32(data), (u32_t)hexdump_str,
+		      "Unexpected string address.");
+	zassert_equal(sys_get_le16(&data[4]), sizeof(hexdump),
+		      "Unexpected data length.");
+	zassert_equal(memcmp(&data[6], hexdump, sizeof(hexdump)), 0,
+		      "Unexpected data.");
+}
+
+static void test_log_output_dict_dropped(void)
+{
+	u8_t exp[] = {
+		0xA5, 4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x34, 0x12, 0x00, 0x00
+	};
+
+	mock_len = 0;
+	log_output_flags_set(&log_output, LOG_OUTPUT_FLAG_DICTIONARY);
+	log_output_dropped_process(&log_output, 0x1234);
+	log_output_flags_set(&log_output, 0);
+
+	zassert_equal(mock_len, sizeof(exp), "Unexpected record length.");
+	zassert_equal(memcmp(mock_buffer, exp, sizeof(exp)), 0,
+		      "Unexpected record.");
+}
+
+/* Instances without the dictionary flag keep the readable indication. */
+static void test_log_output_text_dropped(void)
+{
+	mock_len = 0;
+	log_output_dropped_process(&log_output, 0x1234);
+
+	zassert_true(mock_len < sizeof(mock_buffer), "Output too long.");
+	mock_buffer[mock_len] = '\0';
+
+	/* colors may surround the text */
+	zassert_not_null(strstr((char *)mock_buffer,
+				"--- 4660 messages dropped ---\r\n"),
+			 "Unexpected indication.");
+}
+
+/*test case main entry*/
+void test_main(void)
+{
+	ztest_test_suite(test_log_output,
+			 ztest_unit_test(test_log_output_dict_std),
+			 ztest_unit_test(test_log_output_dict_hexdump),
+			 ztest_unit_test(test_log_output_dict_dropped),
+			 ztest_unit_test(test_log_output_text_dropped));
+	ztest_run_test_suite(test_log_output);
+}
@@ -0,0 +1,433 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * CBOR reader and writer of the mcumgr net_bufs on fragment chains. The
+ * buffers are configured small, so that short requests are already spread
+ * over several fragments. Responses of a test command group are sent
+ * through an SMP transport whose output collects the fragments.
+ */
+
+#include <ztest.h>
+#include <misc/byteorder.h>
+#include <net/buf.h>
+#include <mgmt/buf.h>
+#include <mgmt/smp.h>
+#include <mgmt/mgmt.h>
+#include "cbor_buf_writer.h"
+
+#define DATA_SIZE	16
+#define FLAT_SIZE	128
+#define MTU		20
+#define TEST_GROUP	MGMT_GROUP_ID_PERUSER
+#define TEST_SEQ	5
+
+static const char test_name[] = "a name which does not fit into a buffer";
+static u8_t test_data[30];
+static u8_t flat[FLAT_SIZE];
+static size_t flat_len;
+
+static struct zephyr_smp_transport test_zst;
+static u8_t rsp_flat[FLAT_SIZE];
+static size_t rsp_len;
+static int output_rc;
+static u16_t mtu;
+
+/* Copies data into a chain of fragments holding up to piece bytes each */
+static struct net_buf *chain_create(const u8_t *data, size_t len,
+				    size_t piece)
+{
+	struct net_buf *nb = NULL;
+	struct net_buf *frag;
+
+	for (size_t off = 0; off < len; off += piece) {
+		frag = mcumgr_buf_alloc();
+		zassert_not_null(frag, "no buffer");
+
+		net_buf_add_mem(frag, &data[off], min(piece, len - off));
+		if (nb == NULL) {
+			nb = frag;
+		} else {
+			net_buf_frag_add(nb, frag);
+		}
+	}
+
+	return nb;
+}
+
+/* Returns the fragment holding len bytes at ptr */
+static struct net_buf *chain_frag(struct net_buf *nb, const u8_t *ptr,
+				  size_t len)
+{
+	for (; nb != NULL; nb = nb->frags) {
+		if (ptr >= nb->data && ptr + len <= nb->data + nb->len) {
+			return nb;
+		}
+	}
+
+	return NULL;
+}
+
+/* Every buffer of the pool has been released */
+static void check_released(void)
+{
+	struct net_buf *nb[CONFIG_MCUMGR_BUF_COUNT];
+
+	for (int i = 0; i < ARRAY_SIZE(nb); i++) {
+		nb[i] = mcumgr_buf_alloc();
+		zassert_not_null(nb[i], "buffer leaked");
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(nb); i++) {
+		mcumgr_buf_free(nb[i]);
+	}
+}
+
+static CborError encode(CborEncoder *enc)
+{
+	CborEncoder map;
+	CborError err = 0;
+
+	err |= cbor_encoder_create_map(enc, &map, 3);
+	err |= cbor_encode_text_stringz(&map, "name");
+	err |= cbor_encode_text_stringz(&map, test_name);
+	err |= cbor_encode_text_stringz(&map, "data");
+	err |= cbor_encode_byte_string(&map, test_data, sizeof(test_data));
+	err |= cbor_encode_text_stringz(&map, "id");
+	err |= cbor_encode_int(&map, 7);
+	err |= cbor_encoder_close_container(enc, &map);
+
+	return err;
+}
+
+static void encode_flat(void)
+{
+	struct cbor_buf_writer writer;
+	CborEncoder enc;
+
+	for (int i = 0; i < sizeof(test_data); i++) {
+		test_data[i] = 0x80 + i;
+	}
+
+	cbor_buf_writer_init(&writer, flat, sizeof(flat));
+	cbor_encoder_cust_writer_init(&enc, &writer.enc, 0);
+	zassert_equal(encode(&enc), CborNoError, "encoding failed");
+
+	flat_len = writer.enc.bytes_written;
+}
+
+/*
+ * Reads a string chunk by chunk. Returns the number of chunks, which are
+ * expected in place and cut only at fragment ends.
+ */
+static int check_string(struct net_buf *nb, CborValue *value,
+			const void *exp, size_t exp_len)
+{
+	struct net_buf *frag;
+	const u8_t *ptr;
+	size_t total = 0;
+	size_t len;
+	int chunks = 0;
+	CborError err;
+
+	while (true) {
+		if (cbor_value_is_text_string(value)) {
+			err = cbor_value_get_text_string_chunk(value,
+					(const char **)&ptr, &len, value);
+		} else {
+			err = cbor_value_get_byte_string_chunk(value, &ptr,
+							       &len, value);
+		}
+		zassert_equal(err, CborNoError, "chunk not read");
+
+		if (ptr == NULL) {
+			break;
+		}
+
+		frag = chain_frag(nb, ptr, len);
+		zassert_not_null(frag, "chunk not in place");
+		zassert_true(ptr + len == frag->data + frag->len ||
+			     total + len == exp_len,
+			     "chunk cut before the end of the fragment");
+		zassert_true(total + len <= exp_len, "string too long");
+		zassert_equal(memcmp(ptr, (const u8_t *)exp + total, len), 0,
+			      "wrong string data");
+
+		total += len;
+		chunks++;
+	}
+
+	zassert_equal(total, exp_len, "string too short");
+
+	return chunks;
+}
+
+/* Decodes the map of encode() of size bytes from nb, returns the chunks of
+ * the name
+ */
+static int check_map(struct net_buf *nb, size_t size)
+{
+	struct cbor_nb_reader reader;
+	CborParser parser;
+	CborValue value;
+	CborValue elem;
+	int chunks;
+	int id;
+
+	cbor_nb_reader_init(&reader, nb);
+	zassert_equal(reader.r.message_size, size, "wrong message size");
+
+	zassert_equal(cbor_parser_cust_reader_init(&reader.r, 0, &parser,
+						   &value),
+		      CborNoError, "parser not initialized");
+	zassert_true(cbor_value_is_map(&value), "no map");
+
+	zassert_equal(cbor_value_map_find_value(&value, "id", &elem),
+		      CborNoError, "id not found");
+	zassert_equal(cbor_value_get_int(&elem, &id), CborNoError,
+		      "id not an integer");
+	zassert_equal(id, 7, "wrong id");
+
+	zassert_equal(cbor_value_map_find_value(&value, "nam", &elem),
+		      CborNoError, "lookup failed");
+	zassert_false(cbor_value_is_valid(&elem), "key prefix matched");
+
+	zassert_equal(cbor_value_map_find_value(&value, "name", &elem),
+		      CborNoError, "name not found");
+	zassert_true(cbor_value_is_text_string(&elem), "name not a text");
+	chunks = check_string(nb, &elem, test_name, strlen(test_name));
+
+	zassert_equal(cbor_value_map_find_value(&value, "data", &elem),
+		      CborNoError, "data not found");
+	zassert_true(cbor_value_is_byte_string(&elem), "data not bytes");
+	check_string(nb, &elem, test_data, sizeof(test_data));
+
+	return chunks;
+}
+
+static u64_t get_be64(const u8_t *src)
+{
+	return ((u64_t)sys_get_be32(src) << 32) | sys_get_be32(&src[4]);
+}
+
+static void check_get(struct cbor_decoder_reader *r, const u8_t *data,
+		      int off)
+{
+	zassert_equal(r->get8(r, off),
+		      off + 1 <= DATA_SIZE ? data[off] : UINT8_MAX,
+		      "wrong 8-bit value at %d", off);
+	zassert_equal(r->get16(r, off),
+		      off + 2 <= DATA_SIZE ? sys_get_be16(&data[off]) :
+		      UINT16_MAX, "wrong 16-bit value at %d", off);
+	zassert_equal(r->get32(r, off),
+		      off + 4 <= DATA_SIZE ? sys_get_be32(&data[off]) :
+		      UINT32_MAX, "wrong 32-bit value at %d", off);
+	zassert_equal(r->get64(r, off),
+		      off + 8 <= DATA_SIZE ? get_be64(&data[off]) :
+		      UINT64_MAX, "wrong 64-bit value at %d", off);
+}
+
+/* Integers are read across fragment boundaries in both directions */
+static void test_reader_get(void)
+{
+	static const size_t pieces[] = { 1, 3, 5, DATA_SIZE };
+	struct cbor_nb_reader reader;
+	struct net_buf *nb;
+	u8_t data[DATA_SIZE];
+
+	for (int i = 0; i < DATA_SIZE; i++) {
+		data[i] = 29 * i + 7;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(pieces); i++) {
+		nb = chain_create(data, DATA_SIZE, pieces[i]);
+		cbor_nb_reader_init(&reader, nb);
+		zassert_equal(reader.r.message_size, DATA_SIZE,
+			      "wrong message size");
+
+		for (int off = 0; off <= DATA_SIZE; off++) {
+			check_get(&reader.r, data, off);
+		}
+
+		/* the reader starts again from the head of the chain */
+		for (int off = DATA_SIZE; off >= 0; off--) {
+			check_get(&reader.r, data, off);
+		}
+
+		zassert_equal(reader.r.get8(&reader.r, -1), UINT8_MAX,
+			      "negative offset read");
+
+		mcumgr_buf_free(nb);
+	}
+
+	check_released();
+}
+
+/* Strings and map keys which straddle fragments are decoded in place */
+static void test_reader_strings(void)
+{
+	static const size_t pieces[] = { 7, 13, CONFIG_MCUMGR_BUF_SIZE };
+	struct net_buf *nb;
+
+	encode_flat();
+
+	for (int i = 0; i < ARRAY_SIZE(pieces); i++) {
+		nb = chain_create(flat, flat_len, pieces[i]);
+		zassert_true(check_map(nb, flat_len) > 1, "name not split");
+		mcumgr_buf_free(nb);
+	}
+
+	check_released();
+}
+
+/* A plain writer stops at the end of its buffer */
+static void test_writer_full(void)
+{
+	struct cbor_nb_writer writer;
+	struct net_buf *nb;
+	CborEncoder enc;
+
+	encode_flat();
+
+	nb = mcumgr_buf_alloc();
+	zassert_not_null(nb, "no buffer");
+
+	cbor_nb_writer_init(&writer, nb);
+	cbor_encoder_cust_writer_init(&enc, &writer.enc, 0);
+	zassert_true(encode(&enc) & CborErrorOutOfMemory,
+		     "encoding did not run out of memory");
+	zassert_is_null(nb->frags, "fragment added");
+	zassert_equal(writer.enc.bytes_written, nb->len,
+		      "wrong number of bytes written");
+
+	mcumgr_buf_free(nb);
+	check_released();
+}
+
+static int test_read(struct mgmt_ctxt *ctxt)
+{
+	return encode(&ctxt->encoder) ? MGMT_ERR_ENOMEM : 0;
+}
+
+static const struct mgmt_handler test_handlers[] = {
+	{ .mh_read = test_read },
+};
+
+static struct mgmt_group test_group = {
+	.mg_handlers = test_handlers,
+	.mg_handlers_count = ARRAY_SIZE(test_handlers),
+	.mg_group_id = TEST_GROUP,
+};
+
+/* Collects the fragments of the responses, which it owns */
+static int test_output(struct zephyr_smp_transport *zst, struct net_buf *nb)
+{
+	zassert_is_null(nb->frags, "fragment is a chain");
+	zassert_true(nb->len > 0 && nb->len <= mtu, "wrong fragment length");
+
+	if (output_rc == 0) {
+		zassert_true(rsp_len + nb->len <= sizeof(rsp_flat),
+			     "response too long");
+		memcpy(&rsp_flat[rsp_len], nb->data, nb->len);
+		rsp_len += nb->len;
+	}
+
+	mcumgr_buf_free(nb);
+
+	return output_rc;
+}
+
+static u16_t test_get_mtu(const struct net_buf *nb)
+{
+	return mtu;
+}
+
+/* Sends a read request of the test command and lets the SMP layer run */
+static void request(void)
+{
+	static const u8_t payload[] = { 0xa0 };
+	struct mgmt_hdr hdr = {
+		.nh_op = MGMT_OP_READ,
+		.nh_len = sizeof(payload),
+		.nh_group = TEST_GROUP,
+		.nh_seq = TEST_SEQ,
+		.nh_id = 0,
+	};
+	struct net_buf *nb;
+
+	encode_flat();
+	rsp_len = 0;
+
+	nb = mcumgr_buf_alloc();
+	zassert_not_null(nb, "no buffer");
+
+	mgmt_hton_hdr(&hdr);
+	net_buf_add_mem(nb, &hdr, sizeof(hdr));
+	net_buf_add_mem(nb, payload, sizeof(payload));
+
+	zephyr_smp_rx_req(&test_zst, nb);
+	k_sleep(100);
+}
+
+/*
+ * A chain writer adds fragments as needed, the response is split into
+ * MTU-sized packets again.
+ */
+static void test_writer_chain(void)
+{
+	struct mgmt_hdr hdr;
+	struct net_buf *nb;
+
+	output_rc = 0;
+	mtu = MTU;
+	request();
+
+	zassert_true(rsp_len > MGMT_HDR_SIZE + CONFIG_MCUMGR_BUF_SIZE,
+		     "response not chained");
+
+	memcpy(&hdr, rsp_flat, sizeof(hdr));
+	mgmt_ntoh_hdr(&hdr);
+	zassert_equal(hdr.nh_op, MGMT_OP_READ_RSP, "wrong operation");
+	zassert_equal(hdr.nh_len, rsp_len - MGMT_HDR_SIZE, "wrong length");
+	zassert_equal(hdr.nh_group, TEST_GROUP, "wrong group");
+	zassert_equal(hdr.nh_seq, TEST_SEQ, "wrong sequence number");
+
+	nb = chain_create(&rsp_flat[MGMT_HDR_SIZE], hdr.nh_len, 11);
+	check_map(nb, hdr.nh_len);
+	mcumgr_buf_free(nb);
+
+	check_released();
+}
+
+/* Responses which are not sent are released */
+static void test_tx_error(void)
+{
+	output_rc = -EIO;
+	mtu = MTU;
+	request();
+	check_released();
+
+	output_rc = 0;
+	mtu = 0;
+	request();
+	zassert_equal(rsp_len, 0, "sent without MTU");
+	check_released();
+}
+
+void test_main(void)
+{
+	zephyr_smp_transport_init(&test_zst, test_output, test_get_mtu, NULL,
+				  NULL);
+	mgmt_register_group(&test_group);
+
+	ztest_test_suite(mgmt_buf,
+			 ztest_unit_test(test_reader_get),
+			 ztest_unit_test(test_reader_strings),
+			 ztest_unit_test(test_writer_full),
+			 ztest_unit_test(test_writer_chain),
+			 ztest_unit_test(test_tx_error));
+	ztest_run_test_suite(mgmt_buf);
+}
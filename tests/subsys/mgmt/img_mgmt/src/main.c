@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Image upload of mcumgr with out-of-order chunks. Upload requests are
+ * handed to the SMP layer through a test transport and written to the
+ * second image slot. Chunks arriving ahead of the expected offset are kept
+ * and must reach the image in order once the missing chunk has been
+ * received.
+ */
+
+#include <ztest.h>
+#include <misc/byteorder.h>
+#include <net/buf.h>
+#include <mgmt/buf.h>
+#include <mgmt/smp.h>
+#include <mgmt/mgmt.h>
+#include <img_mgmt/img_mgmt.h>
+#include <img_mgmt/img_mgmt_impl.h>
+#include <img_mgmt/image.h>
+#include "cbor_buf_reader.h"
+#include "cbor_buf_writer.h"
+
+#define CHUNK_SIZE	CONFIG_IMG_MGMT_UL_CHUNK_SIZE
+#define IMAGE_CHUNKS	6
+#define IMAGE_SIZE	(IMAGE_CHUNKS * CHUNK_SIZE)
+#define REQ_SIZE	(CHUNK_SIZE + 32)
+#define RSP_SIZE	64
+#define MTU		RSP_SIZE
+
+static u8_t image[IMAGE_SIZE];
+static u8_t slot[IMAGE_SIZE];
+
+static struct zephyr_smp_transport test_zst;
+static K_SEM_DEFINE(rsp_sem, 0, 1);
+static u8_t rsp_flat[RSP_SIZE];
+static size_t rsp_len;
+
+/* Collects the response, which fits into a single fragment */
+static int test_output(struct zephyr_smp_transport *zst, struct net_buf *nb)
+{
+	zassert_true(nb->len <= sizeof(rsp_flat), "response too long");
+	memcpy(rsp_flat, nb->data, nb->len);
+	rsp_len = nb->len;
+
+	mcumgr_buf_free(nb);
+	k_sem_give(&rsp_sem);
+
+	return 0;
+}
+
+static u16_t test_get_mtu(const struct net_buf *nb)
+{
+	return MTU;
+}
+
+static size_t encode_req(u8_t *buf, size_t size, int chunk)
+{
+	struct cbor_buf_writer writer;
+	CborEncoder enc;
+	CborEncoder map;
+	CborError err = 0;
+
+	cbor_buf_writer_init(&writer, buf, size);
+	cbor_encoder_cust_writer_init(&enc, &writer.enc, 0);
+
+	err |= cbor_encoder_create_map(&enc, &map, CborIndefiniteLength);
+	err |= cbor_encode_text_stringz(&map, "data");
+	err |= cbor_encode_byte_string(&map, &image[chunk * CHUNK_SIZE],
+				       CHUNK_SIZE);
+	if (chunk == 0) {
+		err |= cbor_encode_text_stringz(&map, "len");
+		err |= cbor_encode_uint(&map, IMAGE_SIZE);
+	}
+	err |= cbor_encode_text_stringz(&map, "off");
+	err |= cbor_encode_uint(&map, chunk * CHUNK_SIZE);
+	err |= cbor_encoder_close_container(&enc, &map);
+	zassert_equal(err, CborNoError, "request encoding failed");
+
+	return writer.enc.bytes_written;
+}
+
+/* Returns the value of an integer field of the response */
+static s64_t rsp_int(const char *key)
+{
+	struct cbor_buf_reader reader;
+	CborParser parser;
+	CborValue value;
+	CborValue field;
+	s64_t ret;
+
+	cbor_buf_reader_init(&reader, &rsp_flat[MGMT_HDR_SIZE],
+			     rsp_len - MGMT_HDR_SIZE);
+	zassert_equal(cbor_parser_cust_reader_init(&reader.r, 0, &parser,
+						   &value), CborNoError,
+		      "response not parsed");
+	zassert_equal(cbor_value_map_find_value(&value, key, &field),
+		      CborNoError, "response not parsed");
+	zassert_true(cbor_value_is_integer(&field), "no %s in response", key);
+	zassert_equal(cbor_value_get_int64(&field, &ret), CborNoError,
+		      "wrong %s in response", key);
+
+	return ret;
+}
+
+/* Sends one chunk, returns the offset the image manager expects next */
+static s64_t upload(int chunk)
+{
+	u8_t payload[REQ_SIZE];
+	struct mgmt_hdr hdr = {
+		.nh_op = MGMT_OP_WRITE,
+		.nh_group = MGMT_GROUP_ID_IMAGE,
+		.nh_seq = chunk,
+		.nh_id = IMG_MGMT_ID_UPLOAD,
+	};
+	struct net_buf *nb;
+
+	hdr.nh_len = encode_req(payload, sizeof(payload), chunk);
+	mgmt_hton_hdr(&hdr);
+
+	nb = mcumgr_buf_alloc();
+	zassert_not_null(nb, "no buffer");
+	net_buf_add_mem(nb, &hdr, sizeof(hdr));
+	net_buf_add_mem(nb, payload, sys_be16_to_cpu(hdr.nh_len));
+
+	/* The first chunk of an upload may have to erase the slot */
+	zephyr_smp_rx_req(&test_zst, nb);
+	zassert_equal(k_sem_take(&rsp_sem, K_SECONDS(60)), 0, "no response");
+
+	memcpy(&hdr, rsp_flat, sizeof(hdr));
+	mgmt_ntoh_hdr(&hdr);
+	zassert_equal(hdr.nh_op, MGMT_OP_WRITE_RSP, "wrong operation");
+	zassert_equal(hdr.nh_seq, chunk, "wrong sequence number");
+	zassert_equal(rsp_int("rc"), 0, "chunk %d rejected", chunk);
+
+	return rsp_int("off");
+}
+
+static void check_slot(void)
+{
+	(void)memset(slot, 0, sizeof(slot));
+	zassert_equal(img_mgmt_impl_read(1, 0, slot, sizeof(slot)), 0,
+		      "slot not read");
+	zassert_mem_equal(slot, image, IMAGE_SIZE, "wrong image data");
+}
+
+static void image_init(void)
+{
+	struct image_header hdr = {
+		.ih_magic = IMAGE_MAGIC,
+	};
+
+	for (size_t i = 0; i < sizeof(image); i++) {
+		image[i] = i ^ (i >> 8);
+	}
+
+	memcpy(image, &hdr, sizeof(hdr));
+}
+
+static void test_upload_in_order(void)
+{
+	for (int i = 0; i < IMAGE_CHUNKS; i++) {
+		zassert_equal(upload(i), (i + 1) * CHUNK_SIZE,
+			      "wrong expected offset");
+	}
+
+	check_slot();
+}
+
+/* Chunks after a lost one are written when it is sent again */
+static void test_upload_reordered(void)
+{
+	zassert_equal(upload(0), CHUNK_SIZE, "first chunk not written");
+	zassert_equal(upload(2), CHUNK_SIZE, "chunk ahead written");
+	zassert_equal(upload(3), CHUNK_SIZE, "chunk ahead written");
+
+	zassert_equal(upload(1), 4 * CHUNK_SIZE, "kept chunks not written");
+
+	zassert_equal(upload(4), 5 * CHUNK_SIZE, "wrong expected offset");
+	zassert_equal(upload(5), IMAGE_SIZE, "wrong expected offset");
+
+	check_slot();
+}
+
+/* A kept last chunk completes the upload */
+static void test_upload_last_kept(void)
+{
+	upload(0);
+	zassert_equal(upload(5), CHUNK_SIZE, "chunk ahead written");
+
+	for (int i = 1; i < IMAGE_CHUNKS - 2; i++) {
+		upload(i);
+	}
+
+	zassert_equal(upload(4), IMAGE_SIZE, "kept last chunk not written");
+	check_slot();
+}
+
+/* Chunks which find no free entry are dropped and have to be resent */
+static void test_upload_reorder_full(void)
+{
+	upload(0);
+	upload(2);
+	upload(3);
+	upload(4);
+
+	zassert_equal(upload(1), 4 * CHUNK_SIZE, "dropped chunk written");
+	zassert_equal(upload(5), 4 * CHUNK_SIZE, "chunk ahead written");
+	zassert_equal(upload(4), IMAGE_SIZE, "kept chunk not written");
+
+	check_slot();
+}
+
+/* Retransmissions neither take a second entry nor get written again */
+static void test_upload_retransmit(void)
+{
+	upload(0);
+	upload(2);
+	upload(2);
+	upload(3);
+
+	zassert_equal(upload(1), 4 * CHUNK_SIZE, "kept chunks not written");
+	zassert_equal(upload(1), 4 * CHUNK_SIZE, "old chunk accepted");
+	zassert_equal(upload(3), 4 * CHUNK_SIZE, "old chunk accepted");
+
+	upload(4);
+	zassert_equal(upload(5), IMAGE_SIZE, "upload not finished");
+
+	check_slot();
+}
+
+/* Chunks kept for an upload are not used by the next one */
+static void test_upload_restart(void)
+{
+	upload(0);
+	upload(2);
+
+	zassert_equal(upload(0), CHUNK_SIZE, "upload not restarted");
+	zassert_equal(upload(1), 2 * CHUNK_SIZE,
+		      "chunk of previous upload written");
+
+	for (int i = 2; i < IMAGE_CHUNKS; i++) {
+		upload(i);
+	}
+
+	check_slot();
+}
+
+void test_main(void)
+{
+	image_init();
+
+	zephyr_smp_transport_init(&test_zst, test_output, test_get_mtu, NULL,
+				  NULL);
+	img_mgmt_register_group();
+
+	ztest_test_suite(img_mgmt,
+			 ztest_unit_test(test_upload_in_order),
+			 ztest_unit_test(test_upload_reordered),
+			 ztest_unit_test(test_upload_last_kept),
+			 ztest_unit_test(test_upload_reorder_full),
+			 ztest_unit_test(test_upload_retransmit),
+			 ztest_unit_test(test_upload_restart));
+	ztest_run_test_suite(img_mgmt);
+}
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Reassembly of SMP requests written to the Bluetooth characteristic in
+ * several pieces. There is no controller: the connections are created in
+ * the host as on a connection complete event, and the writes are passed to
+ * the characteristic as the ATT layer does. The requests are addressed to a
+ * test command group, whose handler records what reached the SMP layer.
+ */
+
+#include <ztest.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/conn.h>
+#include <bluetooth/gatt.h>
+#include <mgmt/buf.h>
+#include <mgmt/mgmt.h>
+#include <mgmt/smp_bt.h>
+#include "cbor_buf_writer.h"
+
+#include "conn_internal.h"
+
+#define BUF_SIZE	CONFIG_MCUMGR_BUF_SIZE
+#define HDR_SIZE	MGMT_HDR_SIZE
+#define TEST_GROUP	MGMT_GROUP_ID_PERUSER
+
+/* SMP characteristic {DA2E7828-FBCE-4E01-AE9E-261174997C48} */
+static struct bt_uuid_128 smp_chr_uuid = BT_UUID_INIT_128(
+	0x48, 0x7c, 0x99, 0x74, 0x11, 0x26, 0x9e, 0xae,
+	0x01, 0x4e, 0xce, 0xfb, 0x28, 0x78, 0x2e, 0xda);
+
+static const struct bt_gatt_attr *smp_chr;
+
+static const bt_addr_le_t peer[2] = {
+	{ BT_ADDR_LE_RANDOM, { { 0x01, 0x00, 0x00, 0x00, 0x00, 0xc0 } } },
+	{ BT_ADDR_LE_RANDOM, { { 0x02, 0x00, 0x00, 0x00, 0x00, 0xc0 } } },
+};
+
+static struct bt_conn *conn_a;
+static struct bt_conn *conn_b;
+static atomic_val_t conn_a_refs;
+static atomic_val_t conn_b_refs;
+
+static u8_t rx_data[BUF_SIZE];
+static size_t rx_len;
+static int rx_cnt;
+
+/* Records the data of a request of the test group */
+static int test_write(struct mgmt_ctxt *ctxt)
+{
+	CborValue value;
+	size_t len = sizeof(rx_data);
+
+	if (cbor_value_map_find_value(&ctxt->it, "d", &value) != CborNoError ||
+	    !cbor_value_is_byte_string(&value)) {
+		return MGMT_ERR_EINVAL;
+	}
+
+	if (cbor_value_copy_byte_string(&value, rx_data, &len, NULL) !=
+	    CborNoError) {
+		return MGMT_ERR_EINVAL;
+	}
+
+	rx_len = len;
+	rx_cnt++;
+
+	return 0;
+}
+
+static const struct mgmt_handler test_handlers[] = {
+	{ .mh_write = test_write },
+};
+
+static struct mgmt_group test_group = {
+	.mg_handlers = test_handlers,
+	.mg_handlers_count = ARRAY_SIZE(test_handlers),
+	.mg_group_id = TEST_GROUP,
+};
+
+static u8_t find_smp_chr(const struct bt_gatt_attr *attr, void *user_data)
+{
+	if (attr->write == NULL ||
+	    bt_uuid_cmp(attr->uuid, &smp_chr_uuid.uuid) != 0) {
+		return BT_GATT_ITER_CONTINUE;
+	}
+
+	smp_chr = attr;
+
+	return BT_GATT_ITER_STOP;
+}
+
+static struct bt_conn *connect(const bt_addr_le_t *addr)
+{
+	struct bt_conn *conn = bt_conn_add_le(addr);
+
+	zassert_not_null(conn, "no connection");
+	bt_conn_set_state(conn, BT_CONN_CONNECTED);
+
+	return conn;
+}
+
+/*
+ * Fills in an SMP request of the test group carrying len bytes of data,
+ * returns the length of the frame.
+ */
+static size_t frame(u8_t *buf, size_t size, u8_t len)
+{
+	struct mgmt_hdr hdr = {
+		.nh_op = MGMT_OP_WRITE,
+		.nh_group = TEST_GROUP,
+	};
+	struct cbor_buf_writer writer;
+	CborEncoder enc;
+	CborEncoder map;
+	CborError err = 0;
+	u8_t data[BUF_SIZE];
+
+	zassert_true(len <= sizeof(data), "data too long");
+
+	for (int i = 0; i < len; i++) {
+		data[i] = len + i;
+	}
+
+	cbor_buf_writer_init(&writer, &buf[HDR_SIZE], size - HDR_SIZE);
+	cbor_encoder_cust_writer_init(&enc, &writer.enc, 0);
+
+	err |= cbor_encoder_create_map(&enc, &map, 1);
+	err |= cbor_encode_text_stringz(&map, "d");
+	err |= cbor_encode_byte_string(&map, data, len);
+	err |= cbor_encoder_close_container(&enc, &map);
+	zassert_equal(err, CborNoError, "request encoding failed");
+
+	hdr.nh_len = writer.enc.bytes_written;
+	mgmt_hton_hdr(&hdr);
+	memcpy(buf, &hdr, sizeof(hdr));
+
+	return HDR_SIZE + writer.enc.bytes_written;
+}
+
+/* Writes to the characteristic and lets the SMP layer run */
+static ssize_t chr_write_rc(struct bt_conn *conn, const u8_t *buf, u16_t len)
+{
+	ssize_t ret;
+
+	ret = smp_chr->write(conn, smp_chr, buf, len, 0,
+			     BT_GATT_WRITE_FLAG_CMD);
+	k_sleep(100);
+
+	return ret;
+}
+
+static void chr_write(struct bt_conn *conn, const u8_t *buf, u16_t len)
+{
+	zassert_equal(chr_write_rc(conn, buf, len), len, "write rejected");
+}
+
+/* Checks the data of the last request which reached the SMP layer */
+static void check_rx(int cnt, u8_t len)
+{
+	zassert_equal(rx_cnt, cnt, "wrong number of requests");
+	zassert_equal(rx_len, len, "wrong request length");
+
+	for (int i = 0; i < len; i++) {
+		zassert_equal(rx_data[i], (u8_t)(len + i),
+			      "wrong request data");
+	}
+}
+
+/* No buffer or connection reference is kept */
+static void check_released(void)
+{
+	struct net_buf *nb[CONFIG_MCUMGR_BUF_COUNT];
+
+	for (int i = 0; i < ARRAY_SIZE(nb); i++) {
+		nb[i] = mcumgr_buf_alloc();
+		zassert_not_null(nb[i], "buffer leaked");
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(nb); i++) {
+		mcumgr_buf_free(nb[i]);
+	}
+
+	zassert_equal(atomic_get(&conn_a->ref), conn_a_refs,
+		      "connection reference leaked");
+	zassert_equal(atomic_get(&conn_b->ref), conn_b_refs,
+		      "connection reference leaked");
+}
+
+static void rx_reset(void)
+{
+	rx_len = 0;
+	rx_cnt = 0;
+}
+
+/* A request is passed on once its last piece has been written */
+static void test_write_split(void)
+{
+	u8_t buf[BUF_SIZE];
+	size_t len = frame(buf, sizeof(buf), 20);
+
+	rx_reset();
+
+	/* partial header, complete header and partial payload */
+	chr_write(conn_a, buf, 4);
+	chr_write(conn_a, &buf[4], HDR_SIZE - 4);
+	chr_write(conn_a, &buf[HDR_SIZE], 10);
+	zassert_equal(rx_cnt, 0, "partial request passed on");
+	chr_write(conn_a, &buf[HDR_SIZE + 10], len - HDR_SIZE - 10);
+	check_rx(1, 20);
+	check_released();
+
+	/* a request in one write is passed on right away */
+	chr_write(conn_a, buf, len);
+	check_rx(2, 20);
+	check_released();
+}
+
+/*
+ * Frames written together are passed on together. Without an ATT channel
+ * the response to the first frame cannot be sent, which makes the SMP
+ * layer drop the rest of the request.
+ */
+static void test_write_frames(void)
+{
+	u8_t buf[BUF_SIZE];
+	size_t len;
+
+	rx_reset();
+
+	len = frame(buf, sizeof(buf), 6);
+	len += frame(&buf[len], sizeof(buf) - len, 2);
+
+	chr_write(conn_a, buf, len - 1);
+	zassert_equal(rx_cnt, 0, "partial request passed on");
+	chr_write(conn_a, &buf[len - 1], 1);
+	check_rx(1, 6);
+	check_released();
+}
+
+/* A write from another peer drops the partial request */
+static void test_write_other_conn(void)
+{
+	u8_t buf[BUF_SIZE];
+	size_t len = frame(buf, sizeof(buf), 12);
+
+	rx_reset();
+
+	chr_write(conn_a, buf, 10);
+	chr_write(conn_b, buf, 10);
+	zassert_equal(atomic_get(&conn_a->ref), conn_a_refs,
+		      "dropped request kept reference");
+	chr_write(conn_b, &buf[10], len - 10);
+	check_rx(1, 12);
+	check_released();
+}
+
+/* Requests which do not fit into a buffer are rejected */
+static void test_write_overflow(void)
+{
+	u8_t buf[2 * BUF_SIZE];
+	size_t len = frame(buf, sizeof(buf), BUF_SIZE);
+	ssize_t ret;
+
+	rx_reset();
+
+	chr_write(conn_a, buf, BUF_SIZE / 2);
+	ret = chr_write_rc(conn_a, &buf[BUF_SIZE / 2], len - BUF_SIZE / 2);
+	zassert_equal(ret, BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES),
+		      "oversized request accepted");
+	zassert_equal(rx_cnt, 0, "oversized request passed on");
+	check_released();
+}
+
+/* Disconnection of the peer drops its partial request */
+static void test_write_disconnected(void)
+{
+	u8_t buf[BUF_SIZE];
+
+	frame(buf, sizeof(buf), 12);
+	rx_reset();
+
+	chr_write(conn_a, buf, 10);
+	bt_conn_set_state(conn_b, BT_CONN_DISCONNECTED);
+	zassert_equal(atomic_get(&conn_a->ref), conn_a_refs + 1,
+		      "request of other peer dropped");
+
+	bt_conn_set_state(conn_a, BT_CONN_DISCONNECTED);
+	zassert_equal(rx_cnt, 0, "partial request passed on");
+	zassert_equal(atomic_get(&conn_a->ref), conn_a_refs,
+		      "partial request kept");
+	check_released();
+}
+
+/* Registers the service and connects both peers */
+static void test_setup(void)
+{
+	zassert_equal(smp_bt_register(), 0, "service not registered");
+
+	bt_gatt_foreach_attr(0x0001, 0xffff, find_smp_chr, NULL);
+	zassert_not_null(smp_chr, "no SMP characteristic");
+
+	conn_a = connect(&peer[0]);
+	conn_b = connect(&peer[1]);
+	conn_a_refs = atomic_get(&conn_a->ref);
+	conn_b_refs = atomic_get(&conn_b->ref);
+}
+
+void test_main(void)
+{
+	mgmt_register_group(&test_group);
+
+	ztest_test_suite(smp_bt,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_write_split),
+			 ztest_unit_test(test_write_frames),
+			 ztest_unit_test(test_write_other_conn),
+			 ztest_unit_test(test_write_overflow),
+			 ztest_unit_test(test_write_disconnected));
+	ztest_run_test_suite(smp_bt);
+}
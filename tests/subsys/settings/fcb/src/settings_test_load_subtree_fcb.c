@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2019 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "settings_test.h"
+#include "settings/settings_fcb.h"
+
+static u8_t sub_val;
+static char sub_key[16];
+static int sub_commit_called;
+
+static int sub_handle_set(int argc, char **argv, void *value_ctx)
+{
+	int rc;
+
+	if (argc == 1) {
+		strncpy(sub_key, argv[0], sizeof(sub_key) - 1);
+		rc = settings_val_read_cb(value_ctx, &sub_val, sizeof(sub_val));
+		zassert_true(rc >= 0, "SETTINGS_VALUE_SET callback");
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
+static int sub_handle_commit(void)
+{
+	sub_commit_called++;
+	return 0;
+}
+
+/* registered below the "myfoo" test handler */
+static struct settings_handler sub_handler = {
+	.name = "myfoo/sub",
+	.h_set = sub_handle_set,
+	.h_commit = sub_handle_commit
+};
+
+static int fcb_count_cb(struct fcb_entry_ctx *entry_ctx, void *arg)
+{
+	(*(int *)arg)++;
+	return 0;
+}
+
+static int fcb_records(struct settings_fcb *cf)
+{
+	int cnt = 0;
+	int rc;
+
+	rc = fcb_walk(&cf->cf_fcb, NULL, fcb_count_cb, &cnt);
+	zassert_true(rc == 0, "fcb_walk call failure");
+
+	return cnt;
+}
+
+static void sub_clear_state(void)
+{
+	val8 = 0U;
+	val32 = 0U;
+	sub_val = 0U;
+	(void)memset(sub_key, 0, sizeof(sub_key));
+	sub_commit_called = 0;
+	ctest_clear_call_state();
+}
+
+void test_config_load_subtree_fcb(void)
+{
+	struct settings_fcb cf;
+	u8_t val;
+	int cnt;
+	int rc;
+
+	config_wipe_srcs();
+	config_wipe_fcb(fcb_sectors, ARRAY_SIZE(fcb_sectors));
+
+	cf.cf_fcb.f_magic = CONFIG_SETTINGS_FCB_MAGIC;
+	cf.cf_fcb.f_sectors = fcb_sectors;
+	cf.cf_fcb.f_sector_cnt = ARRAY_SIZE(fcb_sectors);
+
+	rc = settings_fcb_src(&cf);
+	zassert_true(rc == 0, "can't register FCB as configuration source");
+
+	rc = settings_fcb_dst(&cf);
+	zassert_true(rc == 0,
+		     "can't register FCB as configuration destination");
+
+	rc = settings_register(&sub_handler);
+	zassert_true(rc == 0, "can't register handler");
+
+	val = 11U;
+	rc = settings_save_one("myfoo/mybar", &val, sizeof(val));
+	zassert_true(rc == 0, "fcb one item write error");
+	val = 22U;
+	rc = settings_save_one("myfoo/sub/key", &val, sizeof(val));
+	zassert_true(rc == 0, "fcb one item write error");
+	val32 = 33U;
+	rc = settings_save_one("3/v", &val32, sizeof(val32));
+	zassert_true(rc == 0, "fcb one item write error");
+
+	/* items of the nested handler reach it with the name below it */
+	sub_clear_state();
+	rc = settings_load_subtree("myfoo/sub");
+	zassert_true(rc == 0, "fcb read error");
+	zassert_true(sub_val == 22U, "bad value read");
+	zassert_true(!strcmp(sub_key, "key"), "bad name below the handler");
+	zassert_true(val8 == 0U && val32 == 0U, "item outside subtree read");
+	zassert_true(sub_commit_called == 1, "subtree not committed");
+	zassert_true(test_commit_called == 0, "parent handler committed");
+
+	sub_clear_state();
+	rc = settings_load_subtree("myfoo");
+	zassert_true(rc == 0, "fcb read error");
+	zassert_true(val8 == 11U && sub_val == 22U, "bad value read");
+	zassert_true(val32 == 0U, "item outside subtree read");
+	zassert_true(test_commit_called == 1 && sub_commit_called == 1,
+		     "subtree not committed");
+
+	/* a name sharing the first characters is not in the subtree */
+	sub_clear_state();
+	rc = settings_load_subtree("myf");
+	zassert_true(rc == 0, "fcb read error");
+	zassert_true(val8 == 0U && sub_val == 0U && val32 == 0U,
+		     "item outside subtree read");
+
+	sub_clear_state();
+	rc = settings_load();
+	zassert_true(rc == 0, "fcb read error");
+	zassert_true(val8 == 11U && sub_val == 22U && val32 == 33U,
+		     "bad value read");
+
+	/* an unchanged value is not stored again, a changed one is */
+	cnt = fcb_records(&cf);
+	val = 22U;
+	rc = settings_save_one("myfoo/sub/key", &val, sizeof(val));
+	zassert_true(rc == 0, "fcb one item write error");
+	zassert_true(fcb_records(&cf) == cnt, "unchanged value stored");
+
+	val = 23U;
+	rc = settings_save_one("myfoo/sub/key", &val, sizeof(val));
+	zassert_true(rc == 0, "fcb one item write error");
+	zassert_true(fcb_records(&cf) == cnt + 1, "changed value not stored");
+
+	rc = settings_save_one("myfoo/sub/key", &val, sizeof(val));
+	zassert_true(rc == 0, "fcb one item write error");
+	zassert_true(fcb_records(&cf) == cnt + 1, "unchanged value stored");
+
+	sub_clear_state();
+	rc = settings_load_subtree("myfoo/sub");
+	zassert_true(rc == 0, "fcb read error");
+	zassert_true(sub_val == 23U, "bad value read");
+}